@@ -0,0 +1,112 @@
+#pragma once
+#include <VHAL.h>
+#include <Utilities/Checksum/CRC/Crc.h>
+#include <span>
+#include <cstring>
+#include <algorithm>
+
+/*
+Definitions shared by the Modbus master, slave and transports
+
+CRC16/MODBUS uses a slice-by-4 table (2 KB) generated at compile time and placed in flash,
+about twice as fast as a single 256 entry table on full-size frames:
+    uint16 crc = Modbus::Crc16(std::span(frame, length));
+    length = Modbus::AppendCrc(std::span(frame), length);  // Low byte first
+
+Bit-packed data (coils, discrete inputs) is stored like on the wire:
+item n is bit n % 8 of byte n / 8
+    Modbus::PackBits(store, 100, response, 37);     // 37 items from item 100 to response bit 0
+    Modbus::UnpackBits(request, store, 100, 37);    // And back
+*/
+
+
+namespace Modbus {
+    enum class Function : uint8 {
+        ReadCoils = 0x01,
+        ReadDiscreteInputs = 0x02,
+        ReadHoldingRegisters = 0x03,
+        ReadInputRegisters = 0x04,
+        WriteSingleCoil = 0x05,
+        WriteSingleRegister = 0x06,
+        WriteMultipleCoils = 0x0F,
+        WriteMultipleRegisters = 0x10
+    };
+
+    static constexpr size_t MAX_FRAME_SIZE = 256;          // RTU: address + PDU + CRC
+    static constexpr size_t MAX_PDU_SIZE = 253;
+    static constexpr uint16 MAX_READ_BITS = 2000;
+    static constexpr uint16 MAX_WRITE_BITS = 1968;
+    static constexpr uint16 MAX_READ_REGISTERS = 125;
+    static constexpr uint16 MAX_WRITE_REGISTERS = 123;
+
+
+    inline uint16 Crc16(std::span<const uint8> data) {
+        return Crc::Calculate(data.data(), data.size(), Crc::StaticSliceTable<Crc::CRC_16_MODBUS, 4>);
+    }
+
+
+    // Appends the CRC of the first `length` bytes, returns the new length
+    inline size_t AppendCrc(std::span<uint8> frame, size_t length) {
+        uint16 crc = Crc16(frame.first(length));
+        frame[length] = crc & 0xFF;
+        frame[length + 1] = crc >> 8;
+        return length + 2;
+    }
+
+
+    // Frame with the CRC in its last two bytes
+    inline bool CheckCrc(std::span<const uint8> frame) {
+        if (frame.size() < 2) {
+            return false;
+        }
+        uint16 receivedCrc = (frame[frame.size() - 1] << 8) | frame[frame.size() - 2];
+        return receivedCrc == Crc16(frame.first(frame.size() - 2));
+    }
+
+
+    // Copies `count` bits starting at bit `sourceBit` of the store to bit 0 of destination,
+    // a byte per step. Unused bits of the last destination byte are cleared
+    inline void PackBits(std::span<const uint8> source, size_t sourceBit, uint8* destination, size_t count) {
+        size_t first = sourceBit / 8;
+        uint8 shift = sourceBit % 8;
+        size_t bytes = (count + 7) / 8;
+
+        if (shift == 0) {
+            std::memcpy(destination, source.data() + first, bytes);
+        } else {
+            for (size_t i = 0; i < bytes; i++) {
+                size_t index = first + i;
+                uint8 high = index + 1 < source.size() ? source[index + 1] << (8 - shift) : 0;
+                destination[i] = (source[index] >> shift) | high;
+            }
+        }
+
+        if (count % 8) {
+            destination[bytes - 1] &= (1 << (count % 8)) - 1;
+        }
+    }
+
+
+    // Copies `count` bits from bit 0 of source into the store at bit `destinationBit`,
+    // up to a byte per step, neighbouring bits of the store are kept
+    inline void UnpackBits(const uint8* source, std::span<uint8> destination, size_t destinationBit, size_t count) {
+        size_t sourceBytes = (count + 7) / 8;
+        for (size_t done = 0; done < count;) {
+            size_t bit = destinationBit + done;
+            uint8 shift = bit % 8;
+            size_t take = std::min<size_t>(8 - shift, count - done);
+
+            size_t index = done / 8;
+            uint16 window = source[index];
+            if (index + 1 < sourceBytes) {
+                window |= source[index + 1] << 8;
+            }
+            uint8 mask = ((1u << take) - 1) << shift;
+            uint8 value = ((window >> (done % 8)) << shift) & mask;
+
+            uint8& target = destination[bit / 8];
+            target = (target & ~mask) | value;
+            done += take;
+        }
+    }
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include <VHAL.h>
+#include <Drivers/Interface/Modbus/Modbus.h>
+#include <Utilities/Buffer/RingBuffer.h>
 #include <array>
 #include <span>
 #include <functional>
@@ -57,6 +59,24 @@ PLC communication:
     std::array<uint16, 8> commands = {...};
     plc.WriteMultipleRegisters(100, std::span(commands));
 
+Asynchronous requests (the bus is driven from Process(), nothing blocks):
+    master.SetBaudRate(115200);                 // For 3.5 character inter-frame timing
+    std::array<uint16, 10> registers{};
+    master.ReadHoldingRegistersAsync(5, 200, std::span(registers),
+        [](const ModbusMaster::Completion& completion) {
+            if (completion.error == ModbusMaster::ModbusError::Success) {
+                // registers[] is filled
+            }
+        });
+
+    // UART RX interrupt (or keep SetReceiveCallback() for polling)
+    void OnUartData(std::span<const uint8> data) {
+        master.DataReceived(data);
+    }
+
+    // Main loop
+    master.Process();
+
 Error handling:
     auto result = master.ReadHoldingRegisters(100, std::span(data));
     if (result == ModbusError::Timeout) {
@@ -69,16 +89,7 @@ Error handling:
 
 class ModbusMaster {
 public:
-	enum class ModbusFunction : uint8 {
-	    ReadCoils = 0x01,
-	    ReadDiscreteInputs = 0x02,
-	    ReadHoldingRegisters = 0x03,
-	    ReadInputRegisters = 0x04,
-	    WriteSingleCoil = 0x05,
-	    WriteSingleRegister = 0x06,
-	    WriteMultipleCoils = 0x0F,
-	    WriteMultipleRegisters = 0x10
-	};
+    using ModbusFunction = Modbus::Function;
 
 	enum class ModbusError : uint8 {
 	    Success = 0,
@@ -86,26 +97,76 @@ public:
 	    CrcError,
 	    ExceptionResponse,
 	    InvalidResponse,
-	    BufferTooSmall
+	    BufferTooSmall,
+	    QueueFull
 	};
 
+    // Outcome of a request, read data is already stored in the request's span
+    struct Completion {
+        uint8 slaveId;
+        ModbusFunction function;
+        uint16 address;
+        ModbusError error;
+        uint8 exceptionCode;        // Valid for ModbusError::ExceptionResponse
+        uint32 latency;             // Ticks from sending the request to the end of the response
+        std::span<const uint8> response;    // Response PDU (normal or exception), only valid inside the callback
+    };
+
+    using CompletionCallback = std::function<void(const Completion&)>;
+
+    // Spans must stay valid until the completion callback is called
+    struct Request {
+        uint8 slaveId = 0;
+        ModbusFunction function = ModbusFunction::ReadHoldingRegisters;
+        uint16 address = 0;
+        uint16 value = 0;                           // WriteSingleCoil / WriteSingleRegister
+        uint32 timeout = 0;                         // 0 - master timeout
+        std::span<bool> bits;                       // ReadCoils / ReadDiscreteInputs
+        std::span<uint16> registers;                // ReadHoldingRegisters / ReadInputRegisters
+        std::span<const bool> writeBits;            // WriteMultipleCoils
+        std::span<const uint16> writeRegisters;     // WriteMultipleRegisters
+        std::span<const uint8> pdu;                 // Prebuilt PDU sent as is (e.g. by a gateway), overrides the fields above
+        CompletionCallback onComplete;
+    };
+
 
 private:
-    static constexpr size_t MAX_FRAME_SIZE = 256;
-    static constexpr uint16 CRC_INIT = 0xFFFF;
+    static constexpr size_t MAX_FRAME_SIZE = Modbus::MAX_FRAME_SIZE;
     static constexpr uint32 DEFAULT_TIMEOUT_MS = 1000;
-    
+    static constexpr uint32 DEFAULT_BAUD_RATE = 19200;
+    static constexpr uint32 BROADCAST_DELAY_MS = 100;    // Turnaround delay, broadcasts have no response
+    static constexpr uint16 MAX_QUEUED_REQUESTS = 16;
+
+    enum class State : uint8 {
+        Idle,
+        WaitingResponse,
+        BroadcastDelay
+    };
+
     uint8 slaveId;
     uint32 timeoutMs;
     std::function<void(std::span<const uint8>)> sendCallback;
     std::function<size_t(std::span<uint8>)> receiveCallback;
     std::function<uint32()> getTickCallback;
-    
+
+    RingBuffer<Request, MAX_QUEUED_REQUESTS> requestQueue;
+    Request currentRequest;
+    State state = State::Idle;
+    uint32 sentAt = 0;
+    uint32 interFrameTicks = 1;             // 3.5 characters of silence
+    uint32 broadcastDelayTicks = BROADCAST_DELAY_MS;
+
+    std::array<uint8, MAX_FRAME_SIZE> txFrame;
+    std::array<uint8, MAX_FRAME_SIZE> rxFrame;
+    size_t rxLength = 0;
+    uint32 lastBusActivity = 0;             // Last received byte or end of our own request
+
 
 public:
     explicit ModbusMaster(uint8 slaveId, uint32 timeoutMs = DEFAULT_TIMEOUT_MS) 
         : slaveId(slaveId), timeoutMs(timeoutMs) {
         getTickCallback = []() -> uint32 { return System::GetTick(); };
+        SetBaudRate(DEFAULT_BAUD_RATE);
     }
     
 
@@ -114,6 +175,7 @@ public:
     }
     
 
+    // Polled from Process(), alternative to pushing bytes with DataReceived()
     void SetReceiveCallback(std::function<size_t(std::span<uint8>)> callback) {
         receiveCallback = callback;
     }
@@ -132,326 +194,567 @@ public:
     void SetSlaveId(uint8 slaveId) {
         this->slaveId = slaveId;
     }
-    
 
-    ModbusError ReadCoils(uint16 startAddress, std::span<bool> coils) {
-        if (coils.size() > 2000) return ModbusError::BufferTooSmall;
-        
-        std::array<uint8, 8> request{};
-        request[0] = slaveId;
-        request[1] = static_cast<uint8>(ModbusFunction::ReadCoils);
-        request[2] = startAddress >> 8;
-        request[3] = startAddress & 0xFF;
-        request[4] = coils.size() >> 8;
-        request[5] = coils.size() & 0xFF;
-        
-        uint16 crc = CalculateCrc(std::span(request.data(), 6));
-        request[6] = crc & 0xFF;
-        request[7] = crc >> 8;
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        size_t responseLength;
-        auto error = SendRequest(std::span(request), std::span(response), responseLength);
-        if (error != ModbusError::Success) return error;
-        
-        if (!ValidateResponse(std::span(response.data(), responseLength), static_cast<uint8>(ModbusFunction::ReadCoils))) {
-            return ModbusError::InvalidResponse;
+
+    // Derives the 3.5 character inter-frame gap from the line speed. tickFrequency is
+    // the rate of the tick callback, all timeouts are counted in these ticks
+    void SetBaudRate(uint32 baudRate, uint32 tickFrequency = 1000) {
+        // 11 bits per character, fixed 1750 us above 19200 baud as the specification recommends
+        uint64 gapMicroseconds = baudRate > 19200 ? 1750 : 38500000ull / baudRate;
+        interFrameTicks = std::max<uint32>(1, static_cast<uint32>((gapMicroseconds * tickFrequency + 999999) / 1000000));
+        broadcastDelayTicks = static_cast<uint32>(static_cast<uint64>(BROADCAST_DELAY_MS) * tickFrequency / 1000);
+    }
+
+
+    uint32 GetTick() const {
+        return getTickCallback();
+    }
+
+
+    bool IsIdle() const {
+        return state == State::Idle && requestQueue.IsEmpty();
+    }
+
+
+    // Received bytes from the UART (RX interrupt or DMA). A gap longer than
+    // 3.5 characters starts a new frame
+    void DataReceived(std::span<const uint8> data) {
+        AppendReceived(data, true);
+    }
+
+
+    // Drives the bus: collects the response, handles timeouts and starts queued requests
+    void Process() {
+        PollReceiver();
+
+        uint32 now = getTickCallback();
+        switch (state) {
+            case State::Idle:
+                StartNextRequest(now);
+                break;
+
+            case State::WaitingResponse:
+                CheckResponse(now);
+                break;
+
+            case State::BroadcastDelay:
+                if (now - sentAt >= broadcastDelayTicks) {
+                    Finish(ModbusError::Success, 0, now);
+                }
+                break;
         }
-        
-        if (response[1] & 0x80) return ModbusError::ExceptionResponse;
-        
-        uint8 byteCount = response[2];
-        for (size_t i = 0; i < coils.size() && i < byteCount * 8; ++i) {
-            coils[i] = (response[3 + i / 8] >> (i % 8)) & 1;
+    }
+
+
+    // Queues a request, the completion callback is called from Process()
+    ResultStatus Submit(Request request) {
+        if (!sendCallback) {
+            return ResultStatus::noInit;
         }
-        
-        return ModbusError::Success;
+        if (!request.pdu.empty()) {
+            request.function = static_cast<ModbusFunction>(request.pdu[0]);
+        }
+        if (CheckRequest(request) != ModbusError::Success) {
+            return ResultStatus::invalidParameter;
+        }
+        return requestQueue.Push(std::move(request));
+    }
+
+
+    ResultStatus ReadCoilsAsync(uint8 slaveId, uint16 startAddress, std::span<bool> coils, CompletionCallback callback, uint32 timeout = 0) {
+        Request request;
+        request.slaveId = slaveId;
+        request.function = ModbusFunction::ReadCoils;
+        request.address = startAddress;
+        request.timeout = timeout;
+        request.bits = coils;
+        request.onComplete = std::move(callback);
+        return Submit(std::move(request));
+    }
+
+
+    ResultStatus ReadDiscreteInputsAsync(uint8 slaveId, uint16 startAddress, std::span<bool> inputs, CompletionCallback callback, uint32 timeout = 0) {
+        Request request;
+        request.slaveId = slaveId;
+        request.function = ModbusFunction::ReadDiscreteInputs;
+        request.address = startAddress;
+        request.timeout = timeout;
+        request.bits = inputs;
+        request.onComplete = std::move(callback);
+        return Submit(std::move(request));
+    }
+
+
+    ResultStatus ReadHoldingRegistersAsync(uint8 slaveId, uint16 startAddress, std::span<uint16> registers, CompletionCallback callback, uint32 timeout = 0) {
+        Request request;
+        request.slaveId = slaveId;
+        request.function = ModbusFunction::ReadHoldingRegisters;
+        request.address = startAddress;
+        request.timeout = timeout;
+        request.registers = registers;
+        request.onComplete = std::move(callback);
+        return Submit(std::move(request));
+    }
+
+
+    ResultStatus ReadInputRegistersAsync(uint8 slaveId, uint16 startAddress, std::span<uint16> registers, CompletionCallback callback, uint32 timeout = 0) {
+        Request request;
+        request.slaveId = slaveId;
+        request.function = ModbusFunction::ReadInputRegisters;
+        request.address = startAddress;
+        request.timeout = timeout;
+        request.registers = registers;
+        request.onComplete = std::move(callback);
+        return Submit(std::move(request));
+    }
+
+
+    ResultStatus WriteSingleCoilAsync(uint8 slaveId, uint16 address, bool value, CompletionCallback callback, uint32 timeout = 0) {
+        Request request;
+        request.slaveId = slaveId;
+        request.function = ModbusFunction::WriteSingleCoil;
+        request.address = address;
+        request.value = value ? 1 : 0;
+        request.timeout = timeout;
+        request.onComplete = std::move(callback);
+        return Submit(std::move(request));
+    }
+
+
+    ResultStatus WriteSingleRegisterAsync(uint8 slaveId, uint16 address, uint16 value, CompletionCallback callback, uint32 timeout = 0) {
+        Request request;
+        request.slaveId = slaveId;
+        request.function = ModbusFunction::WriteSingleRegister;
+        request.address = address;
+        request.value = value;
+        request.timeout = timeout;
+        request.onComplete = std::move(callback);
+        return Submit(std::move(request));
+    }
+
+
+    ResultStatus WriteMultipleCoilsAsync(uint8 slaveId, uint16 startAddress, std::span<const bool> coils, CompletionCallback callback, uint32 timeout = 0) {
+        Request request;
+        request.slaveId = slaveId;
+        request.function = ModbusFunction::WriteMultipleCoils;
+        request.address = startAddress;
+        request.timeout = timeout;
+        request.writeBits = coils;
+        request.onComplete = std::move(callback);
+        return Submit(std::move(request));
+    }
+
+
+    ResultStatus WriteMultipleRegistersAsync(uint8 slaveId, uint16 startAddress, std::span<const uint16> registers, CompletionCallback callback, uint32 timeout = 0) {
+        Request request;
+        request.slaveId = slaveId;
+        request.function = ModbusFunction::WriteMultipleRegisters;
+        request.address = startAddress;
+        request.timeout = timeout;
+        request.writeRegisters = registers;
+        request.onComplete = std::move(callback);
+        return Submit(std::move(request));
+    }
+
+
+    // Blocking variants for the configured slave: queue the request and run
+    // Process() until it completes. Not to be called from a completion callback
+    ModbusError ReadCoils(uint16 startAddress, std::span<bool> coils) {
+        Request request;
+        request.function = ModbusFunction::ReadCoils;
+        request.address = startAddress;
+        request.bits = coils;
+        return Transact(std::move(request));
     }
     
 
     ModbusError ReadDiscreteInputs(uint16 startAddress, std::span<bool> inputs) {
-        if (inputs.size() > 2000) return ModbusError::BufferTooSmall;
-        
-        std::array<uint8, 8> request{};
-        request[0] = slaveId;
-        request[1] = static_cast<uint8>(ModbusFunction::ReadDiscreteInputs);
-        request[2] = startAddress >> 8;
-        request[3] = startAddress & 0xFF;
-        request[4] = inputs.size() >> 8;
-        request[5] = inputs.size() & 0xFF;
-        
-        uint16 crc = CalculateCrc(std::span(request.data(), 6));
-        request[6] = crc & 0xFF;
-        request[7] = crc >> 8;
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        size_t responseLength;
-        auto error = SendRequest(std::span(request), std::span(response), responseLength);
-        if (error != ModbusError::Success) return error;
-        
-        if (!ValidateResponse(std::span(response.data(), responseLength), static_cast<uint8>(ModbusFunction::ReadDiscreteInputs))) {
-            return ModbusError::InvalidResponse;
-        }
-        
-        if (response[1] & 0x80) return ModbusError::ExceptionResponse;
-        
-        uint8 byteCount = response[2];
-        for (size_t i = 0; i < inputs.size() && i < byteCount * 8; ++i) {
-            inputs[i] = (response[3 + i / 8] >> (i % 8)) & 1;
-        }
-        
-        return ModbusError::Success;
+        Request request;
+        request.function = ModbusFunction::ReadDiscreteInputs;
+        request.address = startAddress;
+        request.bits = inputs;
+        return Transact(std::move(request));
     }
     
 
     ModbusError ReadHoldingRegisters(uint16 startAddress, std::span<uint16> registers) {
-        if (registers.size() > 125) return ModbusError::BufferTooSmall;
-        
-        std::array<uint8, 8> request{};
-        request[0] = slaveId;
-        request[1] = static_cast<uint8>(ModbusFunction::ReadHoldingRegisters);
-        request[2] = startAddress >> 8;
-        request[3] = startAddress & 0xFF;
-        request[4] = registers.size() >> 8;
-        request[5] = registers.size() & 0xFF;
-        
-        uint16 crc = CalculateCrc(std::span(request.data(), 6));
-        request[6] = crc & 0xFF;
-        request[7] = crc >> 8;
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        size_t responseLength;
-        auto error = SendRequest(std::span(request), std::span(response), responseLength);
-        if (error != ModbusError::Success) return error;
-        
-        if (!ValidateResponse(std::span(response.data(), responseLength), static_cast<uint8>(ModbusFunction::ReadHoldingRegisters))) {
-            return ModbusError::InvalidResponse;
-        }
-        
-        if (response[1] & 0x80) return ModbusError::ExceptionResponse;
-        
-        uint8 byteCount = response[2];
-        for (size_t i = 0; i < registers.size() && i < byteCount / 2; ++i) {
-            registers[i] = (response[3 + i * 2] << 8) | response[4 + i * 2];
-        }
-        
-        return ModbusError::Success;
+        Request request;
+        request.function = ModbusFunction::ReadHoldingRegisters;
+        request.address = startAddress;
+        request.registers = registers;
+        return Transact(std::move(request));
     }
     
 
     ModbusError ReadInputRegisters(uint16 startAddress, std::span<uint16> registers) {
-        if (registers.size() > 125) return ModbusError::BufferTooSmall;
-        
-        std::array<uint8, 8> request{};
-        request[0] = slaveId;
-        request[1] = static_cast<uint8>(ModbusFunction::ReadInputRegisters);
-        request[2] = startAddress >> 8;
-        request[3] = startAddress & 0xFF;
-        request[4] = registers.size() >> 8;
-        request[5] = registers.size() & 0xFF;
-        
-        uint16 crc = CalculateCrc(std::span(request.data(), 6));
-        request[6] = crc & 0xFF;
-        request[7] = crc >> 8;
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        size_t responseLength;
-        auto error = SendRequest(std::span(request), std::span(response), responseLength);
-        if (error != ModbusError::Success) return error;
-        
-        if (!ValidateResponse(std::span(response.data(), responseLength), static_cast<uint8>(ModbusFunction::ReadInputRegisters))) {
-            return ModbusError::InvalidResponse;
-        }
-        
-        if (response[1] & 0x80) return ModbusError::ExceptionResponse;
-        
-        uint8 byteCount = response[2];
-        for (size_t i = 0; i < registers.size() && i < byteCount / 2; ++i) {
-            registers[i] = (response[3 + i * 2] << 8) | response[4 + i * 2];
-        }
-        
-        return ModbusError::Success;
+        Request request;
+        request.function = ModbusFunction::ReadInputRegisters;
+        request.address = startAddress;
+        request.registers = registers;
+        return Transact(std::move(request));
     }
     
 
     ModbusError WriteSingleCoil(uint16 address, bool value) {
-        std::array<uint8, 8> request{};
-        request[0] = slaveId;
-        request[1] = static_cast<uint8>(ModbusFunction::WriteSingleCoil);
-        request[2] = address >> 8;
-        request[3] = address & 0xFF;
-        request[4] = value ? 0xFF : 0x00;
-        request[5] = 0x00;
-        
-        uint16 crc = CalculateCrc(std::span(request.data(), 6));
-        request[6] = crc & 0xFF;
-        request[7] = crc >> 8;
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        size_t responseLength;
-        auto error = SendRequest(std::span(request), std::span(response), responseLength);
-        if (error != ModbusError::Success) return error;
-        
-        if (!ValidateResponse(std::span(response.data(), responseLength), static_cast<uint8>(ModbusFunction::WriteSingleCoil))) {
-            return ModbusError::InvalidResponse;
-        }
-        
-        if (response[1] & 0x80) return ModbusError::ExceptionResponse;
-        
-        return ModbusError::Success;
+        Request request;
+        request.function = ModbusFunction::WriteSingleCoil;
+        request.address = address;
+        request.value = value ? 1 : 0;
+        return Transact(std::move(request));
     }
     
 
     ModbusError WriteSingleRegister(uint16 address, uint16 value) {
-        std::array<uint8, 8> request{};
-        request[0] = slaveId;
-        request[1] = static_cast<uint8>(ModbusFunction::WriteSingleRegister);
-        request[2] = address >> 8;
-        request[3] = address & 0xFF;
-        request[4] = value >> 8;
-        request[5] = value & 0xFF;
-        
-        uint16 crc = CalculateCrc(std::span(request.data(), 6));
-        request[6] = crc & 0xFF;
-        request[7] = crc >> 8;
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        size_t responseLength;
-        auto error = SendRequest(std::span(request), std::span(response), responseLength);
-        if (error != ModbusError::Success) return error;
-        
-        if (!ValidateResponse(std::span(response.data(), responseLength), static_cast<uint8>(ModbusFunction::WriteSingleRegister))) {
-            return ModbusError::InvalidResponse;
-        }
-        
-        if (response[1] & 0x80) return ModbusError::ExceptionResponse;
-        
-        return ModbusError::Success;
+        Request request;
+        request.function = ModbusFunction::WriteSingleRegister;
+        request.address = address;
+        request.value = value;
+        return Transact(std::move(request));
     }
     
 
     ModbusError WriteMultipleCoils(uint16 startAddress, std::span<const bool> coils) {
-        if (coils.size() > 1968) return ModbusError::BufferTooSmall;
-        
-        uint8 byteCount = (coils.size() + 7) / 8;
-        std::array<uint8, MAX_FRAME_SIZE> request{};
-        
-        request[0] = slaveId;
-        request[1] = static_cast<uint8>(ModbusFunction::WriteMultipleCoils);
-        request[2] = startAddress >> 8;
-        request[3] = startAddress & 0xFF;
-        request[4] = coils.size() >> 8;
-        request[5] = coils.size() & 0xFF;
-        request[6] = byteCount;
-        
-        // Pack coils into bytes
-        for (size_t i = 0; i < coils.size(); ++i) {
-            if (coils[i]) {
-                request[7 + i / 8] |= (1 << (i % 8));
-            }
+        Request request;
+        request.function = ModbusFunction::WriteMultipleCoils;
+        request.address = startAddress;
+        request.writeBits = coils;
+        return Transact(std::move(request));
+    }
+    
+
+    ModbusError WriteMultipleRegisters(uint16 startAddress, std::span<const uint16> registers) {
+        Request request;
+        request.function = ModbusFunction::WriteMultipleRegisters;
+        request.address = startAddress;
+        request.writeRegisters = registers;
+        return Transact(std::move(request));
+    }
+
+
+private:
+    static bool IsRead(ModbusFunction function) {
+        return function == ModbusFunction::ReadCoils || function == ModbusFunction::ReadDiscreteInputs ||
+               function == ModbusFunction::ReadHoldingRegisters || function == ModbusFunction::ReadInputRegisters;
+    }
+
+
+    static ModbusError CheckRequest(const Request& request) {
+        if (request.pdu.size() > Modbus::MAX_PDU_SIZE) {
+            return ModbusError::BufferTooSmall;
         }
-        
-        size_t requestLength = 7 + byteCount;
-        uint16 crc = CalculateCrc(std::span(request.data(), requestLength));
-        request[requestLength] = crc & 0xFF;
-        request[requestLength + 1] = crc >> 8;
-        requestLength += 2;
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        size_t responseLength;
-        auto error = SendRequest(std::span(request.data(), requestLength), std::span(response), responseLength);
-        if (error != ModbusError::Success) return error;
-        
-        if (!ValidateResponse(std::span(response.data(), responseLength), static_cast<uint8>(ModbusFunction::WriteMultipleCoils))) {
+
+        switch (request.function) {
+            case ModbusFunction::ReadCoils:
+            case ModbusFunction::ReadDiscreteInputs:
+                if (request.bits.size() > Modbus::MAX_READ_BITS) return ModbusError::BufferTooSmall;
+                break;
+            case ModbusFunction::ReadHoldingRegisters:
+            case ModbusFunction::ReadInputRegisters:
+                if (request.registers.size() > Modbus::MAX_READ_REGISTERS) return ModbusError::BufferTooSmall;
+                break;
+            case ModbusFunction::WriteMultipleCoils:
+                if (request.writeBits.size() > Modbus::MAX_WRITE_BITS) return ModbusError::BufferTooSmall;
+                break;
+            case ModbusFunction::WriteMultipleRegisters:
+                if (request.writeRegisters.size() > Modbus::MAX_WRITE_REGISTERS) return ModbusError::BufferTooSmall;
+                break;
+            default:
+                break;
+        }
+
+        // Broadcast (slave 0) is only defined for writes
+        if (request.slaveId == 0 && IsRead(request.function)) {
             return ModbusError::InvalidResponse;
         }
-        
-        if (response[1] & 0x80) return ModbusError::ExceptionResponse;
-        
         return ModbusError::Success;
     }
-    
 
-    ModbusError WriteMultipleRegisters(uint16 startAddress, std::span<const uint16> registers) {
-        if (registers.size() > 123) return ModbusError::BufferTooSmall;
-        
-        std::array<uint8, MAX_FRAME_SIZE> request{};
-        
-        request[0] = slaveId;
-        request[1] = static_cast<uint8>(ModbusFunction::WriteMultipleRegisters);
-        request[2] = startAddress >> 8;
-        request[3] = startAddress & 0xFF;
-        request[4] = registers.size() >> 8;
-        request[5] = registers.size() & 0xFF;
-        request[6] = registers.size() * 2;
-        
-        // Pack registers
-        for (size_t i = 0; i < registers.size(); ++i) {
-            request[7 + i * 2] = registers[i] >> 8;
-            request[8 + i * 2] = registers[i] & 0xFF;
+
+    ModbusError Transact(Request request) {
+        request.slaveId = slaveId;
+        ModbusError error = CheckRequest(request);
+        if (error != ModbusError::Success) {
+            return error;
         }
-        
-        size_t requestLength = 7 + registers.size() * 2;
-        uint16 crc = CalculateCrc(std::span(request.data(), requestLength));
-        request[requestLength] = crc & 0xFF;
-        request[requestLength + 1] = crc >> 8;
-        requestLength += 2;
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        size_t responseLength;
-        auto error = SendRequest(std::span(request.data(), requestLength), std::span(response), responseLength);
-        if (error != ModbusError::Success) return error;
-        
-        if (!ValidateResponse(std::span(response.data(), responseLength), static_cast<uint8>(ModbusFunction::WriteMultipleRegisters))) {
+
+        bool done = false;
+        request.onComplete = [&](const Completion& completion) {
+            error = completion.error;
+            done = true;
+        };
+
+        ResultStatus status = Submit(std::move(request));
+        if (status == ResultStatus::filled) {
+            return ModbusError::QueueFull;
+        } else if (status != ResultStatus::ok) {
             return ModbusError::InvalidResponse;
         }
-        
-        if (response[1] & 0x80) return ModbusError::ExceptionResponse;
-        
-        return ModbusError::Success;
+
+        while (!done) {
+            Process();
+        }
+        return error;
     }
 
 
-private:
-    uint16 CalculateCrc(std::span<const uint8> data) const {
-        uint16 crc = CRC_INIT;
-        for (uint8 byte : data) {
-            crc ^= byte;
-            for (int i = 0; i < 8; ++i) {
-                crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+    void StartNextRequest(uint32 now) {
+        if (requestQueue.IsEmpty()) {
+            return;
+        }
+
+        // The bus has to be silent for 3.5 characters before the next frame
+        System::CriticalSection(true);
+        uint32 lastActivity = lastBusActivity;
+        System::CriticalSection(false);
+        if (now - lastActivity <= interFrameTicks) {
+            return;
+        }
+
+        auto next = requestQueue.Pop();
+        if (next.IsErr()) {
+            return;
+        }
+        currentRequest = std::move(next.Value());
+
+        size_t length = EncodeRequest(currentRequest);
+
+        System::CriticalSection(true);
+        rxLength = 0;
+        state = currentRequest.slaveId == 0 ? State::BroadcastDelay : State::WaitingResponse;
+        System::CriticalSection(false);
+
+        sendCallback(std::span<const uint8>(txFrame.data(), length));
+
+        sentAt = getTickCallback();
+        System::CriticalSection(true);
+        lastBusActivity = sentAt;
+        System::CriticalSection(false);
+    }
+
+
+    size_t EncodeRequest(const Request& request) {
+        txFrame[0] = request.slaveId;
+        if (!request.pdu.empty()) {
+            std::copy(request.pdu.begin(), request.pdu.end(), txFrame.begin() + 1);
+            return Modbus::AppendCrc(std::span(txFrame), 1 + request.pdu.size());
+        }
+
+        txFrame[1] = static_cast<uint8>(request.function);
+        txFrame[2] = request.address >> 8;
+        txFrame[3] = request.address & 0xFF;
+
+        size_t length = 6;
+        switch (request.function) {
+            case ModbusFunction::ReadCoils:
+            case ModbusFunction::ReadDiscreteInputs:
+                txFrame[4] = request.bits.size() >> 8;
+                txFrame[5] = request.bits.size() & 0xFF;
+                break;
+
+            case ModbusFunction::ReadHoldingRegisters:
+            case ModbusFunction::ReadInputRegisters:
+                txFrame[4] = request.registers.size() >> 8;
+                txFrame[5] = request.registers.size() & 0xFF;
+                break;
+
+            case ModbusFunction::WriteSingleCoil:
+                txFrame[4] = request.value ? 0xFF : 0x00;
+                txFrame[5] = 0x00;
+                break;
+
+            case ModbusFunction::WriteSingleRegister:
+                txFrame[4] = request.value >> 8;
+                txFrame[5] = request.value & 0xFF;
+                break;
+
+            case ModbusFunction::WriteMultipleCoils: {
+                size_t byteCount = (request.writeBits.size() + 7) / 8;
+                txFrame[4] = request.writeBits.size() >> 8;
+                txFrame[5] = request.writeBits.size() & 0xFF;
+                txFrame[6] = byteCount;
+
+                // Pack coils into bytes
+                std::fill_n(txFrame.begin() + 7, byteCount, 0);
+                for (size_t i = 0; i < request.writeBits.size(); ++i) {
+                    if (request.writeBits[i]) {
+                        txFrame[7 + i / 8] |= (1 << (i % 8));
+                    }
+                }
+                length = 7 + byteCount;
+                break;
             }
+
+            case ModbusFunction::WriteMultipleRegisters:
+                txFrame[4] = request.writeRegisters.size() >> 8;
+                txFrame[5] = request.writeRegisters.size() & 0xFF;
+                txFrame[6] = request.writeRegisters.size() * 2;
+
+                // Pack registers
+                for (size_t i = 0; i < request.writeRegisters.size(); ++i) {
+                    txFrame[7 + i * 2] = request.writeRegisters[i] >> 8;
+                    txFrame[8 + i * 2] = request.writeRegisters[i] & 0xFF;
+                }
+                length = 7 + request.writeRegisters.size() * 2;
+                break;
         }
-        return crc;
+
+        return Modbus::AppendCrc(std::span(txFrame), length);
     }
-    
-    
-    bool ValidateResponse(std::span<const uint8> response, uint8 expectedFunction) const {
-        if (response.size() < 3) return false;
-        if (response[0] != slaveId) return false;
-        if ((response[1] & 0x7F) != expectedFunction) return false;
-        
-        // Check CRC
-        uint16 receivedCrc = (response[response.size() - 1] << 8) | response[response.size() - 2];
-        uint16 calculatedCrc = CalculateCrc(response.subspan(0, response.size() - 2));
-        return receivedCrc == calculatedCrc;
+
+
+    void PollReceiver() {
+        if (!receiveCallback) {
+            return;
+        }
+
+        // Polling can lag behind the line, so gaps between polls say nothing about
+        // frame boundaries: frames are delimited by their length and by silence in CheckResponse()
+        std::array<uint8, 64> chunk;
+        size_t received;
+        while ((received = receiveCallback(std::span(chunk))) > 0) {
+            AppendReceived(std::span<const uint8>(chunk.data(), std::min(received, chunk.size())), false);
+        }
     }
-    
 
-    ModbusError SendRequest(std::span<const uint8> request, std::span<uint8> response, size_t& responseLength) {
-        if (!sendCallback || !receiveCallback) {
-            return ModbusError::InvalidResponse;
+
+    void AppendReceived(std::span<const uint8> data, bool detectGap) {
+        uint32 now = getTickCallback();
+
+        System::CriticalSection(true);
+        if (detectGap && rxLength > 0 && now - lastBusActivity > interFrameTicks) {
+            rxLength = 0;  // Previous frame was cut short, this is a new one
+        }
+        lastBusActivity = now;
+
+        // Bytes outside of a response (late answers, other masters) only keep the bus busy
+        if (state == State::WaitingResponse) {
+            size_t count = std::min(data.size(), MAX_FRAME_SIZE - rxLength);
+            std::copy_n(data.begin(), count, rxFrame.begin() + rxLength);
+            rxLength += count;
+        }
+        System::CriticalSection(false);
+    }
+
+
+    // Full length of the response being received, 0 while not enough of it is there to tell
+    size_t ExpectedResponseLength(size_t length) const {
+        if (length < 2) return 0;
+        if (rxFrame[1] & 0x80) return 5;
+
+        switch (static_cast<ModbusFunction>(rxFrame[1])) {
+            case ModbusFunction::ReadCoils:
+            case ModbusFunction::ReadDiscreteInputs:
+            case ModbusFunction::ReadHoldingRegisters:
+            case ModbusFunction::ReadInputRegisters:
+                return length < 3 ? 0 : 5 + rxFrame[2];
+            default:
+                return 8;
+        }
+    }
+
+
+    void CheckResponse(uint32 now) {
+        System::CriticalSection(true);
+        size_t length = rxLength;
+        uint32 lastActivity = lastBusActivity;
+        size_t expected = ExpectedResponseLength(length);
+        bool complete = expected != 0 && length >= expected;
+        if (complete) {
+            state = State::Idle;  // Stop collecting, the frame is parsed outside of the critical section
+        }
+        System::CriticalSection(false);
+
+        if (complete) {
+            uint8 exceptionCode = 0;
+            ModbusError error = expected > MAX_FRAME_SIZE
+                ? ModbusError::InvalidResponse
+                : ParseResponse(std::span<const uint8>(rxFrame.data(), expected), exceptionCode);
+
+            std::span<const uint8> pdu;
+            if (error == ModbusError::Success || error == ModbusError::ExceptionResponse) {
+                pdu = std::span<const uint8>(rxFrame.data() + 1, expected - 3);
+            }
+            Finish(error, exceptionCode, lastActivity, pdu);
+            return;
         }
-        
-        sendCallback(request);
-        
-        uint32 startTime = getTickCallback();
-        while ((getTickCallback() - startTime) < timeoutMs) {
-            responseLength = receiveCallback(response);
-            if (responseLength > 0) {
-                return ModbusError::Success;
+
+        if (length > 0 && now - lastActivity > interFrameTicks) {
+            // Line went silent in the middle of a frame: noise or a truncated answer, keep waiting
+            System::CriticalSection(true);
+            if (rxLength == length) {
+                rxLength = 0;
             }
+            System::CriticalSection(false);
+        }
+
+        uint32 timeout = currentRequest.timeout != 0 ? currentRequest.timeout : timeoutMs;
+        if (now - sentAt >= timeout) {
+            Finish(ModbusError::Timeout, 0, now);
+        }
+    }
+
+
+    ModbusError ParseResponse(std::span<const uint8> response, uint8& exceptionCode) const {
+        if (!Modbus::CheckCrc(response)) {
+            return ModbusError::CrcError;
+        }
+
+        if (response[0] != currentRequest.slaveId) return ModbusError::InvalidResponse;
+        if ((response[1] & 0x7F) != static_cast<uint8>(currentRequest.function)) return ModbusError::InvalidResponse;
+
+        if (response[1] & 0x80) {
+            exceptionCode = response[2];
+            return ModbusError::ExceptionResponse;
+        }
+
+        uint8 byteCount = response[2];
+        switch (currentRequest.function) {
+            case ModbusFunction::ReadCoils:
+            case ModbusFunction::ReadDiscreteInputs:
+                if (byteCount < (currentRequest.bits.size() + 7) / 8) return ModbusError::InvalidResponse;
+                for (size_t i = 0; i < currentRequest.bits.size(); ++i) {
+                    currentRequest.bits[i] = (response[3 + i / 8] >> (i % 8)) & 1;
+                }
+                break;
+
+            case ModbusFunction::ReadHoldingRegisters:
+            case ModbusFunction::ReadInputRegisters:
+                if (byteCount < currentRequest.registers.size() * 2) return ModbusError::InvalidResponse;
+                for (size_t i = 0; i < currentRequest.registers.size(); ++i) {
+                    currentRequest.registers[i] = (response[3 + i * 2] << 8) | response[4 + i * 2];
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        return ModbusError::Success;
+    }
+
+
+    void Finish(ModbusError error, uint8 exceptionCode, uint32 endTick, std::span<const uint8> response = {}) {
+        Completion completion{
+            currentRequest.slaveId,
+            currentRequest.function,
+            currentRequest.address,
+            error,
+            exceptionCode,
+            endTick - sentAt,
+            response
+        };
+
+        // The callback may queue the next request right away
+        CompletionCallback callback = std::move(currentRequest.onComplete);
+        currentRequest = Request();
+
+        System::CriticalSection(true);
+        state = State::Idle;
+        rxLength = 0;
+        System::CriticalSection(false);
+
+        if (callback) {
+            callback(completion);
         }
-        
-        return ModbusError::Timeout;
     }
 };
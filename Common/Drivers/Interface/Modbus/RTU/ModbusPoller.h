@@ -0,0 +1,327 @@
+#pragma once
+#include <VHAL.h>
+#include <Drivers/Interface/Modbus/RTU/ModbusMaster.h>
+#include <array>
+#include <span>
+#include <bit>
+#include <limits>
+#include <functional>
+
+/*
+Cyclic polling of many slaves on top of the asynchronous ModbusMaster
+
+Every register group is read at its own period. Groups are served round-robin,
+so a slow or dead slave does not starve the others: after a failed poll the
+slave is backed off exponentially and its groups are skipped until the backoff
+expires. Periods, timeouts and latencies are in master ticks (see ModbusMaster::SetBaudRate).
+
+Setup:
+    ModbusPoller<> poller(master);
+
+    std::array<uint16, 8> drive1{};
+    std::array<uint16, 8> drive2{};
+    std::array<bool, 16> inputs{};
+    poller.AddHoldingRegisters(1, 100, std::span(drive1), 50);     // Every 50 ms
+    poller.AddHoldingRegisters(2, 100, std::span(drive2), 50);
+    poller.AddDiscreteInputs(7, 0, std::span(inputs), 200, [](uint8 slaveId, uint16 address, auto error) {
+        // Called after every poll of the group
+    });
+    poller.SetSlaveTimeout(7, 300);
+
+    // Main loop, also drives the master
+    poller.Process();
+
+Statistics:
+    const auto* statistics = poller.GetStatistics(7);
+    // requests, responses, timeouts, crcErrors, exceptions, latencyHistogram...
+*/
+
+
+template<size_t MaxGroups = 32, size_t MaxSlaves = 32>
+class ModbusPoller {
+public:
+    using ModbusFunction = ModbusMaster::ModbusFunction;
+    using ModbusError = ModbusMaster::ModbusError;
+    using UpdateCallback = std::function<void(uint8 slaveId, uint16 address, ModbusError error)>;
+
+    // Bucket 0 is a zero latency, bucket i holds [2^(i-1), 2^i) ticks, the last one is open-ended
+    static constexpr size_t LATENCY_BUCKETS = 12;
+
+    struct SlaveStatistics {
+        uint32 requests = 0;
+        uint32 responses = 0;               // Valid answers, exceptions included
+        uint32 timeouts = 0;
+        uint32 crcErrors = 0;
+        uint32 invalidResponses = 0;
+        uint32 exceptions = 0;
+        uint32 minLatency = std::numeric_limits<uint32>::max();
+        uint32 maxLatency = 0;
+        uint32 totalLatency = 0;            // Average = totalLatency / responses
+        std::array<uint32, LATENCY_BUCKETS> latencyHistogram{};
+    };
+
+
+private:
+    static constexpr uint8 MAX_IN_FLIGHT = 2;  // Requests handed to the master, the rest waits here to stay reorderable
+    static constexpr uint32 DEFAULT_BACKOFF_INITIAL = 100;
+    static constexpr uint32 DEFAULT_BACKOFF_MAX = 5000;
+
+    struct Slave {
+        uint8 slaveId = 0;
+        uint32 timeout = 0;                 // 0 - master timeout
+        uint8 consecutiveFailures = 0;
+        uint32 retryAt = 0;
+        SlaveStatistics statistics;
+    };
+
+    struct Group {
+        uint8 slaveIndex = 0;
+        ModbusFunction function = ModbusFunction::ReadHoldingRegisters;
+        uint16 address = 0;
+        std::span<bool> bits;
+        std::span<uint16> registers;
+        uint32 period = 0;
+        uint32 nextDue = 0;
+        bool inFlight = false;
+        UpdateCallback onUpdate;
+    };
+
+    ModbusMaster& master;
+    std::array<Slave, MaxSlaves> slaves;
+    std::array<Group, MaxGroups> groups;
+    size_t slaveCount = 0;
+    size_t groupCount = 0;
+    size_t nextGroup = 0;                   // Round-robin cursor
+    uint8 inFlight = 0;
+    uint32 backoffInitial = DEFAULT_BACKOFF_INITIAL;
+    uint32 backoffMax = DEFAULT_BACKOFF_MAX;
+
+
+public:
+    explicit ModbusPoller(ModbusMaster& master) : master(master) {}
+
+
+    ResultStatus AddCoils(uint8 slaveId, uint16 address, std::span<bool> coils, uint32 period, UpdateCallback callback = nullptr) {
+        return AddGroup(slaveId, ModbusFunction::ReadCoils, address, coils, {}, period, std::move(callback));
+    }
+
+
+    ResultStatus AddDiscreteInputs(uint8 slaveId, uint16 address, std::span<bool> inputs, uint32 period, UpdateCallback callback = nullptr) {
+        return AddGroup(slaveId, ModbusFunction::ReadDiscreteInputs, address, inputs, {}, period, std::move(callback));
+    }
+
+
+    ResultStatus AddHoldingRegisters(uint8 slaveId, uint16 address, std::span<uint16> registers, uint32 period, UpdateCallback callback = nullptr) {
+        return AddGroup(slaveId, ModbusFunction::ReadHoldingRegisters, address, {}, registers, period, std::move(callback));
+    }
+
+
+    ResultStatus AddInputRegisters(uint8 slaveId, uint16 address, std::span<uint16> registers, uint32 period, UpdateCallback callback = nullptr) {
+        return AddGroup(slaveId, ModbusFunction::ReadInputRegisters, address, {}, registers, period, std::move(callback));
+    }
+
+
+    ResultStatus SetSlaveTimeout(uint8 slaveId, uint32 timeout) {
+        Slave* slave = FindSlave(slaveId);
+        if (!slave) {
+            return ResultStatus::notFound;
+        }
+        slave->timeout = timeout;
+        return ResultStatus::ok;
+    }
+
+
+    // After n consecutive failures a slave is skipped for min(initial * 2^(n-1), maximum) ticks
+    void SetBackoff(uint32 initial, uint32 maximum) {
+        backoffInitial = initial;
+        backoffMax = maximum;
+    }
+
+
+    const SlaveStatistics* GetStatistics(uint8 slaveId) const {
+        for (size_t i = 0; i < slaveCount; i++) {
+            if (slaves[i].slaveId == slaveId) {
+                return &slaves[i].statistics;
+            }
+        }
+        return nullptr;
+    }
+
+
+    void ResetStatistics() {
+        for (size_t i = 0; i < slaveCount; i++) {
+            slaves[i].statistics = SlaveStatistics();
+        }
+    }
+
+
+    // False while the slave is backed off after failed polls
+    bool IsOnline(uint8 slaveId) const {
+        for (size_t i = 0; i < slaveCount; i++) {
+            if (slaves[i].slaveId == slaveId) {
+                return slaves[i].consecutiveFailures == 0;
+            }
+        }
+        return false;
+    }
+
+
+    void Process() {
+        master.Process();
+
+        uint32 now = master.GetTick();
+        for (size_t checked = 0; checked < groupCount && inFlight < MAX_IN_FLIGHT; checked++) {
+            size_t index = nextGroup;
+            nextGroup = (nextGroup + 1) % groupCount;
+
+            Group& group = groups[index];
+            Slave& slave = slaves[group.slaveIndex];
+            if (group.inFlight || static_cast<int32>(now - group.nextDue) < 0) {
+                continue;
+            }
+            if (slave.consecutiveFailures != 0 && static_cast<int32>(now - slave.retryAt) < 0) {
+                continue;
+            }
+
+            if (!Poll(index)) {
+                break;  // Master queue is full, try again on the next call
+            }
+
+            // Keep the phase, but do not burst to catch up after a stall
+            group.nextDue += group.period;
+            if (static_cast<int32>(now - group.nextDue) >= 0) {
+                group.nextDue = now + group.period;
+            }
+        }
+    }
+
+
+private:
+    Slave* FindSlave(uint8 slaveId) {
+        for (size_t i = 0; i < slaveCount; i++) {
+            if (slaves[i].slaveId == slaveId) {
+                return &slaves[i];
+            }
+        }
+        return nullptr;
+    }
+
+
+    ResultStatus AddGroup(uint8 slaveId, ModbusFunction function, uint16 address, std::span<bool> bits,
+                          std::span<uint16> registers, uint32 period, UpdateCallback callback) {
+        if (slaveId == 0) {
+            return ResultStatus::invalidParameter;  // Broadcasts have no response to poll
+        }
+        if (groupCount == MaxGroups) {
+            return ResultStatus::filled;
+        }
+
+        Slave* slave = FindSlave(slaveId);
+        if (!slave) {
+            if (slaveCount == MaxSlaves) {
+                return ResultStatus::filled;
+            }
+            slave = &slaves[slaveCount++];
+            *slave = Slave();
+            slave->slaveId = slaveId;
+        }
+
+        Group& group = groups[groupCount++];
+        group = Group();
+        group.slaveIndex = static_cast<uint8>(slave - slaves.data());
+        group.function = function;
+        group.address = address;
+        group.bits = bits;
+        group.registers = registers;
+        group.period = period;
+        group.nextDue = master.GetTick();
+        group.onUpdate = std::move(callback);
+        return ResultStatus::ok;
+    }
+
+
+    bool Poll(size_t index) {
+        Group& group = groups[index];
+        Slave& slave = slaves[group.slaveIndex];
+
+        ModbusMaster::Request request;
+        request.slaveId = slave.slaveId;
+        request.function = group.function;
+        request.address = group.address;
+        request.timeout = slave.timeout;
+        request.bits = group.bits;
+        request.registers = group.registers;
+        request.onComplete = [this, index](const ModbusMaster::Completion& completion) {
+            OnComplete(index, completion);
+        };
+
+        if (master.Submit(std::move(request)) != ResultStatus::ok) {
+            return false;
+        }
+
+        group.inFlight = true;
+        inFlight++;
+        slave.statistics.requests++;
+        return true;
+    }
+
+
+    void OnComplete(size_t index, const ModbusMaster::Completion& completion) {
+        Group& group = groups[index];
+        Slave& slave = slaves[group.slaveIndex];
+        SlaveStatistics& statistics = slave.statistics;
+
+        group.inFlight = false;
+        inFlight--;
+
+        switch (completion.error) {
+            case ModbusError::Success:
+            case ModbusError::ExceptionResponse:
+                if (completion.error == ModbusError::ExceptionResponse) {
+                    statistics.exceptions++;
+                }
+                statistics.responses++;
+                RecordLatency(statistics, completion.latency);
+                slave.consecutiveFailures = 0;
+                break;
+
+            default:
+                if (completion.error == ModbusError::Timeout) {
+                    statistics.timeouts++;
+                } else if (completion.error == ModbusError::CrcError) {
+                    statistics.crcErrors++;
+                } else {
+                    statistics.invalidResponses++;
+                }
+
+                if (slave.consecutiveFailures < 31) {
+                    slave.consecutiveFailures++;
+                }
+                slave.retryAt = master.GetTick() + Backoff(slave.consecutiveFailures);
+                break;
+        }
+
+        if (group.onUpdate) {
+            group.onUpdate(slave.slaveId, group.address, completion.error);
+        }
+    }
+
+
+    uint32 Backoff(uint8 failures) const {
+        uint32 shift = failures - 1;
+        if (shift >= 31 || backoffInitial > (backoffMax >> shift)) {
+            return backoffMax;
+        }
+        return backoffInitial << shift;
+    }
+
+
+    static void RecordLatency(SlaveStatistics& statistics, uint32 latency) {
+        statistics.minLatency = std::min(statistics.minLatency, latency);
+        statistics.maxLatency = std::max(statistics.maxLatency, latency);
+        statistics.totalLatency += latency;
+
+        size_t bucket = std::min<size_t>(std::bit_width(latency), LATENCY_BUCKETS - 1);
+        statistics.latencyHistogram[bucket]++;
+    }
+};
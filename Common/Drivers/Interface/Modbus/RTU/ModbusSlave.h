@@ -1,687 +1,753 @@
-#pragma once
-
-#include <VHAL.h>
-#include <array>
-#include <span>
-#include <functional>
-#include <optional>
-
-/*
-Modbus RTU Slave implementation for embedded systems
-Responds to Modbus master requests and manages device data
-
-Basic setup:
-    ModbusSlave slave(1);  // Slave ID 1
-    slave.SetSendCallback([](std::span<const uint8> data) {
-        uart.SendData(data.data(), data.size());
-    });
-
-Data mapping:
-    std::array<bool, 100> coilData{};
-    std::array<bool, 50> inputData{};
-    std::array<uint16, 200> holdingRegs{};
-    std::array<uint16, 100> inputRegs{};
-    
-    slave.SetCoilData(std::span(coilData));
-    slave.SetDiscreteInputData(std::span(inputData));
-    slave.SetHoldingRegisterData(std::span(holdingRegs));
-    slave.SetInputRegisterData(std::span(inputRegs));
-
-Request processing:
-    void OnModbusData(std::span<const uint8> receivedData) {
-        slave.ProcessRequest(receivedData);
-    }
-
-Device control:
-    slave.SetCoilWriteCallback([](uint16 address, bool value) -> bool {
-        if (address == 100) {
-            SetOutputPin(value);
-            return true;  // Success
-        }
-        return false;  // Address not supported
-    });
-    
-    slave.SetRegisterWriteCallback([](uint16 address, uint16 value) -> bool {
-        if (address >= 200 && address < 210) {
-            SetDeviceParameter(address - 200, value);
-            return true;
-        }
-        return false;
-    });
-
-Sensor data provider:
-    ModbusSlave sensorSlave(2);
-    std::array<uint16, 10> sensorValues{};
-    
-    // Update sensor data periodically
-    void UpdateSensors() {
-        sensorValues[0] = GetTemperature() * 10;  // 0.1°C resolution
-        sensorValues[1] = GetHumidity() * 10;     // 0.1% resolution
-        sensorValues[2] = GetPressure();          // hPa
-    }
-
-Motor controller:
-    ModbusSlave motorController(3);
-    motorController.SetRegisterWriteCallback([](uint16 addr, uint16 value) -> bool {
-        switch (addr) {
-            case 100: SetMotorSpeed(value); return true;
-            case 101: SetMotorDirection(value); return true;
-            case 102: if (value) StartMotor(); else StopMotor(); return true;
-            default: return false;
-        }
-    });
-
-Address validation:
-    slave.SetAddressValidator([](uint16 address, uint16 quantity, DataType type) -> bool {
-        switch (type) {
-            case DataType::Coils:
-                return address < 1000 && (address + quantity) <= 1000;
-            case DataType::HoldingRegisters:
-                return address >= 100 && address < 500;
-            default:
-                return true;
-        }
-    });
-
-Custom exception handling:
-    slave.SetExceptionCallback([](ModbusException exception, uint16 address) {
-        System::console << "Modbus exception: " << (int)exception 
-                       << " at address: " << address << Console::endl;
-    });
-*/
-
-
-class ModbusSlave {
-public:
-	enum class ModbusException : uint8 {
-	    IllegalFunction = 0x01,
-	    IllegalDataAddress = 0x02,
-	    IllegalDataValue = 0x03,
-	    SlaveDeviceFailure = 0x04
-	};
-
-	enum class DataType : uint8 {
-	    Coils,
-	    DiscreteInputs,
-	    HoldingRegisters,
-	    InputRegisters
-	};
-
-
-private:
-    static constexpr size_t MAX_FRAME_SIZE = 256;
-    static constexpr uint16 CRC_INIT = 0xFFFF;
-    
-    uint8 slaveId;
-    std::function<void(std::span<const uint8>)> sendCallback;
-    std::function<bool(uint16, bool)> coilWriteCallback;
-    std::function<bool(uint16, uint16)> registerWriteCallback;
-    std::function<bool(uint16, uint16, DataType)> addressValidator;
-    std::function<void(ModbusException, uint16)> exceptionCallback;
-    
-    std::span<bool> coilData;
-    std::span<bool> discreteInputData;
-    std::span<uint16> holdingRegisterData;
-    std::span<uint16> inputRegisterData;
-
-
-public:
-    explicit ModbusSlave(uint8 slaveId) : slaveId(slaveId) {}
-    
-
-    void SetSendCallback(std::function<void(std::span<const uint8>)> callback) {
-        sendCallback = callback;
-    }
-    
-
-    void SetCoilWriteCallback(std::function<bool(uint16, bool)> callback) {
-        coilWriteCallback = callback;
-    }
-    
-
-    void SetRegisterWriteCallback(std::function<bool(uint16, uint16)> callback) {
-        registerWriteCallback = callback;
-    }
-    
-
-    void SetAddressValidator(std::function<bool(uint16, uint16, DataType)> validator) {
-        addressValidator = validator;
-    }
-    
-
-    void SetExceptionCallback(std::function<void(ModbusException, uint16)> callback) {
-        exceptionCallback = callback;
-    }
-    
-
-    void SetCoilData(std::span<bool> data) {
-        coilData = data;
-    }
-    
-
-    void SetDiscreteInputData(std::span<bool> data) {
-        discreteInputData = data;
-    }
-    
-
-    void SetHoldingRegisterData(std::span<uint16> data) {
-        holdingRegisterData = data;
-    }
-    
-
-    void SetInputRegisterData(std::span<uint16> data) {
-        inputRegisterData = data;
-    }
-    
-
-    void ProcessRequest(std::span<const uint8> request) {
-        if (request.size() < 4) return;
-        
-        uint8 receivedSlaveId = request[0];
-        uint8 functionCode = request[1];
-        
-        // Ignore if not for us (unless broadcast)
-        if (receivedSlaveId != slaveId && receivedSlaveId != 0) {
-            return;
-        }
-        
-        if (!ValidateRequest(request)) {
-            return; // Invalid CRC, ignore silently
-        }
-        
-        switch (static_cast<ModbusFunction>(functionCode)) {
-            case ModbusFunction::ReadCoils:
-                HandleReadCoils(request);
-                break;
-            case ModbusFunction::ReadDiscreteInputs:
-                HandleReadDiscreteInputs(request);
-                break;
-            case ModbusFunction::ReadHoldingRegisters:
-                HandleReadHoldingRegisters(request);
-                break;
-            case ModbusFunction::ReadInputRegisters:
-                HandleReadInputRegisters(request);
-                break;
-            case ModbusFunction::WriteSingleCoil:
-                HandleWriteSingleCoil(request);
-                break;
-            case ModbusFunction::WriteSingleRegister:
-                HandleWriteSingleRegister(request);
-                break;
-            case ModbusFunction::WriteMultipleCoils:
-                HandleWriteMultipleCoils(request);
-                break;
-            case ModbusFunction::WriteMultipleRegisters:
-                HandleWriteMultipleRegisters(request);
-                break;
-            default:
-                SendExceptionResponse(functionCode, ModbusException::IllegalFunction);
-                break;
-        }
-    }
-    
-
-    void SetCoil(uint16 address, bool value) {
-        if (address < coilData.size()) {
-            coilData[address] = value;
-        }
-    }
-    
-
-    bool GetCoil(uint16 address) const {
-        if (address < coilData.size()) {
-            return coilData[address];
-        }
-        return false;
-    }
-    
-
-    void SetRegister(uint16 address, uint16 value) {
-        if (address < holdingRegisterData.size()) {
-            holdingRegisterData[address] = value;
-        }
-    }
-    
-
-    uint16 GetRegister(uint16 address) const {
-        if (address < holdingRegisterData.size()) {
-            return holdingRegisterData[address];
-        }
-        return 0;
-    }
-
-private:
-    void HandleReadCoils(std::span<const uint8> request) {
-        if (request.size() < 8) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadCoils), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        uint16 startAddress = (request[2] << 8) | request[3];
-        uint16 quantity = (request[4] << 8) | request[5];
-        
-        if (quantity == 0 || quantity > 2000) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadCoils), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        if (addressValidator && !addressValidator(startAddress, quantity, DataType::Coils)) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadCoils), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        if (startAddress + quantity > coilData.size()) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadCoils), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        uint8 byteCount = (quantity + 7) / 8;
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        
-        response[0] = slaveId;
-        response[1] = static_cast<uint8>(ModbusFunction::ReadCoils);
-        response[2] = byteCount;
-        
-        // Pack coils into bytes
-        for (uint16 i = 0; i < quantity; ++i) {
-            if (coilData[startAddress + i]) {
-                response[3 + i / 8] |= (1 << (i % 8));
-            }
-        }
-        
-        size_t responseLength = 3 + byteCount;
-        uint16 crc = CalculateCrc(std::span(response.data(), responseLength));
-        response[responseLength] = crc & 0xFF;
-        response[responseLength + 1] = crc >> 8;
-        responseLength += 2;
-        
-        if (sendCallback) {
-            sendCallback(std::span(response.data(), responseLength));
-        }
-    }
-
-    
-    void HandleReadDiscreteInputs(std::span<const uint8> request) {
-        if (request.size() < 8) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadDiscreteInputs), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        uint16 startAddress = (request[2] << 8) | request[3];
-        uint16 quantity = (request[4] << 8) | request[5];
-        
-        if (quantity == 0 || quantity > 2000) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadDiscreteInputs), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        if (addressValidator && !addressValidator(startAddress, quantity, DataType::DiscreteInputs)) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadDiscreteInputs), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        if (startAddress + quantity > discreteInputData.size()) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadDiscreteInputs), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        uint8 byteCount = (quantity + 7) / 8;
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        
-        response[0] = slaveId;
-        response[1] = static_cast<uint8>(ModbusFunction::ReadDiscreteInputs);
-        response[2] = byteCount;
-        
-        // Pack inputs into bytes
-        for (uint16 i = 0; i < quantity; ++i) {
-            if (discreteInputData[startAddress + i]) {
-                response[3 + i / 8] |= (1 << (i % 8));
-            }
-        }
-        
-        size_t responseLength = 3 + byteCount;
-        uint16 crc = CalculateCrc(std::span(response.data(), responseLength));
-        response[responseLength] = crc & 0xFF;
-        response[responseLength + 1] = crc >> 8;
-        responseLength += 2;
-        
-        if (sendCallback) {
-            sendCallback(std::span(response.data(), responseLength));
-        }
-    }
-
-    
-    void HandleReadHoldingRegisters(std::span<const uint8> request) {
-        if (request.size() < 8) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadHoldingRegisters), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        uint16 startAddress = (request[2] << 8) | request[3];
-        uint16 quantity = (request[4] << 8) | request[5];
-        
-        if (quantity == 0 || quantity > 125) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadHoldingRegisters), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        if (addressValidator && !addressValidator(startAddress, quantity, DataType::HoldingRegisters)) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadHoldingRegisters), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        if (startAddress + quantity > holdingRegisterData.size()) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadHoldingRegisters), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        
-        response[0] = slaveId;
-        response[1] = static_cast<uint8>(ModbusFunction::ReadHoldingRegisters);
-        response[2] = quantity * 2;
-        
-        // Pack registers
-        for (uint16 i = 0; i < quantity; ++i) {
-            uint16 value = holdingRegisterData[startAddress + i];
-            response[3 + i * 2] = value >> 8;
-            response[4 + i * 2] = value & 0xFF;
-        }
-        
-        size_t responseLength = 3 + quantity * 2;
-        uint16 crc = CalculateCrc(std::span(response.data(), responseLength));
-        response[responseLength] = crc & 0xFF;
-        response[responseLength + 1] = crc >> 8;
-        responseLength += 2;
-        
-        if (sendCallback) {
-            sendCallback(std::span(response.data(), responseLength));
-        }
-    }
-    
-
-    void HandleReadInputRegisters(std::span<const uint8> request) {
-        if (request.size() < 8) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadInputRegisters), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        uint16 startAddress = (request[2] << 8) | request[3];
-        uint16 quantity = (request[4] << 8) | request[5];
-        
-        if (quantity == 0 || quantity > 125) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadInputRegisters), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        if (addressValidator && !addressValidator(startAddress, quantity, DataType::InputRegisters)) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadInputRegisters), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        if (startAddress + quantity > inputRegisterData.size()) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::ReadInputRegisters), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        std::array<uint8, MAX_FRAME_SIZE> response{};
-        
-        response[0] = slaveId;
-        response[1] = static_cast<uint8>(ModbusFunction::ReadInputRegisters);
-        response[2] = quantity * 2;
-        
-        // Pack registers
-        for (uint16 i = 0; i < quantity; ++i) {
-            uint16 value = inputRegisterData[startAddress + i];
-            response[3 + i * 2] = value >> 8;
-            response[4 + i * 2] = value & 0xFF;
-        }
-        
-        size_t responseLength = 3 + quantity * 2;
-        uint16 crc = CalculateCrc(std::span(response.data(), responseLength));
-        response[responseLength] = crc & 0xFF;
-        response[responseLength + 1] = crc >> 8;
-        responseLength += 2;
-        
-        if (sendCallback) {
-            sendCallback(std::span(response.data(), responseLength));
-        }
-    }
-    
-
-    void HandleWriteSingleCoil(std::span<const uint8> request) {
-        if (request.size() < 8) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteSingleCoil), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        uint16 address = (request[2] << 8) | request[3];
-        uint16 value = (request[4] << 8) | request[5];
-        
-        if (value != 0x0000 && value != 0xFF00) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteSingleCoil), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        bool coilValue = (value == 0xFF00);
-        
-        if (addressValidator && !addressValidator(address, 1, DataType::Coils)) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteSingleCoil), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        if (coilWriteCallback) {
-            if (!coilWriteCallback(address, coilValue)) {
-                SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteSingleCoil), ModbusException::SlaveDeviceFailure);
-                return;
-            }
-        } else if (address < coilData.size()) {
-            coilData[address] = coilValue;
-        } else {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteSingleCoil), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        // Echo back the request
-        if (sendCallback) {
-            sendCallback(request);
-        }
-    }
-
-    
-    void HandleWriteSingleRegister(std::span<const uint8> request) {
-        if (request.size() < 8) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteSingleRegister), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        uint16 address = (request[2] << 8) | request[3];
-        uint16 value = (request[4] << 8) | request[5];
-        
-        if (addressValidator && !addressValidator(address, 1, DataType::HoldingRegisters)) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteSingleRegister), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        if (registerWriteCallback) {
-            if (!registerWriteCallback(address, value)) {
-                SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteSingleRegister), ModbusException::SlaveDeviceFailure);
-                return;
-            }
-        } else if (address < holdingRegisterData.size()) {
-            holdingRegisterData[address] = value;
-        } else {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteSingleRegister), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        // Echo back the request
-        if (sendCallback) {
-            sendCallback(request);
-        }
-    }
-
-    
-    void HandleWriteMultipleCoils(std::span<const uint8> request) {
-        if (request.size() < 9) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleCoils), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        uint16 startAddress = (request[2] << 8) | request[3];
-        uint16 quantity = (request[4] << 8) | request[5];
-        uint8 byteCount = request[6];
-        
-        if (quantity == 0 || quantity > 1968 || byteCount != (quantity + 7) / 8) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleCoils), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        if (request.size() < 9 + byteCount) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleCoils), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        if (addressValidator && !addressValidator(startAddress, quantity, DataType::Coils)) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleCoils), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        // Write coils
-        for (uint16 i = 0; i < quantity; ++i) {
-            bool coilValue = (request[7 + i / 8] >> (i % 8)) & 1;
-            
-            if (coilWriteCallback) {
-                if (!coilWriteCallback(startAddress + i, coilValue)) {
-                    SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleCoils), ModbusException::SlaveDeviceFailure);
-                    return;
-                }
-            } else if (startAddress + i < coilData.size()) {
-                coilData[startAddress + i] = coilValue;
-            } else {
-                SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleCoils), ModbusException::IllegalDataAddress);
-                return;
-            }
-        }
-        
-        // Send response
-        std::array<uint8, 8> response{};
-        response[0] = slaveId;
-        response[1] = static_cast<uint8>(ModbusFunction::WriteMultipleCoils);
-        response[2] = startAddress >> 8;
-        response[3] = startAddress & 0xFF;
-        response[4] = quantity >> 8;
-        response[5] = quantity & 0xFF;
-        
-        uint16 crc = CalculateCrc(std::span(response.data(), 6));
-        response[6] = crc & 0xFF;
-        response[7] = crc >> 8;
-        
-        if (sendCallback) {
-            sendCallback(std::span(response));
-        }
-    }
-    
-
-    void HandleWriteMultipleRegisters(std::span<const uint8> request) {
-        if (request.size() < 9) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleRegisters), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        uint16 startAddress = (request[2] << 8) | request[3];
-        uint16 quantity = (request[4] << 8) | request[5];
-        uint8 byteCount = request[6];
-        
-        if (quantity == 0 || quantity > 123 || byteCount != quantity * 2) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleRegisters), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        if (request.size() < 9 + byteCount) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleRegisters), ModbusException::IllegalDataValue);
-            return;
-        }
-        
-        if (addressValidator && !addressValidator(startAddress, quantity, DataType::HoldingRegisters)) {
-            SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleRegisters), ModbusException::IllegalDataAddress);
-            return;
-        }
-        
-        // Write registers
-        for (uint16 i = 0; i < quantity; ++i) {
-            uint16 value = (request[7 + i * 2] << 8) | request[8 + i * 2];
-            
-            if (registerWriteCallback) {
-                if (!registerWriteCallback(startAddress + i, value)) {
-                    SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleRegisters), ModbusException::SlaveDeviceFailure);
-                    return;
-                }
-            } else if (startAddress + i < holdingRegisterData.size()) {
-                holdingRegisterData[startAddress + i] = value;
-            } else {
-                SendExceptionResponse(static_cast<uint8>(ModbusFunction::WriteMultipleRegisters), ModbusException::IllegalDataAddress);
-                return;
-            }
-        }
-        
-        // Send response
-        std::array<uint8, 8> response{};
-        response[0] = slaveId;
-        response[1] = static_cast<uint8>(ModbusFunction::WriteMultipleRegisters);
-        response[2] = startAddress >> 8;
-        response[3] = startAddress & 0xFF;
-        response[4] = quantity >> 8;
-        response[5] = quantity & 0xFF;
-        
-        uint16 crc = CalculateCrc(std::span(response.data(), 6));
-        response[6] = crc & 0xFF;
-        response[7] = crc >> 8;
-        
-        if (sendCallback) {
-            sendCallback(std::span(response));
-        }
-    }
-
-
-    uint16 CalculateCrc(std::span<const uint8> data) const {
-        uint16 crc = CRC_INIT;
-        for (uint8 byte : data) {
-            crc ^= byte;
-            for (int i = 0; i < 8; ++i) {
-                crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
-            }
-        }
-        return crc;
-    }
-    
-
-    bool ValidateRequest(std::span<const uint8> request) const {
-        if (request.size() < 4) return false;
-        
-        // Check CRC
-        uint16 receivedCrc = (request[request.size() - 1] << 8) | request[request.size() - 2];
-        uint16 calculatedCrc = CalculateCrc(request.subspan(0, request.size() - 2));
-        return receivedCrc == calculatedCrc;
-    }
-    
-
-    void SendExceptionResponse(uint8 functionCode, ModbusException exception) {
-        if (!sendCallback) return;
-        
-        std::array<uint8, 5> response{};
-        response[0] = slaveId;
-        response[1] = functionCode | 0x80;  // Set exception bit
-        response[2] = static_cast<uint8>(exception);
-        
-        uint16 crc = CalculateCrc(std::span(response.data(), 3));
-        response[3] = crc & 0xFF;
-        response[4] = crc >> 8;
-        
-        sendCallback(std::span(response));
-        
-        if (exceptionCallback) {
-            exceptionCallback(exception, 0);
-        }
-    }
-};
+#pragma once
+
+#include <VHAL.h>
+#include <Drivers/Interface/Modbus/Modbus.h>
+#include <array>
+#include <span>
+#include <functional>
+#include <optional>
+#include <algorithm>
+
+/*
+Modbus RTU Slave implementation for embedded systems
+Responds to Modbus master requests and manages device data
+
+Basic setup:
+    ModbusSlave slave(1);  // Slave ID 1
+    slave.SetSendCallback([](std::span<const uint8> data) {
+        uart.SendData(data.data(), data.size());
+    });
+
+Data mapping (coils and discrete inputs are bit-packed, item n is bit n % 8 of byte n / 8):
+    std::array<uint8, 100 / 8 + 1> coilData{};
+    std::array<uint8, 50 / 8 + 1> inputData{};
+    std::array<uint16, 200> holdingRegs{};
+    std::array<uint16, 100> inputRegs{};
+    
+    slave.SetCoilData(std::span(coilData), 100);
+    slave.SetDiscreteInputData(std::span(inputData), 50);
+    slave.SetHoldingRegisterData(std::span(holdingRegs));
+    slave.SetInputRegisterData(std::span(inputRegs));
+
+Request processing:
+    void OnModbusData(std::span<const uint8> receivedData) {
+        slave.ProcessRequest(receivedData);
+    }
+
+Zero-copy response (built straight in the DMA TX buffer, the send callback is not used):
+    size_t length = slave.ProcessRequest(receivedData, std::span(dmaTxBuffer));
+    if (length > 0) {
+        StartUartDma(dmaTxBuffer, length);
+    }
+
+Device control:
+    slave.SetCoilWriteCallback([](uint16 address, bool value) -> bool {
+        if (address == 100) {
+            SetOutputPin(value);
+            return true;  // Success
+        }
+        return false;  // Address not supported
+    });
+    
+    slave.SetRegisterWriteCallback([](uint16 address, uint16 value) -> bool {
+        if (address >= 200 && address < 210) {
+            SetDeviceParameter(address - 200, value);
+            return true;
+        }
+        return false;
+    });
+
+Sensor data provider:
+    ModbusSlave sensorSlave(2);
+    std::array<uint16, 10> sensorValues{};
+    
+    // Update sensor data periodically
+    void UpdateSensors() {
+        sensorValues[0] = GetTemperature() * 10;  // 0.1°C resolution
+        sensorValues[1] = GetHumidity() * 10;     // 0.1% resolution
+        sensorValues[2] = GetPressure();          // hPa
+    }
+
+Motor controller:
+    ModbusSlave motorController(3);
+    motorController.SetRegisterWriteCallback([](uint16 addr, uint16 value) -> bool {
+        switch (addr) {
+            case 100: SetMotorSpeed(value); return true;
+            case 101: SetMotorDirection(value); return true;
+            case 102: if (value) StartMotor(); else StopMotor(); return true;
+            default: return false;
+        }
+    });
+
+Register map (ranges resolved by binary search, one handler call per block and request):
+    std::array<uint16, 100> parameters{};
+    std::array<uint16, 8> status{};
+
+    const ModbusSlave::RegisterBlock holdingMap[] = {     // Sorted by address, no overlaps
+        { .address = 0, .count = 8, .data = status,
+          .onRead = [](uint16 address, std::span<uint16> values) { RefreshStatus(); return true; } },
+        { .address = 1000, .count = 100, .data = parameters,
+          .onWrite = [](uint16 address, std::span<const uint16> values) { return Validate(address, values); },
+          .atomic = true },       // The whole write lands in one critical section
+    };
+    slave.SetHoldingRegisterMap(holdingMap);
+
+Multi-writes through the coil / register write callbacks are applied one item at a time: when the
+callback rejects item i, items 0..i-1 stay written. The address validator sees the whole range before
+anything is written, and a register map writes all or nothing.
+
+Address validation:
+    slave.SetAddressValidator([](uint16 address, uint16 quantity, DataType type) -> bool {
+        switch (type) {
+            case DataType::Coils:
+                return address < 1000 && (address + quantity) <= 1000;
+            case DataType::HoldingRegisters:
+                return address >= 100 && address < 500;
+            default:
+                return true;
+        }
+    });
+
+Custom exception handling:
+    slave.SetExceptionCallback([](ModbusException exception, uint16 address) {
+        System::console << "Modbus exception: " << (int)exception 
+                       << " at address: " << address << Console::endl;
+    });
+*/
+
+
+class ModbusSlave {
+public:
+    using ModbusFunction = Modbus::Function;
+
+	enum class ModbusException : uint8 {
+	    IllegalFunction = 0x01,
+	    IllegalDataAddress = 0x02,
+	    IllegalDataValue = 0x03,
+	    SlaveDeviceFailure = 0x04
+	};
+
+	enum class DataType : uint8 {
+	    Coils,
+	    DiscreteInputs,
+	    HoldingRegisters,
+	    InputRegisters
+	};
+
+    // `address` is the first register of the part of the block a request touches
+    using BlockReadHandler = std::function<bool(uint16 address, std::span<uint16> values)>;
+    using BlockWriteHandler = std::function<bool(uint16 address, std::span<const uint16> values)>;
+
+    // `count` registers starting at `address`. A read calls onRead with the requested part of
+    // `data` to refresh it in place (or to fill a scratch buffer when there is no data), then
+    // sends it. A write is decoded first and offered to onWrite as a whole, returning false
+    // rejects it with nothing written; then it is copied into `data`, in one critical
+    // section if `atomic` is set so the control loop never sees half of it
+    struct RegisterBlock {
+        uint16 address = 0;
+        uint16 count = 0;
+        std::span<uint16> data;
+        BlockReadHandler onRead;
+        BlockWriteHandler onWrite;
+        bool atomic = false;
+    };
+
+
+private:
+    static constexpr size_t MAX_FRAME_SIZE = Modbus::MAX_FRAME_SIZE;
+    
+    uint8 slaveId;
+    std::function<void(std::span<const uint8>)> sendCallback;
+    std::function<bool(uint16, bool)> coilWriteCallback;
+    std::function<bool(uint16, uint16)> registerWriteCallback;
+    std::function<bool(uint16, uint16, DataType)> addressValidator;
+    std::function<void(ModbusException, uint16)> exceptionCallback;
+    
+    std::span<uint8> coilData;
+    std::span<uint8> discreteInputData;
+    uint16 coilCount = 0;
+    uint16 discreteInputCount = 0;
+    std::span<uint16> holdingRegisterData;
+    std::span<uint16> inputRegisterData;
+    std::span<const RegisterBlock> holdingRegisterMap;
+    std::span<const RegisterBlock> inputRegisterMap;
+
+    std::array<uint16, Modbus::MAX_READ_REGISTERS> registerScratch;    // Decoded writes, reads without backing data
+
+    std::array<uint8, MAX_FRAME_SIZE> txBuffer;     // Responses that go through the send callback
+
+
+public:
+    explicit ModbusSlave(uint8 slaveId) : slaveId(slaveId) {}
+
+
+    uint8 GetSlaveId() const {
+        return slaveId;
+    }
+    
+
+    void SetSendCallback(std::function<void(std::span<const uint8>)> callback) {
+        sendCallback = callback;
+    }
+    
+
+    void SetCoilWriteCallback(std::function<bool(uint16, bool)> callback) {
+        coilWriteCallback = callback;
+    }
+    
+
+    void SetRegisterWriteCallback(std::function<bool(uint16, uint16)> callback) {
+        registerWriteCallback = callback;
+    }
+    
+
+    void SetAddressValidator(std::function<bool(uint16, uint16, DataType)> validator) {
+        addressValidator = validator;
+    }
+    
+
+    void SetExceptionCallback(std::function<void(ModbusException, uint16)> callback) {
+        exceptionCallback = callback;
+    }
+    
+
+    // Bit-packed, `count` coils (all bits of data by default)
+    void SetCoilData(std::span<uint8> data, uint16 count = 0xFFFF) {
+        coilData = data;
+        coilCount = static_cast<uint16>(std::min<size_t>(count, data.size() * 8));
+    }
+    
+
+    void SetDiscreteInputData(std::span<uint8> data, uint16 count = 0xFFFF) {
+        discreteInputData = data;
+        discreteInputCount = static_cast<uint16>(std::min<size_t>(count, data.size() * 8));
+    }
+    
+
+    void SetHoldingRegisterData(std::span<uint16> data) {
+        holdingRegisterData = data;
+    }
+    
+
+    void SetInputRegisterData(std::span<uint16> data) {
+        inputRegisterData = data;
+    }
+
+
+    // Replaces SetHoldingRegisterData() and the per-register write callback. The table is
+    // not copied and has to be sorted by address without overlaps
+    ResultStatus SetHoldingRegisterMap(std::span<const RegisterBlock> map) {
+        if (!IsValidMap(map)) {
+            return ResultStatus::invalidParameter;
+        }
+        holdingRegisterMap = map;
+        return ResultStatus::ok;
+    }
+
+
+    // Input registers are read only, onWrite is never called
+    ResultStatus SetInputRegisterMap(std::span<const RegisterBlock> map) {
+        if (!IsValidMap(map)) {
+            return ResultStatus::invalidParameter;
+        }
+        inputRegisterMap = map;
+        return ResultStatus::ok;
+    }
+    
+
+    // Response goes through the send callback
+    void ProcessRequest(std::span<const uint8> request) {
+        size_t length = ProcessRequest(request, std::span(txBuffer));
+        if (length > 0 && sendCallback) {
+            sendCallback(std::span<const uint8>(txBuffer.data(), length));
+        }
+    }
+
+
+    // Builds the response directly in `response` (e.g. a DMA TX buffer, at least 8 bytes)
+    // and returns its length, 0 - nothing to send (not for us, broadcast or bad CRC)
+    size_t ProcessRequest(std::span<const uint8> request, std::span<uint8> response) {
+        if (request.size() < 4 || response.size() < 8) return 0;
+        
+        uint8 receivedSlaveId = request[0];
+        
+        // Ignore if not for us (unless broadcast)
+        if (receivedSlaveId != slaveId && receivedSlaveId != 0) {
+            return 0;
+        }
+        
+        if (!Modbus::CheckCrc(request)) {
+            return 0; // Invalid CRC, ignore silently
+        }
+
+        response[0] = slaveId;
+        size_t pduLength = ProcessPdu(
+            request.subspan(1, request.size() - 3),
+            response.subspan(1, std::min(response.size(), MAX_FRAME_SIZE) - 3)
+        );
+
+        // Broadcasts are executed but never answered
+        if (pduLength == 0 || receivedSlaveId == 0) {
+            return 0;
+        }
+        return Modbus::AppendCrc(response, 1 + pduLength);
+    }
+
+
+    // Protocol data unit (function code and data, no address and CRC), shared with other
+    // transports. `response` needs at least 5 bytes, returns the length of the response PDU
+    size_t ProcessPdu(std::span<const uint8> request, std::span<uint8> response) {
+        if (request.empty() || response.size() < 5) return 0;
+
+        uint8 functionCode = request[0];
+        switch (static_cast<ModbusFunction>(functionCode)) {
+            case ModbusFunction::ReadCoils:
+                return HandleReadBits(request, response, DataType::Coils, coilData, coilCount);
+            case ModbusFunction::ReadDiscreteInputs:
+                return HandleReadBits(request, response, DataType::DiscreteInputs, discreteInputData, discreteInputCount);
+            case ModbusFunction::ReadHoldingRegisters:
+                return HandleReadRegisters(request, response, DataType::HoldingRegisters, holdingRegisterData, holdingRegisterMap);
+            case ModbusFunction::ReadInputRegisters:
+                return HandleReadRegisters(request, response, DataType::InputRegisters, inputRegisterData, inputRegisterMap);
+            case ModbusFunction::WriteSingleCoil:
+                return HandleWriteSingleCoil(request, response);
+            case ModbusFunction::WriteSingleRegister:
+                return HandleWriteSingleRegister(request, response);
+            case ModbusFunction::WriteMultipleCoils:
+                return HandleWriteMultipleCoils(request, response);
+            case ModbusFunction::WriteMultipleRegisters:
+                return HandleWriteMultipleRegisters(request, response);
+            default:
+                return ExceptionResponse(response, functionCode, ModbusException::IllegalFunction, 0);
+        }
+    }
+    
+
+    void SetCoil(uint16 address, bool value) {
+        if (address < coilCount) {
+            uint8 mask = 1 << (address % 8);
+            coilData[address / 8] = value ? (coilData[address / 8] | mask) : (coilData[address / 8] & ~mask);
+        }
+    }
+    
+
+    bool GetCoil(uint16 address) const {
+        if (address < coilCount) {
+            return (coilData[address / 8] >> (address % 8)) & 1;
+        }
+        return false;
+    }
+    
+
+    void SetRegister(uint16 address, uint16 value) {
+        if (address < holdingRegisterData.size()) {
+            holdingRegisterData[address] = value;
+        }
+    }
+    
+
+    uint16 GetRegister(uint16 address) const {
+        if (address < holdingRegisterData.size()) {
+            return holdingRegisterData[address];
+        }
+        return 0;
+    }
+
+private:
+    static uint16 ReadUint16(std::span<const uint8> data, size_t offset) {
+        return (data[offset] << 8) | data[offset + 1];
+    }
+
+
+    static void WriteUint16(std::span<uint8> data, size_t offset, uint16 value) {
+        data[offset] = value >> 8;
+        data[offset + 1] = value & 0xFF;
+    }
+
+
+    size_t HandleReadBits(std::span<const uint8> request, std::span<uint8> response, DataType type,
+                          std::span<const uint8> store, uint16 count) {
+        uint8 functionCode = request[0];
+        if (request.size() < 5) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, 0);
+        }
+        
+        uint16 startAddress = ReadUint16(request, 1);
+        uint16 quantity = ReadUint16(request, 3);
+        
+        if (quantity == 0 || quantity > Modbus::MAX_READ_BITS) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, startAddress);
+        }
+        
+        if (addressValidator && !addressValidator(startAddress, quantity, type)) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, startAddress);
+        }
+        
+        if (startAddress + quantity > count) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, startAddress);
+        }
+        
+        uint8 byteCount = (quantity + 7) / 8;
+        if (response.size() < 2u + byteCount) {
+            return ExceptionResponse(response, functionCode, ModbusException::SlaveDeviceFailure, startAddress);
+        }
+
+        response[0] = functionCode;
+        response[1] = byteCount;
+        Modbus::PackBits(store, startAddress, response.data() + 2, quantity);
+        return 2 + byteCount;
+    }
+
+    
+    size_t HandleReadRegisters(std::span<const uint8> request, std::span<uint8> response, DataType type,
+                               std::span<const uint16> store, std::span<const RegisterBlock> map) {
+        uint8 functionCode = request[0];
+        if (request.size() < 5) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, 0);
+        }
+        
+        uint16 startAddress = ReadUint16(request, 1);
+        uint16 quantity = ReadUint16(request, 3);
+        
+        if (quantity == 0 || quantity > Modbus::MAX_READ_REGISTERS) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, startAddress);
+        }
+        
+        if (addressValidator && !addressValidator(startAddress, quantity, type)) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, startAddress);
+        }
+        
+        bool mapped = !map.empty();
+        if (mapped ? !IsMapped(map, startAddress, quantity) : startAddress + quantity > store.size()) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, startAddress);
+        }
+
+        if (response.size() < 2u + quantity * 2) {
+            return ExceptionResponse(response, functionCode, ModbusException::SlaveDeviceFailure, startAddress);
+        }
+        
+        response[0] = functionCode;
+        response[1] = quantity * 2;
+        uint8* destination = response.data() + 2;
+
+        if (!mapped) {
+            PackRegisters(store.subspan(startAddress, quantity), destination);
+            return 2 + quantity * 2;
+        }
+
+        bool success = ForEachBlock(map, startAddress, quantity,
+            [&](const RegisterBlock& block, uint16 blockOffset, uint16 requestOffset, uint16 count) {
+                std::span<uint16> values = block.data.empty()
+                    ? std::span<uint16>(registerScratch.data() + requestOffset, count)
+                    : block.data.subspan(blockOffset, count);
+
+                if (block.onRead && !block.onRead(block.address + blockOffset, values)) {
+                    return false;
+                }
+                PackRegisters(values, destination + requestOffset * 2);
+                return true;
+            });
+
+        if (!success) {
+            return ExceptionResponse(response, functionCode, ModbusException::SlaveDeviceFailure, startAddress);
+        }
+        return 2 + quantity * 2;
+    }
+    
+
+    size_t HandleWriteSingleCoil(std::span<const uint8> request, std::span<uint8> response) {
+        uint8 functionCode = request[0];
+        if (request.size() < 5) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, 0);
+        }
+        
+        uint16 address = ReadUint16(request, 1);
+        uint16 value = ReadUint16(request, 3);
+        
+        if (value != 0x0000 && value != 0xFF00) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, address);
+        }
+        
+        bool coilValue = (value == 0xFF00);
+        
+        if (addressValidator && !addressValidator(address, 1, DataType::Coils)) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, address);
+        }
+        
+        if (coilWriteCallback) {
+            if (!coilWriteCallback(address, coilValue)) {
+                return ExceptionResponse(response, functionCode, ModbusException::SlaveDeviceFailure, address);
+            }
+        } else if (address < coilCount) {
+            SetCoil(address, coilValue);
+        } else {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, address);
+        }
+        
+        // Echo back the request
+        return EchoResponse(request, response);
+    }
+
+    
+    size_t HandleWriteSingleRegister(std::span<const uint8> request, std::span<uint8> response) {
+        uint8 functionCode = request[0];
+        if (request.size() < 5) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, 0);
+        }
+        
+        uint16 address = ReadUint16(request, 1);
+        uint16 value = ReadUint16(request, 3);
+        
+        if (addressValidator && !addressValidator(address, 1, DataType::HoldingRegisters)) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, address);
+        }
+
+        if (!holdingRegisterMap.empty()) {
+            registerScratch[0] = value;
+            ModbusException exception;
+            if (!WriteToMap(address, 1, exception)) {
+                return ExceptionResponse(response, functionCode, exception, address);
+            }
+        } else if (registerWriteCallback) {
+            if (!registerWriteCallback(address, value)) {
+                return ExceptionResponse(response, functionCode, ModbusException::SlaveDeviceFailure, address);
+            }
+        } else if (address < holdingRegisterData.size()) {
+            holdingRegisterData[address] = value;
+        } else {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, address);
+        }
+        
+        // Echo back the request
+        return EchoResponse(request, response);
+    }
+
+    
+    size_t HandleWriteMultipleCoils(std::span<const uint8> request, std::span<uint8> response) {
+        uint8 functionCode = request[0];
+        if (request.size() < 6) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, 0);
+        }
+        
+        uint16 startAddress = ReadUint16(request, 1);
+        uint16 quantity = ReadUint16(request, 3);
+        uint8 byteCount = request[5];
+        
+        if (quantity == 0 || quantity > Modbus::MAX_WRITE_BITS || byteCount != (quantity + 7) / 8) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, startAddress);
+        }
+        
+        if (request.size() < 6u + byteCount) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, startAddress);
+        }
+        
+        if (addressValidator && !addressValidator(startAddress, quantity, DataType::Coils)) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, startAddress);
+        }
+        
+        const uint8* values = request.data() + 6;
+        if (coilWriteCallback) {
+            for (uint16 i = 0; i < quantity; ++i) {
+                bool coilValue = (values[i / 8] >> (i % 8)) & 1;
+                if (!coilWriteCallback(startAddress + i, coilValue)) {
+                    return ExceptionResponse(response, functionCode, ModbusException::SlaveDeviceFailure, startAddress + i);
+                }
+            }
+        } else if (startAddress + quantity <= coilCount) {
+            Modbus::UnpackBits(values, coilData, startAddress, quantity);
+        } else {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, startAddress);
+        }
+        
+        return WriteMultipleResponse(functionCode, startAddress, quantity, response);
+    }
+    
+
+    size_t HandleWriteMultipleRegisters(std::span<const uint8> request, std::span<uint8> response) {
+        uint8 functionCode = request[0];
+        if (request.size() < 6) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, 0);
+        }
+        
+        uint16 startAddress = ReadUint16(request, 1);
+        uint16 quantity = ReadUint16(request, 3);
+        uint8 byteCount = request[5];
+        
+        if (quantity == 0 || quantity > Modbus::MAX_WRITE_REGISTERS || byteCount != quantity * 2) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, startAddress);
+        }
+        
+        if (request.size() < 6u + byteCount) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataValue, startAddress);
+        }
+        
+        if (addressValidator && !addressValidator(startAddress, quantity, DataType::HoldingRegisters)) {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, startAddress);
+        }
+        
+        if (!holdingRegisterMap.empty()) {
+            for (uint16 i = 0; i < quantity; ++i) {
+                registerScratch[i] = ReadUint16(request, 6 + i * 2);
+            }
+            ModbusException exception;
+            if (!WriteToMap(startAddress, quantity, exception)) {
+                return ExceptionResponse(response, functionCode, exception, startAddress);
+            }
+        } else if (registerWriteCallback) {
+            for (uint16 i = 0; i < quantity; ++i) {
+                if (!registerWriteCallback(startAddress + i, ReadUint16(request, 6 + i * 2))) {
+                    return ExceptionResponse(response, functionCode, ModbusException::SlaveDeviceFailure, startAddress + i);
+                }
+            }
+        } else if (startAddress + quantity <= holdingRegisterData.size()) {
+            for (uint16 i = 0; i < quantity; ++i) {
+                holdingRegisterData[startAddress + i] = ReadUint16(request, 6 + i * 2);
+            }
+        } else {
+            return ExceptionResponse(response, functionCode, ModbusException::IllegalDataAddress, startAddress);
+        }
+        
+        return WriteMultipleResponse(functionCode, startAddress, quantity, response);
+    }
+
+
+    static void PackRegisters(std::span<const uint16> values, uint8* destination) {
+        for (size_t i = 0; i < values.size(); ++i) {
+            destination[i * 2] = values[i] >> 8;
+            destination[i * 2 + 1] = values[i] & 0xFF;
+        }
+    }
+
+
+    static bool IsValidMap(std::span<const RegisterBlock> map) {
+        uint32 end = 0;
+        for (const auto& block : map) {
+            if (block.count == 0 || block.address < end || block.address + block.count > 0x10000u) {
+                return false;
+            }
+            if (!block.data.empty() && block.data.size() < block.count) {
+                return false;
+            }
+            if (block.data.empty() && !block.onRead && !block.onWrite) {
+                return false;
+            }
+            end = block.address + block.count;
+        }
+        return true;
+    }
+
+
+    // Block containing `address`, binary search over the sorted table
+    static const RegisterBlock* FindBlock(std::span<const RegisterBlock> map, uint16 address) {
+        auto next = std::upper_bound(map.begin(), map.end(), address,
+            [](uint16 value, const RegisterBlock& block) { return value < block.address; });
+        if (next == map.begin()) {
+            return nullptr;
+        }
+
+        const RegisterBlock& block = *(next - 1);
+        return address - block.address < block.count ? &block : nullptr;
+    }
+
+
+    // Calls visit(block, blockOffset, requestOffset, count) for every block piece of
+    // [address, address + quantity), stops at the first gap or when visit returns false
+    template<typename Visitor>
+    static bool ForEachBlock(std::span<const RegisterBlock> map, uint16 address, uint16 quantity, Visitor&& visit) {
+        const RegisterBlock* block = FindBlock(map, address);
+        if (!block) {
+            return false;
+        }
+
+        uint16 done = 0;
+        while (true) {
+            uint16 blockOffset = address + done - block->address;
+            uint16 count = std::min<uint16>(quantity - done, block->count - blockOffset);
+            if (!visit(*block, blockOffset, done, count)) {
+                return false;
+            }
+
+            done += count;
+            if (done == quantity) {
+                return true;
+            }
+
+            // Ranges have to be contiguous, the next block must start right here
+            block++;
+            if (block == map.data() + map.size() || block->address != address + done) {
+                return false;
+            }
+        }
+    }
+
+
+    // A block with neither data nor onWrite is read-only, writes to it are not mapped
+    static bool IsMapped(std::span<const RegisterBlock> map, uint16 address, uint16 quantity, bool write = false) {
+        return ForEachBlock(map, address, quantity, [write](const RegisterBlock& block, uint16, uint16, uint16) {
+            return !write || !block.data.empty() || static_cast<bool>(block.onWrite);
+        });
+    }
+
+
+    // Values are decoded into registerScratch. All handlers see their part before anything is
+    // written, so a rejected request leaves every block untouched
+    bool WriteToMap(uint16 address, uint16 quantity, ModbusException& exception) {
+        if (!IsMapped(holdingRegisterMap, address, quantity, true)) {
+            exception = ModbusException::IllegalDataAddress;
+            return false;
+        }
+
+        bool atomic = false;
+        bool accepted = ForEachBlock(holdingRegisterMap, address, quantity,
+            [&](const RegisterBlock& block, uint16 blockOffset, uint16 requestOffset, uint16 count) {
+                atomic |= block.atomic;
+                std::span<const uint16> values(registerScratch.data() + requestOffset, count);
+                return !block.onWrite || block.onWrite(block.address + blockOffset, values);
+            });
+
+        if (!accepted) {
+            exception = ModbusException::SlaveDeviceFailure;
+            return false;
+        }
+
+        if (atomic) {
+            System::CriticalSection(true);
+        }
+        ForEachBlock(holdingRegisterMap, address, quantity,
+            [&](const RegisterBlock& block, uint16 blockOffset, uint16 requestOffset, uint16 count) {
+                if (!block.data.empty()) {
+                    std::copy_n(registerScratch.begin() + requestOffset, count, block.data.begin() + blockOffset);
+                }
+                return true;
+            });
+        if (atomic) {
+            System::CriticalSection(false);
+        }
+        return true;
+    }
+
+
+    static size_t EchoResponse(std::span<const uint8> request, std::span<uint8> response) {
+        std::copy_n(request.begin(), 5, response.begin());
+        return 5;
+    }
+
+
+    static size_t WriteMultipleResponse(uint8 functionCode, uint16 startAddress, uint16 quantity, std::span<uint8> response) {
+        response[0] = functionCode;
+        WriteUint16(response, 1, startAddress);
+        WriteUint16(response, 3, quantity);
+        return 5;
+    }
+    
+
+    size_t ExceptionResponse(std::span<uint8> response, uint8 functionCode, ModbusException exception, uint16 address) {
+        response[0] = functionCode | 0x80;  // Set exception bit
+        response[1] = static_cast<uint8>(exception);
+        
+        if (exceptionCallback) {
+            exceptionCallback(exception, address);
+        }
+        return 2;
+    }
+};
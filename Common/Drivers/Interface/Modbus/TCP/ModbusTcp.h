@@ -0,0 +1,117 @@
+#pragma once
+#include <VHAL.h>
+#include <Drivers/Interface/Modbus/Modbus.h>
+#include <array>
+#include <span>
+#include <cstring>
+
+/*
+Modbus TCP framing (MBAP header) shared by the TCP server and the RTU gateway
+
+ADU layout, all fields big-endian:
+    transactionId(2) protocolId(2, always 0) length(2, unit id + PDU) unitId(1) PDU
+
+A TCP connection is a byte stream, StreamFramer cuts it back into ADUs:
+    ModbusTcp::StreamFramer framer;
+    framer.Feed(receivedData, [](const ModbusTcp::MbapHeader& header, std::span<const uint8> pdu) {
+        // One complete request
+    });
+*/
+
+
+namespace ModbusTcp {
+    static constexpr uint16 DEFAULT_PORT = 502;
+    static constexpr size_t MBAP_HEADER_SIZE = 7;
+    static constexpr size_t MAX_ADU_SIZE = MBAP_HEADER_SIZE + Modbus::MAX_PDU_SIZE;
+
+    // Exception codes the gateway answers with itself
+    static constexpr uint8 ILLEGAL_FUNCTION = 0x01;
+    static constexpr uint8 GATEWAY_PATH_UNAVAILABLE = 0x0A;
+    static constexpr uint8 GATEWAY_TARGET_FAILED = 0x0B;
+
+    struct MbapHeader {
+        uint16 transactionId;
+        uint16 protocolId;
+        uint16 length;
+        uint8 unitId;
+    };
+
+
+    inline MbapHeader ReadHeader(const uint8* data) {
+        return {
+            static_cast<uint16>((data[0] << 8) | data[1]),
+            static_cast<uint16>((data[2] << 8) | data[3]),
+            static_cast<uint16>((data[4] << 8) | data[5]),
+            data[6]
+        };
+    }
+
+
+    // Writes the header for a PDU of `pduLength` bytes, returns the header size
+    inline size_t WriteHeader(uint8* data, uint16 transactionId, uint8 unitId, size_t pduLength) {
+        uint16 length = static_cast<uint16>(pduLength + 1);
+        data[0] = transactionId >> 8;
+        data[1] = transactionId & 0xFF;
+        data[2] = 0;
+        data[3] = 0;
+        data[4] = length >> 8;
+        data[5] = length & 0xFF;
+        data[6] = unitId;
+        return MBAP_HEADER_SIZE;
+    }
+
+
+    // Exception response PDU, returns its length
+    inline size_t WriteException(uint8* pdu, uint8 functionCode, uint8 exceptionCode) {
+        pdu[0] = functionCode | 0x80;
+        pdu[1] = exceptionCode;
+        return 2;
+    }
+
+
+    class StreamFramer {
+    private:
+        std::array<uint8, MAX_ADU_SIZE> buffer;
+        size_t length = 0;
+
+
+    public:
+        void Reset() {
+            length = 0;
+        }
+
+
+        // Calls handler(header, pdu) for every complete ADU. Returns false on a header that
+        // can not be Modbus (wrong protocol id or length), the stream is out of sync and
+        // the connection should be closed
+        template<typename Handler>
+        bool Feed(std::span<const uint8> data, Handler&& handler) {
+            while (!data.empty()) {
+                // Complete the header first, then the PDU it announces
+                size_t needed = MBAP_HEADER_SIZE;
+                if (length >= MBAP_HEADER_SIZE) {
+                    MbapHeader header = ReadHeader(buffer.data());
+                    needed = MBAP_HEADER_SIZE - 1 + header.length;
+                }
+
+                size_t count = std::min(data.size(), needed - length);
+                std::memcpy(buffer.data() + length, data.data(), count);
+                length += count;
+                data = data.subspan(count);
+
+                if (length == MBAP_HEADER_SIZE) {
+                    MbapHeader header = ReadHeader(buffer.data());
+                    if (header.protocolId != 0 || header.length < 2 || header.length > Modbus::MAX_PDU_SIZE + 1) {
+                        length = 0;
+                        return false;
+                    }
+                } else if (length > MBAP_HEADER_SIZE && length == needed) {
+                    MbapHeader header = ReadHeader(buffer.data());
+                    length = 0;
+                    handler(header, std::span<const uint8>(buffer.data() + MBAP_HEADER_SIZE, needed - MBAP_HEADER_SIZE));
+                }
+            }
+            return true;
+        }
+    };
+}
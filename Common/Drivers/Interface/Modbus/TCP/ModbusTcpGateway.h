@@ -0,0 +1,282 @@
+#pragma once
+#include <VHAL.h>
+#include <Drivers/Interface/Modbus/TCP/ModbusTcp.h>
+#include <Drivers/Interface/Modbus/RTU/ModbusMaster.h>
+#include <array>
+#include <span>
+#include <functional>
+#include <algorithm>
+
+/*
+Modbus TCP to RTU gateway: requests of any number of TCP clients are queued on the
+serial bus through the asynchronous ModbusMaster, the unit id selects the RTU slave
+
+    ModbusMaster bus(1);
+    bus.SetSendCallback(...);                   // RS-485
+    bus.SetBaudRate(115200);
+
+    ModbusTcpGateway<8> gateway(bus);
+    gateway.SetSendCallback([](uint8 connection, std::span<const uint8> data) {
+        tcp.Send(connection, data.data(), data.size());
+    });
+
+    void OnTcpData(uint8 connection, std::span<const uint8> data) {
+        gateway.DataReceived(connection, data);
+    }
+
+    void OnTcpClosed(uint8 connection) {
+        gateway.ConnectionClosed(connection);
+    }
+
+    void OnUartData(std::span<const uint8> data) {
+        bus.DataReceived(data);
+    }
+
+    // Main loop, drives the bus as well
+    gateway.Process();
+
+Request coalescing: a read that is byte for byte the same as one already waiting for the
+bus (same unit id and PDU) does not go to the bus again, the single RTU response is
+sent to every client that asked for it, each with its own transaction id.
+
+Failures are reported with the standard gateway exceptions: 0x0A (path unavailable)
+when the queue is full, 0x0B (target failed to respond) on timeout or a corrupted answer.
+*/
+
+
+template<size_t MaxConnections = 4, size_t MaxPending = 8, size_t MaxWaiters = 4>
+class ModbusTcpGateway {
+public:
+    using SendCallback = std::function<void(uint8 connection, std::span<const uint8> data)>;
+    using CloseCallback = std::function<void(uint8 connection)>;
+
+    struct Statistics {
+        uint32 requests = 0;            // ADUs received from TCP clients
+        uint32 forwarded = 0;           // Requests sent to the serial bus
+        uint32 coalesced = 0;           // Requests answered by another client's identical request
+        uint32 rejected = 0;            // Answered with a gateway exception
+    };
+
+
+private:
+    struct Waiter {
+        uint8 connection;
+        uint16 transactionId;
+    };
+
+    struct Pending {
+        bool used = false;
+        bool joinable = false;          // A read with no write to its unit queued after it
+        uint8 unitId = 0;
+        uint8 pduLength = 0;
+        std::array<uint8, Modbus::MAX_PDU_SIZE> pdu;
+        std::array<Waiter, MaxWaiters> waiters;
+        uint8 waiterCount = 0;
+    };
+
+    ModbusMaster& master;
+    SendCallback sendCallback;
+    CloseCallback closeCallback;
+    std::array<ModbusTcp::StreamFramer, MaxConnections> framers;
+    std::array<Pending, MaxPending> pending;
+    std::array<uint8, ModbusTcp::MAX_ADU_SIZE> txBuffer;
+    uint32 timeout = 0;
+    Statistics statistics;
+
+
+public:
+    explicit ModbusTcpGateway(ModbusMaster& master) : master(master) {}
+
+
+    void SetSendCallback(SendCallback callback) {
+        sendCallback = callback;
+    }
+
+
+    // Called when a client sends something that is not Modbus TCP
+    void SetCloseCallback(CloseCallback callback) {
+        closeCallback = callback;
+    }
+
+
+    // Serial response timeout, 0 - master timeout
+    void SetTimeout(uint32 timeout) {
+        this->timeout = timeout;
+    }
+
+
+    const Statistics& GetStatistics() const {
+        return statistics;
+    }
+
+
+    void DataReceived(uint8 connection, std::span<const uint8> data) {
+        if (connection >= MaxConnections) {
+            return;
+        }
+
+        bool valid = framers[connection].Feed(data, [this, connection](const ModbusTcp::MbapHeader& header, std::span<const uint8> pdu) {
+            HandleRequest(connection, header, pdu);
+        });
+
+        if (!valid && closeCallback) {
+            closeCallback(connection);
+        }
+    }
+
+
+    // Answers that are still on the bus are dropped for this connection
+    void ConnectionClosed(uint8 connection) {
+        if (connection >= MaxConnections) {
+            return;
+        }
+
+        framers[connection].Reset();
+        for (auto& entry : pending) {
+            auto end = std::remove_if(entry.waiters.begin(), entry.waiters.begin() + entry.waiterCount,
+                [connection](const Waiter& waiter) { return waiter.connection == connection; });
+            entry.waiterCount = static_cast<uint8>(end - entry.waiters.begin());
+        }
+    }
+
+
+    void Process() {
+        master.Process();
+    }
+
+
+private:
+    static bool IsRead(uint8 functionCode) {
+        return functionCode >= static_cast<uint8>(Modbus::Function::ReadCoils) &&
+               functionCode <= static_cast<uint8>(Modbus::Function::ReadInputRegisters);
+    }
+
+
+    static bool IsSupported(uint8 functionCode) {
+        switch (static_cast<Modbus::Function>(functionCode)) {
+            case Modbus::Function::ReadCoils:
+            case Modbus::Function::ReadDiscreteInputs:
+            case Modbus::Function::ReadHoldingRegisters:
+            case Modbus::Function::ReadInputRegisters:
+            case Modbus::Function::WriteSingleCoil:
+            case Modbus::Function::WriteSingleRegister:
+            case Modbus::Function::WriteMultipleCoils:
+            case Modbus::Function::WriteMultipleRegisters:
+                return true;
+            default:
+                return false;  // The master can only tell the response length of these
+        }
+    }
+
+
+    void HandleRequest(uint8 connection, const ModbusTcp::MbapHeader& header, std::span<const uint8> pdu) {
+        statistics.requests++;
+        Waiter waiter{ connection, header.transactionId };
+        uint8 functionCode = pdu[0];
+
+        if (!IsSupported(functionCode)) {
+            SendException(waiter, header.unitId, functionCode, ModbusTcp::ILLEGAL_FUNCTION);
+            return;
+        }
+
+        // Same read already waiting for the bus: share its answer
+        if (IsRead(functionCode)) {
+            for (auto& entry : pending) {
+                if (entry.used && entry.joinable && entry.unitId == header.unitId && entry.waiterCount < MaxWaiters &&
+                    entry.pduLength == pdu.size() && std::equal(pdu.begin(), pdu.end(), entry.pdu.begin())) {
+                    entry.waiters[entry.waiterCount++] = waiter;
+                    statistics.coalesced++;
+                    return;
+                }
+            }
+        }
+
+        auto free = std::find_if(pending.begin(), pending.end(), [](const Pending& entry) { return !entry.used; });
+        if (free == pending.end()) {
+            SendException(waiter, header.unitId, functionCode, ModbusTcp::GATEWAY_PATH_UNAVAILABLE);
+            return;
+        }
+
+        size_t index = free - pending.begin();
+        Pending& entry = *free;
+        entry.unitId = header.unitId;
+        entry.pduLength = static_cast<uint8>(pdu.size());
+        std::copy(pdu.begin(), pdu.end(), entry.pdu.begin());
+        entry.waiters[0] = waiter;
+        entry.waiterCount = 1;
+
+        ModbusMaster::Request request;
+        request.slaveId = header.unitId;
+        request.pdu = std::span<const uint8>(entry.pdu.data(), entry.pduLength);
+        request.timeout = timeout;
+        request.onComplete = [this, index](const ModbusMaster::Completion& completion) {
+            OnComplete(index, completion);
+        };
+
+        if (master.Submit(std::move(request)) != ResultStatus::ok) {
+            SendException(waiter, header.unitId, functionCode, ModbusTcp::GATEWAY_PATH_UNAVAILABLE);
+            return;
+        }
+
+        // A later read must not share the answer of a read the bus runs before this write
+        if (!IsRead(functionCode)) {
+            for (auto& other : pending) {
+                if (other.used && (other.unitId == header.unitId || header.unitId == 0)) {
+                    other.joinable = false;
+                }
+            }
+        }
+
+        entry.used = true;
+        entry.joinable = IsRead(functionCode);
+        statistics.forwarded++;
+    }
+
+
+    void OnComplete(size_t index, const ModbusMaster::Completion& completion) {
+        Pending& entry = pending[index];
+
+        // Copy the waiters out before freeing the slot: a transport that feeds data back from
+        // sendCallback can claim the slot or drop waiters while they are answered
+        std::array<Waiter, MaxWaiters> waiters = entry.waiters;
+        uint8 waiterCount = entry.waiterCount;
+        uint8 unitId = entry.unitId;
+        uint8 functionCode = entry.pdu[0];
+        entry.waiterCount = 0;
+        entry.used = false;
+
+        bool answered = completion.error == ModbusMaster::ModbusError::Success ||
+                        completion.error == ModbusMaster::ModbusError::ExceptionResponse;
+        for (uint8 i = 0; i < waiterCount; i++) {
+            if (!answered) {
+                SendException(waiters[i], unitId, functionCode, ModbusTcp::GATEWAY_TARGET_FAILED);
+            } else if (!completion.response.empty()) {
+                SendResponse(waiters[i], unitId, completion.response);
+            }
+            // Broadcasts complete without a response, there is nothing to forward
+        }
+    }
+
+
+    void SendResponse(const Waiter& waiter, uint8 unitId, std::span<const uint8> pdu) {
+        if (!sendCallback) {
+            return;
+        }
+
+        ModbusTcp::WriteHeader(txBuffer.data(), waiter.transactionId, unitId, pdu.size());
+        std::copy(pdu.begin(), pdu.end(), txBuffer.begin() + ModbusTcp::MBAP_HEADER_SIZE);
+        sendCallback(waiter.connection, std::span<const uint8>(txBuffer.data(), ModbusTcp::MBAP_HEADER_SIZE + pdu.size()));
+    }
+
+
+    void SendException(const Waiter& waiter, uint8 unitId, uint8 functionCode, uint8 exceptionCode) {
+        statistics.rejected++;
+        if (!sendCallback) {
+            return;
+        }
+
+        size_t pduLength = ModbusTcp::WriteException(txBuffer.data() + ModbusTcp::MBAP_HEADER_SIZE, functionCode, exceptionCode);
+        ModbusTcp::WriteHeader(txBuffer.data(), waiter.transactionId, unitId, pduLength);
+        sendCallback(waiter.connection, std::span<const uint8>(txBuffer.data(), ModbusTcp::MBAP_HEADER_SIZE + pduLength));
+    }
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <VHAL.h>
+#include <Drivers/Interface/Modbus/TCP/ModbusTcp.h>
+#include <Drivers/Interface/Modbus/RTU/ModbusSlave.h>
+#include <array>
+#include <span>
+#include <functional>
+
+/*
+Modbus TCP server on top of a ModbusSlave: the same register maps, write callbacks
+and address validator serve RTU and TCP at the same time
+
+The socket layer is not part of the class, it only needs connection numbers:
+    ModbusSlave slave(1);
+    slave.SetHoldingRegisterData(std::span(holdingRegs));
+
+    ModbusTcpServer<4> server(slave);
+    server.SetSendCallback([](uint8 connection, std::span<const uint8> data) {
+        tcp.Send(connection, data.data(), data.size());
+    });
+
+    // Socket events
+    void OnTcpData(uint8 connection, std::span<const uint8> data) {
+        server.DataReceived(connection, data);
+    }
+
+    void OnTcpClosed(uint8 connection) {
+        server.ConnectionClosed(connection);
+    }
+
+Clients may pipeline requests, every response carries the transaction id of its request.
+Requests are answered for the slave's own unit id, 0 and 0xFF.
+*/
+
+
+template<size_t MaxConnections = 4>
+class ModbusTcpServer {
+public:
+    using SendCallback = std::function<void(uint8 connection, std::span<const uint8> data)>;
+    using CloseCallback = std::function<void(uint8 connection)>;
+
+
+private:
+    ModbusSlave& slave;
+    SendCallback sendCallback;
+    CloseCallback closeCallback;
+    std::array<ModbusTcp::StreamFramer, MaxConnections> framers;
+    std::array<uint8, ModbusTcp::MAX_ADU_SIZE> txBuffer;
+
+
+public:
+    explicit ModbusTcpServer(ModbusSlave& slave) : slave(slave) {}
+
+
+    void SetSendCallback(SendCallback callback) {
+        sendCallback = callback;
+    }
+
+
+    // Called when a client sends something that is not Modbus TCP
+    void SetCloseCallback(CloseCallback callback) {
+        closeCallback = callback;
+    }
+
+
+    void DataReceived(uint8 connection, std::span<const uint8> data) {
+        if (connection >= MaxConnections) {
+            return;
+        }
+
+        bool valid = framers[connection].Feed(data, [this, connection](const ModbusTcp::MbapHeader& header, std::span<const uint8> pdu) {
+            HandleRequest(connection, header, pdu);
+        });
+
+        if (!valid && closeCallback) {
+            closeCallback(connection);
+        }
+    }
+
+
+    void ConnectionClosed(uint8 connection) {
+        if (connection < MaxConnections) {
+            framers[connection].Reset();
+        }
+    }
+
+
+private:
+    void HandleRequest(uint8 connection, const ModbusTcp::MbapHeader& header, std::span<const uint8> pdu) {
+        if (header.unitId != slave.GetSlaveId() && header.unitId != 0 && header.unitId != 0xFF) {
+            return;
+        }
+
+        std::span<uint8> responsePdu(txBuffer.data() + ModbusTcp::MBAP_HEADER_SIZE, Modbus::MAX_PDU_SIZE);
+        size_t pduLength = slave.ProcessPdu(pdu, responsePdu);
+        if (pduLength == 0 || !sendCallback) {
+            return;
+        }
+
+        ModbusTcp::WriteHeader(txBuffer.data(), header.transactionId, header.unitId, pduLength);
+        sendCallback(connection, std::span<const uint8>(txBuffer.data(), ModbusTcp::MBAP_HEADER_SIZE + pduLength));
+    }
+};
@@ -103,7 +103,7 @@ protected:
         memcpy(encodedBuffer + sizeof(address) + sizeof(dataSize), data, length);
 
         // CRC
-        uint16 crc = Crc::Calculate(encodedBuffer, sizeof(address) + sizeof(dataSize) + length, Crc::CRC_16_USB());
+        uint16 crc = Crc::Calculate(encodedBuffer, sizeof(address) + sizeof(dataSize) + length, Crc::StaticTable<Crc::CRC_16_USB>);
         memcpy(encodedBuffer + sizeof(address) + sizeof(dataSize) + length, &crc, sizeof(crc));
 
         auto encode = cobs.Encode(encodedBuffer, sizeof(address) + sizeof(dataSize) + length + sizeof(crc), encodedBuffer, encodedBufferSize);
@@ -130,7 +130,7 @@ protected:
         }
 
         auto crc = ByteConverter::GetType<uint16>(decodedBuffer[decode.Value() - 2]);
-        if(Crc::Calculate(decodedBuffer, decode.Value() - 2, Crc::CRC_16_USB()) != crc) {
+        if(Crc::Calculate(decodedBuffer, decode.Value() - 2, Crc::StaticTable<Crc::CRC_16_USB>) != crc) {
             return ResultStatus::crcError;
 
         }
@@ -30,6 +30,8 @@ private:
     };
 
     static constexpr size_t maxEncodedSize = MaxPacketSize + MaxPacketSize / 254 + 3;
+    static constexpr size_t headerSize = 9;     // type, address, packetId, dataSize
+    static constexpr size_t maxDecodedSize = headerSize + MaxPacketSize + sizeof(uint16);
 
     struct AckInfo {
         uint32 id;
@@ -43,8 +45,9 @@ private:
     OS::MailBox<AckInfo, AckMailCount> ackMail;
     OS::Mutex writeMutex;
 
-    uint8 rxBuffer[maxEncodedSize];
-    size_t rxBufferCounter = 0;
+    // Frames are decoded byte by byte as they arrive
+    uint8 rxBuffer[maxDecodedSize];
+    COBS<>::Decoder decoder;
     uint32 currentPacketId = 0;
 
     uint8* readBuffer;
@@ -58,7 +61,7 @@ public:
     //      escape byte     = 0xFE
     //      escaped start   = 0x01
     //      escaped stop    = 0x02 
-    ReliableProtocolCOBS() : cobs({0xFF, 0x00, 0xFE, 0x01, 0x02}), writeMutex() {}
+    ReliableProtocolCOBS() : cobs({0xFF, 0x00, 0xFE, 0x01, 0x02}), writeMutex(), decoder(cobs.GetConfig(), std::span(rxBuffer)) {}
 
 
     inline void RxEvent(uint8 byte) {
@@ -71,15 +74,8 @@ public:
         if (!byteMail.Get(byte, mailTimeOut)) {
             return;
         }
-        if (byte == cobs.GetConfig().startByte || rxBufferCounter >= maxEncodedSize) {
-            rxBufferCounter = 0;
-        }
-
-        rxBuffer[rxBufferCounter++] = byte;
-
-        if (byte == cobs.GetConfig().stopByte) {
-            ProcessReceivedPacket();
-            rxBufferCounter = 0;
+        if (decoder.Put(byte)) {
+            ProcessReceivedPacket(decoder.GetFrame().size());
         }
     }
 
@@ -174,37 +170,35 @@ private:
     }
 
 
+    // The pieces go straight into the encoder, the packet is never assembled unencoded
     Result<size_t> EncodePacket(PacketType type, uint16 address, uint32 packetId, const uint8* data, size_t length, uint8* encodedBuffer, size_t encodedBufferSize) {
-        // type
-        encodedBuffer[0] = static_cast<uint8>(type); 
-
-        // address
-        memcpy(encodedBuffer + 1, &address, sizeof(address));
-
-        // packetId
-        memcpy(encodedBuffer + 1 + sizeof(address), &packetId, sizeof(packetId));
-
-        // dataSize
+        uint8 header[headerSize];
         uint16 dataSize = static_cast<uint16>(length);
-        memcpy(encodedBuffer + 1 + sizeof(address) + sizeof(packetId), &dataSize, sizeof(dataSize));
+        header[0] = static_cast<uint8>(type);
+        memcpy(header + 1, &address, sizeof(address));
+        memcpy(header + 1 + sizeof(address), &packetId, sizeof(packetId));
+        memcpy(header + 1 + sizeof(address) + sizeof(packetId), &dataSize, sizeof(dataSize));
+
+        COBS<>::Encoder encoder(cobs.GetConfig(), std::span(encodedBuffer, encodedBufferSize));
+        encoder.Write(header);
+        uint16 crc = Crc::Calculate(header, headerSize, Crc::StaticTable<Crc::CRC_16_XMODEM>);
 
-        // data
         if (data != nullptr && dataSize != 0) {
-            memcpy(encodedBuffer + 1 + sizeof(address) + sizeof(packetId) + sizeof(dataSize), data, length);
+            encoder.Write(std::span(data, length));
+            crc = Crc::Calculate(data, length, Crc::StaticTable<Crc::CRC_16_XMODEM>, crc);
         }
 
-        // CRC
-        uint16 crc = Crc::Calculate(encodedBuffer, 1 + sizeof(address) + sizeof(packetId) + sizeof(dataSize) + length, Crc::CRC_16_XMODEM());
-        memcpy(encodedBuffer + 1 + sizeof(address) + sizeof(packetId) + sizeof(dataSize) + length, &crc, sizeof(crc));
-
-        return cobs.Encode(encodedBuffer, 1 + sizeof(address) + sizeof(packetId) + sizeof(dataSize) + length + sizeof(crc), encodedBuffer, encodedBufferSize);
+        uint8 crcBytes[sizeof(crc)];
+        memcpy(crcBytes, &crc, sizeof(crc));
+        encoder.Write(crcBytes);
+        return encoder.Finish();
     }
 
 
-    void ProcessReceivedPacket() {
-        uint8 decodedBuffer[MaxPacketSize];
-        auto result = cobs.Decode(rxBuffer, rxBufferCounter, decodedBuffer, MaxPacketSize);
-        if (!result.IsOk() || result.Value() < 9) {
+    // The decoded packet is in rxBuffer
+    void ProcessReceivedPacket(size_t length) {
+        uint8* decodedBuffer = rxBuffer;
+        if (length < headerSize + sizeof(uint16)) {
             return;
         }
 
@@ -213,9 +207,12 @@ private:
         auto packetId = ByteConverter::GetType<uint32>(&decodedBuffer[3]);
         auto size = ByteConverter::GetType<uint16>(&decodedBuffer[7]);
         const uint8* data = decodedBuffer + 9;
+        if (length < headerSize + size + sizeof(uint16)) {
+            return;
+        }
 
         uint16 crc = ByteConverter::GetType<uint16>(&decodedBuffer[9 + size]);
-        if (Crc::Calculate(decodedBuffer, 9 + size, Crc::CRC_16_XMODEM()) != crc) {
+        if (Crc::Calculate(decodedBuffer, 9 + size, Crc::StaticTable<Crc::CRC_16_XMODEM>) != crc) {
             return; // CRC error
         }
 
@@ -158,9 +158,7 @@ public:
 
     // Receive data from transport
     void DataReceived(std::span<const uint8> data) {
-        for (uint8 byte : data) {
-            receiveBuffer.Push(byte);
-        }
+        receiveBuffer.PushMultiple(data);
         ProcessIncoming();
     }
 
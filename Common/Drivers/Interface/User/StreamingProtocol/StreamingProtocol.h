@@ -9,6 +9,8 @@
 #include <cstring>
 #include <algorithm>
 #include <functional>
+#include <bit>
+#include <type_traits>
 
 
 /**
@@ -17,6 +19,9 @@
  * Features:
  * - Push-based data reception (call DataReceived() when data arrives)
  * - Automatic fragmentation for large messages
+ * - Selective-repeat sliding window: up to WindowSize fragments in flight,
+ *   cumulative + selective (bitmap) ACKs, per-fragment retransmit timers
+ * - Out-of-order fragments are reassembled, the data callback always sees fragments in order
  * - ACK/NACK reliability with configurable retries
  * - CRC16 error detection
  * - No dynamic memory allocation
@@ -59,15 +64,16 @@
  * );
  * auto result = protocol.Send(data);
 */
-template<size_t MaxPacketSize = 32, size_t MaxPacketCount = 4>
+template<size_t MaxPacketSize = 32, size_t MaxPacketCount = 4, size_t WindowSize = 8>
 class StreamingProtocol {
 public:
     enum class PacketType : uint8 {
         SingleData = 0x01,     // Single data packet
         FragmentData = 0x02,   // Data fragment
         Ack = 0x03,            // Acknowledgment
-        Nack = 0x04,           // Negative acknowledgment
-        SingleNoAck = 0x05     // Single packet without acknowledgment
+        Nack = 0x04,           // Negative acknowledgment, fragment should be resent
+        SingleNoAck = 0x05,    // Single packet without acknowledgment
+        Reject = 0x06          // Receiver rejected the stream
     };
 
     enum class StreamResult : uint8 {
@@ -83,6 +89,8 @@ public:
         uint16 payloadSize;
 
         // Fields for fragmentation (used only when type == FRAGMENT_DATA)
+        // Ack: fragmentIndex is the cumulative ACK (all fragments below it were delivered),
+        // the payload is a uint32 bitmap, bit i = fragment fragmentIndex + 1 + i was received
         uint32 streamId;       // Data stream ID
         uint16 totalFragments; // Total number of fragments
         uint16 fragmentIndex;  // Current fragment index (0-based)
@@ -97,11 +105,13 @@ public:
     struct SendOptions {
         uint8 maxRetries = 3;
         bool retryOnError = true;
+        uint32 ackTimeout = 1000;  // Process() calls before an unacknowledged fragment is resent
 
         constexpr SendOptions() = default;
-        constexpr SendOptions(uint8 retries, bool onError = true)
+        constexpr SendOptions(uint8 retries, bool onError = true, uint32 timeout = 1000)
             : maxRetries(retries),
-			  retryOnError(onError)
+			  retryOnError(onError),
+			  ackTimeout(timeout)
         {}
     };
 
@@ -125,11 +135,23 @@ protected:
     static constexpr size_t MAX_PAYLOAD_SIZE = MaxPacketSize - sizeof(PacketHeader) - sizeof(uint16);
     static constexpr size_t BUFFER_SIZE = MaxPacketSize * MaxPacketCount;
 
+    // DataReceived() is the only writer and reader of the receive buffer, so the
+    // lock-free SPSC buffer is used whenever its power of two size allows it
+    using ReceiveBufferPolicy = std::conditional_t<
+        std::has_single_bit(BUFFER_SIZE),
+        RingBufferPolicy::SPSC,
+        RingBufferPolicy::CriticalSection
+    >;
+
 
 public:
     static_assert(
-        MaxPacketSize >= sizeof(PacketHeader) + 1 + sizeof(uint16),
-        "MaxPacketSize must be at least header + 1 byte payload + CRC16"
+        MaxPacketSize >= sizeof(PacketHeader) + sizeof(uint32) + sizeof(uint16),
+        "MaxPacketSize must be at least header + ACK bitmap + CRC16"
+    );
+    static_assert(
+        WindowSize >= 1 && WindowSize <= 33,
+        "WindowSize must be 1..33 (the selective ACK bitmap covers 32 fragments past the cumulative ACK)"
     );
 
     StreamingProtocol() = default;
@@ -152,19 +174,23 @@ public:
         }
         
         // Сохраняем ссылку на данные и начинаем streaming
+        size_t totalFragments = (data.size() + MAX_PAYLOAD_SIZE - 1) / MAX_PAYLOAD_SIZE;
+        if (totalFragments > UINT16_MAX) {
+            return {SendStatus::BufferFull, 0, 0};
+        }
+
         currentDataSpan = data;
-        currentSentBytes = 0;
+        currentOptions = options;
         currentStreamIdSending = currentStreamId++;
+        totalFragmentsSending = static_cast<uint16>(totalFragments);
+        windowBase = 0;
+        nextFragment = 0;
         isBusy = true;
-        waitingForAck = false;
-        
-        // Вычисляем количество фрагментов
-        size_t totalFragments = (data.size() + MAX_PAYLOAD_SIZE - 1) / MAX_PAYLOAD_SIZE;
         
-        // Отправляем первый пакет сразу, не ждем Process()
-        SendNextStreamPacket();
+        // Отправляем первое окно сразу, не ждем Process()
+        FillWindow();
         
-        return {SendStatus::Success, currentStreamIdSending, static_cast<uint16>(totalFragments)};
+        return {SendStatus::Success, currentStreamIdSending, totalFragmentsSending};
     }
 
 
@@ -178,23 +204,29 @@ public:
     // Process outgoing packets (call in main loop)
     void Process() {
         processCounter++;
-        
+
+        // Control packets (ACK/NACK) first, the peer's window depends on them
+        FlushStreamAck();
+        do {
+            ProcessOutgoing();
+            HandleRetransmissions();
+        } while (!hasCurrentPendingPacket && !pendingPackets.IsEmpty());
+
         // Обрабатываем streaming отправку
-        if (isBusy && !waitingForAck) {
-            SendNextStreamPacket();
+        if (isBusy) {
+            CheckAckTimeouts();
         }
-        
-        ProcessOutgoing();
-        HandleRetransmissions();
+        if (isBusy) {
+            FillWindow();
+        }
+
         CheckStreamActivity();
     }
 
 
     // Receive data from external source (call when data received via UART/BLE/etc)
     void DataReceived(std::span<const uint8> data) {
-        for (uint8 byte : data) {
-            receiveBuffer.Push(byte);
-        }
+        receiveBuffer.PushMultiple(data);
         ProcessIncoming();
     }
     
@@ -205,11 +237,15 @@ public:
         // Clear receive state
         lastReceivedPacketNumber = 0xFFFF;  // Невозможное значение, чтобы первый пакет не был дубликатом
         receiveBuffer.Clear();
+        receiveInSync = true;
         
         // Clear send state
         currentPacketNumber = 0;
         hasCurrentPendingPacket = false;
         isBusy = false;  // ВАЖНО: сбрасываем флаг занятости!
+        windowBase = 0;
+        nextFragment = 0;
+        totalFragmentsSending = 0;
         
         // Clear active streams
         for (auto& stream : activeStreams) {
@@ -217,11 +253,11 @@ public:
             stream.streamId = 0;
             stream.totalFragments = 0;
             stream.nextExpectedFragment = 0;
+            stream.receivedMask = 0;
             stream.lastActivity = 0;
         }
-        
-        // Reset timers
-        lastPacketTime = 0;
+        reorderOwner = nullptr;
+        ackPendingStream = nullptr;
     }
 
 private:
@@ -233,100 +269,155 @@ private:
         uint8 retryCount;
         bool requiresAck;
         SendOptions options;
+        uint32 selectiveAck;              // Payload of Ack packets
 
-        PendingPacket() : dataSpan{}, sentBytes(0), createdAt(0), retryCount(0), requiresAck(false), options{} {}
+        PendingPacket() : dataSpan{}, sentBytes(0), createdAt(0), retryCount(0), requiresAck(false), options{}, selectiveAck(0) {}
     };
 
     struct ActiveStream {
         uint32 streamId;
         uint16 totalFragments;
         uint16 nextExpectedFragment;
+        uint32 receivedMask;  // bit i: fragment nextExpectedFragment + 1 + i is buffered
         uint32 lastActivity;
         bool completed;
 
-        ActiveStream() : streamId(0), totalFragments(0), nextExpectedFragment(0),
+        ActiveStream() : streamId(0), totalFragments(0), nextExpectedFragment(0), receivedMask(0),
                         lastActivity(0), completed(true) {}
     };
 
+    // Sender side: state of one fragment in flight, indexed by fragment % WindowSize
+    struct WindowSlot {
+        uint16 packetNumber;   // Kept on retransmission
+        uint32 sentAt;
+        uint8 retryCount;
+        bool acked;
+        bool fastRetransmitted;
+    };
+
+    // Receiver side: fragments that arrived ahead of a gap
+    static constexpr size_t REORDER_SLOTS = WindowSize - 1;
+
+    struct ReorderSlot {
+        uint16 size;
+        std::array<uint8, MAX_PAYLOAD_SIZE> data;
+    };
+
     TransmitCallback transmitCallback;
     DataStreamCallback onDataCallback;
     StreamCompleteCallback onCompleteCallback;
 
-    RingBuffer<uint8, BUFFER_SIZE> receiveBuffer;
+    RingBuffer<uint8, BUFFER_SIZE, ReceiveBufferPolicy> receiveBuffer;
     RingBuffer<PendingPacket, 16> pendingPackets;
 
     uint16 currentPacketNumber = 0;
     uint32 currentStreamId = 0;
     uint16 lastReceivedPacketNumber = 0;
+    bool receiveInSync = true;           // Last parsed frame was valid, the next one starts right after it
     bool hasCurrentPendingPacket = false;
     PendingPacket currentPendingPacket;
     uint32 processCounter = 0;
     
     // Streaming state
     bool isBusy = false;              // Идет ли передача данных
-    bool waitingForAck = false;       // Ждем ли ACK для текущего пакета
     std::span<const uint8> currentDataSpan;  // Данные текущей передачи
-    size_t currentSentBytes = 0;      // Сколько байт уже отправлено
+    SendOptions currentOptions;
     uint32 currentStreamIdSending = 0; // ID текущего потока отправки
-    uint32 lastPacketTime = 0;        // Время отправки последнего пакета
+    uint16 totalFragmentsSending = 0;
+    uint16 windowBase = 0;            // Oldest unacknowledged fragment
+    uint16 nextFragment = 0;          // Next fragment that was never sent
+    std::array<WindowSlot, WindowSize> window{};
 
     // Active incoming streams
     static constexpr size_t MAX_ACTIVE_STREAMS = 4;
     ActiveStream activeStreams[MAX_ACTIVE_STREAMS];
 
+    // One reorder buffer, owned by the stream that currently has a gap
+    std::array<ReorderSlot, REORDER_SLOTS> reorderSlots{};
+    ActiveStream* reorderOwner = nullptr;
 
-    // Send next packet from current stream
-    void SendNextStreamPacket() {
-        System::console << Console::debug << "[STREAM] SendNextStreamPacket: sent=" << currentSentBytes 
-                       << " total=" << currentDataSpan.size() << Console::endl;
-        
-        if (currentSentBytes >= currentDataSpan.size()) {
-            // Всё отправлено
-            System::console << Console::debug << "[STREAM] All data sent, clearing isBusy" << Console::endl;
-            isBusy = false;
-            onCompleteCallback(currentStreamIdSending, StreamResult::Success);
-            return;
+    // Stream ACKs are coalesced and sent from Process()
+    ActiveStream* ackPendingStream = nullptr;
+
+
+    // Send every fragment that fits into the window and was never sent
+    void FillWindow() {
+        while (isBusy && nextFragment < totalFragmentsSending && static_cast<size_t>(nextFragment - windowBase) < WindowSize) {
+            WindowSlot& slot = window[nextFragment % WindowSize];
+            slot.packetNumber = currentPacketNumber;
+
+            if (!TransmitFragment(nextFragment, slot.packetNumber)) {
+                break;  // Link busy, retry on next Process()
+            }
+
+            currentPacketNumber++;
+            slot.sentAt = processCounter;
+            slot.retryCount = 0;
+            slot.acked = false;
+            slot.fastRetransmitted = false;
+            nextFragment++;
         }
-        
-        size_t remainingBytes = currentDataSpan.size() - currentSentBytes;
-        size_t packetSize = std::min(static_cast<size_t>(MAX_PAYLOAD_SIZE), remainingBytes);
-        
-        auto packetData = currentDataSpan.subspan(currentSentBytes, packetSize);
-        
-        // Определяем тип пакета
-        PacketType packetType;
-        uint16 fragmentIndex = 0;
-        uint16 totalFragments = 1;
-        
-        if (currentDataSpan.size() > MAX_PAYLOAD_SIZE) {
-            // Фрагментированная передача
-            packetType = PacketType::FragmentData;
-            totalFragments = static_cast<uint16>((currentDataSpan.size() + MAX_PAYLOAD_SIZE - 1) / MAX_PAYLOAD_SIZE);
-            fragmentIndex = static_cast<uint16>(currentSentBytes / MAX_PAYLOAD_SIZE);
-        } else {
-            // Одиночный пакет
-            packetType = PacketType::SingleData;
+    }
+
+
+    // Resend fragments whose ACK did not arrive in time
+    void CheckAckTimeouts() {
+        for (uint16 fragment = windowBase; fragment < nextFragment; fragment++) {
+            WindowSlot& slot = window[fragment % WindowSize];
+            if (!slot.acked && processCounter - slot.sentAt >= currentOptions.ackTimeout) {
+                if (!Retransmit(fragment)) {
+                    return;
+                }
+            }
         }
-        
-        // Создаем и отправляем пакет
-        if (SendCurrentPacket(packetType, packetData, fragmentIndex, totalFragments)) {
-            waitingForAck = true;
-            lastPacketTime = processCounter;
+    }
+
+
+    bool Retransmit(uint16 fragment) {
+        WindowSlot& slot = window[fragment % WindowSize];
+        if (slot.retryCount >= currentOptions.maxRetries) {
+            CompleteSending(StreamResult::RetryExceeded);
+            return false;
+        }
+
+        System::console << Console::debug << "[STREAM] Retransmit fragment=" << fragment << Console::endl;
+
+        if (TransmitFragment(fragment, slot.packetNumber)) {
+            slot.retryCount++;
+            slot.sentAt = processCounter;
         }
+        return true;
     }
 
 
-    // Send current packet with given parameters
-    bool SendCurrentPacket(PacketType type, std::span<const uint8> data, uint16 fragmentIndex, uint16 totalFragments) {
-        // Создаем заголовок
+    void CompleteSending(StreamResult result) {
+        System::console << Console::debug << "[STREAM] Stream " << currentStreamIdSending << " finished, clearing isBusy" << Console::endl;
+        isBusy = false;
+        onCompleteCallback(currentStreamIdSending, result);
+    }
+
+
+    // Send one fragment of the current stream, zero-copy from the caller's span
+    bool TransmitFragment(uint16 fragment, uint16 packetNumber) {
+        size_t offset = static_cast<size_t>(fragment) * MAX_PAYLOAD_SIZE;
+        size_t packetSize = std::min(static_cast<size_t>(MAX_PAYLOAD_SIZE), currentDataSpan.size() - offset);
+        auto packetData = currentDataSpan.subspan(offset, packetSize);
+
+        // Определяем тип пакета
         PacketHeader header;
-        header.packetNumber = currentPacketNumber++;
-        header.type = type;
-        header.payloadSize = static_cast<uint16>(data.size());
-        header.streamId = (type == PacketType::FragmentData) ? currentStreamIdSending : 0;
-        header.totalFragments = totalFragments;
-        header.fragmentIndex = fragmentIndex;
-        
+        header.packetNumber = packetNumber;
+        header.type = (totalFragmentsSending > 1) ? PacketType::FragmentData : PacketType::SingleData;
+        header.payloadSize = static_cast<uint16>(packetSize);
+        header.streamId = currentStreamIdSending;
+        header.totalFragments = totalFragmentsSending;
+        header.fragmentIndex = fragment;
+
+        return TransmitPacket(header, packetData);
+    }
+
+
+    // Assemble header + payload + CRC and pass it to the transmit callback
+    bool TransmitPacket(const PacketHeader& header, std::span<const uint8> data) {
         // Собираем пакет
         std::array<uint8, MaxPacketSize> packetBuffer;
         size_t offset = 0;
@@ -440,16 +531,46 @@ private:
     }
 
 
-    ActiveStream* AllocateStream(uint32 streamId) {
-        // First look for free slot
+    // Finished streams stay in their slot until reused, so a retransmission
+    // whose ACK got lost is acknowledged again instead of starting a new stream
+    ActiveStream* FindDeliveredStream(uint32 streamId) {
         for (auto& stream : activeStreams) {
-            if (stream.completed) {
-                stream = ActiveStream();
-                stream.streamId = streamId;
-                stream.completed = false;
+            if (stream.streamId == streamId && stream.completed &&
+                stream.totalFragments != 0 && stream.nextExpectedFragment == stream.totalFragments) {
                 return &stream;
             }
         }
+        return nullptr;
+    }
+
+
+    void ReleaseStream(ActiveStream* stream) {
+        if (reorderOwner == stream) {
+            reorderOwner = nullptr;
+        }
+        stream->receivedMask = 0;
+    }
+
+
+    ActiveStream* AllocateStream(uint32 streamId) {
+        // First look for free slot, the one finished longest ago
+        ActiveStream* freeSlot = nullptr;
+        for (auto& stream : activeStreams) {
+            if (stream.completed && (!freeSlot || stream.lastActivity < freeSlot->lastActivity)) {
+                freeSlot = &stream;
+            }
+        }
+        if (freeSlot) {
+            if (ackPendingStream == freeSlot) {
+                FlushStreamAck();
+            }
+            ReleaseStream(freeSlot);
+            *freeSlot = ActiveStream();
+            freeSlot->streamId = streamId;
+            freeSlot->completed = false;
+            freeSlot->lastActivity = processCounter;
+            return freeSlot;
+        }
         // If no free slots, take the oldest one
         ActiveStream* oldest = &activeStreams[0];
         uint32 oldestTime = oldest->lastActivity;
@@ -468,6 +589,10 @@ private:
             );
         }
 
+        if (ackPendingStream == oldest) {
+            ackPendingStream = nullptr;
+        }
+        ReleaseStream(oldest);
         *oldest = ActiveStream();
         oldest->streamId = streamId;
         oldest->completed = false;
@@ -484,6 +609,12 @@ private:
             }
 
             size_t totalSize = sizeof(PacketHeader) + header.payloadSize + sizeof(uint16);
+            if (totalSize > MaxPacketSize) {
+                // Corrupted length would stall the parser forever, resync on the next byte
+                receiveBuffer.Pop();
+                receiveInSync = false;
+                continue;
+            }
             if (receiveBuffer.Size() < totalSize) {
                 break;
             }
@@ -501,9 +632,7 @@ private:
         }
 
         uint8 headerBytes[sizeof(PacketHeader)];
-        for (size_t i = 0; i < sizeof(PacketHeader); i++) {
-            headerBytes[i] = receiveBuffer[i];
-        }
+        receiveBuffer.PeekMultiple(headerBytes, sizeof(PacketHeader));
 
         std::memcpy(
             &header,
@@ -517,11 +646,10 @@ private:
     bool ProcessPacket(size_t totalSize) {
         uint8 packetData[MaxPacketSize];
 
-        for (size_t i = 0; i < totalSize; i++) {
-            auto byte = receiveBuffer.Pop();
-            if (byte.IsErr()) return false;
-            packetData[i] = byte.Value();
-        }
+        if (totalSize > MaxPacketSize) return false;
+        // Only peek: a frame with a bad CRC is consumed one byte at a time, so a
+        // corrupted length can not swallow the valid packets behind it
+        if (receiveBuffer.PeekMultiple(packetData, totalSize) != totalSize) return false;
 
         // Check CRC
         uint16 receivedCrc;
@@ -542,12 +670,18 @@ private:
                 packetData,
                 sizeof(PacketHeader)
             );
-            if (header.type == PacketType::SingleData || header.type == PacketType::FragmentData) {
-                SendNack(header.packetNumber);
+            // Header is not trustworthy, the NACK is only a hint, the sender validates it.
+            // While resyncing the "frames" are just shifted garbage, stay silent
+            if (receiveInSync && (header.type == PacketType::SingleData || header.type == PacketType::FragmentData)) {
+                SendControl(PacketType::Nack, header);
             }
+            receiveInSync = false;
             return false;
         }
 
+        receiveBuffer.PopMultiple(std::span<uint8>(packetData, totalSize));
+        receiveInSync = true;
+
         // Extract packet
         PacketHeader header;
         std::memcpy(
@@ -575,6 +709,7 @@ private:
 
             case PacketType::Ack:
             case PacketType::Nack:
+            case PacketType::Reject:
                 HandleAckNack(header, payload);
                 break;
 
@@ -583,7 +718,7 @@ private:
                 break;
 
             default:
-                return false;
+                break;  // Valid frame of an unknown type, already consumed
         }
 
         return true;
@@ -596,7 +731,7 @@ private:
         
         if (header.packetNumber == lastReceivedPacketNumber) {
             System::console << Console::debug << "[STREAM] Duplicate packet, sending ACK" << Console::endl;
-            SendAck(header.packetNumber);
+            SendControl(PacketType::Ack, header, 1);
             return;
         }
 
@@ -611,13 +746,13 @@ private:
         );
 
         if (accepted) {
-            SendAck(header.packetNumber);
+            SendControl(PacketType::Ack, header, 1);
             onCompleteCallback(
                 0,
                 StreamResult::Success
             );
         } else {
-            SendNack(header.packetNumber);
+            SendControl(PacketType::Reject, header);
             onCompleteCallback(
                 0,
                 StreamResult::Rejected
@@ -633,13 +768,19 @@ private:
 
         // Validity checks
         if (fragmentIndex >= totalFragments) {
-            SendNack(header.packetNumber);
+            SendControl(PacketType::Nack, header);
             return;
         }
 
         // Find or create stream
         ActiveStream* stream = FindStream(streamId);
         if (!stream) {
+            if (ActiveStream* delivered = FindDeliveredStream(streamId)) {
+                // Retransmission of a stream we already delivered: the ACK was lost
+                ScheduleStreamAck(delivered);
+                return;
+            }
+
             stream = AllocateStream(streamId);
             stream->totalFragments = totalFragments;
             stream->nextExpectedFragment = 0;
@@ -647,38 +788,103 @@ private:
 
         // Check consistency
         if (stream->totalFragments != totalFragments) {
-            SendNack(header.packetNumber);
+            SendControl(PacketType::Nack, header);
             return;
         }
 
         stream->lastActivity = processCounter;
 
-        // Call callback - data is processed immediately
-        bool accepted = onDataCallback(
-            streamId,
-            fragmentIndex,
-            totalFragments,
-            payload
-        );
+        if (fragmentIndex == stream->nextExpectedFragment) {
+            if (!DeliverInOrder(*stream, payload)) {
+                return;
+            }
+        } else if (fragmentIndex > stream->nextExpectedFragment) {
+            BufferOutOfOrder(*stream, fragmentIndex, payload);
+        }
+        // fragmentIndex < nextExpectedFragment: duplicate, just acknowledge again
 
-        if (accepted) {
-            SendAck(header.packetNumber);
+        ScheduleStreamAck(stream);
+    }
+
+
+    // Deliver the expected fragment and everything buffered right behind it
+    bool DeliverInOrder(ActiveStream& stream, std::span<const uint8> payload) {
+        while (true) {
+            bool accepted = onDataCallback(
+                stream.streamId,
+                stream.nextExpectedFragment,
+                stream.totalFragments,
+                payload
+            );
+
+            if (!accepted) {
+                PacketHeader header{};
+                header.streamId = stream.streamId;
+                header.fragmentIndex = stream.nextExpectedFragment;
+                header.totalFragments = stream.totalFragments;
+                SendControl(PacketType::Reject, header);
+
+                stream.completed = true;
+                ReleaseStream(&stream);
+                onCompleteCallback(
+                    stream.streamId,
+                    StreamResult::Rejected
+                );
+                return false;
+            }
+
+            // Bit 0 is the fragment right after the one just delivered
+            bool haveNext = stream.receivedMask & 1;
+            stream.receivedMask >>= 1;
+            stream.nextExpectedFragment++;
 
             // Check if stream is complete
-            if (fragmentIndex == totalFragments - 1) {
-                stream->completed = true;
+            if (stream.nextExpectedFragment == stream.totalFragments) {
+                stream.completed = true;
+                ReleaseStream(&stream);
                 onCompleteCallback(
-                    streamId,
+                    stream.streamId,
                     StreamResult::Success
                 );
+                return true;
+            }
+
+            if (!haveNext) {
+                if (stream.receivedMask == 0 && reorderOwner == &stream) {
+                    reorderOwner = nullptr;
+                }
+                return true;
+            }
+
+            if constexpr (REORDER_SLOTS > 0) {
+                const ReorderSlot& slot = reorderSlots[stream.nextExpectedFragment % REORDER_SLOTS];
+                payload = std::span<const uint8>(slot.data.data(), slot.size);
             }
-        } else {
-            SendNack(header.packetNumber);
-            stream->completed = true;
-            onCompleteCallback(
-                streamId,
-                StreamResult::Rejected
-            );
+        }
+    }
+
+
+    // Keep a fragment that arrived ahead of a gap, if it is inside the window
+    void BufferOutOfOrder(ActiveStream& stream, uint16 fragmentIndex, std::span<const uint8> payload) {
+        if constexpr (REORDER_SLOTS > 0) {
+            uint16 distance = fragmentIndex - stream.nextExpectedFragment - 1;
+            if (distance >= REORDER_SLOTS) {
+                return;  // Outside of the window, the sender will resend it
+            }
+
+            if (reorderOwner != nullptr && reorderOwner != &stream) {
+                return;  // Buffer is busy with another stream's gap
+            }
+
+            if (stream.receivedMask & (1u << distance)) {
+                return;  // Already buffered
+            }
+
+            ReorderSlot& slot = reorderSlots[fragmentIndex % REORDER_SLOTS];
+            slot.size = static_cast<uint16>(payload.size());
+            std::copy(payload.begin(), payload.end(), slot.data.begin());
+            stream.receivedMask |= 1u << distance;
+            reorderOwner = &stream;
         }
     }
 
@@ -699,80 +905,108 @@ private:
 
 
     void HandleAckNack(const PacketHeader& header, std::span<const uint8> payload) {
-        // Обрабатываем ACK/NACK для streaming отправки
-        if (isBusy && waitingForAck) {
-            if (header.type == PacketType::Ack) {
-                // ACK получен - продвигаем streaming
-                size_t packetSize = std::min(static_cast<size_t>(MAX_PAYLOAD_SIZE), 
-                                           currentDataSpan.size() - currentSentBytes);
-                currentSentBytes += packetSize;
-                waitingForAck = false;
-                
-                // Следующий пакет будет отправлен в следующем Process()
-            } else if (header.type == PacketType::Nack) {
-                // NACK - повторяем текущий пакет
-                waitingForAck = false;
-                // Не увеличиваем currentSentBytes - повторим тот же пакет
-            }
+        if (!isBusy || header.streamId != currentStreamIdSending) {
+            return;  // Stale or for a previous stream
+        }
+
+        if (header.type == PacketType::Reject) {
+            CompleteSending(StreamResult::Rejected);
             return;
         }
-        
-        // Обрабатываем ACK/NACK для старых одиночных пакетов
-        RingBuffer<PendingPacket, 16> tempQueue;
-        bool found = false;
-
-        while (!pendingPackets.IsEmpty()) {
-            auto packet = pendingPackets.Pop();
-            if (!packet.IsOk()) break;
-
-            if (!found && packet.Value().header.packetNumber == header.packetNumber) {
-                found = true;
-                if (header.type == PacketType::Nack && packet.Value().options.retryOnError) {
-                    if (packet.Value().retryCount < packet.Value().options.maxRetries) {
-                        packet.Value().retryCount++;
-                        packet.Value().createdAt = processCounter;
-                        tempQueue.Push(packet.Value());
-                    }
+
+        if (header.type == PacketType::Nack) {
+            // NACK - повторяем пакет, если он еще в окне
+            uint16 fragment = header.fragmentIndex;
+            if (fragment >= windowBase && fragment < nextFragment && !window[fragment % WindowSize].acked) {
+                if (!currentOptions.retryOnError) {
+                    CompleteSending(StreamResult::Error);
+                    return;
                 }
-                // If ACK or retries exceeded - don't return to queue
-            } else {
-                tempQueue.Push(packet.Value());
+                Retransmit(fragment);
+            }
+            return;
+        }
+
+        // ACK: everything below the cumulative index plus the selective bitmap
+        uint16 cumulative = std::min(header.fragmentIndex, nextFragment);
+        uint32 selective = 0;
+        if (payload.size() >= sizeof(uint32)) {
+            std::memcpy(&selective, payload.data(), sizeof(uint32));
+        }
+
+        for (uint16 fragment = windowBase; fragment < cumulative; fragment++) {
+            window[fragment % WindowSize].acked = true;
+        }
+        for (uint8 bit = 0; bit < 32 && (selective >> bit); bit++) {
+            uint32 fragment = static_cast<uint32>(header.fragmentIndex) + 1 + bit;
+            if ((selective >> bit) & 1 && fragment >= windowBase && fragment < nextFragment) {
+                window[fragment % WindowSize].acked = true;
             }
         }
 
-        // Return packets back
-        while (!tempQueue.IsEmpty()) {
-            auto packet = tempQueue.Pop();
-            if (packet.IsOk()) {
-                pendingPackets.Push(packet.Value());
+        // Slide the window
+        while (windowBase < nextFragment && window[windowBase % WindowSize].acked) {
+            windowBase++;
+        }
+
+        if (windowBase == totalFragmentsSending) {
+            CompleteSending(StreamResult::Success);
+            return;
+        }
+
+        // Later fragments arrived but the cumulative one did not: it was lost,
+        // resend once without waiting for its timer
+        if (selective != 0 && header.fragmentIndex == windowBase && windowBase < nextFragment) {
+            WindowSlot& slot = window[windowBase % WindowSize];
+            if (!slot.fastRetransmitted) {
+                slot.fastRetransmitted = true;
+                Retransmit(windowBase);
             }
         }
     }
 
 
-    void SendAck(uint16 originalPacketNumber) {
+    // Queue a control packet answering the given data packet header
+    void SendControl(PacketType type, const PacketHeader& original, uint16 fragmentIndex, uint32 selectiveAck = 0) {
         // ACK должен использовать номер исходного пакета, НЕ увеличивать счетчик!
-        SendOptions defaultOptions;
-        SendSinglePacket(
-            originalPacketNumber,  // Используем оригинальный номер пакета
-            PacketType::Ack,
-            {},
-            false,
-            defaultOptions
-        );
+        PendingPacket packet;
+        packet.header.packetNumber = original.packetNumber;
+        packet.header.type = type;
+        packet.header.payloadSize = (type == PacketType::Ack) ? sizeof(uint32) : 0;
+        packet.header.streamId = original.streamId;
+        packet.header.totalFragments = original.totalFragments;
+        packet.header.fragmentIndex = fragmentIndex;
+        packet.createdAt = processCounter;
+        packet.selectiveAck = selectiveAck;
+
+        pendingPackets.Push(packet);
     }
 
 
-    void SendNack(uint16 originalPacketNumber) {
-        // NACK также должен использовать номер исходного пакета
-        SendOptions defaultOptions;
-        SendSinglePacket(
-            originalPacketNumber,  // Используем оригинальный номер пакета
-            PacketType::Nack,
-            {},
-            false,
-            defaultOptions
-        );
+    void SendControl(PacketType type, const PacketHeader& original) {
+        SendControl(type, original, original.fragmentIndex);
+    }
+
+
+    void ScheduleStreamAck(ActiveStream* stream) {
+        if (ackPendingStream != nullptr && ackPendingStream != stream) {
+            FlushStreamAck();
+        }
+        ackPendingStream = stream;
+    }
+
+
+    // One ACK with the latest cumulative index and bitmap covers every fragment received since the last one
+    void FlushStreamAck() {
+        if (ackPendingStream == nullptr) {
+            return;
+        }
+
+        PacketHeader header{};
+        header.streamId = ackPendingStream->streamId;
+        header.totalFragments = ackPendingStream->totalFragments;
+        SendControl(PacketType::Ack, header, ackPendingStream->nextExpectedFragment, ackPendingStream->receivedMask);
+        ackPendingStream = nullptr;
     }
 
 
@@ -808,7 +1042,14 @@ private:
         );
         offset += sizeof(PacketHeader);
 
-        if (currentPendingPacket.header.payloadSize > 0) {
+        if (currentPendingPacket.header.type == PacketType::Ack) {
+            std::memcpy(
+                packetData.data() + offset,
+                &currentPendingPacket.selectiveAck,
+                sizeof(uint32)
+            );
+            offset += sizeof(uint32);
+        } else if (currentPendingPacket.header.payloadSize > 0) {
             std::memcpy(
                 packetData.data() + offset,
                 currentPendingPacket.dataSpan.data(),
@@ -838,6 +1079,7 @@ private:
         for (auto& stream : activeStreams) {
             if (!stream.completed && processCounter - stream.lastActivity > STREAM_TIMEOUT_CYCLES) {
                 stream.completed = true;
+                ReleaseStream(&stream);
                 onCompleteCallback(
                     stream.streamId,
                     StreamResult::RetryExceeded
@@ -848,7 +1090,7 @@ private:
 
 
     uint16 CalculateCRC16(std::span<const uint8> data) {
-        return Crc::Calculate(data.data(), data.size(), Crc::CRC_16_CCITTFALSE());
+        return Crc::Calculate(data.data(), data.size(), Crc::StaticTable<Crc::CRC_16_CCITTFALSE>);
     }
 };
 
@@ -1113,10 +1113,10 @@ protected:
             // Calculate CRC32 incrementally
             if (offset == 0) {
                 // First chunk
-                currentCrc = Crc::Calculate<uint32, 32>(buffer.data(), chunkSize, Crc::CRC_32());
+                currentCrc = Crc::Calculate(buffer.data(), chunkSize, Crc::StaticSliceTable<Crc::CRC_32>);
             } else {
                 // Continue with previous CRC
-                currentCrc = Crc::Calculate<uint32, 32>(buffer.data(), chunkSize, Crc::CRC_32(), currentCrc);
+                currentCrc = Crc::Calculate(buffer.data(), chunkSize, Crc::StaticSliceTable<Crc::CRC_32>, currentCrc);
             }
 
         }
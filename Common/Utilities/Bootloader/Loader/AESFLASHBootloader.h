@@ -191,12 +191,7 @@ private:
         // Copy data to buffer and encrypt in-place
         std::copy_n(data.begin(), outputSize, encryptionBuffer.begin());
         
-        for (size_t i = 0; i < outputSize; i += AES<>::BLOCK_SIZE) {
-            std::array<uint8, AES<>::BLOCK_SIZE> block;
-            std::copy_n(encryptionBuffer.begin() + i, AES<>::BLOCK_SIZE, block.begin());
-            aes.EncryptECB(block);
-            std::copy(block.begin(), block.end(), encryptionBuffer.begin() + i);
-        }
+        aes.EncryptECB(std::span(encryptionBuffer.data(), outputSize));
         
         return outputSize;
     }
@@ -214,12 +209,7 @@ private:
         // Copy data to buffer and decrypt in-place
         std::copy_n(data.begin(), outputSize, decryptionBuffer.begin());
         
-        for (size_t i = 0; i < outputSize; i += AES<>::BLOCK_SIZE) {
-            std::array<uint8, AES<>::BLOCK_SIZE> block;
-            std::copy_n(decryptionBuffer.begin() + i, AES<>::BLOCK_SIZE, block.begin());
-            aes.DecryptECB(block);
-            std::copy(block.begin(), block.end(), decryptionBuffer.begin() + i);
-        }
+        aes.DecryptECB(std::span(decryptionBuffer.data(), outputSize));
         
         return outputSize;
     }
@@ -2,9 +2,79 @@
 #include <VHAL.h>
 #include <limits>
 #include <functional>
+#include <atomic>
+#include <bit>
+#include <span>
+#include <algorithm>
+#include <cstring>
+
+
+namespace RingBufferPolicy {
+    // Every operation is guarded by System::CriticalSection, any BufferSize,
+    // any number of producers/consumers
+    struct CriticalSection {};
+
+    // Lock-free single producer / single consumer. Push() may only be called
+    // from one context (e.g. an ISR) and the read side (Pop, Peek, MarkRead...)
+    // only from one other context. BufferSize must be a power of two
+    struct SPSC {};
+}
+
+
+// Up to two contiguous parts of the ring: `first` starts at the current
+// position, `second` is the wrapped part at the start of the storage
+template<typename ElementType>
+struct RingBufferRegions {
+    std::span<ElementType> first;
+    std::span<ElementType> second;
+
+    size_t Size() const {
+        return first.size() + second.size();
+    }
+};
 
 
-template<typename ElementType, uint16 BufferSize>
+namespace RingBufferDetail {
+    template<typename ElementType>
+    inline void CopyElements(ElementType* to, const ElementType* from, uint32 count) {
+        if constexpr (std::is_trivially_copyable_v<ElementType>) {
+            if (count > 0) {
+                std::memcpy(to, from, count * sizeof(ElementType));
+            }
+        } else {
+            for (uint32 i = 0; i < count; i++) {
+                to[i] = from[i];
+            }
+        }
+    }
+
+
+    // At most two copies: up to the end of the storage, then from its start
+    template<typename ElementType>
+    inline void CopyFromRing(ElementType* to, const ElementType* ring, uint32 capacity, uint32 position, uint32 count) {
+        uint32 firstPart = std::min(count, capacity - position);
+        CopyElements(to, ring + position, firstPart);
+        CopyElements(to + firstPart, ring, count - firstPart);
+    }
+
+
+    template<typename ElementType>
+    inline void CopyToRing(ElementType* ring, uint32 capacity, uint32 position, const ElementType* from, uint32 count) {
+        uint32 firstPart = std::min(count, capacity - position);
+        CopyElements(ring + position, from, firstPart);
+        CopyElements(ring, from + firstPart, count - firstPart);
+    }
+
+
+    template<typename ElementType>
+    inline RingBufferRegions<ElementType> MakeRegions(ElementType* ring, uint32 capacity, uint32 position, uint32 count) {
+        uint32 firstPart = std::min(count, capacity - position);
+        return { std::span<ElementType>(ring + position, firstPart), std::span<ElementType>(ring, count - firstPart) };
+    }
+}
+
+
+template<typename ElementType, uint16 BufferSize, typename Policy = RingBufferPolicy::CriticalSection>
 class RingBuffer {
     static_assert(BufferSize > 0, "RingBuffer with size 0 are forbidden");
 
@@ -39,6 +109,16 @@ private:
     }
 
 
+    static uint16 Wrap(uint32 index) {
+        return static_cast<uint16>(index >= BufferSize ? index - BufferSize : index);
+    }
+
+
+    static uint16 ClampCount(size_t count) {
+        return static_cast<uint16>(std::min<size_t>(count, BufferSize));
+    }
+
+
 public:
     std::function<void(bool isLook)> onLook = nullptr;
 
@@ -163,19 +243,84 @@ public:
         uint16 available = size - offset;
         uint16 toPeek = (count < available) ? count : available;
         
-        for (uint16 i = 0; i < toPeek; i++) {
-            uint32 index = static_cast<uint32>(readIndex) + offset + i;
-            if (index >= BufferSize) {
-                index -= BufferSize;
-            }
-            outBuffer[i] = buffer[static_cast<uint16>(index)];
-        }
+        RingBufferDetail::CopyFromRing(outBuffer, buffer, BufferSize, Wrap(readIndex + offset), toPeek);
         
         System::CriticalSection(false);
         return toPeek;
     }
 
 
+    uint16 PeekMultiple(std::span<ElementType> outBuffer, uint16 offset = 0) const {
+        return PeekMultiple(outBuffer.data(), ClampCount(outBuffer.size()), offset);
+    }
+
+
+    // Push as many elements as fit, returns the number of pushed elements
+    uint16 PushMultiple(std::span<const ElementType> inElements) {
+        System::CriticalSection(true);
+
+        uint16 toPush = std::min(ClampCount(inElements.size()), static_cast<uint16>(BufferSize - size));
+        RingBufferDetail::CopyToRing(buffer, BufferSize, Wrap(readIndex + size), inElements.data(), toPush);
+        size += toPush;
+
+        System::CriticalSection(false);
+        return toPush;
+    }
+
+
+    // Pop up to outBuffer.size() elements, returns the number of popped elements
+    uint16 PopMultiple(std::span<ElementType> outBuffer) {
+        System::CriticalSection(true);
+
+        uint16 toPop = std::min(ClampCount(outBuffer.size()), size);
+        RingBufferDetail::CopyFromRing(outBuffer.data(), buffer, BufferSize, readIndex, toPop);
+        readIndex = Wrap(readIndex + toPop);
+        size -= toPop;
+
+        System::CriticalSection(false);
+        return toPop;
+    }
+
+
+    // Zero-copy access to the stored elements (oldest first). Consume them
+    // with MarkRead() + CommitReads() when done
+    RingBufferRegions<const ElementType> GetReadRegions() const {
+        System::CriticalSection(true);
+        uint16 position = readIndex;
+        uint16 count = size;
+        System::CriticalSection(false);
+
+        return RingBufferDetail::MakeRegions<const ElementType>(buffer, BufferSize, position, count);
+    }
+
+
+    // Zero-copy access to the free space (e.g. as a DMA target). Publish the
+    // filled elements with CommitWrite(). Only valid with a single producer
+    RingBufferRegions<ElementType> GetWriteRegions() {
+        System::CriticalSection(true);
+        uint16 position = Wrap(readIndex + size);
+        uint16 count = BufferSize - size;
+        System::CriticalSection(false);
+
+        return RingBufferDetail::MakeRegions<ElementType>(buffer, BufferSize, position, count);
+    }
+
+
+    // Publish count elements written through GetWriteRegions()
+    ResultStatus CommitWrite(uint16 count) {
+        System::CriticalSection(true);
+
+        if (count > BufferSize - size) {
+            System::CriticalSection(false);
+            return ResultStatus::error;
+        }
+        size += count;
+
+        System::CriticalSection(false);
+        return ResultStatus::ok;
+    }
+
+
     // Mark elements as read but don't remove them yet
     ResultStatus MarkRead(uint16 count) {
         System::CriticalSection(true);
@@ -196,11 +341,9 @@ public:
     void CommitReads() {
         System::CriticalSection(true);
         
-        while (uncommittedReadCount > 0) {
-            readIndex = (readIndex + 1) % BufferSize;
-            size--;
-            uncommittedReadCount--;
-        }
+        readIndex = Wrap(readIndex + uncommittedReadCount);
+        size -= uncommittedReadCount;
+        uncommittedReadCount = 0;
         
         System::CriticalSection(false);
     }
@@ -218,4 +361,249 @@ public:
     uint16 GetUncommittedCount() const {
         return uncommittedReadCount;
     }
-};
\ No newline at end of file
+};
+
+
+
+template<typename ElementType, uint16 BufferSize>
+class RingBuffer<ElementType, BufferSize, RingBufferPolicy::SPSC> {
+    static_assert(BufferSize > 0, "RingBuffer with size 0 are forbidden");
+    static_assert(std::has_single_bit(BufferSize), "SPSC RingBuffer size must be a power of two");
+    // The counters only use acquire/release loads and stores, which compile to a plain load/store
+    // and a barrier on every core. No read-modify-write, so Cortex-M0 works although its 32-bit
+    // atomics are not is_always_lock_free (it has no exclusive load/store)
+
+
+private:
+    static constexpr uint32 indexMask = BufferSize - 1;
+
+    ElementType buffer[BufferSize];
+
+    // Free running counters, wrap at 2^32 which is a multiple of BufferSize.
+    // writeCounter is owned by the producer, readCounter by the consumer
+    std::atomic<uint32> writeCounter = 0;
+    std::atomic<uint32> readCounter = 0;
+    uint16 uncommittedReadCount = 0;  // Consumer side only
+
+
+private:
+    static uint16 ClampCount(size_t count) {
+        return static_cast<uint16>(std::min<size_t>(count, BufferSize));
+    }
+
+
+public:
+    std::function<void(bool isLook)> onLook = nullptr;
+
+
+    RingBuffer() = default;
+
+
+    // Producer side
+    ResultStatus Push(const ElementType inElement) {
+        uint32 write = writeCounter.load(std::memory_order_relaxed);
+        if (write - readCounter.load(std::memory_order_acquire) == BufferSize) {
+            return ResultStatus::filled;
+        }
+
+        buffer[write & indexMask] = inElement;
+        writeCounter.store(write + 1, std::memory_order_release);
+
+        return ResultStatus::ok;
+    }
+
+
+    // Producer side
+    ResultStatus Push(const ElementType* const inElement) {
+        if (!inElement) {
+            return ResultStatus::error;
+        }
+        return Push(*inElement);
+    }
+
+
+    // Consumer side
+    Result<ElementType> Pop() {
+        uint32 read = readCounter.load(std::memory_order_relaxed);
+        if (writeCounter.load(std::memory_order_acquire) == read) {
+            return ResultStatus::empty;
+        }
+
+        ElementType data = buffer[read & indexMask];
+        readCounter.store(read + 1, std::memory_order_release);
+
+        return data;
+    }
+
+
+    bool IsFull() const {
+        return Size() == BufferSize;
+    }
+
+
+    bool IsEmpty() const {
+        return Size() == 0;
+    }
+
+
+    // Consumer side: drops everything the producer has published so far
+    void Clear() {
+        readCounter.store(writeCounter.load(std::memory_order_acquire), std::memory_order_release);
+        uncommittedReadCount = 0;
+    }
+
+
+    uint16 Size() const {
+        uint32 read = readCounter.load(std::memory_order_acquire);
+        return static_cast<uint16>(writeCounter.load(std::memory_order_acquire) - read);
+    }
+
+
+    constexpr uint16 MaxSize() const {
+        return BufferSize;
+    }
+
+
+    uint16 GetFreeSpace() const {
+        return BufferSize - Size();
+    }
+
+
+    // Consumer side
+    Result<ElementType> Peek() const {
+        uint32 read = readCounter.load(std::memory_order_relaxed);
+        if (writeCounter.load(std::memory_order_acquire) == read) {
+            return ResultStatus::empty;
+        }
+        return buffer[read & indexMask];
+    }
+
+
+    // Consumer side
+    ElementType operator[](uint16 inIndex) const {
+        SystemAssert(inIndex < Size());
+        return buffer[(readCounter.load(std::memory_order_relaxed) + inIndex) & indexMask];
+    }
+
+
+    // Consumer side
+    // Peek at multiple elements without removing them
+    // Returns actual number of elements peeked (may be less than requested)
+    uint16 PeekMultiple(ElementType* outBuffer, uint16 count, uint16 offset = 0) const {
+        uint32 read = readCounter.load(std::memory_order_relaxed);
+        uint32 available = writeCounter.load(std::memory_order_acquire) - read;
+
+        if (offset >= available) {
+            return 0;
+        }
+
+        available -= offset;
+        uint16 toPeek = (count < available) ? count : static_cast<uint16>(available);
+
+        RingBufferDetail::CopyFromRing(outBuffer, buffer, BufferSize, (read + offset) & indexMask, toPeek);
+        return toPeek;
+    }
+
+
+    // Consumer side
+    uint16 PeekMultiple(std::span<ElementType> outBuffer, uint16 offset = 0) const {
+        return PeekMultiple(outBuffer.data(), ClampCount(outBuffer.size()), offset);
+    }
+
+
+    // Producer side
+    // Push as many elements as fit, returns the number of pushed elements
+    uint16 PushMultiple(std::span<const ElementType> inElements) {
+        uint32 write = writeCounter.load(std::memory_order_relaxed);
+        uint32 freeSpace = BufferSize - (write - readCounter.load(std::memory_order_acquire));
+
+        uint16 toPush = static_cast<uint16>(std::min<uint32>(ClampCount(inElements.size()), freeSpace));
+        RingBufferDetail::CopyToRing(buffer, BufferSize, write & indexMask, inElements.data(), toPush);
+        writeCounter.store(write + toPush, std::memory_order_release);
+
+        return toPush;
+    }
+
+
+    // Consumer side
+    // Pop up to outBuffer.size() elements, returns the number of popped elements
+    uint16 PopMultiple(std::span<ElementType> outBuffer) {
+        uint32 read = readCounter.load(std::memory_order_relaxed);
+        uint32 available = writeCounter.load(std::memory_order_acquire) - read;
+
+        uint16 toPop = static_cast<uint16>(std::min<uint32>(ClampCount(outBuffer.size()), available));
+        RingBufferDetail::CopyFromRing(outBuffer.data(), buffer, BufferSize, read & indexMask, toPop);
+        readCounter.store(read + toPop, std::memory_order_release);
+
+        return toPop;
+    }
+
+
+    // Consumer side
+    // Zero-copy access to the stored elements (oldest first). Consume them
+    // with MarkRead() + CommitReads() when done
+    RingBufferRegions<const ElementType> GetReadRegions() const {
+        uint32 read = readCounter.load(std::memory_order_relaxed);
+        uint32 available = writeCounter.load(std::memory_order_acquire) - read;
+
+        return RingBufferDetail::MakeRegions<const ElementType>(buffer, BufferSize, read & indexMask, available);
+    }
+
+
+    // Producer side
+    // Zero-copy access to the free space (e.g. as a DMA target). Publish the
+    // filled elements with CommitWrite()
+    RingBufferRegions<ElementType> GetWriteRegions() {
+        uint32 write = writeCounter.load(std::memory_order_relaxed);
+        uint32 freeSpace = BufferSize - (write - readCounter.load(std::memory_order_acquire));
+
+        return RingBufferDetail::MakeRegions<ElementType>(buffer, BufferSize, write & indexMask, freeSpace);
+    }
+
+
+    // Producer side
+    // Publish count elements written through GetWriteRegions()
+    ResultStatus CommitWrite(uint16 count) {
+        uint32 write = writeCounter.load(std::memory_order_relaxed);
+        if (count > BufferSize - (write - readCounter.load(std::memory_order_acquire))) {
+            return ResultStatus::error;
+        }
+
+        writeCounter.store(write + count, std::memory_order_release);
+        return ResultStatus::ok;
+    }
+
+
+    // Consumer side
+    // Mark elements as read but don't remove them yet
+    ResultStatus MarkRead(uint16 count) {
+        if (count > Size() - uncommittedReadCount) {
+            return ResultStatus::error;  // Can't mark more than available
+        }
+
+        uncommittedReadCount += count;
+        return ResultStatus::ok;
+    }
+
+
+    // Consumer side
+    // Commit all marked reads - releases the slots to the producer in one store
+    void CommitReads() {
+        uint32 read = readCounter.load(std::memory_order_relaxed);
+        readCounter.store(read + uncommittedReadCount, std::memory_order_release);
+        uncommittedReadCount = 0;
+    }
+
+
+    // Consumer side
+    // Rollback marked reads - cancel uncommitted reads
+    void RollbackReads() {
+        uncommittedReadCount = 0;
+    }
+
+
+    // Get number of uncommitted reads
+    uint16 GetUncommittedCount() const {
+        return uncommittedReadCount;
+    }
+};
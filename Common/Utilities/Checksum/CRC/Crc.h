@@ -12,6 +12,9 @@ public:
 	template<typename CRCType, uint16 CRCWidth>
 	struct Table;
 
+	template<typename CRCType, uint16 CRCWidth, uint8 Slices>
+	struct SliceTable;
+
 	template<typename CRCType, uint16 CRCWidth>
 	struct Parameters {
 		CRCType polynomial;   	///< CRC polynomial
@@ -20,60 +23,114 @@ public:
 		bool reflectInput;    	///< true to reflect all input bytes
 		bool reflectOutput; 	///< true to reflect the output CRC (reflection occurs before the final XOR)
 
-		inline Table<CRCType, CRCWidth> MakeTable() const {
+		constexpr Table<CRCType, CRCWidth> MakeTable() const {
 			return Table<CRCType, CRCWidth>(*this);
 		}
+
+		template<uint8 Slices = 8>
+		constexpr SliceTable<CRCType, CRCWidth, Slices> MakeSliceTable() const {
+			return SliceTable<CRCType, CRCWidth, Slices>(*this);
+		}
 	};
 
 
 
+	// constexpr-constructible, so `static constexpr auto table = Crc::CRC_32().MakeTable();`
+	// (or Crc::StaticTable<Crc::CRC_32>) is generated at compile time and placed in flash
 	template<typename CRCType, uint16 CRCWidth>
 	struct Table {
-		inline Table(const Parameters<CRCType, CRCWidth>& params) : parameters(params) {
+		constexpr Table(const Parameters<CRCType, CRCWidth>& params) : parameters(params) {
 			InitTable();
 		}
 
-		inline Table(Parameters<CRCType, CRCWidth>&& params) : parameters(::std::move(params)) {
+		constexpr Table(Parameters<CRCType, CRCWidth>&& params) : parameters(::std::move(params)) {
 			InitTable();
 		}
 
-		inline const Parameters<CRCType, CRCWidth>& GetParameters() const {
+		constexpr const Parameters<CRCType, CRCWidth>& GetParameters() const {
 			return parameters;
 		}
 
-		inline const CRCType* GetTable() const {
+		constexpr const CRCType* GetTable() const {
 			return table;
 		}
 
-		inline CRCType operator[](unsigned char index) const {
+		constexpr CRCType operator[](unsigned char index) const {
 			return table[index];
 		}
 
 	private:
-		inline void InitTable() {
-			static constexpr CRCType BIT_MASK((CRCType(1) << (CRCWidth - CRCType(1))) | ((CRCType(1) << (CRCWidth - CRCType(1))) - CRCType(1)));
-			static constexpr CRCType SHIFT((CHAR_BIT >= CRCWidth) ? static_cast<CRCType>(CHAR_BIT - CRCWidth) : 0);
-
-			CRCType crc;
+		constexpr void InitTable() {
 			unsigned char byte = 0;
 			do {
-				crc = CalculateRemainder<CRCType, CRCWidth>(&byte, sizeof(byte), parameters, CRCType(0));
-				crc &= BIT_MASK;
+				table[byte] = TableEntry(byte, parameters);
+			} while (++byte);
+		}
 
-				if (!parameters.reflectInput && CRCWidth < CHAR_BIT) {
-					crc = static_cast<CRCType>(crc << SHIFT);
-				}
+		Parameters<CRCType, CRCWidth> parameters; ///< CRC parameters used to construct the table
+		CRCType table[1 << CHAR_BIT] = {};        ///< CRC lookup table
+	};
+
+
+
+	// Slice-by-N tables for 16 and 32 bit CRCs: table k holds the CRC of a byte
+	// followed by k zero bytes, so N input bytes are folded with N independent
+	// lookups per iteration instead of N dependent ones
+	template<typename CRCType, uint16 CRCWidth, uint8 Slices>
+	struct SliceTable {
+		static_assert((CRCWidth == 16 || CRCWidth == 32) && ::std::numeric_limits<CRCType>::digits == CRCWidth,
+			"SliceTable supports 16 bit CRCs in uint16 and 32 bit CRCs in uint32");
+		static_assert(Slices * CHAR_BIT >= CRCWidth && Slices <= 16, "Slices must cover the CRC width");
+
+		constexpr SliceTable(const Parameters<CRCType, CRCWidth>& params) : parameters(params) {
+			InitTables();
+		}
+
+		constexpr const Parameters<CRCType, CRCWidth>& GetParameters() const {
+			return parameters;
+		}
 
-				table[byte] = crc;
+		constexpr const CRCType* GetTable(uint8 slice) const {
+			return tables[slice];
+		}
+
+	private:
+		friend class Crc;
+
+		constexpr void InitTables() {
+			unsigned char byte = 0;
+			do {
+				tables[0][byte] = TableEntry(byte, parameters);
 			} while (++byte);
+
+			for (uint8 slice = 1; slice < Slices; slice++) {
+				for (uint16 i = 0; i < (1 << CHAR_BIT); i++) {
+					CRCType previous = tables[slice - 1][i];
+					if (parameters.reflectInput) {
+						tables[slice][i] = static_cast<CRCType>((previous >> CHAR_BIT) ^ tables[0][previous & 0xFF]);
+					} else {
+						tables[slice][i] = static_cast<CRCType>((previous << CHAR_BIT) ^ tables[0][(previous >> (CRCWidth - CHAR_BIT)) & 0xFF]);
+					}
+				}
+			}
 		}
 
-		Parameters<CRCType, CRCWidth> parameters; ///< CRC parameters used to construct the table
-		CRCType table[1 << CHAR_BIT];             ///< CRC lookup table
+		Parameters<CRCType, CRCWidth> parameters;
+		CRCType tables[Slices][1 << CHAR_BIT] = {};
 	};
 
 
 
+	// Compile-time tables for the predefined parameter sets, only the ones that are used end up in flash:
+	//   Crc::Calculate(data, size, Crc::StaticTable<Crc::CRC_16_MODBUS>);
+	template<auto ParametersFunction>
+	static constexpr auto StaticTable = ParametersFunction().MakeTable();
+
+	template<auto ParametersFunction, uint8 Slices = 8>
+	static constexpr auto StaticSliceTable = ParametersFunction().template MakeSliceTable<Slices>();
+
+
+
 
 	template<typename CRCType, uint16 CRCWidth>
 	static inline CRCType Calculate(const void* data, size_t size, const Parameters<CRCType, CRCWidth>& parameters) {
@@ -118,315 +175,392 @@ public:
 
 
 
-    static inline const Parameters<uint8, 4>& CRC_4_ITU() {
-        static const Parameters<uint8, 4> parameters = { 0x3, 0x0, 0x0, true, true };
-        return parameters;
+	template<typename CRCType, uint16 CRCWidth, uint8 Slices>
+	static inline CRCType Calculate(const void* data, size_t size, const SliceTable<CRCType, CRCWidth, Slices>& lookupTable) {
+		const Parameters<CRCType, CRCWidth>& parameters = lookupTable.GetParameters();
+		CRCType remainder = CalculateRemainder(data, size, lookupTable, parameters.initialValue);
+		return Finalize<CRCType, CRCWidth>(remainder, parameters.finalXOR, parameters.reflectInput != parameters.reflectOutput);
+	}
+
+
+
+
+
+	template<typename CRCType, uint16 CRCWidth, uint8 Slices>
+	static inline CRCType Calculate(const void* data, size_t size, const SliceTable<CRCType, CRCWidth, Slices>& lookupTable, CRCType crc) {
+		const Parameters<CRCType, CRCWidth>& parameters = lookupTable.GetParameters();
+		CRCType remainder = UndoFinalize<CRCType, CRCWidth>(crc, parameters.finalXOR, parameters.reflectInput != parameters.reflectOutput);
+		remainder = CalculateRemainder(data, size, lookupTable, remainder);
+		return Finalize<CRCType, CRCWidth>(remainder, parameters.finalXOR, parameters.reflectInput != parameters.reflectOutput);
+	}
+
+
+
+
+
+	// CRC of A||B from crcA = CRC(A), crcB = CRC(B) and the length of B, in O(log(lengthB)).
+	// Lets independent chunks be checksummed separately (e.g. by DMA or in parallel) and merged
+	template<typename CRCType, uint16 CRCWidth>
+	static constexpr CRCType Combine(CRCType crcA, CRCType crcB, size_t lengthB, const Parameters<CRCType, CRCWidth>& parameters) {
+		bool reflectOutput = parameters.reflectInput != parameters.reflectOutput;
+		CRCType remainderA = UndoFinalize<CRCType, CRCWidth>(crcA, parameters.finalXOR, reflectOutput);
+		CRCType remainderB = UndoFinalize<CRCType, CRCWidth>(crcB, parameters.finalXOR, reflectOutput);
+
+		// Register is affine in its start value: R(A||B) = (R(A) ^ init) * x^(8 * lengthB) ^ R(B)
+		CRCType shifted = static_cast<CRCType>(remainderA ^ parameters.initialValue);
+		if (parameters.reflectInput) {
+			shifted = Reflect(shifted, CRCWidth);
+		}
+		shifted = MultiplyModulo<CRCType, CRCWidth>(shifted, PowerOfX<CRCType, CRCWidth>(lengthB, parameters.polynomial), parameters.polynomial);
+		if (parameters.reflectInput) {
+			shifted = Reflect(shifted, CRCWidth);
+		}
+
+		return Finalize<CRCType, CRCWidth>(static_cast<CRCType>(shifted ^ remainderB), parameters.finalXOR, reflectOutput);
+	}
+
+
+
+
+    static constexpr Parameters<uint8, 4> CRC_4_ITU() {
+        return { 0x3, 0x0, 0x0, true, true };
     }
 
 
-    static inline const Parameters<uint8, 5>& CRC_5_EPC() {
-        static const Parameters<uint8, 5> parameters = { 0x09, 0x09, 0x00, false, false };
-        return parameters;
+    static constexpr Parameters<uint8, 5> CRC_5_EPC() {
+        return { 0x09, 0x09, 0x00, false, false };
     }
 
 
-    static inline const Parameters<uint8, 5>& CRC_5_ITU() {
-        static const Parameters<uint8, 5> parameters = { 0x15, 0x00, 0x00, true, true };
-        return parameters;
+    static constexpr Parameters<uint8, 5> CRC_5_ITU() {
+        return { 0x15, 0x00, 0x00, true, true };
     }
 
 
-    static inline const Parameters<uint8, 5>& CRC_5_USB() {
-        static const Parameters<uint8, 5> parameters = { 0x05, 0x1F, 0x1F, true, true };
-        return parameters;
+    static constexpr Parameters<uint8, 5> CRC_5_USB() {
+        return { 0x05, 0x1F, 0x1F, true, true };
     }
 
 
-    static inline const Parameters<uint8, 6>& CRC_6_CDMA2000A() {
-        static const Parameters<uint8, 6> parameters = { 0x27, 0x3F, 0x00, false, false };
-        return parameters;
+    static constexpr Parameters<uint8, 6> CRC_6_CDMA2000A() {
+        return { 0x27, 0x3F, 0x00, false, false };
     }
 
 
-    static inline const Parameters<uint8, 6>& CRC_6_CDMA2000B() {
-        static const Parameters<uint8, 6> parameters = { 0x07, 0x3F, 0x00, false, false };
-        return parameters;
+    static constexpr Parameters<uint8, 6> CRC_6_CDMA2000B() {
+        return { 0x07, 0x3F, 0x00, false, false };
     }
 
 
-    static inline const Parameters<uint8, 6>& CRC_6_ITU() {
-        static const Parameters<uint8, 6> parameters = { 0x03, 0x00, 0x00, true, true };
-        return parameters;
+    static constexpr Parameters<uint8, 6> CRC_6_ITU() {
+        return { 0x03, 0x00, 0x00, true, true };
     }
 
 
-    static inline const Parameters<uint8, 7>& CRC_7() {
-        static const Parameters<uint8, 7> parameters = { 0x09, 0x00, 0x00, false, false };
-        return parameters;
+    static constexpr Parameters<uint8, 7> CRC_7() {
+        return { 0x09, 0x00, 0x00, false, false };
     }
 
 
-    static inline const Parameters<uint8, 8>& CRC_8() {
-        static const Parameters<uint8, 8> parameters = { 0x07, 0x00, 0x00, false, false };
-        return parameters;
+    static constexpr Parameters<uint8, 8> CRC_8() {
+        return { 0x07, 0x00, 0x00, false, false };
     }
 
 
-    static inline const Parameters<uint8, 8>& CRC_8_EBU() {
-        static const Parameters<uint8, 8> parameters = { 0x1D, 0xFF, 0x00, true, true };
-        return parameters;
+    static constexpr Parameters<uint8, 8> CRC_8_EBU() {
+        return { 0x1D, 0xFF, 0x00, true, true };
     }
 
 
-    static inline const Parameters<uint8, 8>& CRC_8_MAXIM() {
-        static const Parameters<uint8, 8> parameters = { 0x31, 0x00, 0x00, true, true };
-        return parameters;
+    static constexpr Parameters<uint8, 8> CRC_8_MAXIM() {
+        return { 0x31, 0x00, 0x00, true, true };
     }
 
 
-    static inline const Parameters<uint8, 8>& CRC_8_WCDMA() {
-        static const Parameters<uint8, 8> parameters = { 0x9B, 0x00, 0x00, true, true };
-        return parameters;
+    static constexpr Parameters<uint8, 8> CRC_8_WCDMA() {
+        return { 0x9B, 0x00, 0x00, true, true };
     }
 
 
-    static inline const Parameters<uint16, 10>& CRC_10() {
-        static const Parameters<uint16, 10> parameters = { 0x233, 0x000, 0x000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 10> CRC_10() {
+        return { 0x233, 0x000, 0x000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 10>& CRC_10_CDMA2000() {
-        static const Parameters<uint16, 10> parameters = { 0x3D9, 0x3FF, 0x000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 10> CRC_10_CDMA2000() {
+        return { 0x3D9, 0x3FF, 0x000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 11>& CRC_11() {
-        static const Parameters<uint16, 11> parameters = { 0x385, 0x01A, 0x000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 11> CRC_11() {
+        return { 0x385, 0x01A, 0x000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 12>& CRC_12_CDMA2000() {
-        static const Parameters<uint16, 12> parameters = { 0xF13, 0xFFF, 0x000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 12> CRC_12_CDMA2000() {
+        return { 0xF13, 0xFFF, 0x000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 12>& CRC_12_DECT() {
-        static const Parameters<uint16, 12> parameters = { 0x80F, 0x000, 0x000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 12> CRC_12_DECT() {
+        return { 0x80F, 0x000, 0x000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 12>& CRC_12_UMTS() {
-        static const Parameters<uint16, 12> parameters = { 0x80F, 0x000, 0x000, false, true };
-        return parameters;
+    static constexpr Parameters<uint16, 12> CRC_12_UMTS() {
+        return { 0x80F, 0x000, 0x000, false, true };
     }
 
 
-    static inline const Parameters<uint16, 13>& CRC_13_BBC() {
-        static const Parameters<uint16, 13> parameters = { 0x1CF5, 0x0000, 0x0000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 13> CRC_13_BBC() {
+        return { 0x1CF5, 0x0000, 0x0000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 15>& CRC_15() {
-        static const Parameters<uint16, 15> parameters = { 0x4599, 0x0000, 0x0000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 15> CRC_15() {
+        return { 0x4599, 0x0000, 0x0000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 15>& CRC_15_MPT1327() {
-        static const Parameters<uint16, 15> parameters = { 0x6815, 0x0000, 0x0001, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 15> CRC_15_MPT1327() {
+        return { 0x6815, 0x0000, 0x0001, false, false };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_ARC() {
-        static const Parameters<uint16, 16> parameters = { 0x8005, 0x0000, 0x0000, true, true };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_ARC() {
+        return { 0x8005, 0x0000, 0x0000, true, true };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_BUYPASS() {
-        static const Parameters<uint16, 16> parameters = { 0x8005, 0x0000, 0x0000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_BUYPASS() {
+        return { 0x8005, 0x0000, 0x0000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_CCITTFALSE() {
-        static const Parameters<uint16, 16> parameters = { 0x1021, 0xFFFF, 0x0000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_CCITTFALSE() {
+        return { 0x1021, 0xFFFF, 0x0000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_CDMA2000() {
-        static const Parameters<uint16, 16> parameters = { 0xC867, 0xFFFF, 0x0000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_CDMA2000() {
+        return { 0xC867, 0xFFFF, 0x0000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_CMS() {
-        static const Parameters<uint16, 16> parameters = { 0x8005, 0xFFFF, 0x0000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_CMS() {
+        return { 0x8005, 0xFFFF, 0x0000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_DECTR() {
-        static const Parameters<uint16, 16> parameters = { 0x0589, 0x0000, 0x0001, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_DECTR() {
+        return { 0x0589, 0x0000, 0x0001, false, false };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_DECTX() {
-        static const Parameters<uint16, 16> parameters = { 0x0589, 0x0000, 0x0000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_DECTX() {
+        return { 0x0589, 0x0000, 0x0000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_DNP() {
-        static const Parameters<uint16, 16> parameters = { 0x3D65, 0x0000, 0xFFFF, true, true };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_DNP() {
+        return { 0x3D65, 0x0000, 0xFFFF, true, true };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_GENIBUS() {
-        static const Parameters<uint16, 16> parameters = { 0x1021, 0xFFFF, 0xFFFF, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_GENIBUS() {
+        return { 0x1021, 0xFFFF, 0xFFFF, false, false };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_KERMIT() {
-        static const Parameters<uint16, 16> parameters = { 0x1021, 0x0000, 0x0000, true, true };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_KERMIT() {
+        return { 0x1021, 0x0000, 0x0000, true, true };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_MAXIM() {
-        static const Parameters<uint16, 16> parameters = { 0x8005, 0x0000, 0xFFFF, true, true };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_MAXIM() {
+        return { 0x8005, 0x0000, 0xFFFF, true, true };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_MODBUS() {
-        static const Parameters<uint16, 16> parameters = { 0x8005, 0xFFFF, 0x0000, true, true };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_MODBUS() {
+        return { 0x8005, 0xFFFF, 0x0000, true, true };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_T10DIF() {
-        static const Parameters<uint16, 16> parameters = { 0x8BB7, 0x0000, 0x0000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_T10DIF() {
+        return { 0x8BB7, 0x0000, 0x0000, false, false };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_USB() {
-        static const Parameters<uint16, 16> parameters = { 0x8005, 0xFFFF, 0xFFFF, true, true };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_USB() {
+        return { 0x8005, 0xFFFF, 0xFFFF, true, true };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_X25() {
-        static const Parameters<uint16, 16> parameters = { 0x1021, 0xFFFF, 0xFFFF, true, true };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_X25() {
+        return { 0x1021, 0xFFFF, 0xFFFF, true, true };
     }
 
 
-    static inline const Parameters<uint16, 16>& CRC_16_XMODEM() {
-        static const Parameters<uint16, 16> parameters = { 0x1021, 0x0000, 0x0000, false, false };
-        return parameters;
+    static constexpr Parameters<uint16, 16> CRC_16_XMODEM() {
+        return { 0x1021, 0x0000, 0x0000, false, false };
     }
 
 
-    static inline const Parameters<uint32, 17>& CRC_17_CAN() {
-        static const Parameters<uint32, 17> parameters = { 0x1685B, 0x00000, 0x00000, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 17> CRC_17_CAN() {
+        return { 0x1685B, 0x00000, 0x00000, false, false };
     }
 
 
-    static inline const Parameters<uint32, 21>& CRC_21_CAN() {
-        static const Parameters<uint32, 21> parameters = { 0x102899, 0x000000, 0x000000, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 21> CRC_21_CAN() {
+        return { 0x102899, 0x000000, 0x000000, false, false };
     }
 
 
-    static inline const Parameters<uint32, 24>& CRC_24() {
-        static const Parameters<uint32, 24> parameters = { 0x864CFB, 0xB704CE, 0x000000, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 24> CRC_24() {
+        return { 0x864CFB, 0xB704CE, 0x000000, false, false };
     }
 
 
-    static inline const Parameters<uint32, 24>& CRC_24_FLEXRAYA() {
-        static const Parameters<uint32, 24> parameters = { 0x5D6DCB, 0xFEDCBA, 0x000000, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 24> CRC_24_FLEXRAYA() {
+        return { 0x5D6DCB, 0xFEDCBA, 0x000000, false, false };
     }
 
 
-    static inline const Parameters<uint32, 24>& CRC_24_FLEXRAYB() {
-        static const Parameters<uint32, 24> parameters = { 0x5D6DCB, 0xABCDEF, 0x000000, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 24> CRC_24_FLEXRAYB() {
+        return { 0x5D6DCB, 0xABCDEF, 0x000000, false, false };
     }
 
 
-    static inline const Parameters<uint32, 30>& CRC_30() {
-        static const Parameters<uint32, 30> parameters = { 0x2030B9C7, 0x3FFFFFFF, 0x00000000, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 30> CRC_30() {
+        return { 0x2030B9C7, 0x3FFFFFFF, 0x00000000, false, false };
     }
 
 
-    static inline const Parameters<uint32, 32>& CRC_32() {
-        static const Parameters<uint32, 32> parameters = { 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, true };
-        return parameters;
+    static constexpr Parameters<uint32, 32> CRC_32() {
+        return { 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, true };
     }
 
 
-    static inline const Parameters<uint32, 32>& CRC_32_BZIP2() {
-        static const Parameters<uint32, 32> parameters = { 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 32> CRC_32_BZIP2() {
+        return { 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, false, false };
     }
 
 
-    static inline const Parameters<uint32, 32>& CRC_32_C() {
-        static const Parameters<uint32, 32> parameters = { 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF, true, true };
-        return parameters;
+    static constexpr Parameters<uint32, 32> CRC_32_C() {
+        return { 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF, true, true };
     }
 
 
-    static inline const Parameters<uint32, 32>& CRC_32_MPEG2() {
-        static const Parameters<uint32, 32> parameters = { 0x04C11DB7, 0xFFFFFFFF, 0x00000000, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 32> CRC_32_MPEG2() {
+        return { 0x04C11DB7, 0xFFFFFFFF, 0x00000000, false, false };
     }
 
 
-    static inline const Parameters<uint32, 32>& CRC_32_POSIX() {
-        static const Parameters<uint32, 32> parameters = { 0x04C11DB7, 0x00000000, 0xFFFFFFFF, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 32> CRC_32_POSIX() {
+        return { 0x04C11DB7, 0x00000000, 0xFFFFFFFF, false, false };
     }
 
 
-    static inline const Parameters<uint32, 32>& CRC_32_Q() {
-        static const Parameters<uint32, 32> parameters = { 0x814141AB, 0x00000000, 0x00000000, false, false };
-        return parameters;
+    static constexpr Parameters<uint32, 32> CRC_32_Q() {
+        return { 0x814141AB, 0x00000000, 0x00000000, false, false };
     }
 
 
-    static inline const Parameters<uint64, 40>& CRC_40_GSM() {
-        static const Parameters<uint64, 40> parameters = { 0x0004820009, 0x0000000000, 0xFFFFFFFFFF, false, false };
-        return parameters;
+    static constexpr Parameters<uint64, 40> CRC_40_GSM() {
+        return { 0x0004820009, 0x0000000000, 0xFFFFFFFFFF, false, false };
     }
 
 
-    static inline const Parameters<uint64, 64>& CRC_64() {
-        static const Parameters<uint64, 64> parameters = { 0x42F0E1EBA9EA3693, 0x0000000000000000, 0x0000000000000000, false, false };
-        return parameters;
+    static constexpr Parameters<uint64, 64> CRC_64() {
+        return { 0x42F0E1EBA9EA3693, 0x0000000000000000, 0x0000000000000000, false, false };
     }
 
 
 private:
+	template<typename CRCType, uint16 CRCWidth>
+	static constexpr CRCType BitMask() {
+		return (CRCType(1) << (CRCWidth - CRCType(1))) | ((CRCType(1) << (CRCWidth - CRCType(1))) - CRCType(1));
+	}
+
+
+
+
+
+	template<typename CRCType, uint16 CRCWidth>
+	static constexpr CRCType TableEntry(unsigned char byte, const Parameters<CRCType, CRCWidth>& parameters) {
+		constexpr CRCType SHIFT((CHAR_BIT >= CRCWidth) ? static_cast<CRCType>(CHAR_BIT - CRCWidth) : 0);
+
+		CRCType crc = CalculateRemainder<CRCType, CRCWidth>(&byte, sizeof(byte), parameters, CRCType(0));
+		crc &= BitMask<CRCType, CRCWidth>();
+
+		if (!parameters.reflectInput && CRCWidth < CHAR_BIT) {
+			crc = static_cast<CRCType>(crc << SHIFT);
+		}
+
+		return crc;
+	}
+
+
+
+
+
+	// a * b mod polynomial in GF(2), non-reflected bit order, CRCWidth bits
+	template<typename CRCType, uint16 CRCWidth>
+	static constexpr CRCType MultiplyModulo(CRCType a, CRCType b, CRCType polynomial) {
+		constexpr CRCType BIT_MASK = BitMask<CRCType, CRCWidth>();
+		CRCType result = 0;
+
+		for (int16 bit = CRCWidth - 1; bit >= 0; --bit) {
+			bool carry = (result >> (CRCWidth - 1)) & 1;
+			result = static_cast<CRCType>((result << 1) & BIT_MASK);
+			if (carry) {
+				result ^= polynomial;
+			}
+			if ((b >> bit) & 1) {
+				result ^= a;
+			}
+		}
+
+		return result;
+	}
+
+
+
+
+
+	// x^(8 * bytes) mod polynomial, by square-and-multiply
+	template<typename CRCType, uint16 CRCWidth>
+	static constexpr CRCType PowerOfX(size_t bytes, CRCType polynomial) {
+		constexpr CRCType BIT_MASK = BitMask<CRCType, CRCWidth>();
+
+		CRCType base = 1;
+		for (uint8 i = 0; i < CHAR_BIT; i++) {
+			bool carry = (base >> (CRCWidth - 1)) & 1;
+			base = static_cast<CRCType>((base << 1) & BIT_MASK);
+			if (carry) {
+				base ^= polynomial;
+			}
+		}
+
+		CRCType result = 1;
+		while (bytes) {
+			if (bytes & 1) {
+				result = MultiplyModulo<CRCType, CRCWidth>(result, base, polynomial);
+			}
+			base = MultiplyModulo<CRCType, CRCWidth>(base, base, polynomial);
+			bytes >>= 1;
+		}
+
+		return result;
+	}
+
+
+
+
+
 	template<typename IntegerType>
-	static inline IntegerType Reflect(IntegerType value, uint16 numBits) {
+	static constexpr IntegerType Reflect(IntegerType value, uint16 numBits) {
 		IntegerType reversedValue(0);
 
 		for (uint16 i = 0; i < numBits; ++i) {
@@ -442,8 +576,8 @@ private:
 
 
 	template<typename CRCType, uint16 CRCWidth>
-	static inline CRCType Finalize(CRCType remainder, CRCType finalXOR, bool reflectOutput) {
-		static constexpr CRCType BIT_MASK = (CRCType(1) << (CRCWidth - CRCType(1))) | ((CRCType(1) << (CRCWidth - CRCType(1))) - CRCType(1));
+	static constexpr CRCType Finalize(CRCType remainder, CRCType finalXOR, bool reflectOutput) {
+		constexpr CRCType BIT_MASK = BitMask<CRCType, CRCWidth>();
 
 		if (reflectOutput) {
 			remainder = Reflect(remainder, CRCWidth);
@@ -457,8 +591,8 @@ private:
 
 
 	template<typename CRCType, uint16 CRCWidth>
-	static inline CRCType UndoFinalize(CRCType crc, CRCType finalXOR, bool reflectOutput) {
-		static constexpr CRCType BIT_MASK = (CRCType(1) << (CRCWidth - CRCType(1))) | ((CRCType(1) << (CRCWidth - CRCType(1))) - CRCType(1));
+	static constexpr CRCType UndoFinalize(CRCType crc, CRCType finalXOR, bool reflectOutput) {
+		constexpr CRCType BIT_MASK = BitMask<CRCType, CRCWidth>();
 		crc = (crc & BIT_MASK) ^ finalXOR;
 
 		if (reflectOutput) {
@@ -474,8 +608,16 @@ private:
 
 	template<typename CRCType, uint16 CRCWidth>
 	static inline CRCType CalculateRemainder(const void* data, size_t size, const Parameters<CRCType, CRCWidth>& parameters, CRCType remainder) {
+		return CalculateRemainder(reinterpret_cast<const unsigned char*>(data), size, parameters, remainder);
+	}
+
+
+
+
+
+	template<typename CRCType, uint16 CRCWidth>
+	static constexpr CRCType CalculateRemainder(const unsigned char* current, size_t size, const Parameters<CRCType, CRCWidth>& parameters, CRCType remainder) {
 		static_assert(::std::numeric_limits<CRCType>::digits >= CRCWidth, "CRCType is too small to contain a CRC of width CRCWidth.");
-		const unsigned char* current = reinterpret_cast<const unsigned char*>(data);
 
 		if (parameters.reflectInput) {
 			CRCType polynomial = Crc::Reflect(parameters.polynomial, CRCWidth);
@@ -487,8 +629,8 @@ private:
 				}
 			}
 		} else if (CRCWidth >= CHAR_BIT) {
-			static constexpr CRCType CRC_WIDTH_MINUS_ONE(CRCWidth - CRCType(1));
-			static constexpr CRCType SHIFT((CRCWidth >= CHAR_BIT) ? static_cast<CRCType>(CRCWidth - CHAR_BIT) : 0);
+			constexpr CRCType CRC_WIDTH_MINUS_ONE(CRCWidth - CRCType(1));
+			constexpr CRCType SHIFT((CRCWidth >= CHAR_BIT) ? static_cast<CRCType>(CRCWidth - CHAR_BIT) : 0);
 
 			while (size--) {
 				remainder = static_cast<CRCType>(remainder ^ (static_cast<CRCType>(*current++) << SHIFT));
@@ -498,8 +640,8 @@ private:
 				}
 			}
 		} else {
-			static constexpr CRCType CHAR_BIT_MINUS_ONE(CHAR_BIT - 1);
-			static constexpr CRCType SHIFT((CHAR_BIT >= CRCWidth) ? static_cast<CRCType>(CHAR_BIT - CRCWidth) : 0);
+			constexpr CRCType CHAR_BIT_MINUS_ONE(CHAR_BIT - 1);
+			constexpr CRCType SHIFT((CHAR_BIT >= CRCWidth) ? static_cast<CRCType>(CHAR_BIT - CRCWidth) : 0);
 
 			CRCType polynomial = static_cast<CRCType>(parameters.polynomial << SHIFT);
 			remainder = static_cast<CRCType>(remainder << SHIFT);
@@ -549,4 +691,56 @@ private:
 
 		return remainder;
 	}
-};
+
+
+
+
+
+	template<typename CRCType, uint16 CRCWidth, uint8 Slices>
+	static inline CRCType CalculateRemainder(const void* data, size_t size, const SliceTable<CRCType, CRCWidth, Slices>& lookupTable, CRCType remainder) {
+		constexpr uint8 CRC_BYTES = CRCWidth / CHAR_BIT;
+		const unsigned char* current = reinterpret_cast<const unsigned char*>(data);
+		const auto& tables = lookupTable.tables;
+
+		// The remainder is folded into the first CRC_BYTES input bytes, then all
+		// Slices bytes are looked up independently. Byte loads keep this
+		// endian- and alignment-agnostic (Cortex-M0 has no unaligned access)
+		if (lookupTable.GetParameters().reflectInput) {
+			while (size >= Slices) {
+				CRCType next = 0;
+				for (uint8 i = 0; i < Slices; i++) {
+					unsigned char byte = current[i];
+					if (i < CRC_BYTES) {
+						byte ^= static_cast<unsigned char>(remainder >> (i * CHAR_BIT));
+					}
+					next ^= tables[Slices - 1 - i][byte];
+				}
+				remainder = next;
+				current += Slices;
+				size -= Slices;
+			}
+			while (size--) {
+				remainder = static_cast<CRCType>((remainder >> CHAR_BIT) ^ tables[0][static_cast<unsigned char>(remainder ^ *current++)]);
+			}
+		} else {
+			while (size >= Slices) {
+				CRCType next = 0;
+				for (uint8 i = 0; i < Slices; i++) {
+					unsigned char byte = current[i];
+					if (i < CRC_BYTES) {
+						byte ^= static_cast<unsigned char>(remainder >> (CRCWidth - CHAR_BIT - i * CHAR_BIT));
+					}
+					next ^= tables[Slices - 1 - i][byte];
+				}
+				remainder = next;
+				current += Slices;
+				size -= Slices;
+			}
+			while (size--) {
+				remainder = static_cast<CRCType>((remainder << CHAR_BIT) ^ tables[0][static_cast<unsigned char>((remainder >> (CRCWidth - CHAR_BIT)) ^ *current++)]);
+			}
+		}
+
+		return remainder;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,1186 @@
+#pragma once
+#include <VHAL.h>
+#include <bit>
+#include <cstring>
+#include <cstddef>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+
+/*
+Exact number to text conversion behind Print (and through it Console and JSON::Writer)
+
+Floating point values are taken apart into their integer mantissa and exponent and never
+multiplied or divided in floating point, so the digits are exact on every target and soft-float
+MCUs only do integer work:
+    char text[NumberFormat::MAX_FLOAT_LENGTH];
+    NumberFormat::Fixed(text, 2.675, 2);        // "2.67", the exact value is 2.67499999...
+    NumberFormat::Fixed(text, 0.125, 2);        // "0.12", ties to even like printf
+    NumberFormat::Shortest(text, 0.1f);         // "0.1", the shortest text that reads back as the same float
+    NumberFormat::Shortest(text, 1e300);        // "1e+300"
+
+Functions write without a terminating zero and return the length. Integers are written
+backwards from the end of the buffer, two digits per step:
+    char digits[20];
+    char* start = NumberFormat::WriteDecimal(digits + sizeof(digits), 1234567890123);
+
+Shortest is Ryu (Ulf Adams, PLDI 2018). Its power of 5 tables are generated at compile time
+and only linked in when Shortest is used for that type: 0.6 KB for float, 9.9 KB for double.
+Fixed does not need them.
+
+Parse is the way back, correctly rounded for any number of digits and bounded by the given
+length, the text does not need a terminating zero:
+    double value;
+    size_t used = NumberFormat::Parse(text, length, value);    // 0 if there is no number
+
+Integers up to 2^53 (2^24 for float) are converted directly, up to 19 digits with exponents
+within +-22 (+-10) take a single multiplication or division where the FPU does them exactly.
+Everything else is Eisel-Lemire (Daniel Lemire, 2021): one or two 64x64 multiplications with
+a truncated 128-bit power of 5, integer work only. Its table costs 10.4 KB for double, 1.7 KB
+for float. More than 19 significant digits fall back to big integer arithmetic only when the
+first 19 leave the rounding open. Digits are read 8 at a time on little-endian targets.
+*/
+
+
+class NumberFormat {
+public:
+    static constexpr size_t MAX_FLOAT_LENGTH = 48;     // "-" + 20 integer digits + "." + 19 decimals
+    static constexpr uint8 MAX_PRECISION = 19;
+
+
+    // Writes `value` so that it ends right before `end`, returns its first character
+    static char* WriteDecimal(char* end, uint64 value) {
+        // Chunks of 8 digits keep the 64-bit divisions out of the loop on 32-bit cores
+        while (value > 0xFFFFFFFF) {
+            uint64 quotient = Div1e8(value);
+            uint32 chunk = static_cast<uint32>(value - quotient * 100000000);
+            value = quotient;
+            for (int i = 0; i < 4; i++) {
+                end -= 2;
+                std::memcpy(end, &DIGIT_PAIRS[(chunk % 100) * 2], 2);
+                chunk /= 100;
+            }
+        }
+
+        uint32 rest = static_cast<uint32>(value);
+        while (rest >= 100) {
+            end -= 2;
+            std::memcpy(end, &DIGIT_PAIRS[(rest % 100) * 2], 2);
+            rest /= 100;
+        }
+        if (rest >= 10) {
+            end -= 2;
+            std::memcpy(end, &DIGIT_PAIRS[rest * 2], 2);
+        } else {
+            *--end = static_cast<char>('0' + rest);
+        }
+        return end;
+    }
+
+
+    // `precision` decimals (at most MAX_PRECISION), correctly rounded. Values of 2^64 and above are
+    // rounded to 17 significant digits without decimals: zero-padded below 10^21 ("18446744073709552000"),
+    // in exponent form from there ("1.7976931348623157e+308")
+    static size_t Fixed(char* text, double value, uint8 precision) {
+        uint64 bits = std::bit_cast<uint64>(value);
+        bool negative = bits >> 63;
+        uint32 exponent = (bits >> 52) & 0x7FF;
+        uint64 mantissa = bits & ((1ull << 52) - 1);
+
+        if (exponent == 0x7FF) {
+            return WriteSpecial(text, negative, mantissa != 0);
+        }
+        precision = std::min(precision, MAX_PRECISION);
+
+        // value = m2 * 2^e2
+        int32 e2 = exponent == 0 ? 1 - 1075 : static_cast<int32>(exponent) - 1075;
+        uint64 m2 = exponent == 0 ? mantissa : mantissa | (1ull << 52);
+
+        uint64 integer = 0;
+        uint64 fraction = 0;
+        if (e2 >= 0) {
+            if (e2 >= 64 || (e2 > 11 && (m2 >> (64 - e2)) != 0)) {
+                return WriteLarge(text, negative, m2, e2);
+            }
+            integer = m2 << e2;
+        } else {
+            uint32 shift = -e2;
+            uint64 remainder = m2;
+            if (shift < 64) {
+                integer = m2 >> shift;
+                remainder = m2 & ((1ull << shift) - 1);
+            }
+
+            // fraction = remainder / 2^shift * 10^precision, rounded half to even
+            bool half = false;
+            bool sticky = false;
+            if (shift < 64 && std::bit_width(remainder) + std::bit_width(POW10[precision]) <= 64) {
+                uint64 product = remainder * POW10[precision];
+                fraction = product >> shift;
+                half = (product >> (shift - 1)) & 1;
+                sticky = (product & ((1ull << (shift - 1)) - 1)) != 0;
+            } else if (shift < 128) {
+                UInt128 product = Multiply(remainder, POW10[precision]);
+                fraction = ShiftRight(product, shift);
+                half = Bit(product, shift - 1);
+                sticky = HasBitsBelow(product, shift - 1);
+            }
+            // shift >= 128: the product is below 2^117, less than half of the last decimal
+
+            uint64 last = precision > 0 ? fraction : integer;
+            if (half && (sticky || (last & 1))) {
+                fraction++;
+            }
+
+            if (fraction == POW10[precision]) {
+                integer++;
+                fraction = 0;
+            }
+        }
+
+        char* out = text;
+        if (negative) {
+            *out++ = '-';
+        }
+
+        out += DecimalLength(integer);
+        WriteDecimal(out, integer);
+
+        if (precision > 0) {
+            *out++ = '.';
+            char* fractionEnd = out + precision;
+            for (char* start = WriteDecimal(fractionEnd, fraction); out < start;) {
+                *out++ = '0';
+            }
+            out = fractionEnd;
+        }
+        return out - text;
+    }
+
+
+    // Shortest text that reads back as exactly `value`, the closest one if there are several.
+    // Plain notation for decimal exponents from -7 to 20, like JavaScript, "1.5e+300" outside
+    template<typename T>
+    static size_t Shortest(char* text, T value) {
+        static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "float or double");
+        using Traits = std::conditional_t<std::is_same_v<T, float>, FloatTraits, DoubleTraits>;
+        using Bits = typename Traits::Bits;
+
+        Bits bits = std::bit_cast<Bits>(value);
+        bool negative = bits >> (Traits::MANTISSA_BITS + Traits::EXPONENT_BITS);
+        Bits mantissa = bits & ((Bits(1) << Traits::MANTISSA_BITS) - 1);
+        uint32 exponent = static_cast<uint32>(bits >> Traits::MANTISSA_BITS) & ((1u << Traits::EXPONENT_BITS) - 1);
+
+        if (exponent == (1u << Traits::EXPONENT_BITS) - 1) {
+            return WriteSpecial(text, negative, mantissa != 0);
+        }
+        if (exponent == 0 && mantissa == 0) {
+            return WriteScientificOrPlain(text, negative, 0, 0);
+        }
+
+        Decimal decimal = ToDecimal<Traits>(mantissa, exponent);
+        return WriteScientificOrPlain(text, negative, decimal.digits, decimal.exponent);
+    }
+
+
+    // Reads a number from the start of text: optional sign, digits with an optional point, an
+    // optional exponent, or Inf / NaN. Rounds to nearest, ties to even. Returns the characters
+    // used, 0 if there is no number
+    template<typename T>
+    static size_t Parse(const char* text, size_t length, T& value) {
+        static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>, "float or double");
+        using Traits = std::conditional_t<std::is_same_v<T, float>, FloatTraits, DoubleTraits>;
+        using Bits = typename Traits::Bits;
+
+        const char* p = text;
+        const char* end = text + length;
+        bool negative = p != end && *p == '-';
+        if (p != end && (*p == '-' || *p == '+')) {
+            p++;
+        }
+
+        if (end - p >= 3 && (p[0] | 0x20) == 'i' && (p[1] | 0x20) == 'n' && (p[2] | 0x20) == 'f') {
+            value = negative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+            p += 3;
+            const char* rest = "inity";
+            if (end - p >= 5 && std::equal(p, p + 5, rest, [](char c, char r) { return (c | 0x20) == r; })) {
+                p += 5;
+            }
+            return p - text;
+        }
+        if (end - p >= 3 && (p[0] | 0x20) == 'n' && (p[1] | 0x20) == 'a' && (p[2] | 0x20) == 'n') {
+            value = std::numeric_limits<T>::quiet_NaN();
+            return p + 3 - text;
+        }
+
+        // The first 19 digits fit 64 bits, more are only read again when needed
+        DecimalText decimal{};
+        uint64 w = 0;
+        decimal.integer = p;
+        p = ParseDigits(p, end, w);
+        decimal.integerLength = p - decimal.integer;
+        decimal.fraction = p;
+        if (p != end && *p == '.') {
+            decimal.fraction = ++p;
+            p = ParseDigits(p, end, w);
+            decimal.fractionLength = p - decimal.fraction;
+        }
+        size_t digitCount = decimal.integerLength + decimal.fractionLength;
+        if (digitCount == 0) {
+            return 0;
+        }
+
+        // "1e" and "1e+" end before the 'e'
+        if (p != end && (*p | 0x20) == 'e') {
+            const char* e = p + 1;
+            bool negativeExponent = e != end && *e == '-';
+            if (e != end && (*e == '-' || *e == '+')) {
+                e++;
+            }
+            if (e != end && IsDigit(*e)) {
+                int64 exponent = 0;
+                for (; e != end && IsDigit(*e); e++) {
+                    if (exponent < 100000000) {     // Far out of range already, keep consuming
+                        exponent = exponent * 10 + (*e - '0');
+                    }
+                }
+                decimal.exponent = negativeExponent ? -exponent : exponent;
+                p = e;
+            }
+        }
+
+        // Leading zeros are not significant, "0.000001234" still fits
+        size_t first = 0;
+        if (digitCount > 19) {
+            while (first < digitCount && decimal.Digit(first) == '0') {
+                first++;
+            }
+        }
+
+        Bits bits;
+        int64 q = decimal.exponent - static_cast<int64>(decimal.fractionLength);
+        if (digitCount - first > 19) {
+            bits = ToBinaryLong<Traits>(decimal, first);
+        } else if (w <= (1ull << (Traits::MANTISSA_BITS + 1)) && q == 0) {
+            T result = static_cast<T>(w);
+            value = negative ? -result : result;
+            return p - text;
+        } else if (Traits::HARDWARE_FLOAT && w <= (1ull << (Traits::MANTISSA_BITS + 1)) &&
+                   q >= -Traits::MAX_EXACT_POW10 && q <= Traits::MAX_EXACT_POW10) {
+            // Both operands are exact, so is the rounding of one operation
+            T result = static_cast<T>(w);
+            result = q < 0 ? result / Traits::EXACT_POW10[-q] : result * Traits::EXACT_POW10[q];
+            value = negative ? -result : result;
+            return p - text;
+        } else {
+            bits = EiselLemire<Traits>(w, q);
+        }
+
+        if (negative) {
+            bits |= Bits(1) << (Traits::MANTISSA_BITS + Traits::EXPONENT_BITS);
+        }
+        value = std::bit_cast<T>(bits);
+        return p - text;
+    }
+
+
+private:
+    static constexpr char DIGIT_PAIRS[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    static constexpr uint64 POW10[MAX_PRECISION + 1] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+        1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+        100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+        1000000000000000000ull, 10000000000000000000ull
+    };
+
+    // Plain 64-bit division is a library call on 32-bit cores, a multiplication by the
+    // reciprocal is not
+    static constexpr bool NATIVE_64 = sizeof(void*) >= 8;
+
+    struct UInt128 {
+        uint64 low;
+        uint64 high;
+    };
+
+    // value = digits * 10^exponent
+    struct Decimal {
+        uint64 digits;
+        int32 exponent;
+    };
+
+    // A number as written: integer.fraction * 10^exponent
+    struct DecimalText {
+        const char* integer;
+        size_t integerLength;
+        const char* fraction;
+        size_t fractionLength;
+        int64 exponent;
+
+        char Digit(size_t index) const {
+            return index < integerLength ? integer[index] : fraction[index - integerLength];
+        }
+    };
+
+
+    static UInt128 Multiply(uint64 a, uint64 b) {
+#if defined(__SIZEOF_INT128__)
+        __extension__ using UInt128Native = unsigned __int128;
+        UInt128Native product = static_cast<UInt128Native>(a) * b;
+        return { static_cast<uint64>(product), static_cast<uint64>(product >> 64) };
+#else
+        uint64 aLow = static_cast<uint32>(a);
+        uint64 aHigh = a >> 32;
+        uint64 bLow = static_cast<uint32>(b);
+        uint64 bHigh = b >> 32;
+
+        uint64 lowLow = aLow * bLow;
+        uint64 lowHigh = aLow * bHigh;
+        uint64 highLow = aHigh * bLow;
+        uint64 highHigh = aHigh * bHigh;
+
+        uint64 middle = (lowLow >> 32) + static_cast<uint32>(lowHigh) + static_cast<uint32>(highLow);
+        return { (middle << 32) | static_cast<uint32>(lowLow), highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32) };
+#endif
+    }
+
+
+    // Low 64 bits of value >> shift, shift < 128
+    static uint64 ShiftRight(UInt128 value, uint32 shift) {
+        if (shift == 0) {
+            return value.low;
+        }
+        if (shift < 64) {
+            return (value.high << (64 - shift)) | (value.low >> shift);
+        }
+        return value.high >> (shift - 64);
+    }
+
+
+    static bool Bit(UInt128 value, uint32 index) {
+        return index < 64 ? (value.low >> index) & 1 : (value.high >> (index - 64)) & 1;
+    }
+
+
+    static bool HasBitsBelow(UInt128 value, uint32 index) {
+        if (index < 64) {
+            return (value.low & ((1ull << index) - 1)) != 0;
+        }
+        return value.low != 0 || (value.high & ((1ull << (index - 64)) - 1)) != 0;
+    }
+
+
+    static uint64 Div10(uint64 value) {
+        if constexpr (NATIVE_64) {
+            return value / 10;
+        } else {
+            return Multiply(value, 0xCCCCCCCCCCCCCCCDull).high >> 3;
+        }
+    }
+
+
+    static uint64 Div100(uint64 value) {
+        if constexpr (NATIVE_64) {
+            return value / 100;
+        } else {
+            return Multiply(value >> 2, 0x28F5C28F5C28F5C3ull).high >> 2;
+        }
+    }
+
+
+    static uint64 Div1e8(uint64 value) {
+        if constexpr (NATIVE_64) {
+            return value / 100000000;
+        } else {
+            return Multiply(value, 0xABCC77118461CEFDull).high >> 26;
+        }
+    }
+
+
+    static uint32 Div10(uint32 value) {
+        return value / 10;
+    }
+
+
+    static uint32 Div100(uint32 value) {
+        return value / 100;
+    }
+
+
+    static uint32 DecimalLength(uint64 value) {
+        uint32 length = 1;
+        while (length <= MAX_PRECISION && value >= POW10[length]) {
+            length++;
+        }
+        return length;
+    }
+
+
+    static size_t WriteSpecial(char* text, bool negative, bool isNaN) {
+        const char* string = isNaN ? "NaN" : negative ? "-Inf" : "Inf";
+        size_t length = std::strlen(string);
+        std::memcpy(text, string, length);
+        return length;
+    }
+
+
+    static size_t WriteScientificOrPlain(char* text, bool negative, uint64 value, int32 exponent) {
+        char digits[20];
+        char* end = digits + sizeof(digits);
+        char* start = WriteDecimal(end, value);
+        int32 length = static_cast<int32>(end - start);
+        int32 point = length + exponent;    // Decimal point position counted from the first digit
+
+        char* out = text;
+        if (negative) {
+            *out++ = '-';
+        }
+
+        if (length <= point && point <= 21) {
+            std::memcpy(out, start, length);
+            std::memset(out + length, '0', point - length);
+            out += point;
+        } else if (0 < point && point <= 21) {
+            std::memcpy(out, start, point);
+            out[point] = '.';
+            std::memcpy(out + point + 1, start + point, length - point);
+            out += length + 1;
+        } else if (-6 < point && point <= 0) {
+            out[0] = '0';
+            out[1] = '.';
+            std::memset(out + 2, '0', -point);
+            std::memcpy(out + 2 - point, start, length);
+            out += 2 - point + length;
+        } else {
+            *out++ = start[0];
+            if (length > 1) {
+                *out++ = '.';
+                std::memcpy(out, start + 1, length - 1);
+                out += length - 1;
+            }
+            int32 e10 = point - 1;
+            *out++ = 'e';
+            *out++ = e10 < 0 ? '-' : '+';
+
+            char exponentDigits[4];
+            char* exponentEnd = exponentDigits + sizeof(exponentDigits);
+            char* exponentStart = WriteDecimal(exponentEnd, e10 < 0 ? -e10 : e10);
+            std::memcpy(out, exponentStart, exponentEnd - exponentStart);
+            out += exponentEnd - exponentStart;
+        }
+        return out - text;
+    }
+
+
+    // Exact m2 * 2^e2 rounded to 17 significant digits (enough to read it back), without the Ryu tables
+    static size_t WriteLarge(char* text, bool negative, uint64 m2, int32 e2) {
+        constexpr uint32 CHUNK = 1000000000;
+
+        // m2 << e2 as 32-bit limbs, up to 2^1024
+        uint32 limbs[34] = {};
+        int32 index = e2 / 32;
+        uint32 shift = e2 % 32;
+        uint64 shifted = m2 << shift;
+        limbs[index] = static_cast<uint32>(shifted);
+        limbs[index + 1] = static_cast<uint32>(shifted >> 32);
+        limbs[index + 2] = shift ? static_cast<uint32>(m2 >> (64 - shift)) : 0;
+        int32 count = index + 3;
+
+        // Base 10^9 chunks, least significant first
+        uint32 chunks[36];
+        int32 chunkCount = 0;
+        while (count > 0) {
+            while (count > 0 && limbs[count - 1] == 0) {
+                count--;
+            }
+            uint64 remainder = 0;
+            for (int32 i = count - 1; i >= 0; i--) {
+                uint64 value = (remainder << 32) | limbs[i];
+                limbs[i] = static_cast<uint32>(value / CHUNK);
+                remainder = value % CHUNK;
+            }
+            if (count > 0) {
+                chunks[chunkCount++] = static_cast<uint32>(remainder);
+            }
+        }
+
+        // The leading 18 digits, everything below only matters as "not zero"
+        char digits[36];
+        int32 i = chunkCount - 1;
+        char* start = WriteDecimal(digits + 9, chunks[i]);
+        int32 length = static_cast<int32>(digits + 9 - start);
+        std::memmove(digits, start, length);
+        int32 totalDigits = length + i * 9;
+        for (i--; i >= 0 && length < 18; i--, length += 9) {
+            start = WriteDecimal(digits + length + 9, chunks[i]);
+            std::memset(digits + length, '0', start - (digits + length));
+        }
+
+        bool sticky = false;
+        for (int32 digit = 18; digit < length; digit++) {
+            sticky |= digits[digit] != '0';
+        }
+        for (; i >= 0; i--) {
+            sticky |= chunks[i] != 0;
+        }
+
+        uint64 significand = 0;
+        for (int32 digit = 0; digit < 17; digit++) {
+            significand = significand * 10 + (digits[digit] - '0');
+        }
+        int32 exponent = totalDigits - 17;
+        char roundDigit = digits[17];
+        if (roundDigit > '5' || (roundDigit == '5' && (sticky || (significand & 1)))) {
+            significand++;
+            if (significand == POW10[17]) {
+                significand = POW10[16];
+                exponent++;
+            }
+        }
+        while (significand % 10 == 0) {
+            significand /= 10;
+            exponent++;
+        }
+        return WriteScientificOrPlain(text, negative, significand, exponent);
+    }
+
+
+    /* Ryu */
+
+    struct DoubleTraits {
+        using Bits = uint64;
+        using Digits = uint64;
+        using Entry = UInt128;
+        static constexpr int32 MANTISSA_BITS = 52;
+        static constexpr int32 EXPONENT_BITS = 11;
+        static constexpr int32 BIAS = 1023;
+        static constexpr int32 SPLIT_BITS = 125;
+        static constexpr int32 INVERSE_BITS = 125;
+        static constexpr size_t SPLIT_COUNT = 326;
+        static constexpr size_t INVERSE_COUNT = 292;
+        static constexpr uint32 MAX_POW5_FACTOR = 21;   // 5^22 > 2^55 > mv
+        static constexpr bool EXTRA_DIGIT = true;       // vr keeps one digit more, it still fits 64 bits
+
+        // Parse: 19 digits times 10^q round to zero below MIN_DECIMAL_EXPONENT, ties are only possible
+        // from MIN_EVEN_EXPONENT to MAX_EVEN_EXPONENT, powers of 10 are exact up to 10^MAX_EXACT_POW10
+        static constexpr int32 MIN_DECIMAL_EXPONENT = -342;
+        static constexpr int32 MAX_DECIMAL_EXPONENT = 308;
+        static constexpr int32 MIN_EVEN_EXPONENT = -4;
+        static constexpr int32 MAX_EVEN_EXPONENT = 23;
+        static constexpr int32 MAX_EXACT_POW10 = 22;
+        static constexpr double EXACT_POW10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+#if defined(__x86_64__) || defined(__aarch64__) || (defined(__ARM_FP) && (__ARM_FP & 8))
+        static constexpr bool HARDWARE_FLOAT = true;
+#else
+        static constexpr bool HARDWARE_FLOAT = false;
+#endif
+    };
+
+    struct FloatTraits {
+        using Bits = uint32;
+        using Digits = uint32;
+        using Entry = uint64;
+        static constexpr int32 MANTISSA_BITS = 23;
+        static constexpr int32 EXPONENT_BITS = 8;
+        static constexpr int32 BIAS = 127;
+        static constexpr int32 SPLIT_BITS = 61;
+        static constexpr int32 INVERSE_BITS = 59;
+        static constexpr size_t SPLIT_COUNT = 48;
+        static constexpr size_t INVERSE_COUNT = 31;
+        static constexpr uint32 MAX_POW5_FACTOR = 11;   // 5^12 > 2^26 > mv
+        static constexpr bool EXTRA_DIGIT = false;      // An extra digit would overflow 32 bits
+
+        static constexpr int32 MIN_DECIMAL_EXPONENT = -65;
+        static constexpr int32 MAX_DECIMAL_EXPONENT = 38;
+        static constexpr int32 MIN_EVEN_EXPONENT = -17;
+        static constexpr int32 MAX_EVEN_EXPONENT = 10;
+        static constexpr int32 MAX_EXACT_POW10 = 10;
+        static constexpr float EXACT_POW10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+#if defined(__x86_64__) || defined(__aarch64__) || (defined(__ARM_FP) && (__ARM_FP & 4))
+        static constexpr bool HARDWARE_FLOAT = true;
+#else
+        static constexpr bool HARDWARE_FLOAT = false;
+#endif
+    };
+
+    template<typename Entry, size_t SplitCount, size_t InverseCount>
+    struct Pow5Table {
+        Entry split[SplitCount];        // floor(5^i / 2^(bitlength(5^i) - SPLIT_BITS))
+        Entry inverse[InverseCount];    // floor(2^(bitlength(5^i) - 1 + INVERSE_BITS) / 5^i) + 1
+    };
+
+
+    // Unsigned integer of Limbs 32-bit words. Builds the tables at compile time and settles
+    // the rare close calls of Parse at run time
+    template<int32 Limbs>
+    struct BigInt {
+        static constexpr int32 LIMBS = Limbs;
+        uint32 limbs[LIMBS] = {};
+
+        constexpr void Multiply(uint32 factor) {
+            uint64 carry = 0;
+            for (auto& limb : limbs) {
+                uint64 value = static_cast<uint64>(limb) * factor + carry;
+                limb = static_cast<uint32>(value);
+                carry = value >> 32;
+            }
+        }
+
+        constexpr void Divide(uint32 divisor) {
+            uint64 remainder = 0;
+            for (int32 i = LIMBS - 1; i >= 0; i--) {
+                uint64 value = (remainder << 32) | limbs[i];
+                limbs[i] = static_cast<uint32>(value / divisor);
+                remainder = value % divisor;
+            }
+        }
+
+        constexpr void Add(uint32 value) {
+            for (int32 i = 0; i < LIMBS && value; i++) {
+                limbs[i] += value;
+                value = limbs[i] < value;
+            }
+        }
+
+        constexpr void MultiplyPow5(uint32 power) {
+            constexpr uint32 POW5_13 = 1220703125;      // Largest power of 5 in 32 bits
+            for (; power >= 13; power -= 13) {
+                Multiply(POW5_13);
+            }
+            uint32 factor = 1;
+            for (; power > 0; power--) {
+                factor *= 5;
+            }
+            Multiply(factor);
+        }
+
+        constexpr void ShiftLeft(uint32 shift) {
+            int32 words = shift / 32;
+            uint32 bits = shift % 32;
+            for (int32 i = LIMBS - 1; i >= 0; i--) {
+                uint32 high = i - words >= 0 ? limbs[i - words] : 0;
+                uint32 low = i - words - 1 >= 0 ? limbs[i - words - 1] : 0;
+                limbs[i] = bits ? (high << bits) | (low >> (32 - bits)) : high;
+            }
+        }
+
+        constexpr int32 Compare(const BigInt& other) const {
+            for (int32 i = LIMBS - 1; i >= 0; i--) {
+                if (limbs[i] != other.limbs[i]) {
+                    return limbs[i] > other.limbs[i] ? 1 : -1;
+                }
+            }
+            return 0;
+        }
+
+        constexpr int32 BitLength() const {
+            for (int32 i = LIMBS - 1; i >= 0; i--) {
+                if (limbs[i]) {
+                    return i * 32 + std::bit_width(limbs[i]);
+                }
+            }
+            return 0;
+        }
+
+        constexpr bool Bit(int32 index) const {
+            return index >= 0 && index < LIMBS * 32 && (limbs[index / 32] >> (index % 32)) & 1;
+        }
+
+        // 64 bits of value >> shift starting at `offset`, a negative shift moves left
+        constexpr uint64 Bits(int32 shift, int32 offset) const {
+            uint64 result = 0;
+            for (int32 i = 63; i >= 0; i--) {
+                result = (result << 1) | Bit(shift + offset + i);
+            }
+            return result;
+        }
+    };
+
+
+    template<typename Traits>
+    static constexpr auto MakePow5Table() {
+        using Entry = typename Traits::Entry;
+        Pow5Table<Entry, Traits::SPLIT_COUNT, Traits::INVERSE_COUNT> table{};
+
+        constexpr int32 INVERSE_SCALE = 832;   // 2^INVERSE_SCALE / 5^i keeps enough bits for every entry
+        BigInt<28> power;          // 2^864 covers every entry
+        BigInt<28> inverse;
+        power.limbs[0] = 1;
+        inverse.limbs[INVERSE_SCALE / 32] = 1u << (INVERSE_SCALE % 32);
+
+        for (size_t i = 0; i < std::max(Traits::SPLIT_COUNT, Traits::INVERSE_COUNT); i++) {
+            int32 length = power.BitLength();
+            if (i < Traits::SPLIT_COUNT) {
+                table.split[i] = MakeEntry<Entry>(power, length - Traits::SPLIT_BITS, false);
+            }
+            if (i < Traits::INVERSE_COUNT) {
+                // floor(floor(2^s / 5^i) / 2^t) == floor(2^(s - t) / 5^i)
+                table.inverse[i] = MakeEntry<Entry>(inverse, INVERSE_SCALE - (length - 1 + Traits::INVERSE_BITS), true);
+            }
+            power.Multiply(5);
+            inverse.Divide(5);
+        }
+        return table;
+    }
+
+
+    template<typename Entry, int32 Limbs>
+    static constexpr Entry MakeEntry(const BigInt<Limbs>& value, int32 shift, bool addOne) {
+        if constexpr (std::is_same_v<Entry, UInt128>) {
+            UInt128 entry = { value.Bits(shift, 0), value.Bits(shift, 64) };
+            if (addOne && ++entry.low == 0) {
+                entry.high++;
+            }
+            return entry;
+        } else {
+            return value.Bits(shift, 0) + addOne;
+        }
+    }
+
+
+    // Instantiated on first use, so including the header does not build the tables
+    template<typename Traits>
+    static constexpr auto POW5_TABLE = MakePow5Table<Traits>();
+
+
+    static int32 Pow5Bits(int32 e) {
+        return static_cast<int32>((static_cast<uint32>(e) * 1217359) >> 19) + 1;    // ceil(log2(5^e)), e > 0
+    }
+
+
+    static uint32 Log10Pow2(int32 e) {
+        return (static_cast<uint32>(e) * 78913) >> 18;     // floor(log10(2^e))
+    }
+
+
+    static uint32 Log10Pow5(int32 e) {
+        return (static_cast<uint32>(e) * 732923) >> 20;    // floor(log10(5^e))
+    }
+
+
+    // (m * factor) >> shift
+    static uint64 MulShift(uint64 m, const UInt128& factor, int32 shift) {
+        UInt128 low = Multiply(m, factor.low);
+        UInt128 high = Multiply(m, factor.high);
+        UInt128 sum = { high.low + low.high, high.high };
+        if (sum.low < low.high) {
+            sum.high++;
+        }
+        return ShiftRight(sum, shift - 64);
+    }
+
+
+    static uint32 MulShift(uint32 m, uint64 factor, int32 shift) {
+        uint64 low = static_cast<uint64>(m) * static_cast<uint32>(factor);
+        uint64 high = static_cast<uint64>(m) * static_cast<uint32>(factor >> 32);
+        return static_cast<uint32>(((low >> 32) + high) >> (shift - 32));
+    }
+
+
+    // Multiplying by the modular inverse of 5 gives value / 5 exactly when it divides
+    template<typename T>
+    static bool MultipleOfPowerOf5(T value, uint32 power) {
+        constexpr T INVERSE5 = static_cast<T>(0xCCCCCCCCCCCCCCCDull);
+        constexpr T LIMIT = static_cast<T>(~T(0)) / 5;
+        for (uint32 i = 0; i < power; i++) {
+            value *= INVERSE5;
+            if (value > LIMIT) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    template<typename T>
+    static bool MultipleOfPowerOf2(T value, uint32 power) {
+        return (value & ((T(1) << power) - 1)) == 0;
+    }
+
+
+    template<typename Traits>
+    static Decimal ToDecimal(typename Traits::Bits mantissa, uint32 exponent) {
+        using Digits = typename Traits::Digits;
+        const auto& table = POW5_TABLE<Traits>;
+
+        // The value is m2 * 2^e2, shifted by 2 so that the halfway points to the neighbours are integers
+        int32 e2;
+        Digits m2;
+        if (exponent == 0) {
+            e2 = 1 - Traits::BIAS - Traits::MANTISSA_BITS - 2;
+            m2 = mantissa;
+        } else {
+            e2 = static_cast<int32>(exponent) - Traits::BIAS - Traits::MANTISSA_BITS - 2;
+            m2 = (Digits(1) << Traits::MANTISSA_BITS) | mantissa;
+        }
+        bool acceptBounds = (m2 & 1) == 0;
+
+        // The interval of values that round to this one is [mv - mmShift - 1, mv + 2] / 4 * 2^e2,
+        // the lower half is narrower at a power of two
+        Digits mv = 4 * m2;
+        uint32 mmShift = mantissa != 0 || exponent <= 1;
+
+        // Bring the interval to decimal: vr, vp, vm = (mv, upper, lower) * 2^e2 / 10^e10
+        Digits vr, vp, vm;
+        int32 e10;
+        bool vmIsTrailingZeros = false;
+        bool vrIsTrailingZeros = false;
+        uint8 lastRemovedDigit = 0;
+        if (e2 >= 0) {
+            // With EXTRA_DIGIT one digit fewer is removed here, so the loop below always sees
+            // the last removed digit. Otherwise it is computed separately when the loop may not run
+            uint32 q = Log10Pow2(e2);
+            if constexpr (Traits::EXTRA_DIGIT) {
+                q -= e2 > 3;
+            }
+            e10 = q;
+            int32 k = Traits::INVERSE_BITS + Pow5Bits(q) - 1;
+            int32 i = -e2 + static_cast<int32>(q) + k;
+            vr = MulShift(mv, table.inverse[q], i);
+            vp = MulShift(mv + 2, table.inverse[q], i);
+            vm = MulShift(mv - 1 - mmShift, table.inverse[q], i);
+
+            if (!Traits::EXTRA_DIGIT && q != 0 && Div10(vp - 1) <= Div10(vm)) {
+                int32 l = Traits::INVERSE_BITS + Pow5Bits(q - 1) - 1;
+                lastRemovedDigit = MulShift(mv, table.inverse[q - 1], -e2 + static_cast<int32>(q) - 1 + l) % 10;
+            }
+
+            if (q <= Traits::MAX_POW5_FACTOR) {
+                // Only one of mv - 1 - mmShift, mv, mv + 2 can be a multiple of 5
+                if (mv % 5 == 0) {
+                    vrIsTrailingZeros = MultipleOfPowerOf5(mv, q);
+                } else if (acceptBounds) {
+                    vmIsTrailingZeros = MultipleOfPowerOf5(mv - 1 - mmShift, q);
+                } else {
+                    vp -= MultipleOfPowerOf5(mv + 2, q);
+                }
+            }
+        } else {
+            uint32 q = Log10Pow5(-e2);
+            if constexpr (Traits::EXTRA_DIGIT) {
+                q -= -e2 > 1;
+            }
+            e10 = static_cast<int32>(q) + e2;
+            int32 i = -e2 - static_cast<int32>(q);
+            int32 k = Pow5Bits(i) - Traits::SPLIT_BITS;
+            int32 j = static_cast<int32>(q) - k;
+            vr = MulShift(mv, table.split[i], j);
+            vp = MulShift(mv + 2, table.split[i], j);
+            vm = MulShift(mv - 1 - mmShift, table.split[i], j);
+
+            if (!Traits::EXTRA_DIGIT && q != 0 && Div10(vp - 1) <= Div10(vm)) {
+                j = static_cast<int32>(q) - 1 - (Pow5Bits(i + 1) - Traits::SPLIT_BITS);
+                lastRemovedDigit = MulShift(mv, table.split[i + 1], j) % 10;
+            }
+
+            if (q <= 1) {
+                // mv has at least q trailing binary zeros, so vr is exact
+                vrIsTrailingZeros = true;
+                if (acceptBounds) {
+                    vmIsTrailingZeros = mmShift == 1;
+                } else {
+                    --vp;
+                }
+            } else if (q < sizeof(Digits) * 8 - 1) {
+                vrIsTrailingZeros = MultipleOfPowerOf2(mv, Traits::EXTRA_DIGIT ? q : q - 1);
+            }
+        }
+
+        // Drop digits while the interval still holds a shorter number
+        int32 removed = 0;
+        Digits output;
+        if (vmIsTrailingZeros || vrIsTrailingZeros) {
+            // Rare: exact bounds or a tie, track both
+            while (Div10(vp) > Div10(vm)) {
+                Digits vmDiv10 = Div10(vm);
+                vmIsTrailingZeros &= vm - vmDiv10 * 10 == 0;
+                vrIsTrailingZeros &= lastRemovedDigit == 0;
+                Digits vrDiv10 = Div10(vr);
+                lastRemovedDigit = static_cast<uint8>(vr - vrDiv10 * 10);
+                vr = vrDiv10;
+                vp = Div10(vp);
+                vm = vmDiv10;
+                removed++;
+            }
+            if (vmIsTrailingZeros) {
+                while (vm - Div10(vm) * 10 == 0) {
+                    vrIsTrailingZeros &= lastRemovedDigit == 0;
+                    Digits vrDiv10 = Div10(vr);
+                    lastRemovedDigit = static_cast<uint8>(vr - vrDiv10 * 10);
+                    vr = vrDiv10;
+                    vp = Div10(vp);
+                    vm = Div10(vm);
+                    removed++;
+                }
+            }
+            if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) {
+                lastRemovedDigit = 4;   // Exactly halfway, round to even
+            }
+            output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+        } else {
+            bool roundUp = lastRemovedDigit >= 5;
+            if (Div100(vp) > Div100(vm)) {
+                Digits vrDiv100 = Div100(vr);
+                roundUp = vr - vrDiv100 * 100 >= 50;
+                vr = vrDiv100;
+                vp = Div100(vp);
+                vm = Div100(vm);
+                removed += 2;
+            }
+            while (Div10(vp) > Div10(vm)) {
+                Digits vrDiv10 = Div10(vr);
+                roundUp = vr - vrDiv10 * 10 >= 5;
+                vr = vrDiv10;
+                vp = Div10(vp);
+                vm = Div10(vm);
+                removed++;
+            }
+            output = vr + (vr == vm || roundUp);
+        }
+
+        return { output, e10 + removed };
+    }
+
+
+    /* Eisel-Lemire */
+
+    static bool IsDigit(char c) {
+        return static_cast<uint8>(c - '0') < 10;
+    }
+
+
+    // Eight characters loaded little-endian: all digits if no byte leaves 0x30..0x39 when
+    // 6 is added
+    static bool IsEightDigits(uint64 chunk) {
+        return ((chunk & 0xF0F0F0F0F0F0F0F0ull) |
+                (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+    }
+
+
+    // Pairs, then fours, then the eight digits combined by three multiplications
+    static uint32 EightDigits(uint64 chunk) {
+        chunk = ((chunk & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+        chunk = ((chunk & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+        return static_cast<uint32>(((chunk & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32);
+    }
+
+
+    // Appends the digits at p to value, wrapping past 19 digits. Returns the first non-digit
+    static const char* ParseDigits(const char* p, const char* end, uint64& value) {
+        if constexpr (std::endian::native == std::endian::little) {
+            uint64 chunk;
+            while (end - p >= 8 && (std::memcpy(&chunk, p, 8), IsEightDigits(chunk))) {
+                value = value * 100000000 + EightDigits(chunk);
+                p += 8;
+            }
+        }
+        for (; p != end && IsDigit(*p); p++) {
+            value = value * 10 + (*p - '0');
+        }
+        return p;
+    }
+
+
+    // 5^q for q from MIN_DECIMAL_EXPONENT to MAX_DECIMAL_EXPONENT, the top 128 bits with bit 127 set.
+    // Negative powers are floor(2^b / 5^-q) + 1, truncated, exactly the table the error bounds
+    // of Eisel-Lemire are proven for
+    template<typename Traits>
+    static constexpr auto MakeEiselLemireTable() {
+        std::array<UInt128, Traits::MAX_DECIMAL_EXPONENT - Traits::MIN_DECIMAL_EXPONENT + 1> table{};
+
+        BigInt<56> power;
+        power.limbs[0] = 1;
+        for (int32 q = 0; q <= Traits::MAX_DECIMAL_EXPONENT; q++) {
+            table[q - Traits::MIN_DECIMAL_EXPONENT] = MakeEntry<UInt128>(power, power.BitLength() - 128, false);
+            power.Multiply(5);
+        }
+
+        constexpr int32 INVERSE_SCALE = 1760;   // Above the largest b, 1718 at 5^342
+        BigInt<56> inverse;
+        inverse.limbs[INVERSE_SCALE / 32] = 1u << (INVERSE_SCALE % 32);
+        power = {};
+        power.limbs[0] = 1;
+        for (int32 q = -1; q >= Traits::MIN_DECIMAL_EXPONENT; q--) {
+            power.Multiply(5);
+            inverse.Divide(5);
+
+            int32 z = power.BitLength();
+            int32 b = q >= -27 ? z + 127 : 2 * z + 128;
+            int32 shift = INVERSE_SCALE - b;    // floor(2^b / 5^-q) == inverse >> shift
+            int32 cut = std::max(inverse.BitLength() - shift - 128, 0);
+
+            // The + 1 reaches the kept bits through a run of ones below them
+            bool carry = true;
+            for (int32 i = 0; i < cut && carry; i++) {
+                carry = inverse.Bit(shift + i);
+            }
+            UInt128 entry = MakeEntry<UInt128>(inverse, shift + cut, carry);
+            table[q - Traits::MIN_DECIMAL_EXPONENT] = entry.high != 0 ? entry : UInt128{ 0, 1ull << 63 };
+        }
+        return table;
+    }
+
+
+    template<typename Traits>
+    static constexpr auto POW5_128 = MakeEiselLemireTable<Traits>();
+
+
+    // w * 10^q correctly rounded, w < 10^19. The product with the truncated 5^q is off by less
+    // than the bits kept below the result, so it never needs a slower fallback
+    // (Mushtak, Lemire, "Fast number parsing without fallback", 2023)
+    template<typename Traits>
+    static typename Traits::Bits EiselLemire(uint64 w, int64 q) {
+        using Bits = typename Traits::Bits;
+        constexpr int32 INFINITE_EXPONENT = (1 << Traits::EXPONENT_BITS) - 1;
+        constexpr int32 PRECISION = Traits::MANTISSA_BITS + 3;
+        constexpr uint64 PRECISION_MASK = ~0ull >> PRECISION;
+
+        if (w == 0 || q < Traits::MIN_DECIMAL_EXPONENT) {
+            return 0;
+        }
+        if (q > Traits::MAX_DECIMAL_EXPONENT) {
+            return Bits(INFINITE_EXPONENT) << Traits::MANTISSA_BITS;
+        }
+
+        int32 leadingZeros = std::countl_zero(w);
+        w <<= leadingZeros;
+        const UInt128& power = POW5_128<Traits>[q - Traits::MIN_DECIMAL_EXPONENT];
+        UInt128 product = Multiply(w, power.high);
+        if ((product.high & PRECISION_MASK) == PRECISION_MASK) {
+            // All ones below the result, the lower half of 5^q may carry into it
+            UInt128 low = Multiply(w, power.low);
+            product.low += low.high;
+            product.high += product.low < low.high;
+        }
+
+        int32 upperBit = static_cast<int32>(product.high >> 63);
+        int32 shift = upperBit + 64 - PRECISION;
+        uint64 mantissa = product.high >> shift;
+        // floor(log2(10^q)) + 63 is the binary exponent of the product
+        int32 exponent = static_cast<int32>((217706 * q) >> 16) + 63 + upperBit - leadingZeros + Traits::BIAS;
+
+        if (exponent <= 0) {
+            // Subnormal. Rounding up may still reach the smallest normal, whose bits are the
+            // same mantissa with the hidden bit in the exponent field
+            if (1 - exponent >= 64) {
+                return 0;
+            }
+            mantissa >>= 1 - exponent;
+            mantissa += mantissa & 1;
+            return static_cast<Bits>(mantissa >> 1);
+        }
+
+        // An exact tie rounds up below unless the result is even. Only small powers of 5
+        // can make w * 5^q end right at the halfway point
+        if (product.low <= 1 && q >= Traits::MIN_EVEN_EXPONENT && q <= Traits::MAX_EVEN_EXPONENT &&
+            (mantissa & 3) == 1 && (mantissa << shift) == product.high) {
+            mantissa &= ~1ull;
+        }
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        if (mantissa >= (2ull << Traits::MANTISSA_BITS)) {
+            mantissa = 1ull << Traits::MANTISSA_BITS;
+            exponent++;
+        }
+        mantissa &= ~(1ull << Traits::MANTISSA_BITS);
+
+        if (exponent >= INFINITE_EXPONENT) {
+            return Bits(INFINITE_EXPONENT) << Traits::MANTISSA_BITS;
+        }
+        return (Bits(exponent) << Traits::MANTISSA_BITS) | static_cast<Bits>(mantissa);
+    }
+
+
+    // More than 19 significant digits from `first` on: the first 19 give w, the value is in
+    // [w, w + 1) * 10^q. When both ends round the same there is nothing left to decide
+    template<typename Traits>
+    static typename Traits::Bits ToBinaryLong(const DecimalText& decimal, size_t first) {
+        size_t count = decimal.integerLength + decimal.fractionLength;
+        size_t significant = count - first;
+        size_t taken = 19;
+
+        uint64 w = 0;
+        for (size_t i = first; i < first + taken; i++) {
+            w = w * 10 + (decimal.Digit(i) - '0');
+        }
+        int64 q = decimal.exponent - static_cast<int64>(decimal.fractionLength) + static_cast<int64>(significant - taken);
+
+        auto bits = EiselLemire<Traits>(w, q);
+        if (bits != EiselLemire<Traits>(w + 1, q)) {
+            bits = RoundExact<Traits>(decimal, first, bits);
+        }
+        return bits;
+    }
+
+
+    // The value is between `bits` and the next float up: compares all digits with the halfway
+    // point in big integers. Only reached for long inputs that are within 10^-19 of a tie
+    template<typename Traits>
+    static typename Traits::Bits RoundExact(const DecimalText& decimal, size_t first, typename Traits::Bits bits) {
+        using Bits = typename Traits::Bits;
+        // A halfway point has at most 767 significant digits, later ones can only break a tie
+        constexpr size_t MAX_DIGITS = 769;
+        // 10^769 shifted against 5^1111 * 2^54 still fits
+        using Big = BigInt<88>;
+
+        size_t count = decimal.integerLength + decimal.fractionLength;
+        size_t last = std::min(count, first + MAX_DIGITS);
+
+        Big digits;
+        for (size_t i = first; i < last;) {
+            uint32 chunk = 0;
+            uint32 multiplier = 1;
+            for (size_t stop = std::min(last, i + 9); i < stop; i++) {
+                chunk = chunk * 10 + (decimal.Digit(i) - '0');
+                multiplier *= 10;
+            }
+            digits.Multiply(multiplier);
+            digits.Add(chunk);
+        }
+        bool sticky = false;
+        for (size_t i = last; i < count && !sticky; i++) {
+            sticky = decimal.Digit(i) != '0';
+        }
+        int32 exponent10 = static_cast<int32>(decimal.exponent - static_cast<int64>(decimal.fractionLength) +
+                                              static_cast<int64>(count - last));
+
+        // Halfway = (2m + 1) * 2^(e - 1), with bits = m * 2^e
+        uint32 biased = static_cast<uint32>(bits >> Traits::MANTISSA_BITS);
+        uint64 m = bits & ((Bits(1) << Traits::MANTISSA_BITS) - 1);
+        if (biased != 0) {
+            m |= 1ull << Traits::MANTISSA_BITS;
+        }
+        int32 e = static_cast<int32>(std::max(biased, 1u)) - Traits::BIAS - Traits::MANTISSA_BITS;
+
+        Big halfway;
+        uint64 twice = 2 * m + 1;
+        halfway.limbs[0] = static_cast<uint32>(twice);
+        halfway.limbs[1] = static_cast<uint32>(twice >> 32);
+
+        // digits * 10^exponent10 against halfway, both scaled to integers
+        if (exponent10 >= 0) {
+            digits.MultiplyPow5(exponent10);
+        } else {
+            halfway.MultiplyPow5(-exponent10);
+        }
+        int32 shift = e - 1 - exponent10;
+        if (shift > 0) {
+            halfway.ShiftLeft(shift);
+        } else {
+            digits.ShiftLeft(-shift);
+        }
+
+        int32 comparison = digits.Compare(halfway);
+        if (comparison > 0 || (comparison == 0 && (sticky || (m & 1)))) {
+            bits++;
+        }
+        return bits;
+    }
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <VHAL.h>
+#include "NumberFormat.h"
 #include <string_view>
 #include <type_traits>
 #include <cstring>
@@ -55,6 +56,17 @@ public:
     }
 
 
+    // As few digits as needed to read the same value back: 0.1f -> "0.1", 1e-9 -> "1e-9"
+    template <typename T>
+    std::enable_if_t<std::is_floating_point_v<T>, size_t>
+    WriteShortest(T number) {
+        char buffer[NumberFormat::MAX_FLOAT_LENGTH];
+        size_t len = FloatToShortestString(buffer, sizeof(buffer), number);
+        WriteRaw(buffer, len);
+        return len;
+    }
+
+
     size_t Write(const std::string_view str) {
         WriteRaw(str.data(), str.size());
         return str.size();
@@ -132,7 +144,7 @@ public:
         if constexpr (std::is_signed_v<T>) {
             if (number < 0 && format == Format::Dec) {
                 isNegative = true;
-                unsignedNumber = static_cast<uint64>(-static_cast<int64_t>(number));
+                unsignedNumber = 0 - static_cast<uint64>(number);
             } else {
                 unsignedNumber = static_cast<uint64>(number);
             }
@@ -144,6 +156,7 @@ public:
     }
 
 
+    // Correctly rounded to `precision` decimals (19 at most)
     template <typename T>
     static std::enable_if_t<std::is_floating_point_v<T>, size_t>
     FloatToString(char* buffer, size_t bufferSize, T number, uint8_t precision = 2) {
@@ -151,6 +164,21 @@ public:
     }
 
 
+    // Shortest text that reads back as the same float or double
+    template <typename T>
+    static std::enable_if_t<std::is_floating_point_v<T>, size_t>
+    FloatToShortestString(char* buffer, size_t bufferSize, T number) {
+        char text[NumberFormat::MAX_FLOAT_LENGTH];
+        size_t length;
+        if constexpr (std::is_same_v<T, float>) {
+            length = NumberFormat::Shortest(text, number);
+        } else {
+            length = NumberFormat::Shortest(text, static_cast<double>(number));
+        }
+        return CopyTruncated(buffer, bufferSize, text, length);
+    }
+
+
     template <typename T>
     static std::enable_if_t<std::is_integral_v<T>, bool>
     StringToNumber(const char* str, T& result, size_t* endPos = nullptr) {
@@ -166,174 +194,76 @@ public:
     template <typename T>
     static std::enable_if_t<std::is_floating_point_v<T>, bool>
     StringToFloat(const char* str, T& result, size_t* endPos = nullptr) {
-        double temp;
-        bool success = StringToFloatCore(str, temp, endPos);
-        if (success) {
-            result = static_cast<T>(temp);
+        if constexpr (std::is_same_v<T, float>) {
+            return StringToFloatCore(str, result, endPos);
+        } else {
+            double temp;
+            bool success = StringToFloatCore(str, temp, endPos);
+            if (success) {
+                result = static_cast<T>(temp);
+            }
+            return success;
         }
-        return success;
     }
 
 
 private:
     static size_t NumberToStringCore(char* buffer, size_t bufferSize, uint64_t number, bool isNegative, uint8_t typeSize, Format format) {
         if (bufferSize == 0) return 0;
-        
-        size_t idx = 0;
-        char tempBuffer[66]; // Max for binary representation of 64-bit number + null
-        
-        // Handle zero case for decimal
-        if (number == 0 && format == Format::Dec) {
-            if (bufferSize > 1) {
-                buffer[0] = '0';
-                buffer[1] = '\0';
-                return 1;
-            }
-            return 0;
-        }
+
+        // Digits are written backwards from the end, no reversing afterwards
+        char tempBuffer[66]; // Max for binary representation of 64-bit number + sign
+        char* end = tempBuffer + sizeof(tempBuffer);
+        char* start = end;
 
         if (format == Format::Bin) {
-            size_t bits = typeSize * 8;
-            for (size_t i = 0; i < bits && idx < sizeof(tempBuffer) - 1; ++i) {
-                tempBuffer[idx++] = (number & (1ULL << (bits - 1 - i))) ? '1' : '0';
+            for (size_t i = 0; i < typeSize * 8u; ++i) {
+                *--start = '0' + (number & 1);
+                number >>= 1;
             }
         } else if (format == Format::Hex) {
             static const char* hex_digits = "0123456789ABCDEF";
             do {
-                tempBuffer[idx++] = hex_digits[number % 16];
-                number /= 16;
-            } while (number > 0 && idx < sizeof(tempBuffer) - 1);
-            // Reverse hex digits
-            for (size_t i = 0; i < idx / 2; ++i) {
-                char temp = tempBuffer[i];
-                tempBuffer[i] = tempBuffer[idx - i - 1];
-                tempBuffer[idx - i - 1] = temp;
-            }
+                *--start = hex_digits[number & 0xF];
+                number >>= 4;
+            } while (number > 0);
         } else if (format == Format::Oct) {
             do {
-                tempBuffer[idx++] = '0' + (number % 8);
-                number /= 8;
-            } while (number > 0 && idx < sizeof(tempBuffer) - 1);
-            // Reverse oct digits
-            for (size_t i = 0; i < idx / 2; ++i) {
-                char temp = tempBuffer[i];
-                tempBuffer[i] = tempBuffer[idx - i - 1];
-                tempBuffer[idx - i - 1] = temp;
-            }
+                *--start = '0' + (number & 7);
+                number >>= 3;
+            } while (number > 0);
         } else { // Format::Dec
-            size_t num_start = idx;
-            do {
-                tempBuffer[idx++] = '0' + (number % 10);
-                number /= 10;
-            } while (number > 0 && idx < sizeof(tempBuffer) - 1);
-            
-            // Reverse digits
-            for (size_t i = num_start; i < num_start + (idx - num_start) / 2; ++i) {
-                char temp = tempBuffer[i];
-                tempBuffer[i] = tempBuffer[idx - (i - num_start) - 1];
-                tempBuffer[idx - (i - num_start) - 1] = temp;
-            }
-            
-            if (isNegative && idx < sizeof(tempBuffer) - 1) {
-                // Insert minus at the beginning
-                for (size_t i = idx; i > 0; --i) {
-                    tempBuffer[i] = tempBuffer[i - 1];
-                }
-                tempBuffer[0] = '-';
-                idx++;
+            start = NumberFormat::WriteDecimal(end, number);
+            if (isNegative) {
+                *--start = '-';
             }
         }
 
-        // Copy to output buffer
-        size_t copyLen = (idx < bufferSize - 1) ? idx : bufferSize - 1;
-        for (size_t i = 0; i < copyLen; ++i) {
-            buffer[i] = tempBuffer[i];
-        }
-        buffer[copyLen] = '\0';
-        return copyLen;
+        return CopyTruncated(buffer, bufferSize, start, end - start);
     }
     
     
     static size_t FloatToStringCore(char* buffer, size_t bufferSize, double number, uint8_t precision) {
         if (bufferSize == 0) return 0;
-        
-        char tempBuffer[64];
-        size_t idx = 0;
 
-        bool isNegative = false;
-        if (number < 0) {
-            isNegative = true;
-            number = -number;
+        if (bufferSize > NumberFormat::MAX_FLOAT_LENGTH) {
+            size_t length = NumberFormat::Fixed(buffer, number, precision);
+            buffer[length] = '\0';
+            return length;
         }
 
-        // Handle special cases using direct bit comparison instead of std functions
-        if (number != number) { // NaN check without std::isnan
-            const char* str = isNegative ? "-NaN" : "NaN";
-            size_t len = isNegative ? 4 : 3;
-            if (len < bufferSize) {
-                for (size_t i = 0; i < len; ++i) {
-                    buffer[i] = str[i];
-                }
-                buffer[len] = '\0';
-                return len;
-            }
-            return 0;
-        }
-        
-        if (number > 1e308) { // Infinity check without std::isinf
-            const char* str = isNegative ? "-Inf" : "Inf";
-            size_t len = isNegative ? 4 : 3;
-            if (len < bufferSize) {
-                for (size_t i = 0; i < len; ++i) {
-                    buffer[i] = str[i];
-                }
-                buffer[len] = '\0';
-                return len;
-            }
-            return 0;
-        }
-
-        if (isNegative) {
-            tempBuffer[idx++] = '-';
-        }
+        char tempBuffer[NumberFormat::MAX_FLOAT_LENGTH];
+        size_t length = NumberFormat::Fixed(tempBuffer, number, precision);
+        return CopyTruncated(buffer, bufferSize, tempBuffer, length);
+    }
 
-        // Extract integer and fractional parts without std::floor
-        uint64_t integerPart = (uint64_t)number;
-        double fractionalPart = number - integerPart;
 
-        // Convert integer part using our optimized core function
-        if (integerPart == 0) {
-            tempBuffer[idx++] = '0';
-        } else {
-            size_t intStart = idx;
-            while (integerPart > 0 && idx < sizeof(tempBuffer) - 1) {
-                tempBuffer[idx++] = '0' + (integerPart % 10);
-                integerPart /= 10;
-            }
-            // Reverse integer digits
-            for (size_t i = intStart; i < intStart + (idx - intStart) / 2; ++i) {
-                char temp = tempBuffer[i];
-                tempBuffer[i] = tempBuffer[idx - (i - intStart) - 1];
-                tempBuffer[idx - (i - intStart) - 1] = temp;
-            }
-        }
-
-        // Add decimal point and fractional part
-        if (precision > 0 && idx < sizeof(tempBuffer) - 1) {
-            tempBuffer[idx++] = '.';
-            for (uint8_t i = 0; i < precision && idx < sizeof(tempBuffer) - 1; ++i) {
-                fractionalPart *= 10;
-                int digit = (int)fractionalPart;
-                tempBuffer[idx++] = '0' + digit;
-                fractionalPart -= digit;
-            }
-        }
+    // Copies as much as fits and terminates with zero, returns the copied length
+    static size_t CopyTruncated(char* buffer, size_t bufferSize, const char* text, size_t length) {
+        if (bufferSize == 0) return 0;
 
-        // Copy to output buffer
-        size_t copyLen = (idx < bufferSize - 1) ? idx : bufferSize - 1;
-        for (size_t i = 0; i < copyLen; ++i) {
-            buffer[i] = tempBuffer[i];
-        }
+        size_t copyLen = (length < bufferSize - 1) ? length : bufferSize - 1;
+        std::memcpy(buffer, text, copyLen);
         buffer[copyLen] = '\0';
         return copyLen;
     }
@@ -430,121 +360,19 @@ private:
     }
 
     
-    static bool StringToFloatCore(const char* str, double& result, size_t* endPos = nullptr) {
+    // Correctly rounded, see NumberFormat::Parse
+    template <typename T>
+    static bool StringToFloatCore(const char* str, T& result, size_t* endPos = nullptr) {
         if (!str) return false;
-        
+
         size_t pos = 0;
-        
-        // Skip whitespace
         while (str[pos] == ' ' || str[pos] == '\t') {
             ++pos;
         }
-        
-        if (str[pos] == '\0') {
-            if (endPos) *endPos = pos;
-            return false;
-        }
-        
-        bool negative = false;
-        if (str[pos] == '-') {
-            negative = true;
-            ++pos;
-        } else if (str[pos] == '+') {
-            ++pos;
-        }
-        
-        // Check for special values without std::numeric_limits
-        if (str[pos] == 'I' || str[pos] == 'i') {
-            if ((str[pos+1] == 'n' || str[pos+1] == 'N') && 
-                (str[pos+2] == 'f' || str[pos+2] == 'F')) {
-                result = negative ? -1.0/0.0 : 1.0/0.0; // Infinity without std
-                pos += 3;
-                if (endPos) *endPos = pos;
-                return true;
-            }
-        }
-        
-        if (str[pos] == 'N' || str[pos] == 'n') {
-            if ((str[pos+1] == 'a' || str[pos+1] == 'A') && 
-                (str[pos+2] == 'n' || str[pos+2] == 'N')) {
-                result = 0.0/0.0; // NaN without std
-                pos += 3;
-                if (endPos) *endPos = pos;
-                return true;
-            }
-        }
-        
-        // Parse number
-        double integerPart = 0;
-        double fractionalPart = 0;
-        double divisor = 1;
-        bool hasInteger = false;
-        bool hasFraction = false;
-        
-        // Integer part
-        while (str[pos] >= '0' && str[pos] <= '9') {
-            integerPart = integerPart * 10 + (str[pos] - '0');
-            hasInteger = true;
-            ++pos;
-        }
-        
-        // Fractional part
-        if (str[pos] == '.') {
-            ++pos;
-            while (str[pos] >= '0' && str[pos] <= '9') {
-                fractionalPart = fractionalPart * 10 + (str[pos] - '0');
-                divisor *= 10;
-                hasFraction = true;
-                ++pos;
-            }
-        }
-        
-        if (!hasInteger && !hasFraction) {
-            if (endPos) *endPos = pos;
-            return false;
-        }
-        
-        result = integerPart + (fractionalPart / divisor);
-        
-        // Handle exponent
-        if (str[pos] == 'e' || str[pos] == 'E') {
-            ++pos;
-            bool expNegative = false;
-            if (str[pos] == '-') {
-                expNegative = true;
-                ++pos;
-            } else if (str[pos] == '+') {
-                ++pos;
-            }
-            
-            int exponent = 0;
-            bool hasExponent = false;
-            while (str[pos] >= '0' && str[pos] <= '9') {
-                exponent = exponent * 10 + (str[pos] - '0');
-                hasExponent = true;
-                ++pos;
-            }
-            
-            if (hasExponent) {
-                double multiplier = 1;
-                for (int i = 0; i < exponent; ++i) {
-                    multiplier *= 10;
-                }
-                
-                if (expNegative) {
-                    result /= multiplier;
-                } else {
-                    result *= multiplier;
-                }
-            }
-        }
-        
-        if (negative) {
-            result = -result;
-        }
-        
-        if (endPos) *endPos = pos;
-        return true;
+
+        size_t length = NumberFormat::Parse(str + pos, strlen(str + pos), result);
+        if (endPos) *endPos = pos + length;
+        return length > 0;
     }
 
 
@@ -563,7 +391,7 @@ private:
     template <typename T>
     std::enable_if_t<std::is_floating_point_v<T>, size_t>
     WriteFloat(T number, uint8 precision) {
-        char buffer[64];
+        char buffer[NumberFormat::MAX_FLOAT_LENGTH + 1];
         size_t len = FloatToString(buffer, sizeof(buffer), number, precision);
         if (len > 0) {
             WriteRaw(buffer, len);
@@ -8,241 +8,447 @@ template class AES<AESKeySize::AES128>;
 template class AES<AESKeySize::AES192>;
 template class AES<AESKeySize::AES256>;
 
+#ifdef AES_CONSTANT_TIME
+namespace {
+    // 8x8 bit matrix transpose: bit c of byte r <-> bit r of byte c
+    inline uint64 Transpose8(uint64 x) noexcept {
+        uint64 t;
+        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+        x = x ^ t ^ (t << 7);
+        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+        x = x ^ t ^ (t << 14);
+        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+        x = x ^ t ^ (t << 28);
+        return x;
+    }
+
+    // 8 state words (32 bytes) -> 8 bit planes, plane j holds bit j of every byte
+    inline void ToBitPlanes(const uint32* state, uint32* planes) noexcept {
+        uint64 rows[4];
+        for (uint8 k = 0; k < 4; ++k) {
+            rows[k] = Transpose8((uint64(state[2 * k]) << 32) | state[2 * k + 1]);
+        }
+        for (uint8 j = 0; j < 8; ++j) {
+            planes[j] = uint32((rows[0] >> (8 * j)) & 0xff)
+                      | uint32((rows[1] >> (8 * j)) & 0xff) << 8
+                      | uint32((rows[2] >> (8 * j)) & 0xff) << 16
+                      | uint32((rows[3] >> (8 * j)) & 0xff) << 24;
+        }
+    }
+
+    inline void FromBitPlanes(const uint32* planes, uint32* state) noexcept {
+        for (uint8 k = 0; k < 4; ++k) {
+            uint64 row = 0;
+            for (uint8 j = 0; j < 8; ++j) {
+                row |= uint64((planes[j] >> (8 * k)) & 0xff) << (8 * j);
+            }
+            row = Transpose8(row);
+            state[2 * k] = uint32(row >> 32);
+            state[2 * k + 1] = uint32(row);
+        }
+    }
+
+    // Boyar-Peralta S-box circuit (113 gates) on bit planes, q[0] is the least significant bit
+    void BitslicedSbox(uint32* q) noexcept {
+        uint32 x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+        uint32 x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+        // Top linear transformation
+        uint32 y14 = x3 ^ x5;
+        uint32 y13 = x0 ^ x6;
+        uint32 y9 = x0 ^ x3;
+        uint32 y8 = x0 ^ x5;
+        uint32 t0 = x1 ^ x2;
+        uint32 y1 = t0 ^ x7;
+        uint32 y4 = y1 ^ x3;
+        uint32 y12 = y13 ^ y14;
+        uint32 y2 = y1 ^ x0;
+        uint32 y5 = y1 ^ x6;
+        uint32 y3 = y5 ^ y8;
+        uint32 t1 = x4 ^ y12;
+        uint32 y15 = t1 ^ x5;
+        uint32 y20 = t1 ^ x1;
+        uint32 y6 = y15 ^ x7;
+        uint32 y10 = y15 ^ t0;
+        uint32 y11 = y20 ^ y9;
+        uint32 y7 = x7 ^ y11;
+        uint32 y17 = y10 ^ y11;
+        uint32 y19 = y10 ^ y8;
+        uint32 y16 = t0 ^ y11;
+        uint32 y21 = y13 ^ y16;
+        uint32 y18 = x0 ^ y16;
+
+        // Non-linear section (GF(2^8) inversion)
+        uint32 t2 = y12 & y15;
+        uint32 t3 = y3 & y6;
+        uint32 t4 = t3 ^ t2;
+        uint32 t5 = y4 & x7;
+        uint32 t6 = t5 ^ t2;
+        uint32 t7 = y13 & y16;
+        uint32 t8 = y5 & y1;
+        uint32 t9 = t8 ^ t7;
+        uint32 t10 = y2 & y7;
+        uint32 t11 = t10 ^ t7;
+        uint32 t12 = y9 & y11;
+        uint32 t13 = y14 & y17;
+        uint32 t14 = t13 ^ t12;
+        uint32 t15 = y8 & y10;
+        uint32 t16 = t15 ^ t12;
+        uint32 t17 = t4 ^ t14;
+        uint32 t18 = t6 ^ t16;
+        uint32 t19 = t9 ^ t14;
+        uint32 t20 = t11 ^ t16;
+        uint32 t21 = t17 ^ y20;
+        uint32 t22 = t18 ^ y19;
+        uint32 t23 = t19 ^ y21;
+        uint32 t24 = t20 ^ y18;
+
+        uint32 t25 = t21 ^ t22;
+        uint32 t26 = t21 & t23;
+        uint32 t27 = t24 ^ t26;
+        uint32 t28 = t25 & t27;
+        uint32 t29 = t28 ^ t22;
+        uint32 t30 = t23 ^ t24;
+        uint32 t31 = t22 ^ t26;
+        uint32 t32 = t31 & t30;
+        uint32 t33 = t32 ^ t24;
+        uint32 t34 = t23 ^ t33;
+        uint32 t35 = t27 ^ t33;
+        uint32 t36 = t24 & t35;
+        uint32 t37 = t36 ^ t34;
+        uint32 t38 = t27 ^ t36;
+        uint32 t39 = t29 & t38;
+        uint32 t40 = t25 ^ t39;
+
+        uint32 t41 = t40 ^ t37;
+        uint32 t42 = t29 ^ t33;
+        uint32 t43 = t29 ^ t40;
+        uint32 t44 = t33 ^ t37;
+        uint32 t45 = t42 ^ t41;
+        uint32 z0 = t44 & y15;
+        uint32 z1 = t37 & y6;
+        uint32 z2 = t33 & x7;
+        uint32 z3 = t43 & y16;
+        uint32 z4 = t40 & y1;
+        uint32 z5 = t29 & y7;
+        uint32 z6 = t42 & y11;
+        uint32 z7 = t45 & y17;
+        uint32 z8 = t41 & y10;
+        uint32 z9 = t44 & y12;
+        uint32 z10 = t37 & y3;
+        uint32 z11 = t33 & y4;
+        uint32 z12 = t43 & y13;
+        uint32 z13 = t40 & y5;
+        uint32 z14 = t29 & y2;
+        uint32 z15 = t42 & y9;
+        uint32 z16 = t45 & y14;
+        uint32 z17 = t41 & y8;
+
+        // Bottom linear transformation
+        uint32 t46 = z15 ^ z16;
+        uint32 t47 = z10 ^ z11;
+        uint32 t48 = z5 ^ z13;
+        uint32 t49 = z9 ^ z10;
+        uint32 t50 = z2 ^ z12;
+        uint32 t51 = z2 ^ z5;
+        uint32 t52 = z7 ^ z8;
+        uint32 t53 = z0 ^ z3;
+        uint32 t54 = z6 ^ z7;
+        uint32 t55 = z16 ^ z17;
+        uint32 t56 = z12 ^ t48;
+        uint32 t57 = t50 ^ t53;
+        uint32 t58 = z4 ^ t46;
+        uint32 t59 = z3 ^ t54;
+        uint32 t60 = t46 ^ t57;
+        uint32 t61 = z14 ^ t57;
+        uint32 t62 = t52 ^ t58;
+        uint32 t63 = t49 ^ t58;
+        uint32 t64 = z4 ^ t59;
+        uint32 t65 = t61 ^ t62;
+        uint32 t66 = z1 ^ t63;
+        uint32 s0 = t59 ^ t63;
+        uint32 s6 = t56 ^ ~t62;
+        uint32 s7 = t48 ^ ~t60;
+        uint32 t67 = t64 ^ t65;
+        uint32 s3 = t53 ^ t66;
+        uint32 s4 = t51 ^ t66;
+        uint32 s5 = t47 ^ t65;
+        uint32 s1 = t64 ^ ~s3;
+        uint32 s2 = t55 ^ ~t67;
+
+        q[7] = s0; q[6] = s1; q[5] = s2; q[4] = s3;
+        q[3] = s4; q[2] = s5; q[1] = s6; q[0] = s7;
+    }
+
+    // Inverse of the S-box affine transform: b_i = y_(i+2) ^ y_(i+5) ^ y_(i+7) ^ (0x05 >> i)
+    inline void InvAffine(uint32* q) noexcept {
+        uint32 y[8];
+        std::copy_n(q, 8, y);
+        for (uint8 i = 0; i < 8; ++i) {
+            q[i] = y[(i + 2) % 8] ^ y[(i + 5) % 8] ^ y[(i + 7) % 8] ^ (((0x05 >> i) & 1) ? 0xFFFFFFFF : 0);
+        }
+    }
+
+    // Four xtime() at once, one per byte of the word
+    inline uint32 XTime4(uint32 x) noexcept {
+        return ((x & 0x7F7F7F7F) << 1) ^ (((x >> 7) & 0x01010101) * 0x1B);
+    }
+
+    inline uint32 MixColumn(uint32 w) noexcept {
+        uint32 r8 = std::rotl(w, 8);
+        return XTime4(w ^ r8) ^ r8 ^ std::rotl(w, 16) ^ std::rotl(w, 24);
+    }
+
+    inline uint32 InvMixColumn(uint32 w) noexcept {
+        // InvMixColumns = MixColumns after adding 4*(a_r ^ a_(r+2)) to each row
+        return MixColumn(w ^ XTime4(XTime4(w ^ std::rotl(w, 16))));
+    }
+}
+#endif
+
+template<AESKeySize KeySize>
+uint32 AES<KeySize>::SubWord(uint32 word) noexcept {
+#ifdef AES_CONSTANT_TIME
+    uint32 state[8] = { word };
+    CtSubBytes(state);
+    return state[0];
+#else
+    return (uint32(AESTables::sbox[word >> 24]) << 24) |
+           (uint32(AESTables::sbox[(word >> 16) & 0xff]) << 16) |
+           (uint32(AESTables::sbox[(word >> 8) & 0xff]) << 8) |
+           uint32(AESTables::sbox[word & 0xff]);
+#endif
+}
+
 template<AESKeySize KeySize>
 void AES<KeySize>::KeyExpansion(const Key& key) noexcept {
     constexpr size_t Nk = KEY_SIZE / 4;
-    constexpr size_t Nr = ROUNDS;
-    
-    uint8 temp[4];
-    
-    // Copy key to round key
-    std::copy(key.begin(), key.end(), roundKey.begin());
-    
+
+    // The first round keys are the key itself
+    for (size_t i = 0; i < Nk; ++i) {
+        roundKey[i] = LoadWord(&key[i * 4]);
+    }
+
     // All other round keys are found from the previous round keys
-    for (size_t i = Nk; i < 4 * (Nr + 1); ++i) {
-        size_t k = (i - 1) * 4;
-        temp[0] = roundKey[k + 0];
-        temp[1] = roundKey[k + 1];
-        temp[2] = roundKey[k + 2];
-        temp[3] = roundKey[k + 3];
+    for (size_t i = Nk; i < ROUND_KEY_WORDS; ++i) {
+        uint32 temp = roundKey[i - 1];
 
         if (i % Nk == 0) {
-            // RotWord
-            uint8 u8tmp = temp[0];
-            temp[0] = temp[1];
-            temp[1] = temp[2];
-            temp[2] = temp[3];
-            temp[3] = u8tmp;
-
-            // SubWord
-            temp[0] = sbox[temp[0]];
-            temp[1] = sbox[temp[1]];
-            temp[2] = sbox[temp[2]];
-            temp[3] = sbox[temp[3]];
-
-            temp[0] ^= Rcon[i/Nk];
-        }
-        
-        if constexpr (KeySize == AESKeySize::AES256) {
+            temp = SubWord(std::rotl(temp, 8)) ^ (uint32(Rcon[i / Nk]) << 24);
+        } else if constexpr (KeySize == AESKeySize::AES256) {
             if (i % Nk == 4) {
-                // SubWord
-                temp[0] = sbox[temp[0]];
-                temp[1] = sbox[temp[1]];
-                temp[2] = sbox[temp[2]];
-                temp[3] = sbox[temp[3]];
+                temp = SubWord(temp);
             }
         }
 
-        size_t j = i * 4; 
-        size_t l = (i - Nk) * 4;
-        roundKey[j + 0] = roundKey[l + 0] ^ temp[0];
-        roundKey[j + 1] = roundKey[l + 1] ^ temp[1];
-        roundKey[j + 2] = roundKey[l + 2] ^ temp[2];
-        roundKey[j + 3] = roundKey[l + 3] ^ temp[3];
+        roundKey[i] = roundKey[i - Nk] ^ temp;
     }
-}
 
-template<AESKeySize KeySize>
-void AES<KeySize>::SubBytes(std::array<std::array<uint8, 4>, 4>& state) const noexcept {
-    for (auto& row : state) {
-        for (auto& byte : row) {
-            byte = sbox[byte];
+#ifndef AES_CONSTANT_TIME
+    // Equivalent inverse cipher: reversed round order, InvMixColumns on the inner round keys
+    for (size_t round = 0; round <= ROUNDS; ++round) {
+        for (size_t c = 0; c < 4; ++c) {
+            uint32 word = roundKey[(ROUNDS - round) * 4 + c];
+            if (round != 0 && round != ROUNDS) {
+                // Td(S(x)) is InvMixColumns of a single byte
+                word = AESTables::Td[AESTables::sbox[word >> 24]] ^
+                       std::rotr(AESTables::Td[AESTables::sbox[(word >> 16) & 0xff]], 8) ^
+                       std::rotr(AESTables::Td[AESTables::sbox[(word >> 8) & 0xff]], 16) ^
+                       std::rotr(AESTables::Td[AESTables::sbox[word & 0xff]], 24);
+            }
+            invRoundKey[round * 4 + c] = word;
         }
     }
+#endif
 }
 
+#ifndef AES_CONSTANT_TIME
+
 template<AESKeySize KeySize>
-void AES<KeySize>::InvSubBytes(std::array<std::array<uint8, 4>, 4>& state) const noexcept {
-    for (auto& row : state) {
-        for (auto& byte : row) {
-            byte = rsbox[byte];
+void AES<KeySize>::CipherBlocks(const uint8* input, uint8* output, size_t count) const noexcept {
+    using AESTables::Te;
+    using AESTables::sbox;
+
+    for (; count > 0; --count, input += BLOCK_SIZE, output += BLOCK_SIZE) {
+        const uint32* rk = roundKey.data();
+        uint32 s0 = LoadWord(input) ^ rk[0];
+        uint32 s1 = LoadWord(input + 4) ^ rk[1];
+        uint32 s2 = LoadWord(input + 8) ^ rk[2];
+        uint32 s3 = LoadWord(input + 12) ^ rk[3];
+
+        // SubBytes, ShiftRows and MixColumns fused into four lookups per column
+        for (size_t round = 1; round < ROUNDS; ++round) {
+            rk += 4;
+            uint32 t0 = Te[s0 >> 24] ^ std::rotr(Te[(s1 >> 16) & 0xff], 8) ^ std::rotr(Te[(s2 >> 8) & 0xff], 16) ^ std::rotr(Te[s3 & 0xff], 24) ^ rk[0];
+            uint32 t1 = Te[s1 >> 24] ^ std::rotr(Te[(s2 >> 16) & 0xff], 8) ^ std::rotr(Te[(s3 >> 8) & 0xff], 16) ^ std::rotr(Te[s0 & 0xff], 24) ^ rk[1];
+            uint32 t2 = Te[s2 >> 24] ^ std::rotr(Te[(s3 >> 16) & 0xff], 8) ^ std::rotr(Te[(s0 >> 8) & 0xff], 16) ^ std::rotr(Te[s1 & 0xff], 24) ^ rk[2];
+            uint32 t3 = Te[s3 >> 24] ^ std::rotr(Te[(s0 >> 16) & 0xff], 8) ^ std::rotr(Te[(s1 >> 8) & 0xff], 16) ^ std::rotr(Te[s2 & 0xff], 24) ^ rk[3];
+            s0 = t0; s1 = t1; s2 = t2; s3 = t3;
         }
+
+        // The last round has no MixColumns
+        rk += 4;
+        auto last = [](uint32 a, uint32 b, uint32 c, uint32 d) {
+            return (uint32(sbox[a >> 24]) << 24) | (uint32(sbox[(b >> 16) & 0xff]) << 16) |
+                   (uint32(sbox[(c >> 8) & 0xff]) << 8) | uint32(sbox[d & 0xff]);
+        };
+        StoreWord(output, last(s0, s1, s2, s3) ^ rk[0]);
+        StoreWord(output + 4, last(s1, s2, s3, s0) ^ rk[1]);
+        StoreWord(output + 8, last(s2, s3, s0, s1) ^ rk[2]);
+        StoreWord(output + 12, last(s3, s0, s1, s2) ^ rk[3]);
     }
 }
 
 template<AESKeySize KeySize>
-void AES<KeySize>::ShiftRows(std::array<std::array<uint8, 4>, 4>& state) const noexcept {
-    uint8 temp;
-
-    // Rotate first row 1 column to left
-    temp = state[1][0];
-    state[1][0] = state[1][1];
-    state[1][1] = state[1][2];
-    state[1][2] = state[1][3];
-    state[1][3] = temp;
-
-    // Rotate second row 2 columns to left
-    temp = state[2][0];
-    state[2][0] = state[2][2];
-    state[2][2] = temp;
-
-    temp = state[2][1];
-    state[2][1] = state[2][3];
-    state[2][3] = temp;
-
-    // Rotate third row 3 columns to left
-    temp = state[3][0];
-    state[3][0] = state[3][3];
-    state[3][3] = state[3][2];
-    state[3][2] = state[3][1];
-    state[3][1] = temp;
+void AES<KeySize>::InvCipherBlocks(const uint8* input, uint8* output, size_t count) const noexcept {
+    using AESTables::Td;
+    using AESTables::rsbox;
+
+    for (; count > 0; --count, input += BLOCK_SIZE, output += BLOCK_SIZE) {
+        const uint32* rk = invRoundKey.data();
+        uint32 s0 = LoadWord(input) ^ rk[0];
+        uint32 s1 = LoadWord(input + 4) ^ rk[1];
+        uint32 s2 = LoadWord(input + 8) ^ rk[2];
+        uint32 s3 = LoadWord(input + 12) ^ rk[3];
+
+        for (size_t round = 1; round < ROUNDS; ++round) {
+            rk += 4;
+            uint32 t0 = Td[s0 >> 24] ^ std::rotr(Td[(s3 >> 16) & 0xff], 8) ^ std::rotr(Td[(s2 >> 8) & 0xff], 16) ^ std::rotr(Td[s1 & 0xff], 24) ^ rk[0];
+            uint32 t1 = Td[s1 >> 24] ^ std::rotr(Td[(s0 >> 16) & 0xff], 8) ^ std::rotr(Td[(s3 >> 8) & 0xff], 16) ^ std::rotr(Td[s2 & 0xff], 24) ^ rk[1];
+            uint32 t2 = Td[s2 >> 24] ^ std::rotr(Td[(s1 >> 16) & 0xff], 8) ^ std::rotr(Td[(s0 >> 8) & 0xff], 16) ^ std::rotr(Td[s3 & 0xff], 24) ^ rk[2];
+            uint32 t3 = Td[s3 >> 24] ^ std::rotr(Td[(s2 >> 16) & 0xff], 8) ^ std::rotr(Td[(s1 >> 8) & 0xff], 16) ^ std::rotr(Td[s0 & 0xff], 24) ^ rk[3];
+            s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+        }
+
+        rk += 4;
+        auto last = [](uint32 a, uint32 b, uint32 c, uint32 d) {
+            return (uint32(rsbox[a >> 24]) << 24) | (uint32(rsbox[(b >> 16) & 0xff]) << 16) |
+                   (uint32(rsbox[(c >> 8) & 0xff]) << 8) | uint32(rsbox[d & 0xff]);
+        };
+        StoreWord(output, last(s0, s3, s2, s1) ^ rk[0]);
+        StoreWord(output + 4, last(s1, s0, s3, s2) ^ rk[1]);
+        StoreWord(output + 8, last(s2, s1, s0, s3) ^ rk[2]);
+        StoreWord(output + 12, last(s3, s2, s1, s0) ^ rk[3]);
+    }
 }
 
+#else
+
 template<AESKeySize KeySize>
-void AES<KeySize>::InvShiftRows(std::array<std::array<uint8, 4>, 4>& state) const noexcept {
-    uint8 temp;
-
-    // Rotate first row 1 column to right
-    temp = state[1][3];
-    state[1][3] = state[1][2];
-    state[1][2] = state[1][1];
-    state[1][1] = state[1][0];
-    state[1][0] = temp;
-
-    // Rotate second row 2 columns to right
-    temp = state[2][0];
-    state[2][0] = state[2][2];
-    state[2][2] = temp;
-
-    temp = state[2][1];
-    state[2][1] = state[2][3];
-    state[2][3] = temp;
-
-    // Rotate third row 3 columns to right
-    temp = state[3][0];
-    state[3][0] = state[3][1];
-    state[3][1] = state[3][2];
-    state[3][2] = state[3][3];
-    state[3][3] = temp;
+void AES<KeySize>::CtSubBytes(uint32* state) noexcept {
+    uint32 planes[8];
+    ToBitPlanes(state, planes);
+    BitslicedSbox(planes);
+    FromBitPlanes(planes, state);
 }
 
 template<AESKeySize KeySize>
-void AES<KeySize>::MixColumns(std::array<std::array<uint8, 4>, 4>& state) const noexcept {
-    uint8 Tmp, Tm, t;
-    for (uint8 i = 0; i < 4; ++i) {
-        t   = state[0][i];
-        Tmp = state[0][i] ^ state[1][i] ^ state[2][i] ^ state[3][i];
-        Tm  = state[0][i] ^ state[1][i]; Tm = xtime(Tm); state[0][i] ^= Tm ^ Tmp;
-        Tm  = state[1][i] ^ state[2][i]; Tm = xtime(Tm); state[1][i] ^= Tm ^ Tmp;
-        Tm  = state[2][i] ^ state[3][i]; Tm = xtime(Tm); state[2][i] ^= Tm ^ Tmp;
-        Tm  = state[3][i] ^ t;           Tm = xtime(Tm); state[3][i] ^= Tm ^ Tmp;
-    }
+void AES<KeySize>::CtInvSubBytes(uint32* state) noexcept {
+    // InvSbox = A^-1 o Sbox o A^-1, the inversion is its own inverse
+    uint32 planes[8];
+    ToBitPlanes(state, planes);
+    InvAffine(planes);
+    BitslicedSbox(planes);
+    InvAffine(planes);
+    FromBitPlanes(planes, state);
 }
 
 template<AESKeySize KeySize>
-void AES<KeySize>::InvMixColumns(std::array<std::array<uint8, 4>, 4>& state) const noexcept {
-    for (uint8 i = 0; i < 4; ++i) {
-        uint8 a = state[0][i];
-        uint8 b = state[1][i];
-        uint8 c = state[2][i];
-        uint8 d = state[3][i];
-
-        state[0][i] = multiply(a, 0x0e) ^ multiply(b, 0x0b) ^ multiply(c, 0x0d) ^ multiply(d, 0x09);
-        state[1][i] = multiply(a, 0x09) ^ multiply(b, 0x0e) ^ multiply(c, 0x0b) ^ multiply(d, 0x0d);
-        state[2][i] = multiply(a, 0x0d) ^ multiply(b, 0x09) ^ multiply(c, 0x0e) ^ multiply(d, 0x0b);
-        state[3][i] = multiply(a, 0x0b) ^ multiply(b, 0x0d) ^ multiply(c, 0x09) ^ multiply(d, 0x0e);
+void AES<KeySize>::CtCipher(uint32* state) const noexcept {
+    auto addRoundKey = [&](size_t round) {
+        for (uint8 i = 0; i < 8; ++i) {
+            state[i] ^= roundKey[round * 4 + (i & 3)];
+        }
+    };
+
+    addRoundKey(0);
+    for (size_t round = 1; round <= ROUNDS; ++round) {
+        CtSubBytes(state);
+        for (uint8 b = 0; b < 8; b += 4) {
+            uint32* s = state + b;
+            uint32 t[4];
+            for (uint8 c = 0; c < 4; ++c) {
+                // ShiftRows: row r of column c comes from column c + r
+                t[c] = (s[c] & 0xFF000000) | (s[(c + 1) & 3] & 0x00FF0000) |
+                       (s[(c + 2) & 3] & 0x0000FF00) | (s[(c + 3) & 3] & 0x000000FF);
+            }
+            for (uint8 c = 0; c < 4; ++c) {
+                s[c] = (round != ROUNDS) ? MixColumn(t[c]) : t[c];
+            }
+        }
+        addRoundKey(round);
     }
 }
 
 template<AESKeySize KeySize>
-void AES<KeySize>::AddRoundKey(std::array<std::array<uint8, 4>, 4>& state, uint8 round) const noexcept {
-    for (uint8 i = 0; i < 4; ++i) {
-        for (uint8 j = 0; j < 4; ++j) {
-            state[j][i] ^= roundKey[(round * 4 * 4) + (i * 4) + j];
+void AES<KeySize>::CtInvCipher(uint32* state) const noexcept {
+    auto addRoundKey = [&](size_t round) {
+        for (uint8 i = 0; i < 8; ++i) {
+            state[i] ^= roundKey[round * 4 + (i & 3)];
+        }
+    };
+
+    addRoundKey(ROUNDS);
+    for (size_t round = ROUNDS; round-- > 0;) {
+        for (uint8 b = 0; b < 8; b += 4) {
+            uint32* s = state + b;
+            uint32 t[4];
+            for (uint8 c = 0; c < 4; ++c) {
+                // InvShiftRows: row r of column c comes from column c - r
+                t[c] = (s[c] & 0xFF000000) | (s[(c + 3) & 3] & 0x00FF0000) |
+                       (s[(c + 2) & 3] & 0x0000FF00) | (s[(c + 1) & 3] & 0x000000FF);
+            }
+            std::copy_n(t, 4, s);
+        }
+        CtInvSubBytes(state);
+        addRoundKey(round);
+        if (round != 0) {
+            for (uint8 i = 0; i < 8; ++i) {
+                state[i] = InvMixColumn(state[i]);
+            }
         }
     }
 }
 
 template<AESKeySize KeySize>
-void AES<KeySize>::Cipher(const uint8* input, uint8* output) const noexcept {
-    std::array<std::array<uint8, 4>, 4> state;
-
-    // Copy input to state array
-    for (uint8 i = 0; i < 4; ++i) {
-        for (uint8 j = 0; j < 4; ++j) {
-            state[j][i] = input[i * 4 + j];
+void AES<KeySize>::CipherBlocks(const uint8* input, uint8* output, size_t count) const noexcept {
+    // Two blocks per pass, an odd last block runs alongside a copy of itself
+    while (count > 0) {
+        size_t blocks = std::min<size_t>(count, 2);
+        uint32 state[8];
+        for (uint8 i = 0; i < 8; ++i) {
+            state[i] = LoadWord(input + ((i >= 4 && blocks == 2) ? i : (i & 3)) * 4);
         }
-    }
-
-    // Add the First round key to the state before starting the rounds
-    AddRoundKey(state, 0);
-
-    // There will be Nr rounds
-    for (uint8 round = 1; round < ROUNDS; ++round) {
-        SubBytes(state);
-        ShiftRows(state);
-        MixColumns(state);
-        AddRoundKey(state, round);
-    }
-
-    // The last round is given below
-    SubBytes(state);
-    ShiftRows(state);
-    AddRoundKey(state, ROUNDS);
-
-    // Copy state array to output
-    for (uint8 i = 0; i < 4; ++i) {
-        for (uint8 j = 0; j < 4; ++j) {
-            output[i * 4 + j] = state[j][i];
+        CtCipher(state);
+        for (uint8 i = 0; i < blocks * 4; ++i) {
+            StoreWord(output + i * 4, state[i]);
         }
+        input += blocks * BLOCK_SIZE;
+        output += blocks * BLOCK_SIZE;
+        count -= blocks;
     }
 }
 
 template<AESKeySize KeySize>
-void AES<KeySize>::InvCipher(const uint8* input, uint8* output) const noexcept {
-    std::array<std::array<uint8, 4>, 4> state;
-
-    // Copy input to state array
-    for (uint8 i = 0; i < 4; ++i) {
-        for (uint8 j = 0; j < 4; ++j) {
-            state[j][i] = input[i * 4 + j];
+void AES<KeySize>::InvCipherBlocks(const uint8* input, uint8* output, size_t count) const noexcept {
+    while (count > 0) {
+        size_t blocks = std::min<size_t>(count, 2);
+        uint32 state[8];
+        for (uint8 i = 0; i < 8; ++i) {
+            state[i] = LoadWord(input + ((i >= 4 && blocks == 2) ? i : (i & 3)) * 4);
         }
-    }
-
-    // Add the last round key to the state before starting the rounds
-    AddRoundKey(state, ROUNDS);
-
-    // There will be Nr rounds
-    for (int round = ROUNDS - 1; round > 0; --round) {
-        InvShiftRows(state);
-        InvSubBytes(state);
-        AddRoundKey(state, round);
-        InvMixColumns(state);
-    }
-
-    // The last round is given below
-    InvShiftRows(state);
-    InvSubBytes(state);
-    AddRoundKey(state, 0);
-
-    // Copy state array to output
-    for (uint8 i = 0; i < 4; ++i) {
-        for (uint8 j = 0; j < 4; ++j) {
-            output[i * 4 + j] = state[j][i];
+        CtInvCipher(state);
+        for (uint8 i = 0; i < blocks * 4; ++i) {
+            StoreWord(output + i * 4, state[i]);
         }
+        input += blocks * BLOCK_SIZE;
+        output += blocks * BLOCK_SIZE;
+        count -= blocks;
     }
 }
 
+#endif
+
 template<AESKeySize KeySize>
 void AES<KeySize>::EncryptCBC(std::span<uint8> data) noexcept {
     if (!iv.has_value() || data.size() % BLOCK_SIZE != 0) {
@@ -250,16 +456,16 @@ void AES<KeySize>::EncryptCBC(std::span<uint8> data) noexcept {
     }
 
     Block ivCopy = iv.value();
-    
+
     for (size_t i = 0; i < data.size(); i += BLOCK_SIZE) {
         // XOR with IV or previous ciphertext
         for (size_t j = 0; j < BLOCK_SIZE; ++j) {
             data[i + j] ^= ivCopy[j];
         }
-        
+
         // Encrypt block
         Cipher(&data[i], &data[i]);
-        
+
         // Copy ciphertext for next block
         std::copy_n(&data[i], BLOCK_SIZE, ivCopy.begin());
     }
@@ -271,22 +477,27 @@ void AES<KeySize>::DecryptCBC(std::span<uint8> data) noexcept {
         return; // CBC requires IV and data must be padded
     }
 
-    Block ivCopy = iv.value();
-    Block nextIv;
-    
-    for (size_t i = 0; i < data.size(); i += BLOCK_SIZE) {
-        // Save ciphertext for next block
-        std::copy_n(&data[i], BLOCK_SIZE, nextIv.begin());
-        
-        // Decrypt block
-        InvCipher(&data[i], &data[i]);
-        
+    // Unlike encryption, decryption of each block only depends on ciphertext,
+    // so blocks are deciphered in batches and chained afterwards
+    std::array<uint8, BATCH_BLOCKS * BLOCK_SIZE> ciphertext;
+    Block chain = iv.value();
+
+    for (size_t i = 0; i < data.size(); i += BATCH_BLOCKS * BLOCK_SIZE) {
+        size_t batchSize = std::min(BATCH_BLOCKS * BLOCK_SIZE, data.size() - i);
+
+        // Save ciphertext, it is the chaining value of the following block
+        std::copy_n(&data[i], batchSize, ciphertext.begin());
+        InvCipherBlocks(&data[i], &data[i], batchSize / BLOCK_SIZE);
+
         // XOR with IV or previous ciphertext
         for (size_t j = 0; j < BLOCK_SIZE; ++j) {
-            data[i + j] ^= ivCopy[j];
+            data[i + j] ^= chain[j];
         }
-        
-        ivCopy = nextIv;
+        for (size_t j = BLOCK_SIZE; j < batchSize; ++j) {
+            data[i + j] ^= ciphertext[j - BLOCK_SIZE];
+        }
+
+        std::copy_n(ciphertext.begin() + batchSize - BLOCK_SIZE, BLOCK_SIZE, chain.begin());
     }
 }
 
@@ -297,21 +508,28 @@ void AES<KeySize>::EncryptCTR(std::span<uint8> data) noexcept {
     }
 
     Block counter = iv.value();
-    Block keystream;
-    
-    for (size_t i = 0; i < data.size(); i += BLOCK_SIZE) {
-        // Encrypt counter to get keystream
-        Cipher(counter.data(), keystream.data());
-        
-        // XOR data with keystream
-        size_t blockSize = std::min(BLOCK_SIZE, data.size() - i);
-        for (size_t j = 0; j < blockSize; ++j) {
-            data[i + j] ^= keystream[j];
+    std::array<uint8, BATCH_BLOCKS * BLOCK_SIZE> counters;
+
+    for (size_t i = 0; i < data.size(); i += BATCH_BLOCKS * BLOCK_SIZE) {
+        size_t batchSize = std::min(BATCH_BLOCKS * BLOCK_SIZE, data.size() - i);
+        size_t blocks = (batchSize + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        // Lay out the counter blocks of the batch
+        for (size_t b = 0; b < blocks; ++b) {
+            std::copy(counter.begin(), counter.end(), counters.begin() + b * BLOCK_SIZE);
+
+            // Increment counter
+            for (int j = BLOCK_SIZE - 1; j >= 0; --j) {
+                if (++counter[j] != 0) break;
+            }
         }
-        
-        // Increment counter
-        for (int j = BLOCK_SIZE - 1; j >= 0; --j) {
-            if (++counter[j] != 0) break;
+
+        // Encrypt counters to get keystream for the whole batch at once
+        CipherBlocks(counters.data(), counters.data(), blocks);
+
+        // XOR data with keystream
+        for (size_t j = 0; j < batchSize; ++j) {
+            data[i + j] ^= counters[j];
         }
     }
-}
\ No newline at end of file
+}
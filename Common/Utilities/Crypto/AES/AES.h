@@ -6,6 +6,12 @@
 #include <concepts>
 #include <algorithm>
 #include <optional>
+#include <bit>
+
+
+// Define AES_CONSTANT_TIME (e.g. in VHALConfig.h) to replace the table lookups with a
+// bitsliced S-box: slower, but no key or data dependent memory accesses (cache/flash
+// accelerator timing) for side-channel sensitive builds
 
 
 // Key sizes
@@ -28,37 +34,8 @@ concept ByteLike = std::same_as<T, uint8> ||
                    std::same_as<T, std::byte> || 
                    std::same_as<T, char> ||
                    std::same_as<T, unsigned char>;
-template<AESKeySize KeySize = AESKeySize::AES128>
-class AES {
-public:
-    static constexpr size_t KEY_SIZE = static_cast<size_t>(KeySize);
-    static constexpr size_t BLOCK_SIZE = 16; // AES block size is always 128 bits (16 bytes)
-    
-    // Calculate expanded key size based on key size
-    static constexpr size_t EXPANDED_KEY_SIZE = []() {
-        if constexpr (KeySize == AESKeySize::AES128) return 176;
-        else if constexpr (KeySize == AESKeySize::AES192) return 208;
-        else return 240; // AES256
-    }();
-    
-    // Number of rounds based on key size
-    static constexpr size_t ROUNDS = []() {
-        if constexpr (KeySize == AESKeySize::AES128) return 10;
-        else if constexpr (KeySize == AESKeySize::AES192) return 12;
-        else return 14; // AES256
-    }();
-
-    using Block = std::array<uint8, BLOCK_SIZE>;
-    using Key = std::array<uint8, KEY_SIZE>;
-    using ExpandedKey = std::array<uint8, EXPANDED_KEY_SIZE>;
-    using IV = std::array<uint8, BLOCK_SIZE>;
-
-private:
-    ExpandedKey roundKey{};
-    std::optional<IV> iv;
-
-    // S-box and inverse S-box as constexpr arrays
-    static constexpr std::array<uint8, 256> sbox = {
+namespace AESTables {
+    inline constexpr std::array<uint8, 256> sbox = {
         0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
         0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
         0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
@@ -77,7 +54,7 @@ private:
         0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
     };
 
-    static constexpr std::array<uint8, 256> rsbox = {
+    inline constexpr std::array<uint8, 256> rsbox = {
         0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
         0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
         0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
@@ -96,17 +73,11 @@ private:
         0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
     };
 
-    // Rcon for key expansion
-    static constexpr std::array<uint8, 11> Rcon = {
-        0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
-    };
-
-    // Helper functions
-    static constexpr uint8 xtime(uint8 x) noexcept {
+    constexpr uint8 xtime(uint8 x) noexcept {
         return ((x << 1) ^ (((x >> 7) & 1) * 0x1b));
     }
 
-    static constexpr uint8 multiply(uint8 x, uint8 y) noexcept {
+    constexpr uint8 multiply(uint8 x, uint8 y) noexcept {
         return (((y & 1) * x) ^
                 ((y >> 1 & 1) * xtime(x)) ^
                 ((y >> 2 & 1) * xtime(xtime(x))) ^
@@ -114,21 +85,114 @@ private:
                 ((y >> 4 & 1) * xtime(xtime(xtime(xtime(x))))));
     }
 
+    // Round tables: SubBytes + MixColumns (Te) and InvSubBytes + InvMixColumns (Td) for
+    // row 0 of a big-endian column, the other rows are byte rotations of it.
+    // One table per direction (2 KB flash) instead of the usual four (8 KB)
+    inline constexpr std::array<uint32, 256> Te = []() {
+        std::array<uint32, 256> table{};
+        for (size_t i = 0; i < 256; i++) {
+            uint8 s = sbox[i];
+            table[i] = (uint32(multiply(s, 2)) << 24) | (uint32(s) << 16) | (uint32(s) << 8) | uint32(multiply(s, 3));
+        }
+        return table;
+    }();
+
+    inline constexpr std::array<uint32, 256> Td = []() {
+        std::array<uint32, 256> table{};
+        for (size_t i = 0; i < 256; i++) {
+            uint8 s = rsbox[i];
+            table[i] = (uint32(multiply(s, 0x0e)) << 24) | (uint32(multiply(s, 0x09)) << 16) | (uint32(multiply(s, 0x0d)) << 8) | uint32(multiply(s, 0x0b));
+        }
+        return table;
+    }();
+}
+
+
+template<AESKeySize KeySize = AESKeySize::AES128>
+class AES {
+public:
+    static constexpr size_t KEY_SIZE = static_cast<size_t>(KeySize);
+    static constexpr size_t BLOCK_SIZE = 16; // AES block size is always 128 bits (16 bytes)
+    
+    // Calculate expanded key size based on key size
+    static constexpr size_t EXPANDED_KEY_SIZE = []() {
+        if constexpr (KeySize == AESKeySize::AES128) return 176;
+        else if constexpr (KeySize == AESKeySize::AES192) return 208;
+        else return 240; // AES256
+    }();
+    
+    // Number of rounds based on key size
+    static constexpr size_t ROUNDS = []() {
+        if constexpr (KeySize == AESKeySize::AES128) return 10;
+        else if constexpr (KeySize == AESKeySize::AES192) return 12;
+        else return 14; // AES256
+    }();
+
+    using Block = std::array<uint8, BLOCK_SIZE>;
+    using Key = std::array<uint8, KEY_SIZE>;
+    using ExpandedKey = std::array<uint8, EXPANDED_KEY_SIZE>;
+    using IV = std::array<uint8, BLOCK_SIZE>;
+
+    // Blocks processed per batch in CTR and CBC decryption
+    static constexpr size_t BATCH_BLOCKS = 4;
+
+#ifdef AES_CONSTANT_TIME
+    static constexpr bool CONSTANT_TIME = true;
+#else
+    static constexpr bool CONSTANT_TIME = false;
+#endif
+
+private:
+    static constexpr size_t ROUND_KEY_WORDS = EXPANDED_KEY_SIZE / 4;
+    using RoundKey = std::array<uint32, ROUND_KEY_WORDS>;
+
+    RoundKey roundKey{};
+#ifndef AES_CONSTANT_TIME
+    RoundKey invRoundKey{};  // Equivalent inverse cipher schedule (InvMixColumns applied)
+#endif
+    std::optional<IV> iv;
+
+    // Rcon for key expansion
+    static constexpr std::array<uint8, 11> Rcon = {
+        0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
+    };
+
     // Key expansion
     void KeyExpansion(const Key& key) noexcept;
 
-    // Core AES operations
-    void SubBytes(std::array<std::array<uint8, 4>, 4>& state) const noexcept;
-    void InvSubBytes(std::array<std::array<uint8, 4>, 4>& state) const noexcept;
-    void ShiftRows(std::array<std::array<uint8, 4>, 4>& state) const noexcept;
-    void InvShiftRows(std::array<std::array<uint8, 4>, 4>& state) const noexcept;
-    void MixColumns(std::array<std::array<uint8, 4>, 4>& state) const noexcept;
-    void InvMixColumns(std::array<std::array<uint8, 4>, 4>& state) const noexcept;
-    void AddRoundKey(std::array<std::array<uint8, 4>, 4>& state, uint8 round) const noexcept;
+    // Columns are big-endian words: row 0 in the most significant byte
+    static inline uint32 LoadWord(const uint8* data) noexcept {
+        return (uint32(data[0]) << 24) | (uint32(data[1]) << 16) | (uint32(data[2]) << 8) | uint32(data[3]);
+    }
+
+    static inline void StoreWord(uint8* data, uint32 word) noexcept {
+        data[0] = static_cast<uint8>(word >> 24);
+        data[1] = static_cast<uint8>(word >> 16);
+        data[2] = static_cast<uint8>(word >> 8);
+        data[3] = static_cast<uint8>(word);
+    }
+
+    static uint32 SubWord(uint32 word) noexcept;
+
+    // Cipher functions, input and output may alias
+    void Cipher(const uint8* input, uint8* output) const noexcept {
+        CipherBlocks(input, output, 1);
+    }
+
+    void InvCipher(const uint8* input, uint8* output) const noexcept {
+        InvCipherBlocks(input, output, 1);
+    }
 
-    // Cipher functions
-    void Cipher(const uint8* input, uint8* output) const noexcept;
-    void InvCipher(const uint8* input, uint8* output) const noexcept;
+    void CipherBlocks(const uint8* input, uint8* output, size_t count) const noexcept;
+    void InvCipherBlocks(const uint8* input, uint8* output, size_t count) const noexcept;
+
+#ifdef AES_CONSTANT_TIME
+    // Two blocks (8 column words) per call: the 32 state bytes fill one bitslice lane each
+    static void CtSubBytes(uint32* state) noexcept;
+    static void CtInvSubBytes(uint32* state) noexcept;
+    void CtCipher(uint32* state) const noexcept;
+    void CtInvCipher(uint32* state) const noexcept;
+#endif
 
 public:
     // Constructors
@@ -154,6 +218,15 @@ public:
         InvCipher(block.data(), block.data());
     }
 
+    // ECB over all whole blocks of data, trailing partial block is left untouched
+    void EncryptECB(std::span<uint8> data) const noexcept {
+        CipherBlocks(data.data(), data.data(), data.size() / BLOCK_SIZE);
+    }
+
+    void DecryptECB(std::span<uint8> data) const noexcept {
+        InvCipherBlocks(data.data(), data.data(), data.size() / BLOCK_SIZE);
+    }
+
     // CBC mode
     void EncryptCBC(std::span<uint8> data) noexcept;
     void DecryptCBC(std::span<uint8> data) noexcept;
@@ -172,14 +245,7 @@ public:
         
         switch (mode) {
             case AESMode::ECB:
-                for (size_t i = 0; i < uint8_span.size(); i += BLOCK_SIZE) {
-                    if (i + BLOCK_SIZE <= uint8_span.size()) {
-                        Block block;
-                        std::copy_n(uint8_span.begin() + i, BLOCK_SIZE, block.begin());
-                        EncryptECB(block);
-                        std::copy(block.begin(), block.end(), uint8_span.begin() + i);
-                    }
-                }
+                EncryptECB(uint8_span);
                 break;
             case AESMode::CBC:
                 EncryptCBC(uint8_span);
@@ -197,14 +263,7 @@ public:
         
         switch (mode) {
             case AESMode::ECB:
-                for (size_t i = 0; i < uint8_span.size(); i += BLOCK_SIZE) {
-                    if (i + BLOCK_SIZE <= uint8_span.size()) {
-                        Block block;
-                        std::copy_n(uint8_span.begin() + i, BLOCK_SIZE, block.begin());
-                        DecryptECB(block);
-                        std::copy(block.begin(), block.end(), uint8_span.begin() + i);
-                    }
-                }
+                DecryptECB(uint8_span);
                 break;
             case AESMode::CBC:
                 DecryptCBC(uint8_span);
@@ -15,47 +15,73 @@ private:
 
 
 public:
+    // Key with the ipad/opad blocks already absorbed: hashing a message with it
+    // skips the two key compressions (and the key hash for long keys) per call
+    class PrecomputedKey {
+    public:
+        explicit PrecomputedKey(std::span<const uint8> key) {
+            std::array<uint8, BLOCK_SIZE> processedKey{};
+
+            // Process key
+            if (key.size() > BLOCK_SIZE) {
+                // Hash long keys
+                SHA256 hasher;
+                hasher.Update(key);
+                auto hashedKey = hasher.Finalize();
+                std::copy(hashedKey.begin(), hashedKey.end(), processedKey.begin());
+            } else {
+                // Pad short keys
+                std::copy(key.begin(), key.end(), processedKey.begin());
+            }
+
+            // Create inner and outer padded keys
+            std::array<uint8, BLOCK_SIZE> paddedKey{};
+
+            std::transform(processedKey.begin(), processedKey.end(), paddedKey.begin(), [](uint8 k) {
+            	return k ^ IPAD;
+            });
+            inner.Update(std::span(paddedKey));
+
+            std::transform(processedKey.begin(), processedKey.end(), paddedKey.begin(), [](uint8 k) {
+            	return k ^ OPAD;
+            });
+            outer.Update(std::span(paddedKey));
+
+            processedKey.fill(0);
+            paddedKey.fill(0);
+        }
+
+        explicit PrecomputedKey(std::string_view key)
+            : PrecomputedKey(std::span(reinterpret_cast<const uint8*>(key.data()), key.size())) {}
+
+        std::array<uint8, HashSize> Compute(std::span<const uint8> message) const {
+            // Inner hash: H(K ⊕ ipad || message)
+            SHA256 innerHasher = inner;
+            innerHasher.Update(message);
+            auto innerHash = innerHasher.Finalize();
+
+            // Outer hash: H(K ⊕ opad || inner_hash)
+            SHA256 outerHasher = outer;
+            outerHasher.Update(std::span(innerHash));
+
+            return outerHasher.Finalize();
+        }
+
+        std::array<uint8, HashSize> Compute(std::string_view message) const {
+            return Compute(std::span(reinterpret_cast<const uint8*>(message.data()), message.size()));
+        }
+
+    private:
+        SHA256 inner;  // State after K ⊕ ipad
+        SHA256 outer;  // State after K ⊕ opad
+    };
+
+
     static std::array<uint8, HashSize> Compute(
         std::span<const uint8> key,
         std::span<const uint8> message) {
 
-        std::array<uint8, BLOCK_SIZE> processedKey{};
-
-        // Process key
-        if (key.size() > BLOCK_SIZE) {
-            // Hash long keys
-            SHA256 hasher;
-            hasher.Update(key);
-            auto hashedKey = hasher.Finalize();
-            std::copy(hashedKey.begin(), hashedKey.end(), processedKey.begin());
-        } else {
-            // Pad short keys
-            std::copy(key.begin(), key.end(), processedKey.begin());
-        }
-
-        // Create inner and outer padded keys
-        std::array<uint8, BLOCK_SIZE> innerKey{};
-        std::array<uint8, BLOCK_SIZE> outerKey{};
-
-        std::transform(processedKey.begin(), processedKey.end(), innerKey.begin(), [](uint8 k) {
-        	return k ^ IPAD;
-        });
-        std::transform(processedKey.begin(), processedKey.end(), outerKey.begin(), [](uint8 k) {
-        	return k ^ OPAD;
-        });
-
-        // Inner hash: H(K ⊕ ipad || message)
-        SHA256 innerHasher;
-        innerHasher.Update(std::span(innerKey));
-        innerHasher.Update(message);
-        auto innerHash = innerHasher.Finalize();
-
-        // Outer hash: H(K ⊕ opad || inner_hash)
-        SHA256 outerHasher;
-        outerHasher.Update(std::span(outerKey));
-        outerHasher.Update(std::span(innerHash));
-
-        return outerHasher.Finalize();
+        return PrecomputedKey(key).Compute(message);
     }
 
 
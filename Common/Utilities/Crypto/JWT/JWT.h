@@ -15,6 +15,9 @@ public:
         HS256
     };
 
+    // HS256 secret with the HMAC pads precomputed, reuse it across tokens signed with the same secret
+    using SigningKey = HMAC<32>::PrecomputedKey;
+
     struct Header {
         Algorithm alg = Algorithm::HS256;
         std::string_view typ = "JWT";
@@ -293,6 +296,16 @@ public:
         const Claims& claims,
         std::string_view secret
     ) {
+        return CreateToken(tokenBuffer, tokenLength, header, claims, SigningKey(secret));
+    }
+
+    static bool CreateToken(
+        std::span<char> tokenBuffer,
+        size_t& tokenLength,
+        const Header& header,
+        const Claims& claims,
+        const SigningKey& key
+    ) {
 
         std::array<char, 256> headerBuffer{};
         std::array<char, 512> claimsBuffer{};
@@ -341,10 +354,7 @@ public:
         // Create signature
         std::array<uint8, 32> signature{};
         if (header.alg == Algorithm::HS256) {
-            signature = HMAC<32>::Compute(
-                std::span(reinterpret_cast<const uint8*>(secret.data()), secret.size()),
-                std::span(reinterpret_cast<const uint8*>(payloadBuffer.data()), payloadLen)
-            );
+            signature = key.Compute(std::span(reinterpret_cast<const uint8*>(payloadBuffer.data()), payloadLen));
         } else {
             return false;
         }
@@ -389,6 +399,25 @@ public:
         std::span<char> claimsStringBuffer3,
         std::span<char> claimsStringBuffer4
     ) {
+        return VerifyToken(
+            token, SigningKey(secret), header, claims,
+            headerWorkBuffer, claimsWorkBuffer,
+            claimsStringBuffer1, claimsStringBuffer2, claimsStringBuffer3, claimsStringBuffer4
+        );
+    }
+
+    static bool VerifyToken(
+        std::string_view token,
+        const SigningKey& key,
+        Header& header,
+        Claims& claims,
+        std::span<char> headerWorkBuffer,
+        std::span<char> claimsWorkBuffer,
+        std::span<char> claimsStringBuffer1,
+        std::span<char> claimsStringBuffer2,
+        std::span<char> claimsStringBuffer3,
+        std::span<char> claimsStringBuffer4
+    ) {
 
         // Find dots
         size_t firstDot = token.find('.');
@@ -439,10 +468,7 @@ public:
         std::array<uint8, 32> expectedSignature{};
 
         if (header.alg == Algorithm::HS256) {
-            expectedSignature = HMAC<32>::Compute(
-                std::span(reinterpret_cast<const uint8*>(secret.data()), secret.size()),
-                std::span(reinterpret_cast<const uint8*>(payload.data()), payload.size())
-            );
+            expectedSignature = key.Compute(payload);
         } else {
             return false;
         }
@@ -459,6 +485,10 @@ public:
 
     // Simplified verify function with automatic buffer allocation
     static bool VerifyToken(std::string_view token, std::string_view secret) {
+        return VerifyToken(token, SigningKey(secret));
+    }
+
+    static bool VerifyToken(std::string_view token, const SigningKey& key) {
         Header header;
         Claims claims;
 
@@ -470,7 +500,7 @@ public:
         std::array<char, 64> claimsBuffer4{};
 
         return VerifyToken(
-            token, secret, header, claims,
+            token, key, header, claims,
             std::span(headerWorkBuffer),
             std::span(claimsWorkBuffer),
             std::span(claimsBuffer1),
@@ -4,6 +4,7 @@
 #include <span>
 #include <string_view>
 #include <algorithm>
+#include <utility>
 
 class SHA256 {
 private:
@@ -38,14 +39,30 @@ public:
     }
 
     void Update(std::span<const uint8> data) {
-        for (uint8 byte : data) {
-            buffer[count % 64] = byte;
-            count++;
-
-            if (count % 64 == 0) {
-                Transform();
+        const uint8* input = data.data();
+        size_t size = data.size();
+        size_t buffered = count % 64;
+        count += size;
+
+        // Complete a partially filled block first
+        if (buffered != 0) {
+            size_t chunk = std::min(size, 64 - buffered);
+            std::copy_n(input, chunk, buffer.begin() + buffered);
+            input += chunk;
+            size -= chunk;
+
+            if (buffered + chunk < 64) {
+                return;
             }
+            Transform(buffer.data());
+        }
+
+        // Whole blocks are compressed straight from the caller's memory
+        for (; size >= 64; input += 64, size -= 64) {
+            Transform(input);
         }
+
+        std::copy_n(input, size, buffer.begin());
     }
 
     void Update(std::string_view str) {
@@ -56,30 +73,24 @@ public:
         uint64 bitCount = count * 8;
 
         // Padding
-        buffer[count % 64] = 0x80;
-        count++;
+        size_t used = count % 64;
+        buffer[used++] = 0x80;
 
         // If not enough space for length, add another block
-        if (count % 64 > 56) {
-            while (count % 64 != 0) {
-                buffer[count % 64] = 0;
-                count++;
-            }
-            Transform();
+        if (used > 56) {
+            std::fill(buffer.begin() + used, buffer.end(), 0);
+            Transform(buffer.data());
+            used = 0;
         }
 
         // Pad to 56 bytes
-        while (count % 64 != 56) {
-            buffer[count % 64] = 0;
-            count++;
-        }
+        std::fill(buffer.begin() + used, buffer.begin() + 56, 0);
 
         // Append length
         for (int i = 7; i >= 0; --i) {
             buffer[56 + i] = static_cast<uint8>(bitCount >> (8 * (7 - i)));
         }
-        count += 8;
-        Transform();
+        Transform(buffer.data());
 
         // Produce final hash
         std::array<uint8, 32> hash{};
@@ -123,40 +134,53 @@ private:
         return Rotr(x, 17) ^ Rotr(x, 19) ^ (x >> 10);
     }
 
-    void Transform() {
-        std::array<uint32, 64> W{};
+    static inline uint32 LoadWord(const uint8* data) {
+        return (static_cast<uint32>(data[0]) << 24) |
+               (static_cast<uint32>(data[1]) << 16) |
+               (static_cast<uint32>(data[2]) << 8) |
+               static_cast<uint32>(data[3]);
+    }
 
-        // Prepare message schedule
-        for (int i = 0; i < 16; ++i) {
-            W[i] = (static_cast<uint32>(buffer[i * 4]) << 24) |
-                   (static_cast<uint32>(buffer[i * 4 + 1]) << 16) |
-                   (static_cast<uint32>(buffer[i * 4 + 2]) << 8) |
-                   static_cast<uint32>(buffer[i * 4 + 3]);
+    // One round, fully resolved at compile time. Instead of shifting a..h every round,
+    // the roles rotate through v: slot (k - I) % 8 holds variable k in round I.
+    // The message schedule is kept in a rolling 16-word window: W[I % 16] is
+    // overwritten with W[I] once W[I - 16] is no longer needed
+    template<size_t I>
+    static inline void Round(uint32 (&v)[8], uint32 (&W)[16]) {
+        constexpr size_t a = (8 - I % 8) % 8;
+        constexpr size_t b = (a + 1) % 8, c = (a + 2) % 8, d = (a + 3) % 8;
+        constexpr size_t e = (a + 4) % 8, f = (a + 5) % 8, g = (a + 6) % 8, h = (a + 7) % 8;
+
+        if constexpr (I >= 16) {
+            W[I % 16] += Gamma1(W[(I - 2) % 16]) + W[(I - 7) % 16] + Gamma0(W[(I - 15) % 16]);
         }
 
-        for (int i = 16; i < 64; ++i) {
-            W[i] = Gamma1(W[i - 2]) + W[i - 7] + Gamma0(W[i - 15]) + W[i - 16];
-        }
+        uint32 T1 = v[h] + Sigma1(v[e]) + Ch(v[e], v[f], v[g]) + K[I] + W[I % 16];
+        uint32 T2 = Sigma0(v[a]) + Maj(v[a], v[b], v[c]);
+        v[d] += T1;       // becomes e of the next round
+        v[h] = T1 + T2;   // becomes a of the next round
+    }
+
+    template<size_t... I>
+    static inline void Rounds(uint32 (&v)[8], uint32 (&W)[16], std::index_sequence<I...>) {
+        (Round<I>(v, W), ...);
+    }
 
-        // Initialize working variables
-        auto [a, b, c, d, e, f, g, h] = state;
-
-        // Main loop
-        for (int i = 0; i < 64; ++i) {
-            uint32 T1 = h + Sigma1(e) + Ch(e, f, g) + K[i] + W[i];
-            uint32 T2 = Sigma0(a) + Maj(a, b, c);
-            h = g;
-            g = f;
-            f = e;
-            e = d + T1;
-            d = c;
-            c = b;
-            b = a;
-            a = T1 + T2;
+    // Compresses one 64 byte block, which does not need to be aligned
+    void Transform(const uint8* block) {
+        uint32 W[16];
+        for (int i = 0; i < 16; ++i) {
+            W[i] = LoadWord(block + i * 4);
         }
 
-        // Add working variables to state
-        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
-        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        uint32 v[8];
+        std::copy(state.begin(), state.end(), v);
+
+        Rounds(v, W, std::make_index_sequence<64>{});
+
+        // Add working variables to state, after 64 rounds the roles are back in place
+        for (int i = 0; i < 8; ++i) {
+            state[i] += v[i];
+        }
     }
 };
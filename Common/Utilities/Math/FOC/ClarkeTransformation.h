@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include <VHAL.h>
 #include <cmath>
+#include <span>
+#include <algorithm>
 
 
 template<typename T = float>
@@ -81,6 +83,58 @@ public:
 
 
 
+	// Batch versions over arrays of samples, the same results as Resolve() for every sample.
+	// Spans must not partially overlap, in place (alpha on a) is allowed.
+	static void ResolveBatch(std::span<const T> a, std::span<const T> b, std::span<T> alpha, std::span<T> beta) {
+		using std::sqrt;
+		static const T D1_SQRT3 = T(1) / sqrt(T(3));
+		const T k = D1_SQRT3;
+
+		size_t count = std::min({a.size(), b.size(), alpha.size(), beta.size()});
+		for (size_t i = 0; i < count; i++) {
+			T phaseA = a[i];
+			T phaseB = b[i];
+			alpha[i] = phaseA;
+			beta[i] = k * (phaseA + (T(2) * phaseB));
+		}
+	}
+
+
+
+	static void ResolveBatch(std::span<const T> a, std::span<const T> b, std::span<const T> c, std::span<T> alpha, std::span<T> beta) {
+		using std::sqrt;
+		static const T D1_SQRT3 = T(1) / sqrt(T(3));
+		const T k = D1_SQRT3;
+
+		size_t count = std::min({a.size(), b.size(), c.size(), alpha.size(), beta.size()});
+		for (size_t i = 0; i < count; i++) {
+			T phaseA = a[i];
+			T phaseB = b[i];
+			T phaseC = c[i];
+			alpha[i] = phaseA;
+			beta[i] = k * (phaseB - phaseC);
+		}
+	}
+
+
+
+	static void ResolveInverseBatch(std::span<const T> alpha, std::span<const T> beta, std::span<T> a, std::span<T> b, std::span<T> c) {
+		using std::sqrt;
+		static const T SQRT3_D2 = sqrt(T(3)) / T(2);
+		const T k = SQRT3_D2;
+
+		size_t count = std::min({alpha.size(), beta.size(), a.size(), b.size(), c.size()});
+		for (size_t i = 0; i < count; i++) {
+			T clarkeAlpha = alpha[i];
+			T clarkeBeta = beta[i];
+			a[i] = clarkeAlpha;
+			b[i] = k * clarkeBeta - T(0.5) * clarkeAlpha;
+			c[i] = -T(0.5) * clarkeAlpha - k * clarkeBeta;
+		}
+	}
+
+
+
 	Clarke GetClarke() {
 		return clarke;
 	}
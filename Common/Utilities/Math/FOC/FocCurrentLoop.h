@@ -0,0 +1,289 @@
+#pragma once
+#include <VHAL.h>
+#include <cmath>
+#include <algorithm>
+
+
+/*
+Complete current loop in one call: Clarke -> Park -> PI(d), PI(q) -> inverse Park -> SVPWM.
+Same math as ClarkeTransformation, ParkTransformation, PidController (P + I, no events) and
+SpaceVectorGenerator chained together, but sin/cos of the angle is evaluated once and shared
+by both Park transforms, the integral step Ki / frequency is computed on Set, and nothing is
+copied between blocks. Works for float and IQ<Q> (include IQMath.h, sin/cos are found by ADL).
+*/
+template<typename T = float>
+class FocCurrentLoop {
+public:
+	enum class CurrentsMode {
+		C2, // with 2 currents
+		C3  // with 3 currents
+	};
+
+	enum class Modulation {
+		SECTOR,       // SpaceVectorGenerator::Resolve
+		COMMON_MODE,  // SpaceVectorGenerator::ResolveCommonMode
+		DISCONTINUOUS // SpaceVectorGenerator::ResolveDiscontinuousPwmMode
+	};
+
+	struct Controller {
+		T proportional = 1;
+		T integral = 0;
+		T max = 1;                    // output limit
+		T min = -1;
+		bool integratorLimit = false; // clamp the integrator to [min, max] as well
+	};
+
+	struct Phase {
+		T a = 0; // phase-a current
+		T b = 0; // phase-b current
+		T c = 0; // phase-c current, C3 only
+	};
+
+	struct Out {
+		T phaseA = 0; // phase-a switching function
+		T phaseB = 0; // phase-b switching function
+		T phaseC = 0; // phase-c switching function
+		T dAxis = 0;  // measured d-axis current
+		T qAxis = 0;  // measured q-axis current
+		T vd = 0;     // d-axis voltage command
+		T vq = 0;     // q-axis voltage command
+	};
+
+
+private:
+	struct Axis {
+		T proportional = 1;
+		T integralStep = 0; // Ki / frequency
+		T max = 1;
+		T min = -1;
+		bool integratorLimit = false;
+		T integrator = 0;
+	};
+
+	struct {
+		Phase phase;
+		T angle = 0;
+		T dReference = 0;
+		T qReference = 0;
+	} in;
+
+	Axis d;
+	Axis q;
+	T voltageScale = 1; // 2 / Vdc, normalizes the voltages for SVPWM
+	CurrentsMode currentsMode = CurrentsMode::C2;
+	Modulation modulation = Modulation::SECTOR;
+	Out out;
+
+
+public:
+	FocCurrentLoop() {}
+
+
+
+	FocCurrentLoop(Controller dController, Controller qController, uint32 frequency) {
+		SetControllers(dController, qController, frequency);
+	}
+
+
+
+	FocCurrentLoop& SetControllers(Controller dController, Controller qController, uint32 frequency) {
+		SetAxis(d, dController, frequency);
+		SetAxis(q, qController, frequency);
+		return *this;
+	}
+
+
+
+	// Output limits are in volts, the voltages are divided by Vdc / 2 before SVPWM
+	FocCurrentLoop& SetBusVoltage(T voltage) {
+		voltageScale = T(2) / voltage;
+		return *this;
+	}
+
+
+
+	FocCurrentLoop& SetCurrentsMode(CurrentsMode mode) {
+		currentsMode = mode;
+		return *this;
+	}
+
+
+
+	FocCurrentLoop& SetModulation(Modulation mode) {
+		modulation = mode;
+		return *this;
+	}
+
+
+
+	FocCurrentLoop& Set(Phase phase, T angle) {
+		in.phase = phase;
+		in.angle = angle;
+		return *this;
+	}
+
+
+
+	FocCurrentLoop& SetReference(T dReference, T qReference) {
+		in.dReference = dReference;
+		in.qReference = qReference;
+		return *this;
+	}
+
+
+
+	FocCurrentLoop& Reset() {
+		d.integrator = 0;
+		q.integrator = 0;
+		out = {};
+		return *this;
+	}
+
+
+
+	FocCurrentLoop& Resolve() {
+		using std::sin;
+		using std::cos;
+		static constexpr T D1_SQRT3 = T(0.5773502691896258);
+
+		T sine = sin(in.angle);
+		T cosine = cos(in.angle);
+
+		// Clarke
+		T alpha = in.phase.a;
+		T beta;
+		if (currentsMode == CurrentsMode::C2) {
+			beta = D1_SQRT3 * (in.phase.a + (T(2) * in.phase.b));
+		} else {
+			beta = D1_SQRT3 * (in.phase.b - in.phase.c);
+		}
+
+		// Park
+		out.dAxis = (alpha * cosine) + (beta * sine);
+		out.qAxis = (beta * cosine) - (alpha * sine);
+
+		// PI
+		out.vd = ResolveAxis(d, in.dReference - out.dAxis);
+		out.vq = ResolveAxis(q, in.qReference - out.qAxis);
+
+		// Inverse Park, normalized to the bus
+		T vd = out.vd * voltageScale;
+		T vq = out.vq * voltageScale;
+		ResolveModulation((vd * cosine) - (vq * sine), (vd * sine) + (vq * cosine));
+
+		return *this;
+	}
+
+
+
+	Out Get() {
+		return out;
+	}
+
+
+private:
+	static void SetAxis(Axis& axis, Controller controller, uint32 frequency) {
+		axis.proportional = controller.proportional;
+		// In double, the frequency itself does not fit most IQ formats
+		axis.integralStep = T(static_cast<double>(controller.integral) / frequency);
+		axis.max = controller.max;
+		axis.min = controller.min;
+		axis.integratorLimit = controller.integratorLimit;
+	}
+
+
+
+	static T ResolveAxis(Axis& axis, T error) {
+		using std::min;
+		using std::max;
+
+		axis.integrator += error * axis.integralStep;
+		if (axis.integratorLimit) {
+			axis.integrator = min(max(axis.integrator, axis.min), axis.max);
+		}
+
+		return min(max((error * axis.proportional) + axis.integrator, axis.min), axis.max);
+	}
+
+
+
+	void ResolveModulation(T alpha, T beta) {
+		using std::max;
+		using std::min;
+		static constexpr T SQRT3_D2 = T(0.8660254037844386);
+
+		if (modulation == Modulation::COMMON_MODE) {
+			T Va = alpha; // Inv Clarke
+			T Vb = -(alpha / T(2)) + (SQRT3_D2 * beta);
+			T Vc = -(alpha / T(2)) - (SQRT3_D2 * beta);
+
+			T Vcommon = (max(max(Va, Vb), Vc) + min(min(Va, Vb), Vc)) / T(2);
+
+			out.phaseA = Va - Vcommon;
+			out.phaseB = Vb - Vcommon;
+			out.phaseC = Vc - Vcommon;
+			return;
+		}
+
+		T tmp1 = beta;
+		T tmp2 = (beta / T(2)) + (SQRT3_D2 * alpha);
+		T tmp3 = tmp2 - tmp1;
+
+		// sector determination
+		uint8 sector = 3;
+		sector = tmp2 > 0 ? sector - 1 : sector;
+		sector = tmp3 > 0 ? sector - 1 : sector;
+		sector = tmp1 < 0 ? 7 - sector : sector;
+
+		if (modulation == Modulation::SECTOR) {
+			switch (sector) {
+				case 1:
+				case 4:
+					out.phaseA = tmp2;
+					out.phaseB = tmp1 - tmp3;
+					out.phaseC = -tmp2;
+				break;
+
+				case 2:
+				case 5:
+					out.phaseA = tmp3 + tmp2;
+					out.phaseB = tmp1;
+					out.phaseC = -tmp1;
+				break;
+
+				default:
+					out.phaseA = tmp3;
+					out.phaseB = -tmp3;
+					out.phaseC = -(tmp1 + tmp2);
+				break;
+			}
+			return;
+		}
+
+		switch (sector) {
+			case 1:
+			case 6:
+				out.phaseA = 0;
+				out.phaseB = tmp3;
+				out.phaseC = tmp2;
+			break;
+
+			case 2:
+			case 3:
+				out.phaseA = -tmp3;
+				out.phaseB = 0;
+				out.phaseC = tmp1;
+			break;
+
+			default:
+				out.phaseA = -tmp2;
+				out.phaseB = -tmp1;
+				out.phaseC = 0;
+			break;
+		}
+
+		out.phaseA = (out.phaseA * T(2)) - T(1);
+		out.phaseB = (out.phaseB * T(2)) - T(1);
+		out.phaseC = (out.phaseC * T(2)) - T(1);
+	}
+};
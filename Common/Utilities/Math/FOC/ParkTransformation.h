@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include <VHAL.h>
 #include <cmath>
+#include <span>
+#include <algorithm>
 
 
 template<typename T = float>
@@ -65,6 +67,42 @@ public:
 
 
 
+	// Batch versions over arrays of samples, the same results as Resolve() / ResolveInverse()
+	// for every sample. Spans must not partially overlap, in place (dAxis on alpha) is allowed.
+	static void ResolveBatch(std::span<const T> alpha, std::span<const T> beta, std::span<const T> angle, std::span<T> dAxis, std::span<T> qAxis) {
+		using std::cos;
+		using std::sin;
+
+		size_t count = std::min({alpha.size(), beta.size(), angle.size(), dAxis.size(), qAxis.size()});
+		for (size_t i = 0; i < count; i++) {
+			T axisAlpha = alpha[i];
+			T axisBeta = beta[i];
+			T cosine = cos(angle[i]);
+			T sine = sin(angle[i]);
+			dAxis[i] = (axisAlpha * cosine) + (axisBeta * sine);
+			qAxis[i] = (axisBeta * cosine)  - (axisAlpha * sine);
+		}
+	}
+
+
+
+	static void ResolveInverseBatch(std::span<const T> dAxis, std::span<const T> qAxis, std::span<const T> angle, std::span<T> alpha, std::span<T> beta) {
+		using std::cos;
+		using std::sin;
+
+		size_t count = std::min({dAxis.size(), qAxis.size(), angle.size(), alpha.size(), beta.size()});
+		for (size_t i = 0; i < count; i++) {
+			T parkD = dAxis[i];
+			T parkQ = qAxis[i];
+			T cosine = cos(angle[i]);
+			T sine = sin(angle[i]);
+			alpha[i] = (parkD * cosine) - (parkQ * sine);
+			beta[i] = (parkD * sine)  + (parkQ * cosine);
+		}
+	}
+
+
+
 	Park GetPark() {
 		return park;
 	}
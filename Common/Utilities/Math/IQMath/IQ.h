@@ -3,7 +3,24 @@
 #include <concepts>
 
 
-template<int Q, int LutSize = 256>
+// Arithmetic policy, the third template parameter of IQ:
+//   SATURATE: results that do not fit int32 stick at the largest / smallest value instead of wrapping
+//   ROUND:    multiplication, narrowing conversions and construction from float round to nearest
+//             instead of truncating
+//   CORDIC:   sin, cos, atan2 and sqrt use the shift-and-add versions of IQCordic.h instead of
+//             the sin LUT, the atan polynomial and Newton's divisions
+template<bool Saturate, bool Round, bool Cordic = false>
+struct IQPolicy {
+	static constexpr bool SATURATE = Saturate;
+	static constexpr bool ROUND = Round;
+	static constexpr bool CORDIC = Cordic;
+};
+
+using IQWrap = IQPolicy<false, false>;    // plain int32 arithmetic, the fastest
+using IQSaturate = IQPolicy<true, true>;  // for integrators and anything that may overflow
+
+
+template<int Q, int LutSize = 256, typename Policy = IQWrap>
 class IQ {
 	static_assert(Q >= 1 && Q <= 30, "Q must be in [1, 30]");
 	static_assert((LutSize & (LutSize - 1)) == 0 && LutSize >= 16, "LutSize must be a power of 2 and >= 16");
@@ -14,13 +31,14 @@ public:
 	static constexpr int q = Q;
 	static constexpr int lutSize = LutSize;
 	static constexpr int32 one = int32(1) << Q;
+	using policy = Policy;
 
 
 	constexpr IQ() = default;
 
-	constexpr IQ(float v) : raw(static_cast<int32>(v * one)) {}
-	constexpr IQ(double v) : raw(static_cast<int32>(v * one)) {}
-	constexpr IQ(int v) : raw(int32(v) << Q) {}
+	constexpr IQ(float v) : raw(FromReal(v)) {}
+	constexpr IQ(double v) : raw(FromReal(v)) {}
+	constexpr IQ(int v) : raw(Policy::SATURATE ? Narrow(static_cast<int64>(v) * one) : int32(v) << Q) {}
 
 	static constexpr IQ FromRaw(int32 r) {
 		IQ result;
@@ -56,22 +74,46 @@ public:
 
 
 	// Arithmetic IQ <-> IQ
-	constexpr IQ operator+(IQ b) const { return FromRaw(raw + b.raw); }
-	constexpr IQ operator-(IQ b) const { return FromRaw(raw - b.raw); }
-	constexpr IQ operator-() const { return FromRaw(-raw); }
+	// Saturation goes through int64, wrapping stays in int32 (no 64-bit helpers on Cortex-M0)
+	constexpr IQ operator+(IQ b) const {
+		if constexpr (Policy::SATURATE) {
+			return FromRaw(Narrow(static_cast<int64>(raw) + b.raw));
+		} else {
+			return FromRaw(raw + b.raw);
+		}
+	}
+
+	constexpr IQ operator-(IQ b) const {
+		if constexpr (Policy::SATURATE) {
+			return FromRaw(Narrow(static_cast<int64>(raw) - b.raw));
+		} else {
+			return FromRaw(raw - b.raw);
+		}
+	}
+
+	constexpr IQ operator-() const {
+		if constexpr (Policy::SATURATE) {
+			return FromRaw(Narrow(-static_cast<int64>(raw)));
+		} else {
+			return FromRaw(-raw);
+		}
+	}
 
 	constexpr IQ operator*(IQ b) const {
 		int64 tmp = static_cast<int64>(raw) * b.raw;
-		return FromRaw(static_cast<int32>(tmp >> Q));
+		return FromRaw(Narrow(ShiftRight(tmp, Q)));
 	}
 
 	constexpr IQ operator/(IQ b) const {
-		int64 tmp = static_cast<int64>(raw) << Q;
-		return FromRaw(static_cast<int32>(tmp / b.raw));
+		if constexpr (Policy::SATURATE) {
+			if (b.raw == 0) return FromRaw(raw < 0 ? minRaw : (raw > 0 ? maxRaw : 0));
+		}
+		int64 tmp = static_cast<int64>(raw) * one;
+		return FromRaw(Narrow(tmp / b.raw));
 	}
 
-	constexpr IQ& operator+=(IQ b) { raw += b.raw; return *this; }
-	constexpr IQ& operator-=(IQ b) { raw -= b.raw; return *this; }
+	constexpr IQ& operator+=(IQ b) { *this = *this + b; return *this; }
+	constexpr IQ& operator-=(IQ b) { *this = *this - b; return *this; }
 	constexpr IQ& operator*=(IQ b) { *this = *this * b; return *this; }
 	constexpr IQ& operator/=(IQ b) { *this = *this / b; return *this; }
 
@@ -79,12 +121,45 @@ public:
 	// Arithmetic IQ <-> scalar
 	constexpr IQ operator+(int32 s) const { return *this + IQ(s); }
 	constexpr IQ operator-(int32 s) const { return *this - IQ(s); }
-	constexpr IQ operator*(int32 s) const { return FromRaw(raw * s); }
-	constexpr IQ operator/(int32 s) const { return FromRaw(raw / s); }
+	constexpr IQ operator*(int32 s) const {
+		if constexpr (Policy::SATURATE) {
+			return FromRaw(Narrow(static_cast<int64>(raw) * s));
+		} else {
+			return FromRaw(raw * s);
+		}
+	}
+
+	constexpr IQ operator/(int32 s) const {
+		if constexpr (Policy::SATURATE) {
+			if (s == 0) return FromRaw(raw < 0 ? minRaw : (raw > 0 ? maxRaw : 0));
+			return FromRaw(Narrow(static_cast<int64>(raw) / s));
+		} else {
+			return FromRaw(raw / s);
+		}
+	}
 
 	friend constexpr IQ operator+(int32 s, IQ a) { return IQ(s) + a; }
 	friend constexpr IQ operator-(int32 s, IQ a) { return IQ(s) - a; }
-	friend constexpr IQ operator*(int32 s, IQ a) { return FromRaw(a.raw * s); }
+	friend constexpr IQ operator*(int32 s, IQ a) { return a * s; }
+
+
+	// Product of any two IQ formats in this format, from the exact 64-bit product with one
+	// shift, so nothing is lost in between: IQ<20>::Multiply(voltage24, gain16)
+	template<int Q1, int L1, typename P1, int Q2, int L2, typename P2>
+	static constexpr IQ Multiply(IQ<Q1, L1, P1> a, IQ<Q2, L2, P2> b) {
+		return FromWide<Q1 + Q2>(static_cast<int64>(a.raw) * b.raw);
+	}
+
+	// From a 64-bit value with Fraction fraction bits (a product, an IQAcc), rounded and
+	// saturated by the policy
+	template<int Fraction>
+	static constexpr IQ FromWide(int64 value) {
+		if constexpr (Fraction >= Q) {
+			return FromRaw(Narrow(ShiftRight(value, Fraction - Q)));
+		} else {
+			return FromRaw(Narrow(ShiftLeft(value, Q - Fraction)));
+		}
+	}
 
 
 	// Comparison
@@ -96,14 +171,55 @@ public:
 	constexpr bool operator>=(IQ b) const { return raw >= b.raw; }
 
 
-	// Conversion between IQ formats
-	template<int Q2, int L2>
-	constexpr explicit IQ(IQ<Q2, L2> other) {
-		if constexpr (Q > Q2) {
-			raw = other.raw << (Q - Q2);
-		} else {
-			raw = other.raw >> (Q2 - Q);
+	// Conversion between IQ formats, rounded and saturated by this format's policy
+	template<int Q2, int L2, typename P2>
+	constexpr explicit IQ(IQ<Q2, L2, P2> other) : raw(FromWide<Q2>(other.raw).raw) {}
+
+
+	static constexpr int32 maxRaw = 2147483647;
+	static constexpr int32 minRaw = -maxRaw - 1;
+
+
+private:
+	// int64 to raw: saturated or wrapped
+	static constexpr int32 Narrow(int64 value) {
+		if constexpr (Policy::SATURATE) {
+			if (value > maxRaw) return maxRaw;
+			if (value < minRaw) return minRaw;
 		}
+		return static_cast<int32>(value);
+	}
+
+	// Drops fraction bits, to nearest (halves up) or toward minus infinity
+	static constexpr int64 ShiftRight(int64 value, int shift) {
+		if constexpr (Policy::ROUND) {
+			if (shift > 0) value += int64(1) << (shift - 1);
+		}
+		return value >> shift;
+	}
+
+	static constexpr int64 ShiftLeft(int64 value, int shift) {
+		if constexpr (Policy::SATURATE) {
+			// Anything outside int32 saturates in Narrow(), only keep it from wrapping here
+			if (value > (int64(maxRaw) >> shift)) return int64(maxRaw) + 1;
+			if (value < (int64(minRaw) >> shift)) return int64(minRaw) - 1;
+		}
+		return static_cast<int64>(static_cast<uint64>(value) << shift);
+	}
+
+	// In the precision of the argument, float stays single precision for FPUs without double
+	template<typename Real>
+	static constexpr int32 FromReal(Real v) {
+		Real scaled = v * one;
+		if constexpr (Policy::ROUND) {
+			scaled += scaled < 0 ? Real(-0.5) : Real(0.5);
+		}
+		if constexpr (Policy::SATURATE) {
+			if (!(scaled == scaled)) return 0;
+			if (scaled >= Real(2147483648.0)) return maxRaw;
+			if (scaled < Real(-2147483648.0)) return minRaw;
+		}
+		return static_cast<int32>(scaled);
 	}
 };
 
@@ -111,51 +227,51 @@ public:
 
 
 // Free functions for ADL
-template<int Q, int L>
-constexpr IQ<Q, L> abs(IQ<Q, L> x) {
-	return IQ<Q, L>::FromRaw(x.raw < 0 ? -x.raw : x.raw);
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> abs(IQ<Q, L, P> x) {
+	return x.raw < 0 ? -x : x;
 }
 
-template<int Q, int L>
-constexpr IQ<Q, L> fabs(IQ<Q, L> x) {
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> fabs(IQ<Q, L, P> x) {
 	return abs(x);
 }
 
-template<int Q, int L>
-constexpr IQ<Q, L> min(IQ<Q, L> a, IQ<Q, L> b) {
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> min(IQ<Q, L, P> a, IQ<Q, L, P> b) {
 	return a.raw < b.raw ? a : b;
 }
 
-template<int Q, int L>
-constexpr IQ<Q, L> max(IQ<Q, L> a, IQ<Q, L> b) {
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> max(IQ<Q, L, P> a, IQ<Q, L, P> b) {
 	return a.raw > b.raw ? a : b;
 }
 
-template<int Q, int L>
-constexpr IQ<Q, L> clamp(IQ<Q, L> val, IQ<Q, L> lo, IQ<Q, L> hi) {
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> clamp(IQ<Q, L, P> val, IQ<Q, L, P> lo, IQ<Q, L, P> hi) {
 	return val.raw < lo.raw ? lo : (val.raw > hi.raw ? hi : val);
 }
 
-template<int Q, int L>
-constexpr IQ<Q, L> floor(IQ<Q, L> x) {
-	return IQ<Q, L>::FromRaw(x.raw & ~(IQ<Q, L>::one - 1));
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> floor(IQ<Q, L, P> x) {
+	return IQ<Q, L, P>::FromRaw(x.raw & ~(IQ<Q, L, P>::one - 1));
 }
 
-template<int Q, int L>
-constexpr IQ<Q, L> ceil(IQ<Q, L> x) {
-	int32 mask = IQ<Q, L>::one - 1;
-	return IQ<Q, L>::FromRaw((x.raw & mask) ? (x.raw | mask) + 1 : x.raw);
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> ceil(IQ<Q, L, P> x) {
+	int32 mask = IQ<Q, L, P>::one - 1;
+	return IQ<Q, L, P>::FromRaw((x.raw & mask) ? (x.raw | mask) + 1 : x.raw);
 }
 
-template<int Q, int L>
-constexpr IQ<Q, L> round(IQ<Q, L> x) {
-	return IQ<Q, L>::FromRaw((x.raw + (IQ<Q, L>::one >> 1)) & ~(IQ<Q, L>::one - 1));
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> round(IQ<Q, L, P> x) {
+	return IQ<Q, L, P>::FromRaw((x.raw + (IQ<Q, L, P>::one >> 1)) & ~(IQ<Q, L, P>::one - 1));
 }
 
-template<int Q, int L>
-constexpr IQ<Q, L> copysign(IQ<Q, L> mag, IQ<Q, L> sgn) {
-	int32 a = mag.raw < 0 ? -mag.raw : mag.raw;
-	return IQ<Q, L>::FromRaw(sgn.raw < 0 ? -a : a);
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> copysign(IQ<Q, L, P> mag, IQ<Q, L, P> sgn) {
+	IQ<Q, L, P> a = abs(mag);
+	return sgn.raw < 0 ? -a : a;
 }
 
 
@@ -164,6 +280,9 @@ using iq8  = IQ<8>;
 using iq16 = IQ<16>;
 using iq24 = IQ<24>;
 
+template<int Q, int LutSize = 256>
+using IQSat = IQ<Q, LutSize, IQSaturate>;
+
 
 template<typename T>
 concept IQType = requires {
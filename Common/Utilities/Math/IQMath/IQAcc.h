@@ -0,0 +1,103 @@
+#pragma once
+#include "IQ.h"
+
+
+/*
+64-bit accumulator for IQ<Q>, the MAC register of a DSP: products are added with all their
+2Q fraction bits, so increments far below one LSB of IQ<Q> (error * Ki / frequency of an
+integrator) add up instead of being truncated away. The range is 63 - 2Q integer bits
+(IQ<24>: +-32768), Get() rounds and saturates into an IQ format by that format's policy.
+
+	IQAcc<24> integrator;
+	integrator.Mac(error, kiStep);                 // integrator += error * kiStep, exact
+	integrator.Clamp(iq24(-12), iq24(12));
+	iq24 output = integrator.Get() + error * kp;
+*/
+template<int Q>
+class IQAcc {
+	static_assert(Q >= 1 && Q <= 30, "Q must be in [1, 30]");
+
+public:
+	static constexpr int fraction = 2 * Q;
+
+	int64 raw = 0;
+
+
+	constexpr IQAcc() = default;
+
+	template<int Q2, int L2, typename P2>
+	constexpr explicit IQAcc(IQ<Q2, L2, P2> value) : raw(Align<Q2>(value.raw)) {}
+
+
+	// += a * b, exact as long as the formats add up to no more than 2Q fraction bits
+	template<int Q1, int L1, typename P1, int Q2, int L2, typename P2>
+	constexpr IQAcc& Mac(IQ<Q1, L1, P1> a, IQ<Q2, L2, P2> b) {
+		raw += Align<Q1 + Q2>(static_cast<int64>(a.raw) * b.raw);
+		return *this;
+	}
+
+	// -= a * b
+	template<int Q1, int L1, typename P1, int Q2, int L2, typename P2>
+	constexpr IQAcc& Msc(IQ<Q1, L1, P1> a, IQ<Q2, L2, P2> b) {
+		raw -= Align<Q1 + Q2>(static_cast<int64>(a.raw) * b.raw);
+		return *this;
+	}
+
+	template<int Q2, int L2, typename P2>
+	constexpr IQAcc& operator+=(IQ<Q2, L2, P2> value) {
+		raw += Align<Q2>(value.raw);
+		return *this;
+	}
+
+	template<int Q2, int L2, typename P2>
+	constexpr IQAcc& operator-=(IQ<Q2, L2, P2> value) {
+		raw -= Align<Q2>(value.raw);
+		return *this;
+	}
+
+	constexpr IQAcc& operator+=(IQAcc other) { raw += other.raw; return *this; }
+	constexpr IQAcc& operator-=(IQAcc other) { raw -= other.raw; return *this; }
+
+
+	template<int L, typename P>
+	constexpr IQAcc& Clamp(IQ<Q, L, P> min, IQ<Q, L, P> max) {
+		int64 low = Align<Q>(min.raw);
+		int64 high = Align<Q>(max.raw);
+		raw = raw < low ? low : (raw > high ? high : raw);
+		return *this;
+	}
+
+	constexpr IQAcc& Reset() {
+		raw = 0;
+		return *this;
+	}
+
+
+	template<typename T = IQ<Q>>
+	constexpr T Get() const {
+		return T::template FromWide<fraction>(raw);
+	}
+
+	constexpr double ToDouble() const {
+		return static_cast<double>(raw) / static_cast<double>(int64(1) << fraction);
+	}
+
+
+	// Comparison
+	constexpr bool operator==(IQAcc b) const { return raw == b.raw; }
+	constexpr bool operator!=(IQAcc b) const { return raw != b.raw; }
+	constexpr bool operator<(IQAcc b) const { return raw < b.raw; }
+	constexpr bool operator>(IQAcc b) const { return raw > b.raw; }
+
+
+private:
+	// A value with Fraction fraction bits to 2Q fraction bits
+	template<int Fraction>
+	static constexpr int64 Align(int64 value) {
+		if constexpr (Fraction <= fraction) {
+			return static_cast<int64>(static_cast<uint64>(value) << (fraction - Fraction));
+		} else {
+			return value >> (Fraction - fraction);
+		}
+	}
+};
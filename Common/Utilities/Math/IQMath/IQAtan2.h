@@ -1,24 +1,25 @@
 #pragma once
 #include "IQ.h"
+#include "IQCordic.h"
 
 
 namespace IQDetail {
 
 // Polynomial approximation of atan(x) for x in [0, 1]
 // 9th order minimax, max error ~0.0005 rad
-template<int Q, int L>
-IQ<Q, L> AtanApprox(IQ<Q, L> x) {
-	constexpr IQ<Q, L> a1( 0.9998660f);
-	constexpr IQ<Q, L> a3(-0.3302995f);
-	constexpr IQ<Q, L> a5( 0.1801410f);
-	constexpr IQ<Q, L> a7(-0.0851330f);
-	constexpr IQ<Q, L> a9( 0.0208351f);
-
-	IQ<Q, L> x2 = x * x;
-	IQ<Q, L> x3 = x2 * x;
-	IQ<Q, L> x5 = x3 * x2;
-	IQ<Q, L> x7 = x5 * x2;
-	IQ<Q, L> x9 = x7 * x2;
+template<int Q, int L, typename P>
+IQ<Q, L, P> AtanApprox(IQ<Q, L, P> x) {
+	constexpr IQ<Q, L, P> a1( 0.9998660f);
+	constexpr IQ<Q, L, P> a3(-0.3302995f);
+	constexpr IQ<Q, L, P> a5( 0.1801410f);
+	constexpr IQ<Q, L, P> a7(-0.0851330f);
+	constexpr IQ<Q, L, P> a9( 0.0208351f);
+
+	IQ<Q, L, P> x2 = x * x;
+	IQ<Q, L, P> x3 = x2 * x;
+	IQ<Q, L, P> x5 = x3 * x2;
+	IQ<Q, L, P> x7 = x5 * x2;
+	IQ<Q, L, P> x9 = x7 * x2;
 
 	return a1 * x + a3 * x3 + a5 * x5 + a7 * x7 + a9 * x9;
 }
@@ -26,11 +27,15 @@ IQ<Q, L> AtanApprox(IQ<Q, L> x) {
 } 
 
 
-template<int Q, int L>
-IQ<Q, L> atan2(IQ<Q, L> y, IQ<Q, L> x) {
-	constexpr IQ<Q, L> pi(3.14159265358979f);
-	constexpr IQ<Q, L> half_pi(1.57079632679490f);
-	constexpr IQ<Q, L> zero(0.0f);
+template<int Q, int L, typename P>
+IQ<Q, L, P> atan2(IQ<Q, L, P> y, IQ<Q, L, P> x) {
+	if constexpr (P::CORDIC) {
+		return Cordic::Atan2(y, x);
+	}
+
+	constexpr IQ<Q, L, P> pi(3.14159265358979f);
+	constexpr IQ<Q, L, P> half_pi(1.57079632679490f);
+	constexpr IQ<Q, L, P> zero(0.0f);
 
 	if (x.raw == 0 && y.raw == 0) return zero;
 
@@ -42,17 +47,17 @@ IQ<Q, L> atan2(IQ<Q, L> y, IQ<Q, L> x) {
 		return x.raw > 0 ? zero : pi;
 	}
 
-	IQ<Q, L> ax = abs(x);
-	IQ<Q, L> ay = abs(y);
+	IQ<Q, L, P> ax = abs(x);
+	IQ<Q, L, P> ay = abs(y);
 
-	IQ<Q, L> angle;
+	IQ<Q, L, P> angle;
 	if (ay <= ax) {
 		// |y/x| <= 1, direct atan
-		IQ<Q, L> ratio = ay / ax;
+		IQ<Q, L, P> ratio = ay / ax;
 		angle = IQDetail::AtanApprox(ratio);
 	} else {
 		// |y/x| > 1, use atan(z) = pi/2 - atan(1/z)
-		IQ<Q, L> ratio = ax / ay;
+		IQ<Q, L, P> ratio = ax / ay;
 		angle = half_pi - IQDetail::AtanApprox(ratio);
 	}
 
@@ -0,0 +1,250 @@
+#pragma once
+#include "IQ.h"
+#include <bit>
+#include <type_traits>
+
+
+/*
+Shift-and-add CORDIC for IQ: no multiplier in the loop, no division, one table of 30 arctangents
+(120 bytes) for every format instead of a sin LUT per LutSize.
+	Cordic::SinCos(angle)  - rotation mode, sine and cosine in one pass
+	Cordic::Polar(x, y)    - vectoring mode, magnitude and angle in one pass
+	Cordic::Atan2(y, x), Cordic::Magnitude(x, y), Cordic::Sqrt(x)
+Q + 2 iterations (at most 30). Sin, cos, atan2 and the magnitude are within about 1 LSB up to Q24,
+sqrt is exact. Polar and Magnitude iterate in int64, a 32-bit state would lose the low bits of large
+vectors. Call these directly, or set the CORDIC flag of the policy (IQPolicy<Saturate, Round, true>)
+to make sin, cos, atan2 and sqrt use them.
+*/
+namespace IQDetail {
+
+constexpr double AtanSeries(double x) {
+	double x2 = x * x;
+	double term = x;
+	double sum = x;
+	for (int n = 3; n < 80; n += 2) {
+		term *= -x2;
+		sum += term / n;
+	}
+	return sum;
+}
+
+
+// atan(2^-i) in binary angle units: a full turn is 2^32, so angles wrap like uint32
+struct CordicTable {
+	static constexpr int SIZE = 30;
+
+	int32 angle[SIZE] = {};
+
+	constexpr CordicTable() {
+		for (int i = 0; i < SIZE; i++) {
+			double a = i == 0 ? 0.7853981633974483 : AtanSeries(1.0 / static_cast<double>(int64(1) << i));
+			angle[i] = static_cast<int32>(a / 6.283185307179586 * 4294967296.0 + 0.5);
+		}
+	}
+};
+
+inline constexpr CordicTable cordicTable{};
+
+// 1 / prod(sqrt(1 + 2^-2i)), the CORDIC gain is 1.6467602581
+constexpr int32 CORDIC_INV_GAIN_Q30 = 652032874;
+constexpr int64 CORDIC_INV_GAIN_Q31 = 1304065748;
+
+template<int Q>
+constexpr int CordicIterations() {
+	return Q + 2 < CordicTable::SIZE ? Q + 2 : CordicTable::SIZE;
+}
+
+// The magnitude is off by about 2^-2n after n iterations, 18 cover the 31 bits of every format
+template<int Q>
+constexpr int CordicMagnitudeIterations() {
+	return CordicIterations<Q>() > 18 ? CordicIterations<Q>() : 18;
+}
+
+
+// Rotation mode: cos and sin of a binary angle, in Q30
+template<int Iterations>
+constexpr void CordicRotate(uint32 phase, int32& cosine, int32& sine) {
+	// Converges for |angle| < 99.9 deg, the left half plane is turned by pi first
+	int32 z = static_cast<int32>(phase);
+	bool negate = z > 0x40000000 || z < -0x40000000;
+	if (negate) {
+		z = static_cast<int32>(phase + 0x80000000u);
+	}
+
+	// Branchless, the direction changes at random: (v ^ sign) - sign is v or -v
+	int32 x = CORDIC_INV_GAIN_Q30;
+	int32 y = 0;
+	for (int i = 0; i < Iterations; i++) {
+		int32 sign = z >> 31;
+		int32 dx = ((y >> i) ^ sign) - sign;
+		int32 dy = ((x >> i) ^ sign) - sign;
+		x -= dx;
+		y += dy;
+		z -= (cordicTable.angle[i] ^ sign) - sign;
+	}
+
+	cosine = negate ? -x : x;
+	sine = negate ? -y : y;
+}
+
+
+template<typename Int>
+struct CordicVector {
+	Int x;       // magnitude * gain, scaled by 2^shift
+	int64 angle; // binary angle, [-2^31, 2^31] (one step over pi on the negative x axis)
+	int shift;
+};
+
+// Vectoring mode: turns (x, y) onto the x axis. int32 is enough for the angle; the magnitude
+// needs an int64 state, with 32 guard bits the truncation in the loop stays below the result's LSB
+template<int Iterations, typename Int>
+constexpr CordicVector<Int> CordicRotateToAxis(int32 x0, int32 y0) {
+	using UInt = std::make_unsigned_t<Int>;
+	constexpr int BITS = 8 * sizeof(Int);
+
+	// Larger component to [2^(BITS - 4), 2^(BITS - 3)): room for the gain and sqrt(2)
+	uint32 bits = (x0 < 0 ? 0u - static_cast<uint32>(x0) : static_cast<uint32>(x0)) |
+		(y0 < 0 ? 0u - static_cast<uint32>(y0) : static_cast<uint32>(y0));
+	int shift = std::countl_zero(bits) - 3 + (BITS - 32);
+	if (bits == 0) return {0, 0, shift};
+
+	Int x = x0;
+	Int y = y0;
+	if (shift >= 0) {
+		x = static_cast<Int>(static_cast<UInt>(x) << shift);
+		y = static_cast<Int>(static_cast<UInt>(y) << shift);
+	} else {
+		x >>= -shift;
+		y >>= -shift;
+	}
+
+	// Left half plane: turn by -+pi/2 first, the rest converges
+	int32 offset = 0;
+	if (x < 0) {
+		Int t = x;
+		if (y >= 0) {
+			x = y;
+			y = -t;
+			offset = 0x40000000;
+		} else {
+			x = -y;
+			y = t;
+			offset = -0x40000000;
+		}
+	}
+
+	int32 z = 0;
+	for (int i = 0; i < Iterations; i++) {
+		Int sign = y >> (BITS - 1);
+		Int dx = ((y >> i) ^ sign) - sign;
+		Int dy = ((x >> i) ^ sign) - sign;
+		x += dx;
+		y -= dy;
+		int32 angleSign = static_cast<int32>(sign);
+		z += (cordicTable.angle[i] ^ angleSign) - angleSign;
+	}
+
+	return {x, static_cast<int64>(offset) + z, shift};
+}
+
+
+// Binary angle to IQ radians: angle * pi / 2^31
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> CordicAngle(int64 angle) {
+	constexpr int64 PI_Q29 = 1686629713;
+	return IQ<Q, L, P>::template FromWide<Q>((angle * PI_Q29 + (int64(1) << (59 - Q))) >> (60 - Q));
+}
+
+// Q30 to IQ, rounded
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> CordicResult(int32 value) {
+	if constexpr (Q == 30) {
+		return IQ<Q, L, P>::FromRaw(value);
+	} else {
+		return IQ<Q, L, P>::FromRaw((value + (int32(1) << (29 - Q))) >> (30 - Q));
+	}
+}
+
+}
+
+
+namespace Cordic {
+
+template<typename T>
+struct Trig {
+	T sine;
+	T cosine;
+};
+
+template<typename T>
+struct Vector {
+	T magnitude;
+	T angle; // radians, [-pi, pi]
+};
+
+
+// Angle in radians, any range
+template<int Q, int L, typename P>
+constexpr Trig<IQ<Q, L, P>> SinCos(IQ<Q, L, P> angle) {
+	// Radians to a binary angle: raw * 2^32 / (2pi * 2^Q), one 32x32 multiply, wraps for free
+	constexpr int64 TURN_Q34 = 2734261102; // 2^34 / 2pi
+	uint32 phase = static_cast<uint32>((static_cast<int64>(angle.raw) * TURN_Q34 + (int64(1) << (Q + 1))) >> (Q + 2));
+
+	int32 cosine;
+	int32 sine;
+	IQDetail::CordicRotate<IQDetail::CordicIterations<Q>()>(phase, cosine, sine);
+	return {IQDetail::CordicResult<Q, L, P>(sine), IQDetail::CordicResult<Q, L, P>(cosine)};
+}
+
+
+// Magnitude and angle of (x, y), the angle as atan2(y, x)
+template<int Q, int L, typename P>
+constexpr Vector<IQ<Q, L, P>> Polar(IQ<Q, L, P> x, IQ<Q, L, P> y) {
+	IQDetail::CordicVector<int64> vector = IQDetail::CordicRotateToAxis<IQDetail::CordicMagnitudeIterations<Q>(), int64>(x.raw, y.raw);
+
+	// Remove the gain as two 32x32 products, x * gain / 2^31 keeps the guard bits, then the scaling, rounded
+	int64 magnitude = (vector.x >> 31) * IQDetail::CORDIC_INV_GAIN_Q31 +
+		(((vector.x & 0x7FFFFFFF) * IQDetail::CORDIC_INV_GAIN_Q31) >> 31);
+	magnitude = (magnitude + (int64(1) << (vector.shift - 1))) >> vector.shift;
+
+	return {IQ<Q, L, P>::template FromWide<Q>(magnitude), IQDetail::CordicAngle<Q, L, P>(vector.angle)};
+}
+
+
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> Atan2(IQ<Q, L, P> y, IQ<Q, L, P> x) {
+	IQDetail::CordicVector<int32> vector = IQDetail::CordicRotateToAxis<IQDetail::CordicIterations<Q>(), int32>(x.raw, y.raw);
+	return IQDetail::CordicAngle<Q, L, P>(vector.angle);
+}
+
+
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> Magnitude(IQ<Q, L, P> x, IQ<Q, L, P> y) {
+	return Polar(x, y).magnitude;
+}
+
+
+// Digit by digit square root, the shift-and-subtract counterpart of CORDIC: exact, rounded to
+// nearest, one bit per step. 0 for negative arguments.
+template<int Q, int L, typename P>
+constexpr IQ<Q, L, P> Sqrt(IQ<Q, L, P> x) {
+	if (x.raw <= 0) return IQ<Q, L, P>::FromRaw(0);
+
+	// result_raw = sqrt(x_raw * 2^Q)
+	uint64 value = static_cast<uint64>(x.raw) << Q;
+	uint64 root = 0;
+	uint64 bit = uint64(1) << ((63 - std::countl_zero(value)) & ~1);
+	while (bit != 0) {
+		uint64 trial = root + bit;
+		uint64 take = 0 - static_cast<uint64>(value >= trial);
+		value -= trial & take;
+		root = (root >> 1) + (bit & take);
+		bit >>= 2;
+	}
+
+	// (root + 1/2)^2 = root^2 + root + 1/4
+	if (value > root) root++;
+	return IQ<Q, L, P>::FromRaw(static_cast<int32>(root));
+}
+
+}
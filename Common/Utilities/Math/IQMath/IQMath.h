@@ -1,6 +1,8 @@
 #pragma once
 
 #include "IQ.h"
+#include "IQAcc.h"
+#include "IQCordic.h"
 #include "IQTrig.h"
 #include "IQSqrt.h"
 #include "IQAtan2.h"
@@ -1,12 +1,17 @@
 #pragma once
 #include "IQ.h"
+#include "IQCordic.h"
 
 
 // Newton-Raphson sqrt for IQ type
 // y_{n+1} = (y_n + x/y_n) / 2
-template<int Q, int L>
-IQ<Q, L> sqrt(IQ<Q, L> x) {
-	if (x.raw <= 0) return IQ<Q, L>::FromRaw(0);
+template<int Q, int L, typename P>
+IQ<Q, L, P> sqrt(IQ<Q, L, P> x) {
+	if constexpr (P::CORDIC) {
+		return Cordic::Sqrt(x);
+	}
+
+	if (x.raw <= 0) return IQ<Q, L, P>::FromRaw(0);
 
 	// Scale to 64-bit: result_raw = sqrt(x_raw * 2^Q)
 	int64_t scaled = static_cast<int64_t>(x.raw) << Q;
@@ -25,5 +30,5 @@ IQ<Q, L> sqrt(IQ<Q, L> x) {
 		y = (y + scaled / y) >> 1;
 	}
 
-	return IQ<Q, L>::FromRaw(static_cast<int32_t>(y));
+	return IQ<Q, L, P>::FromRaw(static_cast<int32_t>(y));
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "IQ.h"
+#include "IQCordic.h"
 
 
 namespace IQDetail {
@@ -54,8 +55,8 @@ inline constexpr SinLUT<Size> sinLut{};
 
 
 // Lookup sin from quarter-wave table with linear interpolation
-template<int Q, int L>
-IQ<Q, L> SinLookup(IQ<Q, L> angle) {
+template<int Q, int L, typename P>
+IQ<Q, L, P> SinLookup(IQ<Q, L, P> angle) {
 	const auto& lut = sinLut<L>;
 
 	constexpr int32_t two_pi_raw = static_cast<int32_t>(6.283185307179586 * (int32_t(1) << Q));
@@ -97,20 +98,28 @@ IQ<Q, L> SinLookup(IQ<Q, L> angle) {
 		result = static_cast<int32_t>(interp << (Q - 31));
 	}
 
-	return IQ<Q, L>::FromRaw(negate ? -result : result);
+	return IQ<Q, L, P>::FromRaw(negate ? -result : result);
 }
 
 } 
 
 
 // ADL-compatible free functions
-template<int Q, int L>
-IQ<Q, L> sin(IQ<Q, L> x) {
-	return IQDetail::SinLookup(x);
+template<int Q, int L, typename P>
+IQ<Q, L, P> sin(IQ<Q, L, P> x) {
+	if constexpr (P::CORDIC) {
+		return Cordic::SinCos(x).sine;
+	} else {
+		return IQDetail::SinLookup(x);
+	}
 }
 
-template<int Q, int L>
-IQ<Q, L> cos(IQ<Q, L> x) {
-	constexpr int32_t half_pi_raw = static_cast<int32_t>(1.5707963267948966 * (int32_t(1) << Q));
-	return IQDetail::SinLookup(IQ<Q, L>::FromRaw(x.raw + half_pi_raw));
+template<int Q, int L, typename P>
+IQ<Q, L, P> cos(IQ<Q, L, P> x) {
+	if constexpr (P::CORDIC) {
+		return Cordic::SinCos(x).cosine;
+	} else {
+		constexpr int32_t half_pi_raw = static_cast<int32_t>(1.5707963267948966 * (int32_t(1) << Q));
+		return IQDetail::SinLookup(IQ<Q, L, P>::FromRaw(x.raw + half_pi_raw));
+	}
 }
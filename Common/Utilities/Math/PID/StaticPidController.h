@@ -0,0 +1,526 @@
+#pragma once
+#include <cmath>
+#include <type_traits>
+#include <Utilities/Math/IQMath/IQ.h>
+#include <Utilities/VSTD/utility/Delegate.h>
+
+
+/*
+PidController with the features chosen at compile time. Features that are not selected are
+not compiled: no branches over disabled options in Resolve(), no storage for their settings or state.
+    StaticPidController<float> pi({kp, ki}, {vMax, -vMax}, 20000);                      // PI
+    StaticPidController<iq24, PidFeature::DERIVATIVE | PidFeature::INTEGRATOR_LIMIT> pid;
+
+The math is the one of PidController. Ki / frequency and Kd * frequency are computed when the
+coefficients or the frequency change (in double, the frequency itself does not fit most IQ
+formats), inversion is folded into the signs of the gains, events count ticks instead of
+milliseconds and call a VSTD::Delegate. The plain PI Resolve() has no branches.
+There is no SetFrozen(): while frozen, do not call Resolve().
+*/
+enum class PidFeature : uint32 {
+    NONE             = 0,
+    DERIVATIVE       = 1 << 0, // D term
+    INTEGRATOR_LIMIT = 1 << 1, // clamp the integrator to its own range
+    ROLL             = 1 << 2, // cyclic input, the error takes the short way across the wrap
+    DEAD_ZONE        = 1 << 3, // forbidden range of the cyclic input, needs ROLL
+    FILTER           = 1 << 4, // back-calculation anti-windup and filtered derivative
+    EVENTS           = 1 << 5  // stabilized / destabilized callbacks
+};
+
+constexpr PidFeature operator|(PidFeature a, PidFeature b) {
+    return static_cast<PidFeature>(static_cast<uint32>(a) | static_cast<uint32>(b));
+}
+
+constexpr bool HasPidFeature(PidFeature features, PidFeature feature) {
+    return (static_cast<uint32>(features) & static_cast<uint32>(feature)) != 0;
+}
+
+
+template <RealType Type = float, PidFeature Features = PidFeature::NONE>
+class StaticPidController {
+public:
+    static constexpr bool HAS_DERIVATIVE = HasPidFeature(Features, PidFeature::DERIVATIVE);
+    static constexpr bool HAS_INTEGRATOR_LIMIT = HasPidFeature(Features, PidFeature::INTEGRATOR_LIMIT);
+    static constexpr bool HAS_ROLL = HasPidFeature(Features, PidFeature::ROLL);
+    static constexpr bool HAS_DEAD_ZONE = HasPidFeature(Features, PidFeature::DEAD_ZONE);
+    static constexpr bool HAS_FILTER = HasPidFeature(Features, PidFeature::FILTER);
+    static constexpr bool HAS_EVENTS = HasPidFeature(Features, PidFeature::EVENTS);
+
+    static_assert(!HAS_DEAD_ZONE || HAS_ROLL, "DEAD_ZONE needs ROLL");
+
+    using Handler = VSTD::Delegate<void(StaticPidController&)>;
+
+    struct Output {
+        Type max = 1;
+        Type min = 0;
+        bool inversion = false; // error = feedback - reference
+    };
+
+    struct Coefficients {
+        Type proportional = 1;
+        Type integral = 0;
+        Type derivative = 0;    // DERIVATIVE only
+    };
+
+    struct IntegratorLimit {
+        Type max = 1;
+        Type min = 0;
+    };
+
+    struct Roll {
+        Type maxInput = 1;
+        Type minInput = 0;
+    };
+
+    struct RollDeadZone {
+        bool throughConnection = false;
+        Type start = 0;
+        Type end = 0;
+    };
+
+    struct Filter {
+        Type backSaturation = 1;
+        Type derivative = 1;
+    };
+
+    struct StabilizedEvent {
+        bool enable = false;
+        Type errorMax = 1;
+        Type errorMin = 0;
+        uint32 timeMs = 100;
+        Handler onStabilized;
+    };
+
+    struct DestabilizedEvent {
+        bool enable = false;
+        Type errorMax = 1;
+        Type errorMin = 0;
+        uint32 timeMs = 100;
+        Handler onDestabilized;
+    };
+
+private:
+    struct Empty {};
+
+    struct RollValues {
+        Type fullRoll = 1;
+        Type halfRoll = Type(0.5f);
+    };
+
+    // FILTER: the continuous gains, with the sign of the inversion, and the filter states
+    struct FilterGains {
+        Type integral = 0;
+        Type derivative = 0;
+        Type samplingTime = 1;      // 1 / frequency
+    };
+
+    struct FilterSave {
+        Type lastOutput = 0;        // before the clamp
+        Type derivative = 0;
+        Type integralFilter = 0;
+        Type derivativeFilter = 0;
+    };
+
+    struct Events {
+        StabilizedEvent stabilized;
+        DestabilizedEvent destabilized;
+        uint32 stabilizedTicks = 0;   // timeMs in Resolve() calls
+        uint32 destabilizedTicks = 0;
+        uint32 stabilizedCount = 0;
+        uint32 destabilizedCount = 0;
+        bool isStabilized = false;
+        bool isDestabilized = false;
+    };
+
+    struct {
+        Type feedback = 0;
+        Type reference = 0;
+    } input;
+
+    uint32 frequency = 1;
+    Coefficients coefficients;
+    Output output;
+    [[no_unique_address]] std::conditional_t<HAS_INTEGRATOR_LIMIT, IntegratorLimit, Empty> integratorLimit;
+    [[no_unique_address]] std::conditional_t<HAS_ROLL, Roll, Empty> roll;
+    [[no_unique_address]] std::conditional_t<HAS_ROLL, RollValues, Empty> calculatedValues;
+    [[no_unique_address]] std::conditional_t<HAS_DEAD_ZONE, RollDeadZone, Empty> rollDeadZone;
+    [[no_unique_address]] std::conditional_t<HAS_FILTER, Filter, Empty> filter;
+    [[no_unique_address]] std::conditional_t<HAS_EVENTS, Events, Empty> events;
+
+    // Coefficients with the sign of the inversion and the sampling time applied
+    struct {
+        Type proportional = 1;
+        Type integralStep = 0;      // Ki / frequency
+        Type derivativeStep = 0;    // Kd * frequency
+    } gains;
+    [[no_unique_address]] std::conditional_t<HAS_FILTER, FilterGains, Empty> filterGains;
+
+    struct {
+        Type integrator = 0;
+        Type error = 0;             // reference - feedback, without the inversion
+        Type output = 0;
+    } save;
+    [[no_unique_address]] std::conditional_t<HAS_FILTER, FilterSave, Empty> filterSave;
+
+
+public:
+    StaticPidController() {}
+
+    StaticPidController(Coefficients _coefficients, Output _output, uint32 _frequency = 1) {
+        coefficients = _coefficients;
+        output = _output;
+        frequency = _frequency;
+        UpdateGains();
+    }
+
+    StaticPidController& Resolve() {
+        if constexpr (HAS_FILTER) {
+            ResolveFilter();
+        } else {
+            ResolveNormal();
+        }
+
+        if constexpr (HAS_EVENTS) {
+            ProcessEvents();
+        }
+
+        return *this;
+    }
+
+    StaticPidController& Reset() {
+        save = {};
+        filterSave = {};
+        return *this;
+    }
+
+    StaticPidController& SetReference(Type reference) {
+        if constexpr (HAS_DEAD_ZONE) {
+            reference = ClampReferenceDeadZone(reference);
+        }
+        input.reference = reference;
+        return *this;
+    }
+
+    StaticPidController& SetFeedback(Type feedback) {
+        input.feedback = feedback;
+        return *this;
+    }
+
+    // Not for every call: the gains are recalculated
+    StaticPidController& SetFrequency(uint32 val) {
+        frequency = val;
+        UpdateGains();
+        return *this;
+    }
+
+    StaticPidController& SetCoefficients(Coefficients val) {
+        coefficients = val;
+        UpdateGains();
+        return *this;
+    }
+
+    StaticPidController& SetProportional(Type val) {
+        coefficients.proportional = val;
+        UpdateGains();
+        return *this;
+    }
+
+    StaticPidController& SetIntegral(Type val) {
+        coefficients.integral = val;
+        UpdateGains();
+        return *this;
+    }
+
+    StaticPidController& SetDerivative(Type val) requires HAS_DERIVATIVE {
+        coefficients.derivative = val;
+        UpdateGains();
+        return *this;
+    }
+
+    StaticPidController& SetOutput(Output val) {
+        output = val;
+        UpdateGains();
+        return *this;
+    }
+
+    StaticPidController& SetOutputInversion(bool enableInversion) {
+        output.inversion = enableInversion;
+        UpdateGains();
+        return *this;
+    }
+
+    StaticPidController& SetIntegratorLimit(IntegratorLimit val) requires HAS_INTEGRATOR_LIMIT {
+        integratorLimit = val;
+        return *this;
+    }
+
+    StaticPidController& SetIntegratorLimit(Type val) requires HAS_INTEGRATOR_LIMIT {
+        using std::abs;
+        val = abs(val);
+        integratorLimit.max = val;
+        integratorLimit.min = -val;
+        return *this;
+    }
+
+    StaticPidController& SetRoll(Roll val) requires HAS_ROLL {
+        roll = val;
+        using std::abs;
+        calculatedValues.fullRoll = roll.maxInput + abs(roll.minInput);
+        calculatedValues.halfRoll = calculatedValues.fullRoll / Type(2);
+        return *this;
+    }
+
+    StaticPidController& SetRollDeadZone(RollDeadZone val) requires HAS_DEAD_ZONE {
+        rollDeadZone.throughConnection = val.throughConnection;
+        using std::min; using std::max;
+        rollDeadZone.start = min(val.start, val.end);
+        rollDeadZone.end = max(val.start, val.end);
+        return *this;
+    }
+
+    StaticPidController& SetFilter(Filter val) requires HAS_FILTER {
+        filter = val;
+        return *this;
+    }
+
+    StaticPidController& SetStabilizedEvent(StabilizedEvent val) requires HAS_EVENTS {
+        events.stabilized = val;
+        UpdateGains();
+        return *this;
+    }
+
+    StaticPidController& SetDestabilizedEvent(DestabilizedEvent val) requires HAS_EVENTS {
+        events.destabilized = val;
+        UpdateGains();
+        return *this;
+    }
+
+    StaticPidController& SetPidOutputValue(Type val) {
+        save.output = val;
+        return *this;
+    }
+
+    Type Get() {
+        return save.output;
+    }
+
+    Type GetLastError() {
+        return output.inversion ? -save.error : save.error;
+    }
+
+
+private:
+    void UpdateGains() {
+        Type sign = output.inversion ? Type(-1) : Type(1);
+        double rate = static_cast<double>(frequency);
+
+        Type integral = coefficients.integral * sign;
+        Type derivative = coefficients.derivative * sign;
+
+        gains.proportional = coefficients.proportional * sign;
+        gains.integralStep = Type(static_cast<double>(integral) / rate);
+        if constexpr (HAS_DERIVATIVE) {
+            gains.derivativeStep = Type(static_cast<double>(derivative) * rate);
+        }
+
+        if constexpr (HAS_FILTER) {
+            filterGains.integral = integral;
+            filterGains.derivative = derivative;
+            filterGains.samplingTime = Type(1.0 / rate);
+        }
+
+        if constexpr (HAS_EVENTS) {
+            events.stabilizedTicks = TimeToTicks(events.stabilized.timeMs);
+            events.destabilizedTicks = TimeToTicks(events.destabilized.timeMs);
+        }
+    }
+
+
+    uint32 TimeToTicks(uint32 timeMs) {
+        return static_cast<uint32>((static_cast<uint64>(timeMs) * frequency + 999) / 1000);
+    }
+
+
+    void ProcessEvents() {
+        Type error = GetLastError();
+
+        if (events.stabilized.enable) {
+            if (error >= events.stabilized.errorMin && error <= events.stabilized.errorMax) {
+                if (!events.isStabilized && ++events.stabilizedCount >= events.stabilizedTicks) {
+                    events.isStabilized = true;
+                    if (events.stabilized.onStabilized) {
+                        events.stabilized.onStabilized(*this);
+                    }
+                }
+            } else {
+                events.stabilizedCount = 0;
+                events.isStabilized = false;
+            }
+        }
+
+        if (events.destabilized.enable) {
+            if (error >= events.destabilized.errorMax || error <= events.destabilized.errorMin) {
+                if (!events.isDestabilized && ++events.destabilizedCount >= events.destabilizedTicks) {
+                    events.isDestabilized = true;
+                    if (events.destabilized.onDestabilized) {
+                        events.destabilized.onDestabilized(*this);
+                    }
+                }
+            } else {
+                events.destabilizedCount = 0;
+                events.isDestabilized = false;
+            }
+        }
+    }
+
+
+    Type ClampReferenceDeadZone(Type reference) {
+        if (rollDeadZone.throughConnection) {
+            if (reference >= roll.minInput && reference <= rollDeadZone.start) {
+                return rollDeadZone.start;
+            }
+
+            if (reference >= rollDeadZone.end && reference <= roll.maxInput) {
+                return rollDeadZone.end;
+            }
+
+            return reference;
+        }
+
+        if (reference >= rollDeadZone.start && reference <= rollDeadZone.end) {
+            using std::abs;
+            if (abs(rollDeadZone.start - reference) > abs(rollDeadZone.end - reference)) {
+                return rollDeadZone.end;
+            }
+
+            return rollDeadZone.start;
+        }
+
+        return reference;
+    }
+
+
+    bool IsThroughConnection() {
+        if constexpr (HAS_DEAD_ZONE) {
+            return rollDeadZone.throughConnection;
+        } else {
+            return false;
+        }
+    }
+
+
+    // reference - feedback, the inversion is in the gains
+    Type GetError() {
+        Type error = input.reference - input.feedback;
+
+        if constexpr (HAS_ROLL) {
+            if (!IsThroughConnection()) {
+                if (error > calculatedValues.halfRoll) {
+                    error -= calculatedValues.fullRoll;
+                } else if (error < -calculatedValues.halfRoll) {
+                    error += calculatedValues.fullRoll;
+                }
+            }
+        }
+
+        if constexpr (HAS_DEAD_ZONE) {
+            if (!IsThroughConnection()) {
+                // Routed like PidController, on the inverted error
+                error = output.inversion ? -RouteAroundDeadZone(-error) : RouteAroundDeadZone(error);
+            }
+        }
+
+        return error;
+    }
+
+
+    Type RouteAroundDeadZone(Type error) {
+        if (input.feedback >= rollDeadZone.start && input.feedback <= rollDeadZone.end) {
+            return error;
+        }
+
+        Type endFeedback = error + input.feedback;
+
+        using std::min;
+        using std::max;
+        Type pidPathStart = min(endFeedback, input.feedback);
+        Type pidPathEnd = max(endFeedback, input.feedback);
+
+        Type deadZoneStart = rollDeadZone.start;
+        Type deadZoneEnd = rollDeadZone.end;
+
+        if (pidPathEnd > calculatedValues.fullRoll) {
+            deadZoneStart += calculatedValues.fullRoll;
+            deadZoneEnd += calculatedValues.fullRoll;
+        }
+
+        if (deadZoneStart < pidPathEnd && deadZoneEnd > pidPathStart) {
+            if (error < roll.minInput) {
+                error += calculatedValues.fullRoll;
+            } else {
+                error -= calculatedValues.fullRoll;
+            }
+        }
+
+        return error;
+    }
+
+
+    void ResolveNormal() {
+        using std::min; using std::max;
+
+        Type error = GetError();
+        Type result = error * gains.proportional;
+
+        // Integrator, Ki = 0 adds 0
+        save.integrator += error * gains.integralStep;
+        if constexpr (HAS_INTEGRATOR_LIMIT) {
+            save.integrator = min(max(save.integrator, integratorLimit.min), integratorLimit.max);
+        }
+        result += save.integrator;
+
+        // Derivative
+        if constexpr (HAS_DERIVATIVE) {
+            result += (error - save.error) * gains.derivativeStep;
+        }
+
+        // Output
+        save.output = min(max(result, output.min), output.max);
+
+        // Last error
+        save.error = error;
+    }
+
+
+    void ResolveFilter() {
+        using std::min; using std::max;
+
+        Type error = GetError();
+
+        // Proportional
+        Type proportionalComponent = gains.proportional * error;
+
+        // Integrator
+        if (filterGains.integral != Type(0)) {
+            save.integrator += filterGains.samplingTime * filterSave.integralFilter;
+            if constexpr (HAS_INTEGRATOR_LIMIT) {
+                save.integrator = min(max(save.integrator, integratorLimit.min), integratorLimit.max);
+            }
+            filterSave.integralFilter = (filterGains.integral * error) + (filter.backSaturation * (save.output - filterSave.lastOutput));
+        }
+
+        // Derivative
+        if constexpr (HAS_DERIVATIVE) {
+            filterSave.derivativeFilter += filterGains.samplingTime * filterSave.derivative;
+            filterSave.derivative = ((filterGains.derivative * error) - filterSave.derivativeFilter) * filter.derivative;
+        }
+
+        // Output
+        save.output = proportionalComponent + save.integrator + filterSave.derivative;
+        filterSave.lastOutput = save.output;
+        save.output = min(max(save.output, output.min), output.max);
+
+        // Last error
+        save.error = error;
+    }
+};
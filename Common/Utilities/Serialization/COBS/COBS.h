@@ -2,11 +2,34 @@
 #include <VHAL.h>
 #include <cstdint>
 #include <cstddef>
-#include <stdexcept>
+#include <cstring>
+#include <span>
 
+/*
+Frames: startByte, COBS of the escaped payload, stopByte. Escaping replaces the three marker
+bytes with escapeByte + a code, COBS then removes the zeros that are left.
 
-template <size_t TempBufferSize = 256>
-class COBS {
+Everything works in one pass straight into the output, nothing is staged on the stack:
+    COBS<> cobs({ });
+    auto encoded = cobs.Encode(data, length, frame, sizeof(frame));
+    auto decoded = cobs.Decode(frame, frameLength, payload, sizeof(payload));
+    auto inPlace = cobs.Decode(frame, frameLength, frame, frameLength);   // output may be the input
+
+A frame can be assembled from pieces without copying them together first:
+    COBS<>::Encoder encoder(cobs.GetConfig(), std::span(frame));
+    encoder.Write(header);
+    encoder.Write(payload);
+    auto length = encoder.Finish();
+
+and received a byte or a chunk at a time, decoded as it arrives:
+    COBS<>::Decoder decoder(cobs.GetConfig(), std::span(payload));
+    decoder.Feed(received, [](std::span<const uint8> frame) { ... });
+
+Runs of 8 bytes with nothing to escape or stuff are copied as one word.
+*/
+
+
+class COBSBase {
 public:
     struct Config {
         uint8 startByte = 0xFF;
@@ -17,146 +40,424 @@ public:
         uint8 escapedEscape = 0x03;
     };
 
+    // Upper bound for a payload of `length` bytes: every byte escaped, a code byte per 254
+    static constexpr size_t MaxEncodedLength(size_t length) {
+        return 2 * length + (2 * length) / 254 + 3;
+    }
+
 private:
-    const Config config;
+    static constexpr uint8 MAX_BLOCK = 254;    // Data bytes under one code byte
 
-public:
-    COBS(const Config& config) : config(config) {
-        SystemAssert(config.startByte != config.stopByte);
-        SystemAssert(config.startByte != config.escapeByte);
-        SystemAssert(config.stopByte != config.escapeByte);
+    // True if any byte of the word equals `byte`
+    static bool HasByte(uint64 word, uint8 byte) {
+        constexpr uint64 ones = 0x0101010101010101ull;
+        uint64 x = word ^ (ones * byte);
+        return ((x - ones) & ~x & (ones << 7)) != 0;
     }
 
-    Config GetConfig() const {
-        return config;
-    }
+    // Decoded output with the escapes undone, shared by the one-shot and streaming decoders
+    class Unescaper {
+    private:
+        const Config config;
+        std::span<uint8> output;
 
-    Result<size_t> Encode(const uint8* data, size_t length, uint8* output, size_t maxOutputLength) const {
-        uint8 tempBuffer[TempBufferSize];
-        if (length > TempBufferSize) {
-            return ResultStatus::bufferOverflow;
+    public:
+        size_t length = 0;
+        bool escape = false;
+        ResultStatus error = ResultStatus::ok;
+
+        Unescaper(const Config& config, std::span<uint8> output) : config(config), output(output) {}
+
+        std::span<uint8> GetOutput() const {
+            return output;
         }
 
-        auto escapedLength = Escape(data, length, tempBuffer, TempBufferSize);
-        if (escapedLength.IsErr()) {
-            return escapedLength.Error();
+        void Reset() {
+            length = 0;
+            escape = false;
+            error = ResultStatus::ok;
         }
 
-        size_t readIndex = 0;
-        size_t writeIndex = 2;
-        size_t blockStart = 1;
+        bool Put(uint8 byte) {
+            if (escape) {
+                escape = false;
+                if (byte == config.escapedStart) byte = config.startByte;
+                else if (byte == config.escapedStop) byte = config.stopByte;
+                else if (byte == config.escapedEscape) byte = config.escapeByte;
+                else {
+                    error = ResultStatus::dataCorrupted;
+                    return false;
+                }
+            }
+            else if (byte == config.escapeByte) {
+                escape = true;
+                return true;
+            }
+
+            if (length >= output.size()) {
+                error = ResultStatus::bufferOverflow;
+                return false;
+            }
+            output[length++] = byte;
+            return true;
+        }
 
-        if (escapedLength.Value() + 2 > maxOutputLength) {
-            return ResultStatus::bufferOverflow;
+        // Block data, word at a time while there is no escape in it. `data` may be ahead of
+        // the output in the same buffer, every word is loaded before it is stored
+        bool Copy(const uint8* data, size_t count) {
+            while (count >= 8 && !escape && output.size() - length >= 8) {
+                uint64 word;
+                std::memcpy(&word, data, 8);
+                if (HasByte(word, config.escapeByte)) {
+                    break;
+                }
+                std::memcpy(output.data() + length, &word, 8);
+                length += 8;
+                data += 8;
+                count -= 8;
+            }
+            for (size_t i = 0; i < count; i++) {
+                if (!Put(data[i])) {
+                    return false;
+                }
+            }
+            return true;
         }
+    };
 
-        output[0] = config.startByte;
-        output[1] = 0; // placeholder for block length
+public:
+    // Incremental encoder: Write() any number of pieces, Finish() closes the frame
+    class Encoder {
+    private:
+        const Config config;
+        std::span<uint8> output;
+        size_t position = 2;
+        size_t blockStart = 1;          // Where the code byte of the open block goes
+        uint8 blockLength = 0;
+        bool overflow = false;
 
-        while (readIndex < escapedLength.Value()) {
-            if (tempBuffer[readIndex] == 0) {
-                output[blockStart] = writeIndex - blockStart;
-                blockStart = writeIndex++;
+        // One byte of the escaped stream
+        void Stuff(uint8 byte) {
+            if (blockLength == MAX_BLOCK) {
+                output[blockStart] = 0xFF;
+                if (!Reserve()) return;
+            }
+            if (byte == 0) {
+                output[blockStart] = blockLength + 1;
+                Reserve();
+            }
+            else if (position < output.size()) {
+                output[position++] = byte;
+                blockLength++;
             }
             else {
-                output[writeIndex++] = tempBuffer[readIndex];
+                overflow = true;
             }
-            readIndex++;
         }
 
-        output[blockStart] = writeIndex - blockStart;
-        output[writeIndex++] = config.stopByte;
+        // Opens a block: room for its code byte
+        bool Reserve() {
+            if (position >= output.size()) {
+                overflow = true;
+                return false;
+            }
+            blockStart = position++;
+            blockLength = 0;
+            return true;
+        }
 
-        return writeIndex;
-    }
+        void Put(uint8 byte) {
+            if (byte == config.startByte) {
+                Stuff(config.escapeByte);
+                Stuff(config.escapedStart);
+            }
+            else if (byte == config.stopByte) {
+                Stuff(config.escapeByte);
+                Stuff(config.escapedStop);
+            }
+            else if (byte == config.escapeByte) {
+                Stuff(config.escapeByte);
+                Stuff(config.escapedEscape);
+            }
+            else {
+                Stuff(byte);
+            }
+        }
 
-    Result<size_t> Decode(const uint8* data, size_t length, uint8* output, size_t maxOutputLength) const {
-        if (length < 2 || data[0] != config.startByte || data[length - 1] != config.stopByte) {
-            return ResultStatus::invalidArgument;
+    public:
+        Encoder(const Config& config, std::span<uint8> output) : config(config), output(output) {
+            if (output.size() < 3) {
+                overflow = true;
+                return;
+            }
+            output[0] = config.startByte;
         }
 
-        uint8 tempBuffer[TempBufferSize];
-        if (length - 2 > TempBufferSize) {
-            return ResultStatus::bufferOverflow;
+        bool Write(std::span<const uint8> data) {
+            const uint8* input = data.data();
+            size_t count = data.size();
+            while (count > 0 && !overflow) {
+                if (count >= 8 && blockLength <= MAX_BLOCK - 8 && output.size() - position >= 8) {
+                    uint64 word;
+                    std::memcpy(&word, input, 8);
+                    if (!HasByte(word, config.startByte) && !HasByte(word, config.stopByte) &&
+                        !HasByte(word, config.escapeByte) && !HasByte(word, 0)) {
+                        std::memcpy(output.data() + position, &word, 8);
+                        position += 8;
+                        blockLength += 8;
+                        input += 8;
+                        count -= 8;
+                        continue;
+                    }
+                }
+                Put(*input++);
+                count--;
+            }
+            return !overflow;
         }
 
-        size_t readIndex = 1;
-        size_t writeIndex = 0;
+        // Frame length
+        Result<size_t> Finish() {
+            if (overflow || position >= output.size()) {
+                overflow = true;
+                return ResultStatus::bufferOverflow;
+            }
+            output[blockStart] = blockLength + 1;
+            output[position++] = config.stopByte;
+            return position;
+        }
+    };
 
-        while (readIndex < length - 1) {
-            uint8 code = data[readIndex++];
-            for (size_t i = 1; i < code; ++i) {
-                if (readIndex >= length - 1) {
-                    return ResultStatus::dataCorrupted;
+    // Streaming decoder: bytes go in as they arrive, every complete valid frame is handed
+    // over decoded. Broken frames are dropped, the next startByte starts over
+    class Decoder {
+    private:
+        enum class State : uint8 {
+            Idle,           // Waiting for startByte
+            Code,
+            Data,
+            Broken          // Waiting for stopByte or startByte
+        };
+
+        const Config config;
+        Unescaper unescaper;
+        State state = State::Idle;
+        uint8 remaining = 0;            // Data bytes left in the block
+        bool zeroPending = false;       // The block ended short of 254, a zero follows unless it was the last
+        uint32 dropped = 0;
+
+        void Start() {
+            unescaper.Reset();
+            state = State::Code;
+            zeroPending = false;
+        }
+
+        void Fail() {
+            state = State::Broken;
+            dropped++;
+        }
+
+    public:
+        Decoder(const Config& config, std::span<uint8> output) : config(config), unescaper(config, output) {}
+
+        void Reset() {
+            state = State::Idle;
+        }
+
+        // Frames dropped for corruption or for not fitting the output
+        uint32 GetDroppedCount() const {
+            return dropped;
+        }
+
+        // True when `byte` completes a frame, GetFrame() has it until the next Put
+        bool Put(uint8 byte) {
+            if (byte == config.stopByte) {
+                bool complete = state == State::Code && !unescaper.escape;
+                if (state == State::Data || (state == State::Code && unescaper.escape)) {
+                    dropped++;
                 }
-                tempBuffer[writeIndex++] = data[readIndex++];
+                state = State::Idle;
+                return complete;
             }
-            if (code < 0xFF && readIndex < length - 1) {
-                tempBuffer[writeIndex++] = 0;
+
+            switch (state) {
+                case State::Idle:
+                case State::Broken:
+                    if (byte == config.startByte) {
+                        Start();
+                    }
+                    return false;
+
+                case State::Code:
+                    // A code byte may be equal to startByte, only data bytes can not
+                    if (byte == 0) {
+                        Fail();
+                        return false;
+                    }
+                    if (zeroPending && !unescaper.Put(0)) {
+                        Fail();
+                        return false;
+                    }
+                    remaining = byte - 1;
+                    zeroPending = byte != 0xFF;
+                    state = remaining > 0 ? State::Data : State::Code;
+                    return false;
+
+                case State::Data:
+                    if (byte == config.startByte) {
+                        dropped++;
+                        Start();
+                        return false;
+                    }
+                    if (!unescaper.Put(byte)) {
+                        Fail();
+                        return false;
+                    }
+                    if (--remaining == 0) {
+                        state = State::Code;
+                    }
+                    return false;
             }
+            return false;
         }
 
-        return Unescape(tempBuffer, writeIndex, output, maxOutputLength);
-    }
+        std::span<const uint8> GetFrame() const {
+            return std::span<const uint8>(unescaper.GetOutput().data(), unescaper.length);
+        }
+
+        // handler(std::span<const uint8> frame) for every frame completed by `data`
+        template<typename Handler>
+        void Feed(std::span<const uint8> data, Handler&& handler) {
+            for (size_t i = 0; i < data.size(); i++) {
+                // Inside a block: copy up to the end of it in one go when nothing in the run
+                // is a marker, bytes are checked one by one otherwise
+                if (state == State::Data && remaining >= 8 && data.size() - i >= 8) {
+                    size_t count = std::min<size_t>(remaining, data.size() - i) & ~size_t(7);
+                    size_t clean = 0;
+                    while (clean < count) {
+                        uint64 word;
+                        std::memcpy(&word, data.data() + i + clean, 8);
+                        if (HasByte(word, config.stopByte) || HasByte(word, config.startByte)) {
+                            break;
+                        }
+                        clean += 8;
+                    }
+                    if (clean > 0) {
+                        if (!unescaper.Copy(data.data() + i, clean)) {
+                            Fail();
+                        }
+                        else if ((remaining -= clean) == 0) {
+                            state = State::Code;
+                        }
+                        i += clean - 1;
+                        continue;
+                    }
+                }
+                if (Put(data[i])) {
+                    handler(GetFrame());
+                }
+            }
+        }
+    };
+
 
 private:
-    Result<size_t> Escape(const uint8* input, size_t length, uint8* output, size_t maxOutputLength) const {
-        size_t writeIndex = 0;
+    const Config config;
 
-        for (size_t i = 0; i < length; ++i) {
-            if (input[i] == config.startByte) {
-                if (writeIndex + 2 > maxOutputLength) return ResultStatus::bufferOverflow;
-                output[writeIndex++] = config.escapeByte;
-                output[writeIndex++] = config.escapedStart;
-            }
-            else if (input[i] == config.stopByte) {
-                if (writeIndex + 2 > maxOutputLength) return ResultStatus::bufferOverflow;
-                output[writeIndex++] = config.escapeByte;
-                output[writeIndex++] = config.escapedStop;
+public:
+    COBSBase(const Config& config) : config(config) {
+        SystemAssert(config.startByte != config.stopByte);
+        SystemAssert(config.startByte != config.escapeByte);
+        SystemAssert(config.stopByte != config.escapeByte);
+    }
+
+    Config GetConfig() const {
+        return config;
+    }
+
+    // Exact frame length for the payload
+    size_t EncodedLength(const uint8* data, size_t length) const {
+        size_t total = 3;
+        uint8 blockLength = 0;
+        auto stuff = [&](uint8 byte) {
+            if (blockLength == MAX_BLOCK) {
+                total++;
+                blockLength = 0;
             }
-            else if (input[i] == config.escapeByte) {
-                if (writeIndex + 2 > maxOutputLength) return ResultStatus::bufferOverflow;
-                output[writeIndex++] = config.escapeByte;
-                output[writeIndex++] = config.escapedEscape;
+            total++;
+            blockLength = byte == 0 ? 0 : blockLength + 1;
+        };
+        for (size_t i = 0; i < length; i++) {
+            uint8 byte = data[i];
+            if (byte == config.startByte || byte == config.stopByte || byte == config.escapeByte) {
+                stuff(config.escapeByte);
+                stuff(byte == config.startByte ? config.escapedStart : byte == config.stopByte ? config.escapedStop : config.escapedEscape);
             }
             else {
-                if (writeIndex + 1 > maxOutputLength) return ResultStatus::bufferOverflow;
-                output[writeIndex++] = input[i];
+                stuff(byte);
+            }
+        }
+        return total;
+    }
+
+    // The payload may be inside the output buffer, e.g. at its start, it is moved to the end
+    // of the buffer first and encoded from there
+    Result<size_t> Encode(const uint8* data, size_t length, uint8* output, size_t maxOutputLength) const {
+        bool overlaps = data < output + maxOutputLength && output < data + length;
+        if (overlaps) {
+            if (data < output || data + length > output + maxOutputLength) {
+                return ResultStatus::invalidArgument;
             }
+            if (EncodedLength(data, length) > maxOutputLength) {
+                return ResultStatus::bufferOverflow;
+            }
+            uint8* moved = output + maxOutputLength - length;
+            std::memmove(moved, data, length);
+            data = moved;
         }
 
-        return writeIndex;
+        Encoder encoder(config, std::span<uint8>(output, maxOutputLength));
+        encoder.Write(std::span<const uint8>(data, length));
+        return encoder.Finish();
     }
 
-    Result<size_t> Unescape(const uint8* input, size_t length, uint8* output, size_t maxOutputLength) const {
-        size_t writeIndex = 0;
+    // `output` may be `data`, decoding in place
+    Result<size_t> Decode(const uint8* data, size_t length, uint8* output, size_t maxOutputLength) const {
+        if (length < 2 || data[0] != config.startByte || data[length - 1] != config.stopByte) {
+            return ResultStatus::invalidArgument;
+        }
 
-        for (size_t i = 0; i < length; ++i) {
-            if (input[i] == config.escapeByte) {
-                ++i;
-                if (i >= length) return ResultStatus::dataCorrupted;
-                if (input[i] == config.escapedStart) {
-                    if (writeIndex + 1 > maxOutputLength) return ResultStatus::bufferOverflow;
-                    output[writeIndex++] = config.startByte;
-                }
-                else if (input[i] == config.escapedStop) {
-                    if (writeIndex + 1 > maxOutputLength) return ResultStatus::bufferOverflow;
-                    output[writeIndex++] = config.stopByte;
-                }
-                else if (input[i] == config.escapedEscape) {
-                    if (writeIndex + 1 > maxOutputLength) return ResultStatus::bufferOverflow;
-                    output[writeIndex++] = config.escapeByte;
-                }
-                else {
-                    return ResultStatus::dataCorrupted;
-                }
+        Unescaper unescaper(config, std::span<uint8>(output, maxOutputLength));
+        size_t readIndex = 1;
+        size_t end = length - 1;
+
+        while (readIndex < end) {
+            uint8 code = data[readIndex++];
+            size_t count = code - 1;
+            if (code == 0 || count > end - readIndex) {
+                return ResultStatus::dataCorrupted;
             }
-            else {
-                if (writeIndex + 1 > maxOutputLength) return ResultStatus::bufferOverflow;
-                output[writeIndex++] = input[i];
+            if (!unescaper.Copy(data + readIndex, count)) {
+                return unescaper.error;
+            }
+            readIndex += count;
+            if (code < 0xFF && readIndex < end && !unescaper.Put(0)) {
+                return unescaper.error;
             }
         }
 
-        return writeIndex;
+        if (unescaper.escape) {
+            return ResultStatus::dataCorrupted;
+        }
+        return unescaper.length;
     }
 };
+
+
+// TempBufferSize is not used any more, it stays so that COBS<N> declarations still compile.
+// All sizes share the config, encoder and decoder types
+template <size_t TempBufferSize = 256>
+class COBS : public COBSBase {
+public:
+    COBS(const Config& config) : COBSBase(config) {}
+};
@@ -4,6 +4,9 @@
 #include <span>
 #include <string_view>
 #include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <cstring>
 #include <Utilities/Print.h>
 
 class JSON {
@@ -17,30 +20,64 @@ public:
         NULL_TYPE
     };
 
-    // JSON Writer for streaming output to buffer
+    // JSON Writer for streaming output to buffer. With a flush callback the buffer is only a
+    // chunk that goes to the callback whenever it fills, a document of any size streams through it.
+    // Commas between elements are inserted automatically, an explicit Comma() is still accepted
     class Writer {
+    public:
+        using FlushCallback = std::function<void(std::span<const char> chunk)>;
+        static constexpr uint8 MAX_DEPTH = 31;
+        static constexpr int SHORTEST = -1;     // Precision: shortest text that reads back exactly
+
     private:
         std::span<char> buffer;
+        FlushCallback flushCallback;
         size_t position = 0;
+        size_t flushed = 0;
         bool hasError = false;
+        uint8 depth = 0;
+        uint32 hasElement = 0;          // Bit per nesting level: the next element there needs a comma
+        bool afterKey = false;          // The next value belongs to the key just written
+        bool commaWritten = false;      // Comma() was called, the next element has its comma
 
-        void WriteChar(char c) {
+        // False when the chunk is full and there is nowhere to send it
+        bool MakeRoom() {
             if (position < buffer.size()) {
-                buffer[position++] = c;
-            } else {
+                return true;
+            }
+            if (!flushCallback || buffer.empty()) {
                 hasError = true;
+                return false;
+            }
+            Flush();
+            return true;
+        }
+
+        void WriteChar(char c) {
+            if (MakeRoom()) {
+                buffer[position++] = c;
             }
         }
 
         void WriteString(std::string_view str) {
-            for (char c : str) {
-                WriteChar(c);
-                if (hasError) break;
+            while (!str.empty() && MakeRoom()) {
+                size_t count = std::min(str.size(), buffer.size() - position);
+                std::memcpy(buffer.data() + position, str.data(), count);
+                position += count;
+                str.remove_prefix(count);
             }
         }
 
         void WriteEscapedString(std::string_view str) {
-            for (char c : str) {
+            static constexpr char HEX[] = "0123456789abcdef";
+            size_t plain = 0;
+            for (size_t i = 0; i < str.size(); i++) {
+                char c = str[i];
+                if (c != '"' && c != '\\' && static_cast<uint8>(c) >= 0x20) {
+                    continue;
+                }
+                WriteString(str.substr(plain, i - plain));
+                plain = i + 1;
                 switch (c) {
                     case '"': WriteString("\\\""); break;
                     case '\\': WriteString("\\\\"); break;
@@ -49,44 +86,114 @@ public:
                     case '\n': WriteString("\\n"); break;
                     case '\r': WriteString("\\r"); break;
                     case '\t': WriteString("\\t"); break;
-                    default: WriteChar(c); break;
+                    default: {
+                        char escape[] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF] };
+                        WriteString(std::string_view(escape, sizeof(escape)));
+                        break;
+                    }
                 }
-                if (hasError) break;
+            }
+            WriteString(str.substr(plain));
+        }
+
+        void WriteInteger(uint64 magnitude, bool negative) {
+            char digits[21];
+            char* end = digits + sizeof(digits);
+            char* start = NumberFormat::WriteDecimal(end, magnitude);
+            if (negative) {
+                *--start = '-';
+            }
+            WriteString(std::string_view(start, end - start));
+        }
+
+        // A comma before every element but the first in its container, none between key and value
+        void BeginElement() {
+            if (afterKey) {
+                afterKey = false;
+                return;
+            }
+            uint32 bit = 1u << depth;
+            if (depth > 0 && (hasElement & bit) && !commaWritten) {
+                WriteChar(',');
+            }
+            hasElement |= bit;
+            commaWritten = false;
+        }
+
+        void Open(char bracket) {
+            BeginElement();
+            WriteChar(bracket);
+            if (depth == MAX_DEPTH) {
+                hasError = true;
+                return;
+            }
+            depth++;
+            hasElement &= ~(1u << depth);
+        }
+
+        void Close(char bracket) {
+            WriteChar(bracket);
+            if (depth > 0) {
+                depth--;
+            }
+            afterKey = false;
+            commaWritten = false;
+        }
+
+        template<typename T>
+        void WriteValue(T value, int precision) {
+            if constexpr (std::is_same_v<std::remove_cv_t<T>, bool>) {
+                Boolean(value);
+            } else if constexpr (std::is_same_v<std::remove_cv_t<T>, float>) {
+                Number(static_cast<float>(value), precision);
+            } else if constexpr (std::is_floating_point_v<T>) {
+                Number(static_cast<double>(value), precision);
+            } else if constexpr (std::is_signed_v<T>) {
+                Number(static_cast<int64>(value));
+            } else {
+                Number(static_cast<uint64>(value));
             }
         }
 
     public:
         explicit Writer(std::span<char> outputBuffer) : buffer(outputBuffer) {}
 
+        // Streaming: `chunk` is handed to `callback` every time it fills and on Flush(). The
+        // callback has to be done with the data when it returns, e.g. copy it or wait for the DMA
+        Writer(std::span<char> chunk, FlushCallback callback) : buffer(chunk), flushCallback(std::move(callback)) {}
+
         Writer& StartObject() {
-            WriteChar('{');
+            Open('{');
             return *this;
         }
 
         Writer& EndObject() {
-            WriteChar('}');
+            Close('}');
             return *this;
         }
 
         Writer& StartArray() {
-            WriteChar('[');
+            Open('[');
             return *this;
         }
 
         Writer& EndArray() {
-            WriteChar(']');
+            Close(']');
             return *this;
         }
 
         Writer& Key(std::string_view key) {
+            BeginElement();
             WriteChar('"');
             WriteEscapedString(key);
             WriteChar('"');
             WriteChar(':');
+            afterKey = true;
             return *this;
         }
 
         Writer& String(std::string_view value) {
+            BeginElement();
             WriteChar('"');
             WriteEscapedString(value);
             WriteChar('"');
@@ -94,45 +201,92 @@ public:
         }
 
         Writer& Number(int64 value) {
-            char numBuffer[32];
-            size_t len = Print::NumberToString(numBuffer, sizeof(numBuffer), value, Print::Format::Dec);
-            WriteString(std::string_view(numBuffer, len));
+            BeginElement();
+            WriteInteger(value < 0 ? 0 - static_cast<uint64>(value) : static_cast<uint64>(value), value < 0);
             return *this;
         }
 
         Writer& Number(uint64 value) {
-            char numBuffer[32];
-            size_t len = Print::NumberToString(numBuffer, sizeof(numBuffer), value, Print::Format::Dec);
-            WriteString(std::string_view(numBuffer, len));
+            BeginElement();
+            WriteInteger(value, false);
             return *this;
         }
 
+        // NaN and infinity have no JSON form, they are written as null
         Writer& Number(double value, int precision = 6) {
-            char numBuffer[64];
-            size_t len = Print::FloatToString(numBuffer, sizeof(numBuffer), value, static_cast<uint8>(precision));
+            BeginElement();
+            if (value != value || value - value != 0) {
+                WriteString("null");
+                return *this;
+            }
+            char numBuffer[NumberFormat::MAX_FLOAT_LENGTH];
+            size_t len = precision == SHORTEST ? NumberFormat::Shortest(numBuffer, value) :
+                         NumberFormat::Fixed(numBuffer, value, static_cast<uint8>(std::max(precision, 0)));
             WriteString(std::string_view(numBuffer, len));
             return *this;
         }
 
+        // SHORTEST gives the float's own shortest form: 0.1f is "0.1", not "0.10000000149011612"
+        Writer& Number(float value, int precision = 6) {
+            if (precision != SHORTEST || value != value || value - value != 0) {
+                return Number(static_cast<double>(value), precision);
+            }
+            BeginElement();
+            char numBuffer[NumberFormat::MAX_FLOAT_LENGTH];
+            WriteString(std::string_view(numBuffer, NumberFormat::Shortest(numBuffer, value)));
+            return *this;
+        }
+
         Writer& Boolean(bool value) {
+            BeginElement();
             WriteString(value ? "true" : "false");
             return *this;
         }
 
         Writer& Null() {
+            BeginElement();
             WriteString("null");
             return *this;
         }
 
+        // Optional, commas are inserted automatically
         Writer& Comma() {
-            WriteChar(',');
+            if (depth > 0 && !commaWritten && (hasElement & (1u << depth))) {
+                WriteChar(',');
+                commaWritten = true;
+            }
             return *this;
         }
 
+        // Whole array of integers, floating point values or bools: [1,2,3]
+        template<typename T, size_t Extent>
+        Writer& Array(std::span<T, Extent> values, int precision = 6) {
+            StartArray();
+            for (const auto& value : values) {
+                WriteValue(value, precision);
+            }
+            return EndArray();
+        }
+
+        // Array of structs, writeSample(writer, sample) writes one element each
+        template<typename T, size_t Extent, typename Function>
+        Writer& Array(std::span<T, Extent> samples, Function&& writeSample) {
+            StartArray();
+            for (const auto& sample : samples) {
+                writeSample(*this, sample);
+            }
+            return EndArray();
+        }
+
         Writer& KeyValue(std::string_view key, std::string_view value) {
             return Key(key).String(value);
         }
 
+        // Without it a string literal would pick the bool overload
+        Writer& KeyValue(std::string_view key, const char* value) {
+            return Key(key).String(value);
+        }
+
         Writer& KeyValue(std::string_view key, int64 value) {
             return Key(key).Number(value);
         }
@@ -149,14 +303,42 @@ public:
             return Key(key).Boolean(value);
         }
 
+        // Sends what is in the chunk to the flush callback
+        Writer& Flush() {
+            if (flushCallback && position > 0) {
+                flushCallback(std::span<const char>(buffer.data(), position));
+                flushed += position;
+                position = 0;
+            }
+            return *this;
+        }
+
+        // Starts a new document in the same buffer
+        void Reset() {
+            position = 0;
+            flushed = 0;
+            hasError = false;
+            depth = 0;
+            hasElement = 0;
+            afterKey = false;
+            commaWritten = false;
+        }
+
+        // Characters written, flushed ones included
         size_t GetLength() const {
-            return position;
+            return flushed + position;
+        }
+
+        // Open objects and arrays, 0 once the document is complete
+        uint8 GetDepth() const {
+            return depth;
         }
 
         bool HasError() const {
             return hasError;
         }
 
+        // Written and not flushed yet, the whole document without a flush callback
         std::string_view GetResult() const {
             return std::string_view(buffer.data(), position);
         }
@@ -252,86 +434,10 @@ public:
 
         bool ParseNumber(double& value) {
             SkipWhitespace();
-            
-            size_t endPos;
-            bool success = Print::StringToFloat(&json[position], value, &endPos);
-            if (success) {
-                position += endPos;
-            }
-            return success;
-        }
-        
-        bool ParseNumberOld(double& value) {
-            // Old implementation kept for reference
-            SkipWhitespace();
-
-            size_t start = position;
-
-            if (position >= json.size()) return false;
-
-            // Manual double parsing to avoid strtod
-            bool negative = false;
-            if (json[position] == '-') {
-                negative = true;
-                position++;
-            }
 
-            if (position >= json.size() || json[position] < '0' || json[position] > '9') {
-                position = start;
-                return false;
-            }
-
-            // Parse integer part
-            double result = 0;
-            while (position < json.size() && json[position] >= '0' && json[position] <= '9') {
-                result = result * 10 + (json[position] - '0');
-                position++;
-            }
-
-            // Parse fractional part
-            if (position < json.size() && json[position] == '.') {
-                position++;
-                double fraction = 0;
-                double divisor = 10;
-
-                while (position < json.size() && json[position] >= '0' && json[position] <= '9') {
-                    fraction += (json[position] - '0') / divisor;
-                    divisor *= 10;
-                    position++;
-                }
-
-                result += fraction;
-            }
-
-            // Parse exponent (simplified)
-            if (position < json.size() && (json[position] == 'e' || json[position] == 'E')) {
-                position++;
-                bool expNegative = false;
-                if (position < json.size() && json[position] == '-') {
-                    expNegative = true;
-                    position++;
-                } else if (position < json.size() && json[position] == '+') {
-                    position++;
-                }
-
-                int exponent = 0;
-                while (position < json.size() && json[position] >= '0' && json[position] <= '9') {
-                    exponent = exponent * 10 + (json[position] - '0');
-                    position++;
-                }
-
-                // Apply exponent (simple power of 10)
-                for (int i = 0; i < exponent; ++i) {
-                    if (expNegative) {
-                        result /= 10;
-                    } else {
-                        result *= 10;
-                    }
-                }
-            }
-
-            value = negative ? -result : result;
-            return true;
+            size_t length = NumberFormat::Parse(json.data() + position, json.size() - position, value);
+            position += length;
+            return length > 0;
         }
 
         bool ParseBoolean(bool& value) {
@@ -510,6 +616,528 @@ public:
         }
     };
 
+    // One entry of a Document's tape. Keys are STRING tokens, each followed by its value
+    struct Token {
+        static constexpr uint32 NO_PARENT = 0xFFFFFFFF;
+
+        uint32 start;               // Offset in the text, strings without their quotes
+        uint32 length : 28;         // Characters, containers up to their closing bracket
+        uint32 type : 3;            // JSON::Type
+        uint32 escaped : 1;         // String with backslashes, decoding is more than a copy
+        uint32 next;                // Index after this value and everything inside it: the next sibling
+        uint32 parent;              // Enclosing object or array
+    };
+
+    class Document;
+
+    // Handle to one value of a Document. Lookups walk sibling links, nested objects and arrays
+    // are stepped over in one move. Decoding happens on request
+    class Value {
+    private:
+        const Document* document = nullptr;
+        uint32 index = 0;
+
+        const Token& GetToken() const {
+            return document->tokens[index];
+        }
+
+        // Key token index of a member, or Token::NO_PARENT
+        uint32 FindMember(std::string_view key) const {
+            const Token& object = GetToken();
+            for (uint32 i = index + 1; i < object.next; i = document->tokens[i + 1].next) {
+                if (document->KeyEquals(document->tokens[i], key)) {
+                    return i;
+                }
+            }
+            return Token::NO_PARENT;
+        }
+
+        static bool ParseInteger(std::string_view text, uint64& value) {
+            if (text.empty()) return false;
+            value = 0;
+            for (char c : text) {
+                if (c < '0' || c > '9') return false;
+                uint32 digit = c - '0';
+                if (value > (~0ull - digit) / 10) return false;
+                value = value * 10 + digit;
+            }
+            return true;
+        }
+
+    public:
+        class Iterator {
+        private:
+            const Document* document;
+            uint32 index;           // Element, or key for object members
+
+        public:
+            Iterator(const Document* document, uint32 index) : document(document), index(index) {}
+
+            Value operator*() const {
+                bool member = document->tokens[document->tokens[index].parent].type == static_cast<uint32>(Type::OBJECT);
+                return Value(document, member ? index + 1 : index);
+            }
+
+            Iterator& operator++() {
+                bool member = document->tokens[document->tokens[index].parent].type == static_cast<uint32>(Type::OBJECT);
+                index = document->tokens[member ? index + 1 : index].next;
+                return *this;
+            }
+
+            bool operator!=(const Iterator& other) const {
+                return index != other.index;
+            }
+        };
+
+        Value() = default;
+        Value(const Document* document, uint32 index) : document(document), index(index) {}
+
+        bool IsValid() const {
+            return document != nullptr;
+        }
+
+        explicit operator bool() const {
+            return IsValid();
+        }
+
+        Type GetType() const {
+            return IsValid() ? static_cast<Type>(GetToken().type) : Type::NULL_TYPE;
+        }
+
+        bool IsNull() const {
+            return IsValid() && GetType() == Type::NULL_TYPE;
+        }
+
+        // Member of an object, invalid if there is none
+        Value operator[](std::string_view key) const {
+            if (GetType() != Type::OBJECT) return {};
+            uint32 member = FindMember(key);
+            return member != Token::NO_PARENT ? Value(document, member + 1) : Value();
+        }
+
+        // Element of an array, invalid past the end
+        Value operator[](size_t position) const {
+            if (GetType() != Type::ARRAY) return {};
+            const Token& array = GetToken();
+            for (uint32 i = index + 1; i < array.next; i = document->tokens[i].next) {
+                if (position-- == 0) {
+                    return Value(document, i);
+                }
+            }
+            return {};
+        }
+
+        // "motor.pid.kp", "sensors[2].name", relative to this value
+        Value Find(std::string_view path) const {
+            Value value = *this;
+            while (!path.empty() && value) {
+                if (path[0] == '[') {
+                    size_t close = path.find(']');
+                    uint64 position;
+                    if (close == std::string_view::npos || !ParseInteger(path.substr(1, close - 1), position)) return {};
+                    value = value[static_cast<size_t>(position)];
+                    path.remove_prefix(close + 1);
+                } else {
+                    size_t end = std::min(path.find('.'), path.find('['));
+                    value = value[path.substr(0, end)];
+                    path.remove_prefix(std::min(end, path.size()));
+                }
+                if (!path.empty() && path[0] == '.') {
+                    path.remove_prefix(1);
+                }
+            }
+            return value;
+        }
+
+        // Members of an object or elements of an array
+        size_t Size() const {
+            size_t count = 0;
+            for (auto it = begin(); it != end(); ++it) {
+                count++;
+            }
+            return count;
+        }
+
+        Iterator begin() const {
+            Type type = GetType();
+            return Iterator(document, type == Type::OBJECT || type == Type::ARRAY ? index + 1 : index);
+        }
+
+        Iterator end() const {
+            Type type = GetType();
+            return Iterator(document, type == Type::OBJECT || type == Type::ARRAY ? GetToken().next : index);
+        }
+
+        // Name of an object member as written, escapes not decoded
+        std::string_view GetKey() const {
+            if (!IsValid() || GetToken().parent == Token::NO_PARENT ||
+                document->tokens[GetToken().parent].type != static_cast<uint32>(Type::OBJECT)) {
+                return {};
+            }
+            return document->GetText(document->tokens[index - 1]);
+        }
+
+        // The value as written, strings without their quotes
+        std::string_view GetRaw() const {
+            return IsValid() ? document->GetText(GetToken()) : std::string_view{};
+        }
+
+        bool Get(uint64& value) const {
+            return GetType() == Type::NUMBER && ParseInteger(GetRaw(), value);
+        }
+
+        bool Get(int64& value) const {
+            std::string_view raw = GetRaw();
+            bool negative = !raw.empty() && raw[0] == '-';
+            uint64 magnitude;
+            if (GetType() != Type::NUMBER || !ParseInteger(raw.substr(negative), magnitude) ||
+                magnitude > (negative ? 1ull << 63 : (1ull << 63) - 1)) {
+                return false;
+            }
+            value = negative ? static_cast<int64>(0 - magnitude) : static_cast<int64>(magnitude);
+            return true;
+        }
+
+        bool Get(double& value) const {
+            std::string_view raw = GetRaw();
+            return GetType() == Type::NUMBER && NumberFormat::Parse(raw.data(), raw.size(), value) == raw.size();
+        }
+
+        bool Get(bool& value) const {
+            if (GetType() != Type::BOOLEAN) return false;
+            value = GetRaw()[0] == 't';
+            return true;
+        }
+
+        // Decodes escapes into output, \u sequences as UTF-8. Truncates like Parser::ParseString
+        bool GetString(std::span<char> output, size_t& length) const {
+            length = 0;
+            if (GetType() != Type::STRING) return false;
+            if (!GetToken().escaped) {
+                std::string_view raw = GetRaw();
+                length = std::min(raw.size(), output.size());
+                std::copy_n(raw.begin(), length, output.begin());
+                return true;
+            }
+            Document::Decode(GetRaw(), [&](char c) {
+                if (length < output.size()) {
+                    output[length++] = c;
+                }
+                return true;
+            });
+            return true;
+        }
+    };
+
+    // Tokenizes the whole text in one pass into a caller supplied tape, then answers any
+    // number of lookups without parsing again. No allocation, the text must outlive it
+    //
+    //     std::array<JSON::Token, 64> tape;
+    //     JSON::Document document(tape);
+    //     if (document.Parse(json)) {
+    //         double kp;
+    //         document.Find("motor.pid.kp").Get(kp);
+    //     }
+    class Document {
+    public:
+        enum class Error {
+            None,
+            Syntax,
+            TooManyTokens
+        };
+
+    private:
+        friend class Value;
+
+        std::span<Token> tokens;
+        std::string_view json;
+        uint32 count = 0;
+        Error error = Error::None;
+        size_t errorPosition = 0;
+
+        std::string_view GetText(const Token& token) const {
+            return json.substr(token.start, token.length);
+        }
+
+        size_t SkipWhitespace(size_t position) const {
+            while (position < json.size() &&
+                   (json[position] == ' ' || json[position] == '\t' ||
+                    json[position] == '\n' || json[position] == '\r')) {
+                position++;
+            }
+            return position;
+        }
+
+        bool Add(Type type, size_t start, size_t length, bool escaped, uint32 parent) {
+            if (count >= tokens.size()) {
+                error = Error::TooManyTokens;
+                return false;
+            }
+            Token& token = tokens[count];
+            token.start = static_cast<uint32>(start);
+            token.length = static_cast<uint32>(length);
+            token.type = static_cast<uint32>(type);
+            token.escaped = escaped;
+            token.parent = parent;
+            token.next = ++count;
+            return true;
+        }
+
+        static int32 HexDigit(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') return (c | 0x20) - 'a' + 10;
+            return -1;
+        }
+
+        static int32 ReadHex4(std::string_view text, size_t position) {
+            if (position + 4 > text.size()) return -1;
+            int32 value = 0;
+            for (size_t i = position; i < position + 4; i++) {
+                int32 digit = HexDigit(text[i]);
+                if (digit < 0) return -1;
+                value = (value << 4) | digit;
+            }
+            return value;
+        }
+
+        // Calls output(char) for every decoded character of a raw string, stops when it returns false
+        template<typename Output>
+        static void Decode(std::string_view raw, Output&& output) {
+            for (size_t i = 0; i < raw.size(); i++) {
+                char c = raw[i];
+                if (c == '\\' && i + 1 < raw.size()) {
+                    char escaped = raw[++i];
+                    if (escaped == 'u') {
+                        uint32 code = static_cast<uint32>(std::max(ReadHex4(raw, i + 1), 0));
+                        i += 4;
+                        if (code >= 0xD800 && code < 0xDC00 && i + 2 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u') {
+                            int32 low = ReadHex4(raw, i + 3);
+                            if (low >= 0xDC00 && low < 0xE000) {
+                                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                                i += 6;
+                            }
+                        }
+                        if (!EncodeUtf8(code, output)) return;
+                        continue;
+                    }
+                    switch (escaped) {
+                        case 'b': c = '\b'; break;
+                        case 'f': c = '\f'; break;
+                        case 'n': c = '\n'; break;
+                        case 'r': c = '\r'; break;
+                        case 't': c = '\t'; break;
+                        default: c = escaped; break;
+                    }
+                }
+                if (!output(c)) return;
+            }
+        }
+
+        template<typename Output>
+        static bool EncodeUtf8(uint32 code, Output& output) {
+            if (code < 0x80) {
+                return output(static_cast<char>(code));
+            }
+            if (code < 0x800) {
+                return output(static_cast<char>(0xC0 | (code >> 6))) &&
+                       output(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            if (code < 0x10000) {
+                return output(static_cast<char>(0xE0 | (code >> 12))) &&
+                       output(static_cast<char>(0x80 | ((code >> 6) & 0x3F))) &&
+                       output(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            return output(static_cast<char>(0xF0 | (code >> 18))) &&
+                   output(static_cast<char>(0x80 | ((code >> 12) & 0x3F))) &&
+                   output(static_cast<char>(0x80 | ((code >> 6) & 0x3F))) &&
+                   output(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+
+        bool KeyEquals(const Token& token, std::string_view key) const {
+            if (!token.escaped) {
+                return GetText(token) == key;
+            }
+            size_t matched = 0;
+            bool equal = true;
+            Decode(GetText(token), [&](char c) {
+                equal = matched < key.size() && key[matched++] == c;
+                return equal;
+            });
+            return equal && matched == key.size();
+        }
+
+        // String at the opening quote, returns the position after the closing one or 0
+        size_t ScanString(size_t position, uint32 parent) {
+            size_t start = position + 1;
+            bool escaped = false;
+            for (size_t i = start; i < json.size(); i++) {
+                char c = json[i];
+                if (c == '"') {
+                    return Add(Type::STRING, start, i - start, escaped, parent) ? i + 1 : 0;
+                }
+                if (static_cast<uint8>(c) < 0x20) {
+                    break;
+                }
+                if (c == '\\') {
+                    escaped = true;
+                    if (++i >= json.size()) break;
+                    char next = json[i];
+                    if (next == 'u') {
+                        if (ReadHex4(json, i + 1) < 0) break;
+                        i += 4;
+                    } else if (std::string_view("\"\\/bfnrt").find(next) == std::string_view::npos) {
+                        break;
+                    }
+                }
+            }
+            return 0;
+        }
+
+        // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        size_t ScanNumber(size_t position, uint32 parent) {
+            auto isDigit = [this](size_t i) { return i < json.size() && json[i] >= '0' && json[i] <= '9'; };
+            size_t i = position;
+            if (i < json.size() && json[i] == '-') i++;
+            if (!isDigit(i)) return 0;
+            if (json[i++] != '0') {
+                while (isDigit(i)) i++;
+            }
+            if (i < json.size() && json[i] == '.') {
+                if (!isDigit(++i)) return 0;
+                while (isDigit(i)) i++;
+            }
+            if (i < json.size() && (json[i] == 'e' || json[i] == 'E')) {
+                i++;
+                if (i < json.size() && (json[i] == '+' || json[i] == '-')) i++;
+                if (!isDigit(i)) return 0;
+                while (isDigit(i)) i++;
+            }
+            return Add(Type::NUMBER, position, i - position, false, parent) ? i : 0;
+        }
+
+        size_t ScanLiteral(size_t position, uint32 parent) {
+            for (std::string_view literal : { "true", "false", "null" }) {
+                if (json.substr(position, literal.size()) == literal) {
+                    Type type = literal[0] == 'n' ? Type::NULL_TYPE : Type::BOOLEAN;
+                    return Add(type, position, literal.size(), false, parent) ? position + literal.size() : 0;
+                }
+            }
+            return 0;
+        }
+
+        bool Fail(size_t position) {
+            if (error == Error::None) {
+                error = Error::Syntax;
+            }
+            errorPosition = position;
+            count = 0;
+            return false;
+        }
+
+    public:
+        explicit Document(std::span<Token> tokens) : tokens(tokens) {}
+
+        // Checks the whole text and fills the tape. Objects and arrays are closed through the
+        // parent links, so nesting depth needs no stack
+        bool Parse(std::string_view text) {
+            json = text;
+            count = 0;
+            error = Error::None;
+            errorPosition = 0;
+            if (json.size() > 0x0FFFFFFF) {
+                return Fail(0);
+            }
+
+            uint32 container = Token::NO_PARENT;
+            bool expectKey = false;
+            size_t position = SkipWhitespace(0);
+            while (true) {
+                if (expectKey) {
+                    size_t keyStart = position;
+                    if (position >= json.size() || json[position] != '"') return Fail(position);
+                    position = ScanString(position, container);
+                    if (position == 0) return Fail(keyStart);
+                    position = SkipWhitespace(position);
+                    if (position >= json.size() || json[position] != ':') return Fail(position);
+                    position = SkipWhitespace(position + 1);
+                }
+
+                size_t start = position;
+                char c = position < json.size() ? json[position] : '\0';
+                if (c == '{' || c == '[') {
+                    if (!Add(c == '{' ? Type::OBJECT : Type::ARRAY, position, 1, false, container)) return Fail(position);
+                    position = SkipWhitespace(position + 1);
+                    if (position < json.size() && json[position] == (c == '{' ? '}' : ']')) {
+                        tokens[count - 1].length = static_cast<uint32>(position + 1 - start);
+                        position++;
+                    } else {
+                        container = count - 1;
+                        expectKey = c == '{';
+                        continue;
+                    }
+                } else {
+                    if (c == '"') {
+                        position = ScanString(position, container);
+                    } else if (c == '-' || (c >= '0' && c <= '9')) {
+                        position = ScanNumber(position, container);
+                    } else {
+                        position = ScanLiteral(position, container);
+                    }
+                    if (position == 0) return Fail(start);
+                }
+
+                // After a value: a comma continues the container, brackets close it
+                while (true) {
+                    position = SkipWhitespace(position);
+                    if (container == Token::NO_PARENT) {
+                        return position == json.size() || Fail(position);
+                    }
+                    Token& open = tokens[container];
+                    bool object = open.type == static_cast<uint32>(Type::OBJECT);
+                    char c = position < json.size() ? json[position] : '\0';
+                    if (c == ',') {
+                        position = SkipWhitespace(position + 1);
+                        expectKey = object;
+                        break;
+                    }
+                    if (c != (object ? '}' : ']')) {
+                        return Fail(position);
+                    }
+                    open.length = static_cast<uint32>(position + 1 - open.start);
+                    open.next = count;
+                    container = open.parent;
+                    position++;
+                }
+            }
+        }
+
+        Error GetError() const {
+            return error;
+        }
+
+        // Where the text stopped making sense
+        size_t GetErrorPosition() const {
+            return errorPosition;
+        }
+
+        // Tape entries in use, also what a text needs: one per value and one per key
+        size_t GetTokenCount() const {
+            return count;
+        }
+
+        Value GetRoot() const {
+            return count > 0 ? Value(this, 0) : Value();
+        }
+
+        Value Find(std::string_view path) const {
+            return GetRoot().Find(path);
+        }
+
+        Value operator[](std::string_view key) const {
+            return GetRoot()[key];
+        }
+    };
+
     // Helper functions for quick operations
     static bool GetString(std::string_view json, std::string_view key, std::span<char> output, size_t& length) {
         std::array<char, 128> valueBuffer{};
@@ -558,40 +1186,6 @@ public:
 
         if (valueStr.empty()) return false;
 
-        // Manual double parsing
-        size_t pos = 0;
-        bool negative = false;
-
-        if (pos < valueStr.size() && valueStr[pos] == '-') {
-            negative = true;
-            pos++;
-        }
-
-        if (pos >= valueStr.size() || valueStr[pos] < '0' || valueStr[pos] > '9') {
-            return false;
-        }
-
-        double result = 0;
-        while (pos < valueStr.size() && valueStr[pos] >= '0' && valueStr[pos] <= '9') {
-            result = result * 10 + (valueStr[pos] - '0');
-            pos++;
-        }
-
-        if (pos < valueStr.size() && valueStr[pos] == '.') {
-            pos++;
-            double fraction = 0;
-            double divisor = 10;
-
-            while (pos < valueStr.size() && valueStr[pos] >= '0' && valueStr[pos] <= '9') {
-                fraction += (valueStr[pos] - '0') / divisor;
-                divisor *= 10;
-                pos++;
-            }
-
-            result += fraction;
-        }
-
-        value = negative ? -result : result;
-        return true;
+        return NumberFormat::Parse(valueStr.data(), valueStr.size(), value) > 0;
     }
 };
@@ -0,0 +1,474 @@
+#pragma once
+#include <VHAL.h>
+#include <span>
+#include <string_view>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+/*
+MessagePack (msgpack.org) writer and reader over caller supplied buffers, no allocation
+
+Integers take the smallest encoding that holds them, a telemetry frame usually ends up at
+a third of its JSON size:
+    uint8 buffer[64];
+    MessagePack::Writer writer(buffer);
+    writer.StartArray(3).Number(uint64(time)).Number(current).Boolean(enabled);
+    if (!writer.HasError()) Send(writer.GetResult());
+
+    MessagePack::Reader reader(received);
+    uint32 count;
+    uint64 time;
+    if (reader.ReadArray(count) && count == 3 && reader.Read(time)) ...
+
+A failed Read leaves the reader where it was, Skip() steps over a whole value of any type
+*/
+
+class MessagePack {
+public:
+    enum class Type {
+        NIL,
+        BOOLEAN,
+        INTEGER,
+        FLOAT,
+        STRING,
+        BINARY,
+        ARRAY,
+        MAP,
+        EXTENSION,
+        INVALID
+    };
+
+    class Writer {
+    private:
+        std::span<uint8> buffer;
+        size_t position = 0;
+        bool hasError = false;
+
+        void Put(uint8 byte) {
+            if (position < buffer.size()) {
+                buffer[position++] = byte;
+            } else {
+                hasError = true;
+            }
+        }
+
+        // Marker followed by `bytes` bytes of value, big-endian
+        void Put(uint8 marker, uint64 value, uint8 bytes) {
+            if (buffer.size() - position < 1u + bytes) {
+                hasError = true;
+                position = buffer.size();
+                return;
+            }
+            buffer[position++] = marker;
+            for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+                buffer[position++] = static_cast<uint8>(value >> shift);
+            }
+        }
+
+        void PutBytes(const void* data, size_t length) {
+            if (buffer.size() - position < length) {
+                hasError = true;
+                position = buffer.size();
+                return;
+            }
+            std::memcpy(buffer.data() + position, data, length);
+            position += length;
+        }
+
+        // fix form for short lengths, then 8, 16 or 32 bit lengths
+        void PutLength(uint32 length, uint8 fixMarker, uint32 fixLimit, uint8 marker8, uint8 marker16, uint8 marker32) {
+            if (length < fixLimit) {
+                Put(static_cast<uint8>(fixMarker | length));
+            } else if (marker8 != 0 && length <= 0xFF) {
+                Put(marker8, length, 1);
+            } else if (length <= 0xFFFF) {
+                Put(marker16, length, 2);
+            } else {
+                Put(marker32, length, 4);
+            }
+        }
+
+    public:
+        explicit Writer(std::span<uint8> outputBuffer) : buffer(outputBuffer) {}
+
+        Writer& Nil() {
+            Put(0xC0);
+            return *this;
+        }
+
+        Writer& Boolean(bool value) {
+            Put(value ? 0xC3 : 0xC2);
+            return *this;
+        }
+
+        Writer& Number(uint64 value) {
+            if (value < 0x80) {
+                Put(static_cast<uint8>(value));
+            } else if (value <= 0xFF) {
+                Put(0xCC, value, 1);
+            } else if (value <= 0xFFFF) {
+                Put(0xCD, value, 2);
+            } else if (value <= 0xFFFFFFFF) {
+                Put(0xCE, value, 4);
+            } else {
+                Put(0xCF, value, 8);
+            }
+            return *this;
+        }
+
+        // Non-negative values use the unsigned forms, they are never longer
+        Writer& Number(int64 value) {
+            if (value >= 0) {
+                return Number(static_cast<uint64>(value));
+            }
+            if (value >= -32) {
+                Put(static_cast<uint8>(value));
+            } else if (value >= std::numeric_limits<int8>::min()) {
+                Put(0xD0, static_cast<uint64>(value), 1);
+            } else if (value >= std::numeric_limits<int16>::min()) {
+                Put(0xD1, static_cast<uint64>(value), 2);
+            } else if (value >= std::numeric_limits<int32>::min()) {
+                Put(0xD2, static_cast<uint64>(value), 4);
+            } else {
+                Put(0xD3, static_cast<uint64>(value), 8);
+            }
+            return *this;
+        }
+
+        Writer& Number(float value) {
+            Put(0xCA, std::bit_cast<uint32>(value), 4);
+            return *this;
+        }
+
+        Writer& Number(double value) {
+            Put(0xCB, std::bit_cast<uint64>(value), 8);
+            return *this;
+        }
+
+        Writer& String(std::string_view value) {
+            PutLength(static_cast<uint32>(value.size()), 0xA0, 32, 0xD9, 0xDA, 0xDB);
+            PutBytes(value.data(), value.size());
+            return *this;
+        }
+
+        Writer& Binary(std::span<const uint8> value) {
+            PutLength(static_cast<uint32>(value.size()), 0, 0, 0xC4, 0xC5, 0xC6);
+            PutBytes(value.data(), value.size());
+            return *this;
+        }
+
+        // The `count` elements follow
+        Writer& StartArray(uint32 count) {
+            PutLength(count, 0x90, 16, 0, 0xDC, 0xDD);
+            return *this;
+        }
+
+        // The `count` key and value pairs follow
+        Writer& StartMap(uint32 count) {
+            PutLength(count, 0x80, 16, 0, 0xDE, 0xDF);
+            return *this;
+        }
+
+        void Reset() {
+            position = 0;
+            hasError = false;
+        }
+
+        size_t GetLength() const {
+            return position;
+        }
+
+        bool HasError() const {
+            return hasError;
+        }
+
+        std::span<const uint8> GetResult() const {
+            return std::span<const uint8>(buffer.data(), position);
+        }
+    };
+
+    class Reader {
+    private:
+        std::span<const uint8> data;
+        size_t position = 0;
+
+        bool Available(size_t count) const {
+            return data.size() - position >= count;
+        }
+
+        // `bytes` big-endian bytes at `offset` from the current position, bounds checked by the caller
+        uint64 Big(size_t offset, uint8 bytes) const {
+            uint64 value = 0;
+            for (uint8 i = 0; i < bytes; i++) {
+                value = (value << 8) | data[position + offset + i];
+            }
+            return value;
+        }
+
+        // Any integer form as magnitude and sign, does not move
+        bool PeekInteger(uint64& magnitude, bool& negative, size_t& length) const {
+            if (!Available(1)) return false;
+            uint8 marker = data[position];
+            negative = false;
+            if (marker < 0x80) {
+                magnitude = marker;
+                length = 1;
+                return true;
+            }
+            if (marker >= 0xE0) {
+                negative = true;
+                magnitude = 0x100 - marker;
+                length = 1;
+                return true;
+            }
+            if (marker < 0xCC || marker > 0xD3) return false;
+
+            uint8 bytes = 1 << ((marker - 0xCC) & 3);
+            if (!Available(1u + bytes)) return false;
+            uint64 raw = Big(1, bytes);
+            length = 1 + bytes;
+            if (marker <= 0xCF) {
+                magnitude = raw;
+                return true;
+            }
+            // Sign extend the two's complement value
+            uint8 unused = 64 - bytes * 8;
+            int64 value = static_cast<int64>(raw << unused) >> unused;
+            negative = value < 0;
+            magnitude = negative ? 0 - static_cast<uint64>(value) : static_cast<uint64>(value);
+            return true;
+        }
+
+        // String, binary, array or map header: the count and the header size
+        bool PeekLength(uint8 fixMask, uint8 fixMarker, uint8 fixBits, uint8 marker8, uint8 marker16, uint8 marker32,
+                        uint32& count, size_t& header) const {
+            if (!Available(1)) return false;
+            uint8 marker = data[position];
+            if (fixBits != 0 && (marker & fixMask) == fixMarker) {
+                count = marker & ((1u << fixBits) - 1);
+                header = 1;
+                return true;
+            }
+            uint8 bytes = marker == marker8 && marker8 != 0 ? 1 : marker == marker16 ? 2 : marker == marker32 ? 4 : 0;
+            if (bytes == 0 || !Available(1u + bytes)) return false;
+            count = static_cast<uint32>(Big(1, bytes));
+            header = 1 + bytes;
+            return true;
+        }
+
+        bool ReadBytes(uint8 fixMask, uint8 fixMarker, uint8 fixBits, uint8 marker8, uint8 marker16, uint8 marker32,
+                       std::span<const uint8>& value) {
+            uint32 count;
+            size_t header;
+            if (!PeekLength(fixMask, fixMarker, fixBits, marker8, marker16, marker32, count, header) ||
+                !Available(header + count)) {
+                return false;
+            }
+            value = data.subspan(position + header, count);
+            position += header + count;
+            return true;
+        }
+
+    public:
+        explicit Reader(std::span<const uint8> input) : data(input) {}
+
+        Type GetType() const {
+            if (!Available(1)) return Type::INVALID;
+            uint8 marker = data[position];
+            if (marker < 0x80 || marker >= 0xE0 || (marker >= 0xCC && marker <= 0xD3)) return Type::INTEGER;
+            if (marker < 0x90 || marker == 0xDE || marker == 0xDF) return Type::MAP;
+            if (marker < 0xA0 || marker == 0xDC || marker == 0xDD) return Type::ARRAY;
+            if (marker < 0xC0 || (marker >= 0xD9 && marker <= 0xDB)) return Type::STRING;
+            switch (marker) {
+                case 0xC0: return Type::NIL;
+                case 0xC2: case 0xC3: return Type::BOOLEAN;
+                case 0xC4: case 0xC5: case 0xC6: return Type::BINARY;
+                case 0xCA: case 0xCB: return Type::FLOAT;
+                case 0xC1: return Type::INVALID;
+                default: return Type::EXTENSION;
+            }
+        }
+
+        bool ReadNil() {
+            if (!Available(1) || data[position] != 0xC0) return false;
+            position++;
+            return true;
+        }
+
+        bool Read(bool& value) {
+            if (!Available(1) || (data[position] & 0xFE) != 0xC2) return false;
+            value = data[position++] == 0xC3;
+            return true;
+        }
+
+        bool Read(uint64& value) {
+            uint64 magnitude;
+            bool negative;
+            size_t length;
+            if (!PeekInteger(magnitude, negative, length) || negative) return false;
+            value = magnitude;
+            position += length;
+            return true;
+        }
+
+        bool Read(int64& value) {
+            uint64 magnitude;
+            bool negative;
+            size_t length;
+            if (!PeekInteger(magnitude, negative, length) ||
+                magnitude > (negative ? 1ull << 63 : (1ull << 63) - 1)) {
+                return false;
+            }
+            value = negative ? static_cast<int64>(0 - magnitude) : static_cast<int64>(magnitude);
+            position += length;
+            return true;
+        }
+
+        // Either float size, integers are converted
+        bool Read(double& value) {
+            if (!Available(1)) return false;
+            uint8 marker = data[position];
+            if (marker == 0xCA && Available(5)) {
+                value = std::bit_cast<float>(static_cast<uint32>(Big(1, 4)));
+                position += 5;
+                return true;
+            }
+            if (marker == 0xCB && Available(9)) {
+                value = std::bit_cast<double>(Big(1, 8));
+                position += 9;
+                return true;
+            }
+
+            uint64 magnitude;
+            bool negative;
+            size_t length;
+            if (!PeekInteger(magnitude, negative, length)) return false;
+            value = negative ? -static_cast<double>(magnitude) : static_cast<double>(magnitude);
+            position += length;
+            return true;
+        }
+
+        bool Read(float& value) {
+            if (Available(5) && data[position] == 0xCA) {
+                value = std::bit_cast<float>(static_cast<uint32>(Big(1, 4)));
+                position += 5;
+                return true;
+            }
+            double wide;
+            if (!Read(wide)) return false;
+            value = static_cast<float>(wide);
+            return true;
+        }
+
+        // Points into the input, not terminated
+        bool ReadString(std::string_view& value) {
+            std::span<const uint8> bytes;
+            if (!ReadBytes(0xE0, 0xA0, 5, 0xD9, 0xDA, 0xDB, bytes)) return false;
+            value = std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            return true;
+        }
+
+        bool ReadBinary(std::span<const uint8>& value) {
+            return ReadBytes(0, 0, 0, 0xC4, 0xC5, 0xC6, value);
+        }
+
+        // Header only, the elements are read next
+        bool ReadArray(uint32& count) {
+            size_t header;
+            if (!PeekLength(0xF0, 0x90, 4, 0, 0xDC, 0xDD, count, header)) return false;
+            position += header;
+            return true;
+        }
+
+        bool ReadMap(uint32& count) {
+            size_t header;
+            if (!PeekLength(0xF0, 0x80, 4, 0, 0xDE, 0xDF, count, header)) return false;
+            position += header;
+            return true;
+        }
+
+        // Steps over one value including everything nested in it, without recursion
+        bool Skip() {
+            size_t start = position;
+            uint64 pending = 1;
+            while (pending > 0) {
+                if (!Available(1)) {
+                    position = start;
+                    return false;
+                }
+                uint8 marker = data[position];
+                size_t header = 1;
+                uint64 payload = 0;
+                uint64 children = 0;
+                uint8 lengthBytes = 0;
+
+                if (marker < 0x80 || marker >= 0xE0) {
+                    // fixint, the marker is the value
+                } else if (marker < 0x90) {
+                    children = 2 * (marker & 0x0F);
+                } else if (marker < 0xA0) {
+                    children = marker & 0x0F;
+                } else if (marker < 0xC0) {
+                    payload = marker & 0x1F;
+                } else {
+                    switch (marker) {
+                        case 0xC0: case 0xC2: case 0xC3: break;
+                        case 0xC4: case 0xD9: lengthBytes = 1; break;
+                        case 0xC5: case 0xDA: lengthBytes = 2; break;
+                        case 0xC6: case 0xDB: lengthBytes = 4; break;
+                        case 0xC7: lengthBytes = 1; break;
+                        case 0xC8: lengthBytes = 2; break;
+                        case 0xC9: lengthBytes = 4; break;
+                        case 0xCA: case 0xD2: case 0xCE: header = 5; break;
+                        case 0xCB: case 0xD3: case 0xCF: header = 9; break;
+                        case 0xCC: case 0xD0: header = 2; break;
+                        case 0xCD: case 0xD1: header = 3; break;
+                        case 0xD4: header = 3; break;
+                        case 0xD5: header = 4; break;
+                        case 0xD6: header = 6; break;
+                        case 0xD7: header = 10; break;
+                        case 0xD8: header = 18; break;
+                        case 0xDC: case 0xDE: lengthBytes = 2; break;
+                        case 0xDD: case 0xDF: lengthBytes = 4; break;
+                        default:
+                            position = start;
+                            return false;
+                    }
+                }
+
+                if (lengthBytes != 0) {
+                    if (!Available(1u + lengthBytes)) {
+                        position = start;
+                        return false;
+                    }
+                    uint64 length = Big(1, lengthBytes);
+                    header = 1 + lengthBytes + (marker >= 0xC7 && marker <= 0xC9);  // ext: type byte
+                    if (marker == 0xDC || marker == 0xDD) {
+                        children = length;
+                    } else if (marker == 0xDE || marker == 0xDF) {
+                        children = 2 * length;
+                    } else {
+                        payload = length;
+                    }
+                }
+
+                if (!Available(header + payload)) {
+                    position = start;
+                    return false;
+                }
+                position += header + payload;
+                pending += children - 1;
+            }
+            return true;
+        }
+
+        size_t GetPosition() const {
+            return position;
+        }
+
+        bool IsAtEnd() const {
+            return position >= data.size();
+        }
+    };
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <VHAL.h>
+#include <array>
+#include <tuple>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/*
+Field list of a plain struct, written once next to its members:
+    struct Telemetry {
+        uint32 time;
+        float current;
+        std::array<int16, 3> phases;
+        SERIALIZABLE(time, current, phases)
+    };
+
+The macro adds two inline functions and one string constant. Nothing is stored in the
+objects, the names are the macro's own text in flash and are split at compile time.
+Serializers walk the fields with a fold over the member references:
+    Reflection::ForEachField(telemetry, [](std::string_view name, auto& field) { ... });
+*/
+
+
+#define SERIALIZABLE(...) \
+    auto ReflectFields() { return std::tie(__VA_ARGS__); } \
+    auto ReflectFields() const { return std::tie(__VA_ARGS__); } \
+    static constexpr std::string_view REFLECTED_NAMES = #__VA_ARGS__;
+
+
+namespace Reflection {
+    template<typename T, typename = void>
+    struct IsReflected : std::false_type {};
+
+    template<typename T>
+    struct IsReflected<T, std::void_t<decltype(std::declval<const T&>().ReflectFields())>> : std::true_type {};
+
+    template<typename T>
+    inline constexpr bool IS_REFLECTED = IsReflected<std::remove_cv_t<T>>::value;
+
+
+    template<typename T>
+    constexpr size_t FieldCount() {
+        return std::tuple_size_v<decltype(std::declval<const T&>().ReflectFields())>;
+    }
+
+
+    // "time, current,\n phases" -> { "time", "current", "phases" }
+    template<typename T>
+    constexpr auto SplitNames() {
+        std::array<std::string_view, FieldCount<T>()> names{};
+        std::string_view text = T::REFLECTED_NAMES;
+        for (auto& name : names) {
+            size_t comma = text.find(',');
+            name = text.substr(0, comma);
+            text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+
+            while (!name.empty() && (name.front() == ' ' || name.front() == '\t' || name.front() == '\n' || name.front() == '\r')) {
+                name.remove_prefix(1);
+            }
+            while (!name.empty() && (name.back() == ' ' || name.back() == '\t' || name.back() == '\n' || name.back() == '\r')) {
+                name.remove_suffix(1);
+            }
+        }
+        return names;
+    }
+
+    template<typename T>
+    inline constexpr auto FIELD_NAMES = SplitNames<T>();
+
+
+    // function(name, field) for every field in declaration order, field is a reference
+    // (const for a const object)
+    template<typename T, typename Function>
+    void ForEachField(T& object, Function&& function) {
+        using Type = std::remove_cv_t<T>;
+        auto fields = object.ReflectFields();
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (function(FIELD_NAMES<Type>[I], std::get<I>(fields)), ...);
+        }(std::make_index_sequence<FieldCount<Type>()>{});
+    }
+}
@@ -0,0 +1,299 @@
+#pragma once
+#include <VHAL.h>
+#include <Utilities/Serialization/Reflection/Reflection.h>
+#include <Utilities/Serialization/JSON/JSON.h>
+#include <Utilities/Serialization/MessagePack/MessagePack.h>
+#include <array>
+#include <span>
+#include <limits>
+#include <cstring>
+
+/*
+JSON and MessagePack for structs declared with SERIALIZABLE, the code for every field is
+generated at compile time from the one field list:
+    struct Motor {
+        float kp, ki;
+        Mode mode;                      // enums travel as their underlying integer
+        SERIALIZABLE(kp, ki, mode)
+    };
+
+    struct Telemetry {
+        uint32 time;
+        std::array<float, 3> phases;
+        char name[16];                  // char arrays are strings
+        Motor motor;                    // nested structs are objects / arrays
+        SERIALIZABLE(time, phases, name, motor)
+    };
+
+    StructSerializer::ToJson(writer, telemetry);               // {"time":1,"phases":[...],...}
+    StructSerializer::FromJson(document.GetRoot(), telemetry);
+
+    StructSerializer::ToMessagePack(packWriter, telemetry);    // [1,[...],"...",[...]]
+    StructSerializer::FromMessagePack(reader, telemetry);
+
+JSON is matched by name: members missing from the text keep their value, unknown ones are
+ignored. MessagePack is positional (a struct is an array of its fields in order), the compact
+form: missing trailing fields keep their value, extra trailing ones are skipped. Floats are
+written in their shortest exact form, so both directions round-trip bit for bit.
+
+Reading returns false when a value has the wrong type or does not fit its field (arrays must
+have exactly their length). JSON goes on with the other fields, MessagePack stops there.
+*/
+
+class StructSerializer {
+private:
+    template<typename T>
+    struct ArrayTraits {
+        static constexpr bool IS_ARRAY = false;
+    };
+
+    template<typename T, size_t N>
+    struct ArrayTraits<T[N]> {
+        static constexpr bool IS_ARRAY = true;
+        using Element = T;
+    };
+
+    template<typename T, size_t N>
+    struct ArrayTraits<std::array<T, N>> {
+        static constexpr bool IS_ARRAY = true;
+        using Element = T;
+    };
+
+    template<typename T>
+    static constexpr bool IsString() {
+        if constexpr (ArrayTraits<T>::IS_ARRAY) {
+            return std::is_same_v<std::remove_cv_t<typename ArrayTraits<T>::Element>, char>;
+        } else {
+            return false;
+        }
+    }
+
+    template<typename T>
+    static constexpr bool IsSupported() {
+        return Reflection::IS_REFLECTED<T> || ArrayTraits<T>::IS_ARRAY || std::is_arithmetic_v<T> || std::is_enum_v<T>;
+    }
+
+    // Up to the first NUL, all of the array if there is none
+    template<typename T>
+    static std::string_view StringOf(const T& text) {
+        const char* data = std::data(text);
+        return std::string_view(data, strnlen(data, std::size(text)));
+    }
+
+    template<typename T>
+    static void SetString(T& text, std::string_view value) {
+        size_t length = std::min(value.size(), std::size(text));
+        std::memcpy(std::data(text), value.data(), length);
+        std::memset(std::data(text) + length, 0, std::size(text) - length);
+    }
+
+    template<typename T>
+    static bool FitInteger(T& field, int64 value) {
+        if constexpr (std::is_unsigned_v<T>) {
+            if (value < 0 || static_cast<uint64>(value) > std::numeric_limits<T>::max()) return false;
+        } else {
+            if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()) return false;
+        }
+        field = static_cast<T>(value);
+        return true;
+    }
+
+    template<typename T>
+    static bool FitInteger(T& field, uint64 value) {
+        if (value > static_cast<uint64>(std::numeric_limits<T>::max())) return false;
+        field = static_cast<T>(value);
+        return true;
+    }
+
+public:
+    template<typename T>
+    static void ToJson(JSON::Writer& writer, const T& value) {
+        static_assert(IsSupported<T>(), "field type has no JSON form, add SERIALIZABLE to it");
+        if constexpr (Reflection::IS_REFLECTED<T>) {
+            writer.StartObject();
+            Reflection::ForEachField(value, [&writer](std::string_view name, const auto& field) {
+                writer.Key(name);
+                ToJson(writer, field);
+            });
+            writer.EndObject();
+        } else if constexpr (IsString<T>()) {
+            writer.String(StringOf(value));
+        } else if constexpr (ArrayTraits<T>::IS_ARRAY) {
+            writer.StartArray();
+            for (const auto& element : value) {
+                ToJson(writer, element);
+            }
+            writer.EndArray();
+        } else if constexpr (std::is_same_v<T, bool>) {
+            writer.Boolean(value);
+        } else if constexpr (std::is_enum_v<T>) {
+            ToJson(writer, static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            writer.Number(value, JSON::Writer::SHORTEST);
+        } else if constexpr (std::is_signed_v<T>) {
+            writer.Number(static_cast<int64>(value));
+        } else {
+            writer.Number(static_cast<uint64>(value));
+        }
+    }
+
+    // Into a buffer, returns the length or 0 if it does not fit
+    template<typename T>
+    static size_t ToJson(std::span<char> buffer, const T& value) {
+        JSON::Writer writer(buffer);
+        ToJson(writer, value);
+        return writer.HasError() ? 0 : writer.GetLength();
+    }
+
+    template<typename T>
+    static bool FromJson(JSON::Value json, T& value) {
+        static_assert(IsSupported<T>(), "field type has no JSON form, add SERIALIZABLE to it");
+        if constexpr (Reflection::IS_REFLECTED<T>) {
+            if (json.GetType() != JSON::Type::OBJECT) return false;
+            bool success = true;
+            Reflection::ForEachField(value, [&json, &success](std::string_view name, auto& field) {
+                JSON::Value member = json[name];
+                if (member && !FromJson(member, field)) {
+                    success = false;
+                }
+            });
+            return success;
+        } else if constexpr (IsString<T>()) {
+            std::array<char, sizeof(T)> text;
+            size_t length;
+            if (!json.GetString(text, length)) return false;
+            SetString(value, std::string_view(text.data(), length));
+            return true;
+        } else if constexpr (ArrayTraits<T>::IS_ARRAY) {
+            if (json.GetType() != JSON::Type::ARRAY) return false;
+            bool success = true;
+            size_t count = 0;
+            for (JSON::Value element : json) {
+                if (count == std::size(value)) return false;
+                success &= FromJson(element, value[count++]);
+            }
+            return success && count == std::size(value);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return json.Get(value);
+        } else if constexpr (std::is_enum_v<T>) {
+            std::underlying_type_t<T> raw;
+            if (!FromJson(json, raw)) return false;
+            value = static_cast<T>(raw);
+            return true;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            // Straight to the field type, a float read through double could round twice
+            std::string_view raw = json.GetRaw();
+            return json.GetType() == JSON::Type::NUMBER && NumberFormat::Parse(raw.data(), raw.size(), value) == raw.size();
+        } else if constexpr (std::is_signed_v<T>) {
+            int64 raw;
+            return json.Get(raw) && FitInteger(value, raw);
+        } else {
+            uint64 raw;
+            return json.Get(raw) && FitInteger(value, raw);
+        }
+    }
+
+    // Parses text with a caller supplied tape, see JSON::Document
+    template<typename T>
+    static bool FromJson(std::string_view text, std::span<JSON::Token> tape, T& value) {
+        JSON::Document document(tape);
+        return document.Parse(text) && FromJson(document.GetRoot(), value);
+    }
+
+    template<typename T>
+    static void ToMessagePack(MessagePack::Writer& writer, const T& value) {
+        static_assert(IsSupported<T>(), "field type has no MessagePack form, add SERIALIZABLE to it");
+        if constexpr (Reflection::IS_REFLECTED<T>) {
+            writer.StartArray(Reflection::FieldCount<T>());
+            Reflection::ForEachField(value, [&writer](std::string_view, const auto& field) {
+                ToMessagePack(writer, field);
+            });
+        } else if constexpr (IsString<T>()) {
+            writer.String(StringOf(value));
+        } else if constexpr (ArrayTraits<T>::IS_ARRAY) {
+            writer.StartArray(static_cast<uint32>(std::size(value)));
+            for (const auto& element : value) {
+                ToMessagePack(writer, element);
+            }
+        } else if constexpr (std::is_same_v<T, bool>) {
+            writer.Boolean(value);
+        } else if constexpr (std::is_enum_v<T>) {
+            ToMessagePack(writer, static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_same_v<T, float>) {
+            writer.Number(value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            writer.Number(static_cast<double>(value));
+        } else if constexpr (std::is_signed_v<T>) {
+            writer.Number(static_cast<int64>(value));
+        } else {
+            writer.Number(static_cast<uint64>(value));
+        }
+    }
+
+    // Into a buffer, returns the length or 0 if it does not fit
+    template<typename T>
+    static size_t ToMessagePack(std::span<uint8> buffer, const T& value) {
+        MessagePack::Writer writer(buffer);
+        ToMessagePack(writer, value);
+        return writer.HasError() ? 0 : writer.GetLength();
+    }
+
+    template<typename T>
+    static bool FromMessagePack(MessagePack::Reader& reader, T& value) {
+        static_assert(IsSupported<T>(), "field type has no MessagePack form, add SERIALIZABLE to it");
+        if constexpr (Reflection::IS_REFLECTED<T>) {
+            uint32 count;
+            if (!reader.ReadArray(count)) return false;
+            bool success = true;
+            uint32 index = 0;
+            Reflection::ForEachField(value, [&](std::string_view, auto& field) {
+                if (index++ < count) {
+                    success = success && FromMessagePack(reader, field);
+                }
+            });
+            // Fields of a newer sender
+            for (; index < count && success; index++) {
+                success = reader.Skip();
+            }
+            return success;
+        } else if constexpr (IsString<T>()) {
+            std::string_view text;
+            if (!reader.ReadString(text)) return false;
+            SetString(value, text);
+            return true;
+        } else if constexpr (ArrayTraits<T>::IS_ARRAY) {
+            uint32 count;
+            if (!reader.ReadArray(count) || count != std::size(value)) return false;
+            for (auto& element : value) {
+                if (!FromMessagePack(reader, element)) return false;
+            }
+            return true;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return reader.Read(value);
+        } else if constexpr (std::is_enum_v<T>) {
+            std::underlying_type_t<T> raw;
+            if (!FromMessagePack(reader, raw)) return false;
+            value = static_cast<T>(raw);
+            return true;
+        } else if constexpr (std::is_same_v<T, float>) {
+            return reader.Read(value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            double raw;
+            if (!reader.Read(raw)) return false;
+            value = static_cast<T>(raw);
+            return true;
+        } else if constexpr (std::is_signed_v<T>) {
+            int64 raw;
+            return reader.Read(raw) && FitInteger(value, raw);
+        } else {
+            uint64 raw;
+            return reader.Read(raw) && FitInteger(value, raw);
+        }
+    }
+
+    template<typename T>
+    static bool FromMessagePack(std::span<const uint8> data, T& value) {
+        MessagePack::Reader reader(data);
+        return FromMessagePack(reader, value);
+    }
+};
@@ -7,6 +7,7 @@
 #include "memory/Allocator.h"
 #include "memory/DefaultHeap.h"
 #include "memory/PoolAllocator.h"
+#include "memory/SlabAllocator.h"
 #include "container/Array.h"
 #include "container/Span.h"
 #include "container/Vector.h"
@@ -11,7 +11,21 @@
 
 namespace VSTD {
 
-template<typename T>
+// Capacity growth policy: capacity * Numerator / Denominator when full
+template<std::size_t Numerator, std::size_t Denominator = 1>
+struct GrowthFactor {
+    static_assert(Numerator > Denominator, "Growth factor must be greater than 1");
+
+    static constexpr std::size_t InitialCapacity = 4;
+
+    static constexpr std::size_t Next(std::size_t capacity) {
+        if (capacity == 0) return InitialCapacity;
+        std::size_t next = capacity * Numerator / Denominator;
+        return next > capacity ? next : capacity + 1;
+    }
+};
+
+template<typename T, typename Growth = GrowthFactor<2>>
 class Vector {
 public:
     using ValueType = T;
@@ -19,6 +33,9 @@ public:
     using ConstIterator = const T*;
 
 private:
+    // Elements can be moved around with memmove / the allocator's Reallocate
+    static constexpr bool IsRelocatable = std::is_trivially_copyable_v<T>;
+
     Handle handle_;
     std::size_t size_ = 0;
     std::size_t capacity_ = 0;
@@ -114,21 +131,15 @@ public:
 
 
     void PushBack(const T& value) {
-        if (size_ >= capacity_) Grow(size_ + 1);
-        T* data = RawData();
-        if (data) {
-            new (&data[size_]) T(value);
-            size_++;
-        }
+        if (size_ >= capacity_ && !Grow(size_ + 1)) return;
+        new (&RawData()[size_]) T(value);
+        size_++;
     }
 
     void PushBack(T&& value) {
-        if (size_ >= capacity_) Grow(size_ + 1);
-        T* data = RawData();
-        if (data) {
-            new (&data[size_]) T(static_cast<T&&>(value));
-            size_++;
-        }
+        if (size_ >= capacity_ && !Grow(size_ + 1)) return;
+        new (&RawData()[size_]) T(static_cast<T&&>(value));
+        size_++;
     }
 
     template<typename... Args>
@@ -151,37 +162,42 @@ public:
 
     void Insert(std::size_t index, const T& value) {
         if (index > size_) return;
-        if (size_ >= capacity_) Grow(size_ + 1);
-        T* data = RawData();
-        for (std::size_t i = size_; i > index; i--) {
-            new (&data[i]) T(static_cast<T&&>(data[i - 1]));
-            data[i - 1].~T();
+        if constexpr (IsRelocatable) {
+            T copy = value; // value may live in this vector
+            if (size_ >= capacity_ && !Grow(size_ + 1)) return;
+            T* data = RawData();
+            memmove(&data[index + 1], &data[index], (size_ - index) * sizeof(T));
+            new (&data[index]) T(copy);
+        } else {
+            if (size_ >= capacity_ && !Grow(size_ + 1)) return;
+            T* data = RawData();
+            for (std::size_t i = size_; i > index; i--) {
+                new (&data[i]) T(static_cast<T&&>(data[i - 1]));
+                data[i - 1].~T();
+            }
+            new (&data[index]) T(value);
         }
-        new (&data[index]) T(value);
         size_++;
     }
 
     void Erase(std::size_t index) {
-        if (index >= size_) return;
-        T* data = RawData();
-        data[index].~T();
-        for (std::size_t i = index; i + 1 < size_; i++) {
-            new (&data[i]) T(static_cast<T&&>(data[i + 1]));
-            data[i + 1].~T();
-        }
-        size_--;
+        EraseRange(index, 1);
     }
 
     void EraseRange(std::size_t first, std::size_t count) {
         if (first >= size_ || count == 0) return;
         if (first + count > size_) count = size_ - first;
         T* data = RawData();
-        for (std::size_t i = first; i < first + count; i++) {
-            data[i].~T();
-        }
-        for (std::size_t i = first; i + count < size_; i++) {
-            new (&data[i]) T(static_cast<T&&>(data[i + count]));
-            data[i + count].~T();
+        if constexpr (IsRelocatable) {
+            memmove(&data[first], &data[first + count], (size_ - first - count) * sizeof(T));
+        } else {
+            for (std::size_t i = first; i < first + count; i++) {
+                data[i].~T();
+            }
+            for (std::size_t i = first; i + count < size_; i++) {
+                new (&data[i]) T(static_cast<T&&>(data[i + count]));
+                data[i + count].~T();
+            }
         }
         size_ -= count;
     }
@@ -220,10 +236,26 @@ public:
         DestroyElements();
     }
 
+    // Exact capacity, no growth factor applied
     void Reserve(std::size_t newCapacity) {
         if (newCapacity > capacity_) {
-            Grow(newCapacity);
+            Reallocate(newCapacity);
+        }
+    }
+
+    // Releases unused capacity back to the allocator
+    void ShrinkToFit() {
+        if (capacity_ == size_) return;
+        if (size_ == 0) {
+            if (handle_.IsValid()) {
+                auto* alloc = GetAlloc();
+                if (alloc) alloc->Deallocate(handle_);
+                handle_ = Handle{};
+            }
+            capacity_ = 0;
+            return;
         }
+        Reallocate(size_);
     }
 
     void Resize(std::size_t newSize) {
@@ -236,7 +268,8 @@ public:
             }
             size_ = newSize;
         } else if (newSize > size_) {
-            Reserve(newSize);
+            // Geometric, so growing one element at a time stays amortized O(1)
+            if (newSize > capacity_ && !Grow(newSize)) return;
             T* data = RawData();
             for (std::size_t i = size_; i < newSize; i++) {
                 new (&data[i]) T();
@@ -261,16 +294,37 @@ private:
         return static_cast<T*>(handle_.Data());
     }
 
-    void Grow(std::size_t minCapacity) {
-        std::size_t newCap = capacity_ == 0 ? 4 : capacity_ * 2;
+    bool Grow(std::size_t minCapacity) {
+        std::size_t newCap = Growth::Next(capacity_);
         if (newCap < minCapacity) newCap = minCapacity;
+        return Reallocate(newCap);
+    }
 
+    bool Reallocate(std::size_t newCap) {
         auto* alloc = GetAlloc();
-        Handle newHandle = alloc->Reallocate(handle_, newCap * sizeof(T));
-        if (!newHandle.IsValid()) return;
+        if (!alloc) return false;
+
+        if constexpr (IsRelocatable) {
+            // Extends the block in place when the allocator can
+            Handle newHandle = alloc->Reallocate(handle_, newCap * sizeof(T));
+            if (!newHandle.IsValid()) return false;
+            handle_ = newHandle;
+        } else {
+            Handle newHandle = alloc->Allocate(newCap * sizeof(T));
+            if (!newHandle.IsValid()) return false;
+
+            T* dst = static_cast<T*>(newHandle.Data());
+            T* src = RawData();
+            for (std::size_t i = 0; i < size_; i++) {
+                new (&dst[i]) T(static_cast<T&&>(src[i]));
+                src[i].~T();
+            }
+            if (handle_.IsValid()) alloc->Deallocate(handle_);
+            handle_ = newHandle;
+        }
 
-        handle_ = newHandle;
         capacity_ = newCap;
+        return true;
     }
 
     void DestroyElements() {
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <string.h>
 #include <new>
+#include <bit>
 #include "IAllocator.h"
 
 namespace VSTD {
@@ -26,6 +27,19 @@ struct IncrementalDefrag {
 template <std::size_t N = 1>
 using BatchDefrag = IncrementalDefrag<N>;
 
+// Moves at most Bytes per Defragment() call, so it can run from an idle
+// hook with a bounded execution time
+template <std::size_t Bytes>
+struct BudgetDefrag {
+    template <typename Heap>
+    static void Step(Heap& heap) {
+        std::size_t budget = Bytes;
+        while (std::size_t moved = heap.DefragStepWithin(budget)) {
+            budget -= moved;
+        }
+    }
+};
+
 template <std::size_t Percent>
 struct ThresholdDefrag {
     template <typename Heap>
@@ -45,6 +59,7 @@ struct BlockHeader {
     Entry*      handleEntry = nullptr;
     std::size_t size = 0;
     bool        free = false;
+    bool        prevFree = false;   // Previous physical block is free (its size is in its footer)
 };
 
 class OomCallback {
@@ -88,9 +103,33 @@ private:
     }
 };
 
+// Free blocks are kept in TLSF-style segregated lists: the first level splits
+// sizes by power of two, the second level splits each power of two range into
+// SlCount linear classes. Two bitmaps tell which lists are non-empty, so finding
+// a fitting free block is a couple of bit scans instead of a heap walk.
+//
+// A free block is merged with its free neighbours as soon as it is released
+// (the previous one is found through the size footer at the end of every free
+// block), so there are never two adjacent free blocks and never a free block
+// at the top of the data region. Compaction resumes from a cursor below which
+// all blocks are in use.
 template <typename DefragPolicy = NoDefrag, typename LockPolicy = NoLock>
 class Heap : public IAllocator {
 private:
+    // Links are stored in the payload of free blocks
+    struct FreeLinks {
+        BlockHeader* prev;
+        BlockHeader* next;
+    };
+
+    static constexpr std::size_t Alignment = alignof(BlockHeader);
+    static constexpr std::size_t MinBlockSize = sizeof(FreeLinks) + sizeof(std::size_t);
+    static constexpr std::size_t SlLog2 = 2;
+    static constexpr std::size_t SlCount = 1 << SlLog2;
+    static constexpr std::size_t FlCount = sizeof(std::size_t) * 8 - SlLog2 + 1;
+
+    static_assert(sizeof(BlockHeader) % Alignment == 0, "BlockHeader must keep payload aligned");
+
     uint8_t*    buffer_;
     std::size_t capacity_;
     bool        ownsBuffer_;
@@ -98,6 +137,19 @@ private:
     std::size_t entryCount_;
     OomCallback oomCallback_;
 
+    std::size_t  flBitmap_ = 0;
+    uint8_t      slBitmap_[FlCount] = {};
+    BlockHeader* freeLists_[FlCount][SlCount] = {};
+
+    // Dead entries of the handle table, linked through Entry::data
+    Entry*      freeEntries_ = nullptr;
+
+    std::size_t usedBytes_ = 0;
+    std::size_t freeBlockBytes_ = 0;
+
+    // Every block below this offset is in use
+    std::size_t defragCursor_ = 0;
+
 public:
     // External buffer, pointer + size
     Heap(uint8_t* buf, std::size_t size)
@@ -125,15 +177,17 @@ public:
     Handle Allocate(std::size_t size) override {
         LockPolicy::Lock();
 
-        Handle result = TryAllocateFromFreeBlock(size);
+        std::size_t blockSize = AlignSize(size);
+
+        Handle result = TryAllocateFromFreeBlock(size, blockSize);
         if (result.IsValid()) {
             LockPolicy::Unlock();
             return result;
         }
 
-        std::size_t newEntryCount = entryCount_ + 1;
+        std::size_t newEntryCount = freeEntries_ ? entryCount_ : entryCount_ + 1;
         std::size_t tableBytes = newEntryCount * sizeof(Entry);
-        std::size_t needed = dataTop_ + sizeof(BlockHeader) + size + tableBytes;
+        std::size_t needed = dataTop_ + sizeof(BlockHeader) + blockSize + tableBytes;
 
         if (needed > capacity_) {
             LockPolicy::Unlock();
@@ -141,17 +195,17 @@ public:
             return Handle();
         }
 
-        Entry* entry = EntrySlot(entryCount_);
-        new (entry) Entry();
-        entryCount_ = newEntryCount;
+        Entry* entry = AcquireEntry();
 
         BlockHeader* hdr = reinterpret_cast<BlockHeader*>(buffer_ + dataTop_);
         hdr->handleEntry = entry;
-        hdr->size = size;
+        hdr->size = blockSize;
         hdr->free = false;
+        hdr->prevFree = false;
 
         void* data = buffer_ + dataTop_ + sizeof(BlockHeader);
-        dataTop_ += sizeof(BlockHeader) + size;
+        dataTop_ += sizeof(BlockHeader) + blockSize;
+        usedBytes_ += blockSize;
 
         entry->data = data;
         entry->size = size;
@@ -167,8 +221,15 @@ public:
             void* data = handle.Data();
             BlockHeader* hdr = reinterpret_cast<BlockHeader*>(
                 static_cast<uint8_t*>(data) - sizeof(BlockHeader));
+            Entry* entry = handle.GetEntry();
+
             hdr->free = true;
+            hdr->handleEntry = nullptr;
+            usedBytes_ -= hdr->size;
+            ReleaseBlock(hdr);
+
             handle.Invalidate();
+            ReleaseEntry(entry);
         }
         LockPolicy::Unlock();
     }
@@ -178,11 +239,14 @@ public:
             return Allocate(newSize);
         }
 
-        std::size_t oldSize = handle.Size();
-        if (newSize <= oldSize) {
+        LockPolicy::Lock();
+        bool resized = ResizeInPlace(handle.GetEntry(), newSize);
+        LockPolicy::Unlock();
+        if (resized) {
             return handle;
         }
 
+        std::size_t oldSize = handle.Size();
         Handle newHandle = Allocate(newSize);
         if (!newHandle.IsValid()) {
             return Handle{};
@@ -205,85 +269,66 @@ public:
         LockPolicy::Unlock();
     }
 
+    // Single compaction step: slides the first block above a hole down into it
     bool DefragStep() {
-        std::size_t offset = 0;
-        while (offset + sizeof(BlockHeader) <= dataTop_) {
-            BlockHeader* hdr = reinterpret_cast<BlockHeader*>(buffer_ + offset);
-            std::size_t blockTotal = sizeof(BlockHeader) + hdr->size;
-
-            if (hdr->free) {
-                std::size_t nextOffset = offset + blockTotal;
-
-                if (nextOffset >= dataTop_) {
-                    dataTop_ = offset;
-                    return true;
-                }
-
-                BlockHeader* nextHdr = reinterpret_cast<BlockHeader*>(buffer_ + nextOffset);
-
-                if (nextHdr->free) {
-                    hdr->size += sizeof(BlockHeader) + nextHdr->size;
-                    return true;
-                }
+        return DefragStepWithin(static_cast<std::size_t>(-1)) != 0;
+    }
 
-                std::size_t nextBlockTotal = sizeof(BlockHeader) + nextHdr->size;
-                uint8_t* src = buffer_ + nextOffset;
-                uint8_t* dst = buffer_ + offset;
+    // Single compaction step that moves at most maxBytes (block header included).
+    // Returns the number of bytes moved, 0 if the heap is compact or the next
+    // block to move is larger than maxBytes
+    std::size_t DefragStepWithin(std::size_t maxBytes) {
+        BlockHeader* hdr = FindHole();
+        if (!hdr) {
+            return 0;
+        }
 
-                Entry* movedEntry = nextHdr->handleEntry;
-                std::size_t movedSize = nextHdr->size;
+        // A hole is never the last block and never followed by another hole
+        BlockHeader* moved = NextBlock(hdr);
+        std::size_t movedTotal = sizeof(BlockHeader) + moved->size;
+        if (movedTotal > maxBytes) {
+            return 0;
+        }
 
-                memmove(dst, src, nextBlockTotal);
+        RemoveFreeBlock(hdr);
+        std::size_t holeSize = hdr->size;
 
-                BlockHeader* movedHdr = reinterpret_cast<BlockHeader*>(dst);
-                void* newData = dst + sizeof(BlockHeader);
-                movedEntry->data = newData;
+        memmove(hdr, moved, movedTotal);
+        hdr->prevFree = false;
+        hdr->handleEntry->data = reinterpret_cast<uint8_t*>(hdr) + sizeof(BlockHeader);
 
-                std::size_t remainingFree = hdr->size;
-                BlockHeader* freeHdr = reinterpret_cast<BlockHeader*>(
-                    dst + sizeof(BlockHeader) + movedSize);
-                freeHdr->handleEntry = nullptr;
-                freeHdr->size = remainingFree;
-                freeHdr->free = true;
+        BlockHeader* freeHdr = NextBlock(hdr);
+        freeHdr->handleEntry = nullptr;
+        freeHdr->size = holeSize;
+        freeHdr->free = true;
+        freeHdr->prevFree = false;
+        defragCursor_ = Offset(freeHdr);
+        MergeWithNext(freeHdr);
+        PlaceFreeBlock(freeHdr);
 
-                return true;
-            }
+        return movedTotal;
+    }
 
-            offset += blockTotal;
+    // Compacts for at most budgetBytes of moved data, returns the bytes moved.
+    // Call repeatedly (e.g. from an idle hook) until it returns 0
+    std::size_t DefragFor(std::size_t budgetBytes) {
+        LockPolicy::Lock();
+        std::size_t total = 0;
+        while (std::size_t moved = DefragStepWithin(budgetBytes - total)) {
+            total += moved;
         }
-        return false;
+        LockPolicy::Unlock();
+        return total;
     }
 
     std::size_t FragmentationPercent() const {
-        std::size_t totalFree = 0;
-        std::size_t freeBlocks = 0;
-        std::size_t offset = 0;
-
-        while (offset + sizeof(BlockHeader) <= dataTop_) {
-            BlockHeader* hdr = reinterpret_cast<BlockHeader*>(buffer_ + offset);
-            if (hdr->free) {
-                totalFree += hdr->size;
-                ++freeBlocks;
-            }
-            offset += sizeof(BlockHeader) + hdr->size;
-        }
-
-        if (totalFree == 0) return 0;
+        if (freeBlockBytes_ == 0) return 0;
         if (dataTop_ == 0) return 0;
-        return (totalFree * 100) / dataTop_;
+        return (freeBlockBytes_ * 100) / dataTop_;
     }
 
     std::size_t UsedBytes() const {
-        std::size_t used = 0;
-        std::size_t offset = 0;
-        while (offset + sizeof(BlockHeader) <= dataTop_) {
-            BlockHeader* hdr = reinterpret_cast<BlockHeader*>(buffer_ + offset);
-            if (!hdr->free) {
-                used += hdr->size;
-            }
-            offset += sizeof(BlockHeader) + hdr->size;
-        }
-        return used;
+        return usedBytes_;
     }
 
     std::size_t TotalBytes() const {
@@ -293,18 +338,7 @@ public:
     std::size_t FreeBytes() const {
         std::size_t tableSz = entryCount_ * sizeof(Entry);
         std::size_t unallocated = capacity_ - dataTop_ - tableSz;
-
-        std::size_t freeInBlocks = 0;
-        std::size_t offset = 0;
-        while (offset + sizeof(BlockHeader) <= dataTop_) {
-            BlockHeader* hdr = reinterpret_cast<BlockHeader*>(buffer_ + offset);
-            if (hdr->free) {
-                freeInBlocks += hdr->size;
-            }
-            offset += sizeof(BlockHeader) + hdr->size;
-        }
-
-        return unallocated + freeInBlocks;
+        return unallocated + freeBlockBytes_;
     }
 
 private:
@@ -313,61 +347,275 @@ private:
             buffer_ + capacity_ - (index + 1) * sizeof(Entry));
     }
 
-    Handle TryAllocateFromFreeBlock(std::size_t size) {
-        std::size_t offset = 0;
-        while (offset + sizeof(BlockHeader) <= dataTop_) {
-            BlockHeader* hdr = reinterpret_cast<BlockHeader*>(buffer_ + offset);
-            std::size_t blockTotal = sizeof(BlockHeader) + hdr->size;
-
-            if (hdr->free && hdr->size >= size) {
-                Entry* entry = nullptr;
-                for (std::size_t i = 0; i < entryCount_; ++i) {
-                    Entry* e = EntrySlot(i);
-                    if (!e->alive) {
-                        entry = e;
-                        break;
-                    }
-                }
+    // Caller guarantees there is room for a new slot when no dead entry exists
+    Entry* AcquireEntry() {
+        Entry* entry = freeEntries_;
+        if (entry) {
+            freeEntries_ = static_cast<Entry*>(entry->data);
+        } else {
+            entry = EntrySlot(entryCount_);
+            ++entryCount_;
+        }
+        new (entry) Entry();
+        return entry;
+    }
 
-                if (!entry) {
-                    std::size_t newEntryCount = entryCount_ + 1;
-                    std::size_t tableBytes = newEntryCount * sizeof(Entry);
-                    if (dataTop_ + tableBytes > capacity_) {
-                        offset += blockTotal;
-                        continue;
-                    }
-                    entry = EntrySlot(entryCount_);
-                    new (entry) Entry();
-                    ++entryCount_;
-                }
+    void ReleaseEntry(Entry* entry) {
+        entry->data = freeEntries_;
+        freeEntries_ = entry;
+    }
+
+    std::size_t Offset(BlockHeader* hdr) const {
+        return static_cast<std::size_t>(reinterpret_cast<uint8_t*>(hdr) - buffer_);
+    }
+
+    // nullptr if hdr is the last block
+    BlockHeader* NextBlock(BlockHeader* hdr) const {
+        std::size_t next = Offset(hdr) + sizeof(BlockHeader) + hdr->size;
+        if (next >= dataTop_) return nullptr;
+        return reinterpret_cast<BlockHeader*>(buffer_ + next);
+    }
+
+    static std::size_t& Footer(BlockHeader* hdr) {
+        return *reinterpret_cast<std::size_t*>(
+            reinterpret_cast<uint8_t*>(hdr) + sizeof(BlockHeader) + hdr->size - sizeof(std::size_t));
+    }
+
+    static BlockHeader* PrevFreeBlock(BlockHeader* hdr) {
+        std::size_t prevSize = *reinterpret_cast<std::size_t*>(
+            reinterpret_cast<uint8_t*>(hdr) - sizeof(std::size_t));
+        return reinterpret_cast<BlockHeader*>(
+            reinterpret_cast<uint8_t*>(hdr) - prevSize - sizeof(BlockHeader));
+    }
+
+    void MergeWithNext(BlockHeader* hdr) {
+        BlockHeader* next = NextBlock(hdr);
+        if (next && next->free) {
+            RemoveFreeBlock(next);
+            hdr->size += sizeof(BlockHeader) + next->size;
+        }
+    }
+
+    // Shrinks the block, or grows it into the following free block or the
+    // unallocated region, without moving the data
+    bool ResizeInPlace(Entry* entry, std::size_t newSize) {
+        BlockHeader* hdr = reinterpret_cast<BlockHeader*>(
+            static_cast<uint8_t*>(entry->data) - sizeof(BlockHeader));
+        std::size_t blockSize = AlignSize(newSize);
 
-                std::size_t remaining = hdr->size - size;
-                if (remaining > sizeof(BlockHeader) + 1) {
-                    hdr->size = size;
-                    hdr->free = false;
-                    hdr->handleEntry = entry;
-
-                    BlockHeader* splitHdr = reinterpret_cast<BlockHeader*>(
-                        buffer_ + offset + sizeof(BlockHeader) + size);
-                    splitHdr->handleEntry = nullptr;
-                    splitHdr->size = remaining - sizeof(BlockHeader);
-                    splitHdr->free = true;
-                } else {
-                    hdr->free = false;
-                    hdr->handleEntry = entry;
+        if (blockSize > hdr->size) {
+            std::size_t extra = blockSize - hdr->size;
+            BlockHeader* next = NextBlock(hdr);
+
+            if (!next) {
+                if (dataTop_ + extra + entryCount_ * sizeof(Entry) > capacity_) {
+                    return false;
                 }
+                dataTop_ += extra;
+                usedBytes_ += extra;
+                hdr->size = blockSize;
+            } else if (next->free && sizeof(BlockHeader) + next->size >= extra) {
+                // A free block is never the last one, so the block after it exists
+                RemoveFreeBlock(next);
+                std::size_t absorbed = sizeof(BlockHeader) + next->size;
+                hdr->size += absorbed;
+                usedBytes_ += absorbed;
+                NextBlock(hdr)->prevFree = false;
+            } else {
+                return false;
+            }
+
+            // The cursor must stay on a block boundary
+            if (defragCursor_ > Offset(hdr)) {
+                defragCursor_ = Offset(hdr);
+            }
+        }
+
+        SplitTail(hdr, blockSize);
+        entry->size = newSize;
+        return true;
+    }
+
+    // Gives the part of a used block beyond blockSize back as a free block
+    void SplitTail(BlockHeader* hdr, std::size_t blockSize) {
+        std::size_t remaining = hdr->size - blockSize;
+        if (remaining < sizeof(BlockHeader) + MinBlockSize) {
+            return;
+        }
+
+        hdr->size = blockSize;
+        usedBytes_ -= remaining;
+
+        BlockHeader* tail = reinterpret_cast<BlockHeader*>(
+            reinterpret_cast<uint8_t*>(hdr) + sizeof(BlockHeader) + blockSize);
+        tail->handleEntry = nullptr;
+        tail->size = remaining - sizeof(BlockHeader);
+        tail->free = true;
+        tail->prevFree = false;
+        ReleaseBlock(tail);
+    }
+
+    // Frees a block released by its owner, merging it with free neighbours
+    void ReleaseBlock(BlockHeader* hdr) {
+        MergeWithNext(hdr);
+        if (hdr->prevFree) {
+            BlockHeader* prev = PrevFreeBlock(hdr);
+            RemoveFreeBlock(prev);
+            prev->size += sizeof(BlockHeader) + hdr->size;
+            hdr = prev;
+        }
+        if (Offset(hdr) < defragCursor_) {
+            defragCursor_ = Offset(hdr);
+        }
+        PlaceFreeBlock(hdr);
+    }
+
+    // Puts an already merged free block into its list, or returns it to the
+    // unallocated region if it is the last block
+    void PlaceFreeBlock(BlockHeader* hdr) {
+        BlockHeader* next = NextBlock(hdr);
+        if (!next) {
+            dataTop_ = Offset(hdr);
+            if (defragCursor_ > dataTop_) defragCursor_ = dataTop_;
+            return;
+        }
+        next->prevFree = true;
+        Footer(hdr) = hdr->size;
+        InsertFreeBlock(hdr);
+    }
 
-                void* data = buffer_ + offset + sizeof(BlockHeader);
-                entry->data = data;
-                entry->size = hdr->size;
-                entry->alive = true;
+    // First free block at or above the cursor, advancing the cursor past used blocks
+    BlockHeader* FindHole() {
+        while (defragCursor_ < dataTop_) {
+            BlockHeader* hdr = reinterpret_cast<BlockHeader*>(buffer_ + defragCursor_);
+            if (hdr->free) return hdr;
+            defragCursor_ += sizeof(BlockHeader) + hdr->size;
+        }
+        return nullptr;
+    }
+
+    static std::size_t AlignSize(std::size_t size) {
+        if (size < MinBlockSize) size = MinBlockSize;
+        return (size + Alignment - 1) & ~(Alignment - 1);
+    }
+
+    static void Mapping(std::size_t size, std::size_t& fl, std::size_t& sl) {
+        std::size_t msb = std::bit_width(size) - 1;
+        if (msb < SlLog2) {
+            fl = 0;
+            sl = size;
+        } else {
+            fl = msb - SlLog2 + 1;
+            sl = (size >> (msb - SlLog2)) - SlCount;
+        }
+    }
+
+    static FreeLinks* Links(BlockHeader* hdr) {
+        return reinterpret_cast<FreeLinks*>(reinterpret_cast<uint8_t*>(hdr) + sizeof(BlockHeader));
+    }
 
-                return Handle(entry);
+    void InsertFreeBlock(BlockHeader* hdr) {
+        std::size_t fl, sl;
+        Mapping(hdr->size, fl, sl);
+
+        FreeLinks* links = Links(hdr);
+        links->prev = nullptr;
+        links->next = freeLists_[fl][sl];
+        if (links->next) Links(links->next)->prev = hdr;
+        freeLists_[fl][sl] = hdr;
+
+        flBitmap_ |= std::size_t(1) << fl;
+        slBitmap_[fl] |= uint8_t(1u << sl);
+        freeBlockBytes_ += hdr->size;
+    }
+
+    void RemoveFreeBlock(BlockHeader* hdr) {
+        std::size_t fl, sl;
+        Mapping(hdr->size, fl, sl);
+
+        FreeLinks* links = Links(hdr);
+        if (links->prev) Links(links->prev)->next = links->next;
+        if (links->next) Links(links->next)->prev = links->prev;
+
+        if (freeLists_[fl][sl] == hdr) {
+            freeLists_[fl][sl] = links->next;
+            if (!links->next) {
+                slBitmap_[fl] &= uint8_t(~(1u << sl));
+                if (!slBitmap_[fl]) flBitmap_ &= ~(std::size_t(1) << fl);
             }
+        }
+        freeBlockBytes_ -= hdr->size;
+    }
 
-            offset += blockTotal;
+    // Good fit: round the request up to the next class boundary so any block
+    // in the first non-empty list at or above it fits without a list walk
+    BlockHeader* FindFreeBlock(std::size_t size) {
+        std::size_t fl, sl;
+        std::size_t msb = std::bit_width(size) - 1;
+        std::size_t rounded = size;
+        if (msb >= SlLog2) {
+            rounded += (std::size_t(1) << (msb - SlLog2)) - 1;
         }
-        return Handle();
+        Mapping(rounded, fl, sl);
+
+        if (fl < FlCount) {
+            std::size_t slMap = slBitmap_[fl] & (~0u << sl);
+            if (!slMap) {
+                std::size_t flMap = (fl + 1 < FlCount) ? flBitmap_ & (~std::size_t(0) << (fl + 1)) : 0;
+                if (flMap) {
+                    fl = std::countr_zero(flMap);
+                    slMap = slBitmap_[fl];
+                }
+            }
+            if (slMap) {
+                return freeLists_[fl][std::countr_zero(slMap)];
+            }
+        }
+
+        // Nearly full heap: the request's own class may still hold a block that fits
+        Mapping(size, fl, sl);
+        for (BlockHeader* hdr = freeLists_[fl][sl]; hdr; hdr = Links(hdr)->next) {
+            if (hdr->size >= size) return hdr;
+        }
+        return nullptr;
+    }
+
+    Handle TryAllocateFromFreeBlock(std::size_t size, std::size_t blockSize) {
+        BlockHeader* hdr = FindFreeBlock(blockSize);
+        if (!hdr) {
+            return Handle();
+        }
+
+        if (!freeEntries_ && dataTop_ + (entryCount_ + 1) * sizeof(Entry) > capacity_) {
+            return Handle();
+        }
+        Entry* entry = AcquireEntry();
+
+        RemoveFreeBlock(hdr);
+
+        std::size_t remaining = hdr->size - blockSize;
+        if (remaining >= sizeof(BlockHeader) + MinBlockSize) {
+            hdr->size = blockSize;
+
+            BlockHeader* splitHdr = reinterpret_cast<BlockHeader*>(
+                reinterpret_cast<uint8_t*>(hdr) + sizeof(BlockHeader) + blockSize);
+            splitHdr->handleEntry = nullptr;
+            splitHdr->size = remaining - sizeof(BlockHeader);
+            splitHdr->free = true;
+            splitHdr->prevFree = false;
+            PlaceFreeBlock(splitHdr);
+        } else if (BlockHeader* next = NextBlock(hdr)) {
+            next->prevFree = false;
+        }
+        hdr->free = false;
+        hdr->handleEntry = entry;
+        usedBytes_ += hdr->size;
+
+        entry->data = reinterpret_cast<uint8_t*>(hdr) + sizeof(BlockHeader);
+        entry->size = size;
+        entry->alive = true;
+
+        return Handle(entry);
     }
 };
 
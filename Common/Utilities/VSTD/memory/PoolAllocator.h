@@ -25,6 +25,7 @@ private:
     BlockEntry entries_[BlockCount] = {};
     FreeNode* freeList_ = nullptr;
     std::size_t allocatedCount_ = 0;
+    std::size_t highWaterMark_ = 0;
 
 public:
     PoolAllocator() {
@@ -49,6 +50,7 @@ public:
         be.blockIndex = blockIndex;
 
         allocatedCount_++;
+        if (allocatedCount_ > highWaterMark_) highWaterMark_ = allocatedCount_;
         return Handle(&be.handleEntry);
     }
 
@@ -78,7 +80,13 @@ public:
         return Handle();
     }
 
+    bool Owns(const Handle& handle) const {
+        const uint8_t* data = static_cast<const uint8_t*>(handle.Data());
+        return data >= pool_ && data < pool_ + sizeof(pool_);
+    }
+
     std::size_t AllocatedCount() const { return allocatedCount_; }
+    std::size_t HighWaterMark() const { return highWaterMark_; }
     std::size_t FreeCount() const { return BlockCount - allocatedCount_; }
     std::size_t TotalBlocks() const { return BlockCount; }
 
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string.h>
+#include <bit>
+#include <tuple>
+#include <utility>
+#include "IAllocator.h"
+#include "PoolAllocator.h"
+
+namespace VSTD {
+
+// Size-class allocator built from PoolAllocators. Class i holds blocks of
+// MinBlockSize << i bytes, BlockCounts gives the number of blocks per class:
+//   SlabAllocator<16, 32, 32, 16, 8, 4>  ->  16B x32, 32B x32, 64B x16, 128B x8, 256B x4
+// Requests larger than the biggest class (or when all fitting classes are
+// exhausted) go to the optional fallback allocator, e.g. a Heap.
+template<std::size_t MinBlockSize, std::size_t... BlockCounts>
+class SlabAllocator : public IAllocator {
+    static_assert(sizeof...(BlockCounts) > 0, "SlabAllocator needs at least one size class");
+    static_assert(std::has_single_bit(MinBlockSize), "MinBlockSize must be a power of two");
+
+public:
+    static constexpr std::size_t ClassCount = sizeof...(BlockCounts);
+    static constexpr std::size_t MaxBlockSize = MinBlockSize << (ClassCount - 1);
+
+private:
+    static constexpr std::size_t MinBlockShift = std::bit_width(MinBlockSize) - 1;
+
+    template<std::size_t... Is>
+    static auto MakePools(std::index_sequence<Is...>)
+        -> std::tuple<PoolAllocator<(MinBlockSize << Is), BlockCounts>...>;
+
+    using Pools = decltype(MakePools(std::make_index_sequence<ClassCount>{}));
+    using Indices = std::make_index_sequence<ClassCount>;
+
+    Pools pools_;
+    IAllocator* fallback_;
+
+public:
+    explicit SlabAllocator(IAllocator* fallback = nullptr) : fallback_(fallback) {}
+
+    // Non-copyable, handles point into the pools
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    Handle Allocate(std::size_t size) override {
+        // Smallest fitting class first, then spill into bigger ones
+        for (std::size_t i = ClassFor(size); i < ClassCount; i++) {
+            Handle handle = AllocateFromClass(i, size, Indices{});
+            if (handle.IsValid()) return handle;
+        }
+        if (fallback_) return fallback_->Allocate(size);
+        return Handle();
+    }
+
+    void Deallocate(Handle& handle) override {
+        if (!handle.IsValid()) return;
+
+        std::size_t owner = OwnerClass(handle, Indices{});
+        if (owner < ClassCount) {
+            DeallocateFromClass(owner, handle, Indices{});
+        } else if (fallback_) {
+            fallback_->Deallocate(handle);
+        }
+    }
+
+    Handle Reallocate(Handle& handle, std::size_t newSize) override {
+        if (!handle.IsValid()) {
+            return Allocate(newSize);
+        }
+
+        std::size_t owner = OwnerClass(handle, Indices{});
+        if (owner == ClassCount) {
+            // Heap blocks stay in the heap, it may be able to extend them
+            return fallback_ ? fallback_->Reallocate(handle, newSize) : Handle();
+        }
+
+        // Shrinking, or growing within the block: only the recorded size changes
+        std::size_t oldSize = handle.Size();
+        if (newSize <= ClassBlockSize(owner)) {
+            handle.GetEntry()->size = newSize;
+            return handle;
+        }
+
+        Handle newHandle = Allocate(newSize);
+        if (!newHandle.IsValid()) {
+            return Handle();
+        }
+
+        memcpy(newHandle.Data(), handle.Data(), oldSize);
+        Deallocate(handle);
+
+        return newHandle;
+    }
+
+    // Class index for a request, ClassCount if it only fits the fallback
+    static constexpr std::size_t ClassFor(std::size_t size) {
+        if (size <= MinBlockSize) return 0;
+        std::size_t index = std::bit_width(size - 1) - MinBlockShift;
+        return index < ClassCount ? index : ClassCount;
+    }
+
+    static constexpr std::size_t ClassBlockSize(std::size_t index) {
+        return MinBlockSize << index;
+    }
+
+    std::size_t AllocatedCount(std::size_t index) const {
+        return VisitClass(index, [](const auto& pool) { return pool.AllocatedCount(); }, Indices{});
+    }
+
+    // Peak number of simultaneously allocated blocks, for sizing BlockCounts
+    std::size_t HighWaterMark(std::size_t index) const {
+        return VisitClass(index, [](const auto& pool) { return pool.HighWaterMark(); }, Indices{});
+    }
+
+    std::size_t TotalBlocks(std::size_t index) const {
+        return VisitClass(index, [](const auto& pool) { return pool.TotalBlocks(); }, Indices{});
+    }
+
+    IAllocator* GetFallback() const { return fallback_; }
+
+private:
+    template<std::size_t... Is>
+    Handle AllocateFromClass(std::size_t index, std::size_t size, std::index_sequence<Is...>) {
+        Handle handle;
+        ((index == Is ? (handle = std::get<Is>(pools_).Allocate(size), true) : false) || ...);
+        return handle;
+    }
+
+    template<std::size_t... Is>
+    void DeallocateFromClass(std::size_t index, Handle& handle, std::index_sequence<Is...>) {
+        ((index == Is ? (std::get<Is>(pools_).Deallocate(handle), true) : false) || ...);
+    }
+
+    template<std::size_t... Is>
+    std::size_t OwnerClass(const Handle& handle, std::index_sequence<Is...>) const {
+        std::size_t owner = ClassCount;
+        ((std::get<Is>(pools_).Owns(handle) ? (owner = Is, true) : false) || ...);
+        return owner;
+    }
+
+    template<typename F, std::size_t... Is>
+    std::size_t VisitClass(std::size_t index, F&& f, std::index_sequence<Is...>) const {
+        std::size_t result = 0;
+        ((index == Is ? (result = f(std::get<Is>(pools_)), true) : false) || ...);
+        return result;
+    }
+};
+
+}